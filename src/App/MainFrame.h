@@ -13,7 +13,9 @@
 #include <wx/timer.h>
 #include <wx/wx.h>
 
+#include "MetadataCache.h"
 #include "RenamerLogic.h"
+#include "RenderCache.h"
 #include <deque>
 #include <filesystem>
 #include <optional>
@@ -64,6 +66,9 @@ enum ControlIDs {
   ID_SaveProfile,
   ID_LoadProfile,
   ID_DeleteProfile,
+  ID_ChainProfiles,
+  ID_RoutingRules,
+  ID_ReplacementTable,
 
   // Export Menu ID
   ID_ExportPreview,
@@ -98,10 +103,20 @@ private:
   wxSpinCtrl *lowestNumSpin;
   wxStaticText *highestNumLabel;
   wxSpinCtrl *highestNumSpin;
+  wxStaticText *resequenceLabel;
+  wxChoice *resequenceChoice;
   wxCheckBox *recursiveCheck;
+  wxStaticText *excludePatternsLabel;
+  wxTextCtrl *excludePatternsCtrl;
+  wxCheckBox *skipHiddenCheck;
+  wxCheckBox *renameFoldersCheck;
+  wxStaticText *maxDepthLabel;
+  wxSpinCtrl *maxDepthSpin;
   wxButton *addFilesButton;
   wxButton *removeFilesButton;
   wxButton *clearFilesButton;
+  wxStaticText *sourcePatternLabel;
+  wxTextCtrl *sourcePatternCtrl;
   wxStaticText *patternLabel;
   wxTextCtrl *patternCtrl;
   wxStaticText *findLabel;
@@ -114,6 +129,9 @@ private:
   wxChoice *caseChoice;
   wxStaticText *incrementLabel;
   wxSpinCtrl *incrementSpin;
+  wxStaticText *conflictSuffixLabel;
+  wxTextCtrl *conflictSuffixCtrl;
+  wxCheckBox *subfolderCheck;
   wxCheckBox *backupCheck;
   wxPanel *bottomPanel;
   wxButton *previewButton;
@@ -149,6 +167,22 @@ private:
   // Real-time preview timer
   wxTimer m_previewTimer;
 
+  // Content hashes and capture dates from earlier previews, kept on disk
+  MetadataCache m_metadataCache;
+
+  // Names rendered by the last preview, stage by stage
+  RenderCache m_renderCache;
+
+  // Saved profiles applied after the current settings, in order
+  std::vector<RuleStep> m_ruleChain;
+  wxArrayString m_ruleChainNames;
+
+  // Per-extension/glob/number patterns, kept as the text the user entered
+  std::vector<RoutedRule> m_routedRules;
+  wxString m_routedRulesText;
+  std::vector<ReplacementPair> m_replacementTable;
+  wxString m_replacementTableText;
+
   // Initialization & Layout
   void SetupLayout();
   void BindEvents();
@@ -173,6 +207,7 @@ private:
   void OnSaveProfile(wxCommandEvent &event);
   void OnLoadProfile(wxCommandEvent &event);
   void OnDeleteProfile(wxCommandEvent &event);
+  void OnChainProfiles(wxCommandEvent &event);
 
   // Undo Event Handler
   void OnUndoRename(wxCommandEvent &event);
@@ -180,6 +215,12 @@ private:
   // Export Preview Handler
   void OnExportPreview(wxCommandEvent &event);
 
+  // Routing Rules Handler
+  void OnRoutingRules(wxCommandEvent &event);
+
+  // Replacement Table Handler
+  void OnReplacementTable(wxCommandEvent &event);
+
   // Progress Handler
   void OnProgressUpdate(wxCommandEvent &event);
 
@@ -198,6 +239,8 @@ private:
   void UpdatePreviewListColumns();
   void PopulateManualPreviewList();
   void SetUndoAvailable(bool available); // << Helper to manage undo state
+  bool SetRoutedRules(const wxString &text, wxString &error);
+  bool SetReplacementTable(const wxString &text, wxString &error);
 
   // Drag & Drop Handlers
   void SetDroppedDirectory(const wxString &path);
@@ -15,12 +15,15 @@
 #include <wx/radiobox.h>
 #include <wx/spinctrl.h>
 #include <wx/stattext.h>
+#include <wx/textdlg.h>
 #include <wx/textctrl.h>
 #include <wx/txtstrm.h>
 #include <wx/wfstream.h>
 
 #include "HelpDialog.h"
 #include "MainFrame.h"
+#include "ReplacementTable.h"
+#include "RuleRouter.h"
 #include "WorkerThread.h"
 
 #include <algorithm>
@@ -206,6 +209,7 @@ void MainFrame::OnPreviewClick(wxCommandEvent &event) {
 
   // Populate common parameters
   params.namingPattern = patternCtrl->GetValue().ToStdString();
+  params.sourcePattern = sourcePatternCtrl->GetValue().ToStdString();
   params.findText = findCtrl->GetValue().ToStdString();
   params.replaceText = replaceCtrl->GetValue().ToStdString();
   params.findCaseSensitive = caseSensitiveCheck->IsChecked();
@@ -218,6 +222,13 @@ void MainFrame::OnPreviewClick(wxCommandEvent &event) {
   else
     params.caseConversionMode = CaseConversionMode::NoChange;
   params.increment = incrementSpin->GetValue();
+  params.ruleChain = m_ruleChain;
+  params.routedRules = m_routedRules;
+  params.replacementTable = m_replacementTable;
+  params.allowSubfolders = subfolderCheck->IsChecked();
+  // Not trimmed: " (#)" starts with a space on purpose
+  params.conflictSuffix = conflictSuffixCtrl->GetValue().ToStdString();
+  params.dryRun = true; // Predict execution failures on every preview
 
   wxColour errorColour(255, 200,
                        200); // Light red for highlighting input errors
@@ -286,9 +297,21 @@ void MainFrame::OnPreviewClick(wxCommandEvent &event) {
       return;
     }
     params.recursiveScan = recursiveCheck->IsChecked();
+    params.excludePatterns =
+        excludePatternsCtrl->GetValue().Trim().ToStdString();
+    params.skipHiddenDirectories = skipHiddenCheck->IsChecked();
+    params.renameDirectories = renameFoldersCheck->IsChecked();
+    params.maxScanDepth = maxDepthSpin->GetValue();
+    // Choice order matches ResequenceOrder, "Off" being None
+    int resequenceSelection = resequenceChoice->GetSelection();
+    if (resequenceSelection >= 1 && resequenceSelection <= 3)
+      params.resequence = static_cast<ResequenceOrder>(resequenceSelection);
 
     if (params.recursiveScan)
       logTextCtrl->AppendText("Recursive scan enabled.\n");
+    if (!params.excludePatterns.empty())
+      logTextCtrl->AppendText(
+          "Using exclude patterns: " + params.excludePatterns + "\n");
     if (params.lowestNumber != 0 || params.highestNumber != 0)
       logTextCtrl->AppendText(
           wxString::Format("Using number filter: %d to %d.\n",
@@ -319,6 +342,7 @@ void MainFrame::OnPreviewClick(wxCommandEvent &event) {
     // Set DirScan specific params to defaults/empty for clarity as they are not
     // used in Manual mode
     params.recursiveScan = false;
+    params.excludePatterns = "";
     params.filenamePattern = "";
     params.filterExtensions = "";
     params.lowestNumber = 0;
@@ -340,6 +364,8 @@ void MainFrame::OnPreviewClick(wxCommandEvent &event) {
   }
 
   logTextCtrl->AppendText("Input validation successful.\n");
+  params.metadataCache = &m_metadataCache;
+  params.renderCache = &m_renderCache;
   m_lastValidParams =
       params; // Store the validated parameters for potential rename operation
 
@@ -704,6 +730,8 @@ void MainFrame::OnHelpTopics(wxCommandEvent &event) {
 // Handles the window close event
 void MainFrame::OnClose(wxCloseEvent &event) {
   SaveSettings(); // Save window position, size, and last used inputs to config
+  std::error_code cacheEc;
+  m_metadataCache.save(cacheEc); // Best effort; rebuilt on the next preview
 
   // Clean up dynamically allocated fs::path pointers associated with list items
   // in Manual mode This is crucial to prevent memory leaks upon closing the
@@ -796,6 +824,96 @@ void MainFrame::OnExportPreview(wxCommandEvent &event) {
                "Export Complete", wxOK | wxICON_INFORMATION, this);
 }
 
+// Parses 'text' into the routing rules used by the next preview. Returns
+// false, keeping the previous rules, if a line is invalid
+bool MainFrame::SetRoutedRules(const wxString &text, wxString &error) {
+  std::vector<RoutedRule> rules;
+  std::string parseError;
+  if (!ParseRoutedRules(text.ToStdString(), rules, parseError)) {
+    error = parseError;
+    return false;
+  }
+  m_routedRules = std::move(rules);
+  m_routedRulesText = text;
+  return true;
+}
+
+// Handles the "File -> Routing Rules..." menu item
+void MainFrame::OnRoutingRules(wxCommandEvent &event) {
+  wxTextEntryDialog dialog(
+      this,
+      "One rule per line; the first rule matching a file supplies its naming "
+      "pattern,\nfiles no rule matches use the New Naming Pattern.\n\n"
+      "  ext:jpg,jpeg glob:IMG_* num:1-500 => IMG_<num><ext>\n"
+      "  ext:mp4,mov => VID_<orig_name><ext>",
+      "Routing Rules", m_routedRulesText,
+      wxOK | wxCANCEL | wxCENTRE | wxTE_MULTILINE);
+  while (dialog.ShowModal() == wxID_OK) {
+    wxString error;
+    if (!SetRoutedRules(dialog.GetValue(), error)) {
+      wxMessageBox(error, "Routing Rules", wxOK | wxICON_ERROR, this);
+      continue; // Let the user correct the text
+    }
+    // The current preview no longer reflects the rules
+    renameButton->Enable(false);
+    m_previewSuccess = false;
+    const wxString summary =
+        m_routedRules.empty()
+            ? wxString("Routing rules cleared.")
+            : wxString::Format("%zu routing rule(s) set.",
+                               m_routedRules.size());
+    UpdateStatusBar(summary);
+    logTextCtrl->AppendText(summary + " Preview again to apply them.\n");
+    return;
+  }
+  UpdateStatusBar("Routing rules unchanged.");
+}
+
+// Parses 'text' into the replacement table used by the next preview.
+// Returns false, keeping the previous table, if a line is invalid
+bool MainFrame::SetReplacementTable(const wxString &text, wxString &error) {
+  std::vector<ReplacementPair> pairs;
+  std::string parseError;
+  if (!ParseReplacementTable(text.ToStdString(), pairs, parseError)) {
+    error = parseError;
+    return false;
+  }
+  m_replacementTable = std::move(pairs);
+  m_replacementTableText = text;
+  return true;
+}
+
+// Handles the "File -> Replacement Table..." menu item
+void MainFrame::OnReplacementTable(wxCommandEvent &event) {
+  wxTextEntryDialog dialog(
+      this,
+      "One replacement per line, all applied in a single pass after Find/"
+      "Replace;\nwhere finds overlap, the leftmost and then longest wins.\n\n"
+      "  colour => color\n"
+      "  \" - copy\" =>",
+      "Replacement Table", m_replacementTableText,
+      wxOK | wxCANCEL | wxCENTRE | wxTE_MULTILINE);
+  while (dialog.ShowModal() == wxID_OK) {
+    wxString error;
+    if (!SetReplacementTable(dialog.GetValue(), error)) {
+      wxMessageBox(error, "Replacement Table", wxOK | wxICON_ERROR, this);
+      continue; // Let the user correct the text
+    }
+    // The current preview no longer reflects the table
+    renameButton->Enable(false);
+    m_previewSuccess = false;
+    const wxString summary =
+        m_replacementTable.empty()
+            ? wxString("Replacement table cleared.")
+            : wxString::Format("%zu replacement(s) set.",
+                               m_replacementTable.size());
+    UpdateStatusBar(summary);
+    logTextCtrl->AppendText(summary + " Preview again to apply them.\n");
+    return;
+  }
+  UpdateStatusBar("Replacement table unchanged.");
+}
+
 // Handles progress update events from worker threads
 void MainFrame::OnProgressUpdate(wxCommandEvent &event) {
   int progress = event.GetInt();
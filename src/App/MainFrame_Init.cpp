@@ -35,6 +35,7 @@
 #include <wx/textdlg.h>
 
 
+#include "CrossDeviceMove.h"
 #include "HelpDialog.h"
 #include "MainFrame.h"
 #include "RenamerLogic.h"
@@ -60,13 +61,17 @@ MainFrame::MainFrame(const wxString &title, const wxPoint &pos,
       m_currentMode(
           RenamingMode::DirectoryScan), // Default mode is DirectoryScan
       m_undoAvailable(false), m_previewSuccess(false),
-      m_backupAttempted(false) {
+      m_backupAttempted(false),
+      m_metadataCache(RenamerLogic::getMetadataCachePath()) {
   SetIcon(wxIcon(L"#1", wxBITMAP_TYPE_ICO_RESOURCE));
   // Create the menu bar
   wxMenu *menuFile = new wxMenu;
   menuFile->Append(ID_SaveProfile, "Save Profile...\tCtrl+S");
   menuFile->Append(ID_LoadProfile, "Load Profile...\tCtrl+L");
   menuFile->Append(ID_DeleteProfile, "Delete Profile...");
+  menuFile->Append(ID_ChainProfiles, "Chain Profiles...");
+  menuFile->Append(ID_RoutingRules, "Routing Rules...");
+  menuFile->Append(ID_ReplacementTable, "Replacement Table...");
   menuFile->AppendSeparator();
   menuFile->Append(ID_ExportPreview, "Export Preview to CSV...");
   menuFile->AppendSeparator();
@@ -132,8 +137,36 @@ MainFrame::MainFrame(const wxString &title, const wxPoint &pos,
   highestNumSpin =
       new wxSpinCtrl(scrolledWindow, wxID_ANY, "", wxDefaultPosition,
                      wxDefaultSize, wxSP_ARROW_KEYS, 0, 9999, 0);
+  resequenceLabel =
+      new wxStaticText(scrolledWindow, wxID_ANY, "Resequence (<num>):");
+  wxArrayString resequenceOptions;
+  resequenceOptions.Add("Off");
+  resequenceOptions.Add("By current number");
+  resequenceOptions.Add("By name");
+  resequenceOptions.Add("By date modified");
+  resequenceChoice = new wxChoice(scrolledWindow, wxID_ANY, wxDefaultPosition,
+                                  wxDefaultSize, resequenceOptions);
+  resequenceChoice->SetSelection(0); // Default to "Off"
+  resequenceChoice->SetToolTip(
+      "Number each folder's files 1, 2, 3, ... in this order instead of "
+      "adding the increment. Files already at their number are not renamed");
   recursiveCheck = new wxCheckBox(scrolledWindow, ID_RecursiveCheck,
                                   "Include Subdirectories");
+  excludePatternsLabel = new wxStaticText(
+      scrolledWindow, wxID_ANY, "Exclude (opt., ';'-sep, folder/ for dirs):");
+  excludePatternsCtrl = new wxTextCtrl(scrolledWindow, wxID_ANY, "");
+  skipHiddenCheck =
+      new wxCheckBox(scrolledWindow, wxID_ANY, "Skip Hidden Folders");
+  renameFoldersCheck =
+      new wxCheckBox(scrolledWindow, wxID_ANY, "Rename Folders Too");
+  renameFoldersCheck->SetToolTip(
+      "Apply the pattern to folders the filters accept as well as files. "
+      "Folders are renamed after everything inside them");
+  maxDepthLabel =
+      new wxStaticText(scrolledWindow, wxID_ANY, "Max Depth (0 = all):");
+  maxDepthSpin =
+      new wxSpinCtrl(scrolledWindow, wxID_ANY, "", wxDefaultPosition,
+                     wxDefaultSize, wxSP_ARROW_KEYS, 0, 999, 0);
   addFilesButton =
       new wxButton(scrolledWindow, ID_AddFilesButton, "Add Files...");
   removeFilesButton =
@@ -142,6 +175,12 @@ MainFrame::MainFrame(const wxString &title, const wxPoint &pos,
   clearFilesButton =
       new wxButton(scrolledWindow, ID_ClearFilesButton, "Clear List");
   clearFilesButton->Enable(false); // Initially disabled
+  sourcePatternLabel = new wxStaticText(scrolledWindow, wxID_ANY,
+                                        "Source Pattern (opt. regex):");
+  sourcePatternCtrl = new wxTextCtrl(scrolledWindow, wxID_ANY, "");
+  sourcePatternCtrl->SetToolTip(
+      "Regex searched in each name without its extension. Use its groups in "
+      "the naming pattern as <1>, <2>, ... or <name> for (?<name>...).");
   patternLabel =
       new wxStaticText(scrolledWindow, wxID_ANY, "New Naming Pattern:");
   patternCtrl =
@@ -166,6 +205,18 @@ MainFrame::MainFrame(const wxString &title, const wxPoint &pos,
   incrementSpin =
       new wxSpinCtrl(scrolledWindow, wxID_ANY, "", wxDefaultPosition,
                      wxDefaultSize, wxSP_ARROW_KEYS, -9999, 9999, 1);
+  conflictSuffixLabel = new wxStaticText(scrolledWindow, wxID_ANY,
+                                         "Resolve Conflicts With (opt.):");
+  conflictSuffixCtrl = new wxTextCtrl(scrolledWindow, wxID_ANY, "");
+  conflictSuffixCtrl->SetToolTip(
+      "Suffix added to a new name that is already taken, '#' being the first "
+      "free counter from 2, e.g. \" (#)\" or \"_###\". Leave empty to skip "
+      "conflicting files instead.");
+  subfolderCheck = new wxCheckBox(scrolledWindow, wxID_ANY,
+                                  "Allow subfolders in pattern ('/')");
+  subfolderCheck->SetToolTip(
+      "Treat '/' in the Naming Pattern as a folder separator, moving files "
+      "into subfolders (created as needed) of their current folder");
   backupCheck =
       new wxCheckBox(scrolledWindow, wxID_ANY, "Create backup before renaming");
   bottomPanel = new wxPanel(
@@ -192,6 +243,24 @@ MainFrame::MainFrame(const wxString &title, const wxPoint &pos,
   // Enable drag and drop for files/directories onto the main panel
   mainPanel->SetDropTarget(new FileDropTarget(this));
 
+  // The cache only saves work; a missing or unreadable one starts empty
+  std::error_code cacheEc;
+  m_metadataCache.load(cacheEc);
+
+  // Tidy up after cross-drive moves a crash or power loss interrupted
+  std::error_code journalEc;
+  const std::size_t recoveredMoves = RecoverInterruptedMoves(
+      RenamerLogic::getMoveJournalPath(), DefaultFileSystem(), journalEc);
+  if (recoveredMoves > 0) {
+    logTextCtrl->AppendText(wxString::Format(
+        "Finished %zu move(s) to another drive that were interrupted.\n",
+        recoveredMoves));
+  }
+  if (journalEc) {
+    logTextCtrl->AppendText("Could not recover interrupted moves: " +
+                            journalEc.message() + "\n");
+  }
+
   // Load last used settings from config, then update UI accordingly
   LoadSettings();
   UpdateUIForMode();          // Reflects loaded mode and settings
@@ -239,7 +308,7 @@ void MainFrame::SetupLayout() {
   // Sizer for Directory Scan specific options
   dirScanSizer = new wxStaticBoxSizer(dirScanBox, wxVERTICAL);
   wxFlexGridSizer *dirGridSizer =
-      new wxFlexGridSizer(5, 2, 5, 5); // 5 rows, 2 columns, 5px gaps
+      new wxFlexGridSizer(7, 2, 5, 5); // 7 rows, 2 columns, 5px gaps
   dirGridSizer->AddGrowableCol(1);     // Second column (controls) should grow
   dirGridSizer->Add(
       new wxStaticText(scrolledWindow, wxID_ANY, "Target Directory:"), 0,
@@ -251,14 +320,29 @@ void MainFrame::SetupLayout() {
   dirGridSizer->Add(filterExtensionsLabel, 0,
                     wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
   dirGridSizer->Add(filterExtensionsCtrl, 1, wxEXPAND | wxALL, 2);
+  dirGridSizer->Add(excludePatternsLabel, 0,
+                    wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
+  dirGridSizer->Add(excludePatternsCtrl, 1, wxEXPAND | wxALL, 2);
   dirGridSizer->Add(lowestNumLabel, 0,
                     wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
   dirGridSizer->Add(lowestNumSpin, 1, wxEXPAND | wxALL, 2);
   dirGridSizer->Add(highestNumLabel, 0,
                     wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
   dirGridSizer->Add(highestNumSpin, 1, wxEXPAND | wxALL, 2);
+  dirGridSizer->Add(resequenceLabel, 0,
+                    wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
+  dirGridSizer->Add(resequenceChoice, 1, wxEXPAND | wxALL, 2);
   dirScanSizer->Add(dirGridSizer, 0, wxEXPAND | wxALL, 5);
-  dirScanSizer->Add(recursiveCheck, 0,
+  wxBoxSizer *recursionSizer = new wxBoxSizer(wxHORIZONTAL);
+  recursionSizer->Add(recursiveCheck, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT,
+                      10);
+  recursionSizer->Add(skipHiddenCheck, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT,
+                      10);
+  recursionSizer->Add(renameFoldersCheck, 0,
+                      wxALIGN_CENTER_VERTICAL | wxRIGHT, 10);
+  recursionSizer->Add(maxDepthLabel, 0, wxALIGN_CENTER_VERTICAL | wxRIGHT, 5);
+  recursionSizer->Add(maxDepthSpin, 0, wxALIGN_CENTER_VERTICAL);
+  dirScanSizer->Add(recursionSizer, 0,
                     wxALIGN_LEFT | wxLEFT | wxRIGHT | wxBOTTOM, 5);
   inputAreaSizer->Add(dirScanSizer, 0, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM,
                       5);
@@ -278,8 +362,11 @@ void MainFrame::SetupLayout() {
   // Sizer for Common Renaming Options
   commonSizer = new wxStaticBoxSizer(commonBox, wxVERTICAL);
   wxFlexGridSizer *commonGridSizer =
-      new wxFlexGridSizer(6, 2, 5, 5); // 6 rows, 2 columns
+      new wxFlexGridSizer(8, 2, 5, 5); // 8 rows, 2 columns
   commonGridSizer->AddGrowableCol(1);  // Second column (controls) grows
+  commonGridSizer->Add(sourcePatternLabel, 0,
+                       wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
+  commonGridSizer->Add(sourcePatternCtrl, 1, wxEXPAND | wxALL, 2);
   commonGridSizer->Add(patternLabel, 0,
                        wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
   commonGridSizer->Add(patternCtrl, 1, wxEXPAND | wxALL, 2);
@@ -300,10 +387,15 @@ void MainFrame::SetupLayout() {
   commonGridSizer->Add(incrementLabel, 0,
                        wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
   commonGridSizer->Add(incrementSpin, 1, wxEXPAND | wxALL, 2);
+  commonGridSizer->Add(conflictSuffixLabel, 0,
+                       wxALIGN_CENTER_VERTICAL | wxALIGN_RIGHT | wxALL, 2);
+  commonGridSizer->Add(conflictSuffixCtrl, 1, wxEXPAND | wxALL, 2);
   commonSizer->Add(commonGridSizer, 0, wxEXPAND | wxALL, 5);
   inputAreaSizer->Add(commonSizer, 0, wxEXPAND | wxLEFT | wxRIGHT | wxBOTTOM,
                       5);
 
+  inputAreaSizer->Add(subfolderCheck, 0,
+                      wxALIGN_LEFT | wxLEFT | wxRIGHT | wxBOTTOM, 10);
   inputAreaSizer->Add(backupCheck, 0,
                       wxALIGN_LEFT | wxLEFT | wxRIGHT | wxBOTTOM, 10);
 
@@ -351,6 +443,10 @@ void MainFrame::BindEvents() {
   Bind(wxEVT_MENU, &MainFrame::OnSaveProfile, this, ID_SaveProfile);
   Bind(wxEVT_MENU, &MainFrame::OnLoadProfile, this, ID_LoadProfile);
   Bind(wxEVT_MENU, &MainFrame::OnDeleteProfile, this, ID_DeleteProfile);
+  Bind(wxEVT_MENU, &MainFrame::OnChainProfiles, this, ID_ChainProfiles);
+  Bind(wxEVT_MENU, &MainFrame::OnRoutingRules, this, ID_RoutingRules);
+  Bind(wxEVT_MENU, &MainFrame::OnReplacementTable, this,
+       ID_ReplacementTable);
   Bind(wxEVT_MENU, &MainFrame::OnUndoRename, this, ID_UndoRename);
   Bind(wxEVT_MENU, &MainFrame::OnExit, this, wxID_EXIT);
   // Help Menu events
@@ -378,6 +474,7 @@ void MainFrame::BindEvents() {
   // Real-time preview on pattern changes
   m_previewTimer.SetOwner(this);
   Bind(wxEVT_TIMER, &MainFrame::OnPreviewTimer, this);
+  sourcePatternCtrl->Bind(wxEVT_TEXT, &MainFrame::OnPatternTextChanged, this);
   patternCtrl->Bind(wxEVT_TEXT, &MainFrame::OnPatternTextChanged, this);
   findCtrl->Bind(wxEVT_TEXT, &MainFrame::OnPatternTextChanged, this);
   replaceCtrl->Bind(wxEVT_TEXT, &MainFrame::OnPatternTextChanged, this);
@@ -8,6 +8,7 @@
 #include <wx/msgdlg.h>
 #include <wx/textdlg.h>
 #include <wx/choicdlg.h>
+#include <wx/rearrangectrl.h>
 #include <wx/log.h>
 #include <wx/listctrl.h>
 #include <wx/button.h>
@@ -115,14 +116,25 @@ void MainFrame::OnSaveProfile(wxCommandEvent &event)
 	cfg->Write("FilenamePattern", fileNamePatternCtrl->GetValue());
 	cfg->Write("FilterExtensions", filterExtensionsCtrl->GetValue());
 	cfg->Write("HighestNum", (long)highestNumSpin->GetValue());
+	cfg->Write("Resequence", (long)resequenceChoice->GetSelection());
 	cfg->Write("LowestNum", (long)lowestNumSpin->GetValue());
 	cfg->Write("RecursiveScan", recursiveCheck->IsChecked());
+	cfg->Write("ExcludePatterns", excludePatternsCtrl->GetValue());
+	cfg->Write("SkipHiddenDirs", skipHiddenCheck->IsChecked());
+	cfg->Write("RenameFolders", renameFoldersCheck->IsChecked());
+	cfg->Write("MaxScanDepth", (long)maxDepthSpin->GetValue());
+	cfg->Write("SourcePattern", sourcePatternCtrl->GetValue());
 	cfg->Write("NamingPattern", patternCtrl->GetValue());
 	cfg->Write("FindText", findCtrl->GetValue());
 	cfg->Write("ReplaceText", replaceCtrl->GetValue());
 	cfg->Write("FindCaseSensitive", caseSensitiveCheck->IsChecked());
+	cfg->Write("FindUseRegex", regexModeCheck->IsChecked());
 	cfg->Write("CaseConversion", (long)caseChoice->GetSelection());
 	cfg->Write("Increment", (long)incrementSpin->GetValue());
+	cfg->Write("ConflictSuffix", conflictSuffixCtrl->GetValue());
+	cfg->Write("RoutedRules", m_routedRulesText);
+	cfg->Write("ReplacementTable", m_replacementTableText);
+	cfg->Write("AllowSubfolders", subfolderCheck->IsChecked());
 	cfg->Write("Backup", backupCheck->IsChecked());
 
 	cfg->SetPath("/"); // Reset config path
@@ -191,14 +203,32 @@ void MainFrame::OnLoadProfile(wxCommandEvent &event)
 	fileNamePatternCtrl->SetValue(cfg->Read("FilenamePattern", "*.*"));
 	filterExtensionsCtrl->SetValue(cfg->Read("FilterExtensions", wxEmptyString));
 	highestNumSpin->SetValue(cfg->ReadLong("HighestNum", 0));
+	resequenceChoice->SetSelection(cfg->ReadLong("Resequence", 0));
 	lowestNumSpin->SetValue(cfg->ReadLong("LowestNum", 0));
 	recursiveCheck->SetValue(cfg->ReadBool("RecursiveScan", false));
+	excludePatternsCtrl->SetValue(cfg->Read("ExcludePatterns", wxEmptyString));
+	skipHiddenCheck->SetValue(cfg->ReadBool("SkipHiddenDirs", false));
+	renameFoldersCheck->SetValue(cfg->ReadBool("RenameFolders", false));
+	maxDepthSpin->SetValue(cfg->ReadLong("MaxScanDepth", 0));
+	sourcePatternCtrl->SetValue(cfg->Read("SourcePattern", wxEmptyString));
 	patternCtrl->SetValue(cfg->Read("NamingPattern", "<orig_name><ext>"));
 	findCtrl->SetValue(cfg->Read("FindText", wxEmptyString));
 	replaceCtrl->SetValue(cfg->Read("ReplaceText", wxEmptyString));
 	caseSensitiveCheck->SetValue(cfg->ReadBool("FindCaseSensitive", true));
+	regexModeCheck->SetValue(cfg->ReadBool("FindUseRegex", false));
 	caseChoice->SetSelection(cfg->ReadLong("CaseConversion", 0));
 	incrementSpin->SetValue(cfg->ReadLong("Increment", 1));
+	conflictSuffixCtrl->SetValue(cfg->Read("ConflictSuffix", wxEmptyString));
+	wxString rulesError;
+	if (!SetRoutedRules(cfg->Read("RoutedRules", wxEmptyString), rulesError))
+	{
+		logTextCtrl->AppendText("Profile routing rules ignored: " + rulesError + "\n");
+	}
+	if (!SetReplacementTable(cfg->Read("ReplacementTable", wxEmptyString), rulesError))
+	{
+		logTextCtrl->AppendText("Profile replacement table ignored: " + rulesError + "\n");
+	}
+	subfolderCheck->SetValue(cfg->ReadBool("AllowSubfolders", false));
 	backupCheck->SetValue(cfg->ReadBool("Backup", false));
 
 	cfg->SetPath("/"); // Reset config path
@@ -311,4 +341,109 @@ void MainFrame::OnDeleteProfile(wxCommandEvent &event)
 	}
 
 	cfg->SetPath("/"); // Reset config path
-}
\ No newline at end of file
+}
+// Handles the "File -> Chain Profiles..." menu item. The checked profiles' naming
+// steps are applied in the listed order after the current settings, all within
+// one preview and one rename
+void MainFrame::OnChainProfiles(wxCommandEvent &event)
+{
+	wxArrayString profileNames = GetProfileNames();
+	if (profileNames.IsEmpty())
+	{
+		wxMessageBox("No saved profiles exist to chain.", "Chain Profiles", wxOK | wxICON_INFORMATION, this);
+		return;
+	}
+
+	// Previously chained profiles come first, checked and in their chain order
+	wxArrayString items;
+	wxArrayInt order;
+	for (const wxString &name : m_ruleChainNames)
+	{
+		if (profileNames.Index(name) != wxNOT_FOUND)
+		{
+			order.Add(static_cast<int>(items.GetCount()));
+			items.Add(name);
+		}
+	}
+	for (const wxString &name : profileNames)
+	{
+		if (items.Index(name) == wxNOT_FOUND)
+		{
+			order.Add(~static_cast<int>(items.GetCount())); // Unchecked
+			items.Add(name);
+		}
+	}
+
+	wxRearrangeDialog dialog(
+		this,
+		"Check the profiles to apply after the current settings and arrange them in order.\n"
+		"Only their naming pattern, find/replace, case conversion and increment are used.",
+		"Chain Profiles",
+		order,
+		items);
+
+	if (dialog.ShowModal() != wxID_OK)
+	{
+		UpdateStatusBar("Profile chain unchanged.");
+		return;
+	}
+
+	wxConfigBase *cfg = wxConfigBase::Get();
+	if (!cfg)
+	{
+		wxLogError("OnChainProfiles: wxConfigBase::Get() returned nullptr.");
+		UpdateStatusBar("Error: Configuration system not available.");
+		wxMessageBox("Cannot chain profiles. Configuration system error.", "Chain Error", wxOK | wxICON_ERROR, this);
+		return;
+	}
+
+	std::vector<RuleStep> steps;
+	wxArrayString names;
+	for (int position : dialog.GetOrder())
+	{
+		if (position < 0)
+		{
+			continue; // Unchecked
+		}
+		const wxString &name = items[position];
+		cfg->SetPath("/Profiles/" + name);
+		RuleStep step;
+		step.namingPattern = cfg->Read("NamingPattern", wxEmptyString).ToStdString();
+		step.findText = cfg->Read("FindText", wxEmptyString).ToStdString();
+		step.replaceText = cfg->Read("ReplaceText", wxEmptyString).ToStdString();
+		step.findCaseSensitive = cfg->ReadBool("FindCaseSensitive", true);
+		step.findUseRegex = cfg->ReadBool("FindUseRegex", false);
+		long caseSelection = cfg->ReadLong("CaseConversion", 0);
+		if (caseSelection == 1)
+			step.caseConversionMode = CaseConversionMode::ToUpper;
+		else if (caseSelection == 2)
+			step.caseConversionMode = CaseConversionMode::ToLower;
+		step.increment = static_cast<int>(cfg->ReadLong("Increment", 0));
+		steps.push_back(std::move(step));
+		names.Add(name);
+	}
+	cfg->SetPath("/"); // Reset config path
+
+	m_ruleChain = std::move(steps);
+	m_ruleChainNames = names;
+
+	// The current preview no longer reflects the chain
+	renameButton->Enable(false);
+	m_previewSuccess = false;
+
+	if (m_ruleChainNames.IsEmpty())
+	{
+		UpdateStatusBar("Profile chain cleared.");
+		logTextCtrl->AppendText("Profile chain cleared.\n");
+	}
+	else
+	{
+		wxString chain;
+		for (const wxString &name : m_ruleChainNames)
+		{
+			chain += (chain.IsEmpty() ? "" : " -> ") + name;
+		}
+		UpdateStatusBar("Profile chain: " + chain);
+		logTextCtrl->AppendText("Profile chain set: " + chain + ". Preview again to apply it.\n");
+	}
+}
@@ -42,15 +42,26 @@ void MainFrame::LoadSettings()
 	// Spin control defaults match their creation values if config entries are absent
 	lowestNumSpin->SetValue(cfg->ReadLong("/Inputs/LowestNum", 0));
 	highestNumSpin->SetValue(cfg->ReadLong("/Inputs/HighestNum", 0));
+	resequenceChoice->SetSelection(cfg->ReadLong("/Inputs/Resequence", 0));
 	recursiveCheck->SetValue(cfg->ReadBool("/Inputs/RecursiveScan", false));
+	excludePatternsCtrl->SetValue(cfg->Read("/Inputs/ExcludePatterns", wxEmptyString));
+	skipHiddenCheck->SetValue(cfg->ReadBool("/Inputs/SkipHiddenDirs", false));
+	renameFoldersCheck->SetValue(cfg->ReadBool("/Inputs/RenameFolders", false));
+	maxDepthSpin->SetValue(cfg->ReadLong("/Inputs/MaxScanDepth", 0));
 
+	sourcePatternCtrl->SetValue(cfg->Read("/Inputs/SourcePattern", wxEmptyString));
 	patternCtrl->SetValue(cfg->Read("/Inputs/NamingPattern", "<orig_name><ext>"));
 	findCtrl->SetValue(cfg->Read("/Inputs/FindText", wxEmptyString));
 	replaceCtrl->SetValue(cfg->Read("/Inputs/ReplaceText", wxEmptyString));
 	caseSensitiveCheck->SetValue(cfg->ReadBool("/Inputs/FindCaseSensitive", true)); // Default to case-sensitive find
 	caseChoice->SetSelection(cfg->ReadLong("/Inputs/CaseConversion", 0));			// Default to "No Change"
 	incrementSpin->SetValue(cfg->ReadLong("/Inputs/Increment", 1));
+	conflictSuffixCtrl->SetValue(cfg->Read("/Inputs/ConflictSuffix", wxEmptyString));
+	subfolderCheck->SetValue(cfg->ReadBool("/Inputs/AllowSubfolders", false));
 	backupCheck->SetValue(cfg->ReadBool("/Inputs/Backup", false)); // Default to backup disabled
+	wxString rulesError; // Rules and tables saved by this build always parse
+	SetRoutedRules(cfg->Read("/Inputs/RoutedRules", wxEmptyString), rulesError);
+	SetReplacementTable(cfg->Read("/Inputs/ReplacementTable", wxEmptyString), rulesError);
 }
 
 // Saves current application settings (window position/size, input values) to config
@@ -75,15 +86,25 @@ void MainFrame::SaveSettings()
 	cfg->Write("/Inputs/FilenamePattern", fileNamePatternCtrl->GetValue());
 	cfg->Write("/Inputs/FilterExtensions", filterExtensionsCtrl->GetValue());
 	cfg->Write("/Inputs/HighestNum", (long)highestNumSpin->GetValue());
+	cfg->Write("/Inputs/Resequence", (long)resequenceChoice->GetSelection());
 	cfg->Write("/Inputs/LowestNum", (long)lowestNumSpin->GetValue());
 	cfg->Write("/Inputs/RecursiveScan", recursiveCheck->IsChecked());
+	cfg->Write("/Inputs/ExcludePatterns", excludePatternsCtrl->GetValue());
+	cfg->Write("/Inputs/SkipHiddenDirs", skipHiddenCheck->IsChecked());
+	cfg->Write("/Inputs/RenameFolders", renameFoldersCheck->IsChecked());
+	cfg->Write("/Inputs/MaxScanDepth", (long)maxDepthSpin->GetValue());
+	cfg->Write("/Inputs/SourcePattern", sourcePatternCtrl->GetValue());
 	cfg->Write("/Inputs/NamingPattern", patternCtrl->GetValue());
 	cfg->Write("/Inputs/FindText", findCtrl->GetValue());
 	cfg->Write("/Inputs/ReplaceText", replaceCtrl->GetValue());
 	cfg->Write("/Inputs/FindCaseSensitive", caseSensitiveCheck->IsChecked());
 	cfg->Write("/Inputs/CaseConversion", (long)caseChoice->GetSelection());
 	cfg->Write("/Inputs/Increment", (long)incrementSpin->GetValue());
+	cfg->Write("/Inputs/ConflictSuffix", conflictSuffixCtrl->GetValue());
+	cfg->Write("/Inputs/AllowSubfolders", subfolderCheck->IsChecked());
 	cfg->Write("/Inputs/Backup", backupCheck->IsChecked());
+	cfg->Write("/Inputs/RoutedRules", m_routedRulesText);
+	cfg->Write("/Inputs/ReplacementTable", m_replacementTableText);
 
 	// Explicitly flush changes to ensure they are written to persistent storage
 	cfg->Flush();
@@ -49,29 +49,30 @@ void MainFrame::OnPreviewThreadComplete(wxCommandEvent &event) {
   m_previewSuccess = results->success;
   delete results; // Delete the heap-allocated data received from the thread
 
-  // Log messages from the results structure
-  for (const auto &msg : m_lastPreviewResults.generalInfoLog) {
-    logTextCtrl->AppendText("Info: " + wxString(msg) + "\n");
-  }
-  logTextCtrl->SetDefaultStyle(warningStyle);
-  for (const auto &msg : m_lastPreviewResults.warningLog) {
-    logTextCtrl->AppendText("Warning: " + wxString(msg) + "\n");
-  }
-  logTextCtrl->SetDefaultStyle(normalStyle);
-  for (const auto &msg : m_lastPreviewResults.missingSourceFilesLog) {
-    logTextCtrl->AppendText("Skipped/Missing: " + wxString(msg) + "\n");
-  }
-  logTextCtrl->SetDefaultStyle(warningStyle);
-  for (const auto &po : m_lastPreviewResults.potentialOverwritesLog) {
-    logTextCtrl->AppendText(
-        "Potential Overwrite: Skipped renaming '" + wxString(po.SourceFile) +
-        "' to '" + wxString(po.TargetFile) +
-        "' because target path exists and is not part of this rename batch.\n");
-  }
-  logTextCtrl->SetDefaultStyle(redStyle);
-  for (const auto &msg : m_lastPreviewResults.errorLog) {
-    logTextCtrl->AppendText("Error: " + wxString(msg) + "\n");
-  }
+  // Log messages from the results structure; text is only formatted here,
+  // and categories over their cap report how many messages were dropped
+  const Diagnostics &diagnostics = m_lastPreviewResults.diagnostics;
+  auto logCategory = [&](DiagCategory category, const wxString &prefix,
+                         const wxTextAttr &style) {
+    logTextCtrl->SetDefaultStyle(style);
+    for (const auto &record : diagnostics.records(category)) {
+      logTextCtrl->AppendText(
+          prefix +
+          wxString(diagnostics.format(record, m_lastPreviewResults.renamePlan)) +
+          "\n");
+    }
+    if (diagnostics.dropped(category) > 0) {
+      logTextCtrl->AppendText(
+          prefix +
+          wxString::Format("... %lu more message(s) not shown.\n",
+                           (unsigned long)diagnostics.dropped(category)));
+    }
+  };
+  logCategory(DiagCategory::Info, "Info: ", normalStyle);
+  logCategory(DiagCategory::Warning, "Warning: ", warningStyle);
+  logCategory(DiagCategory::Skipped, "Skipped/Missing: ", normalStyle);
+  logCategory(DiagCategory::Overwrite, "Potential Overwrite: ", warningStyle);
+  logCategory(DiagCategory::Error, "Error: ", redStyle);
   logTextCtrl->SetDefaultStyle(normalStyle);
 
   // Clear the preview list (and any associated item data from Manual mode's
@@ -158,10 +159,7 @@ void MainFrame::OnPreviewThreadComplete(wxCommandEvent &event) {
       UpdateStatusBar("Preview: No files eligible for rename.");
       // Show an info box only if there were no errors/warnings at all,
       // otherwise a warning
-      if (m_lastPreviewResults.errorLog.empty() &&
-          m_lastPreviewResults.warningLog.empty() &&
-          m_lastPreviewResults.missingSourceFilesLog.empty() &&
-          m_lastPreviewResults.potentialOverwritesLog.empty()) {
+      if (!m_lastPreviewResults.diagnostics.hasIssues()) {
         wxMessageBox("No files were found matching the specified criteria or "
                      "no renames are necessary.",
                      "Preview Information", wxOK | wxICON_INFORMATION, this);
@@ -42,6 +42,8 @@ void MainFrame::UpdateStatusBar(const wxString &text)
 // Resets the background color of input controls to their default, clearing any error highlighting
 void MainFrame::ResetInputBackgrounds()
 {
+	sourcePatternCtrl->SetBackgroundColour(m_defaultTextCtrlBgColour);
+	sourcePatternCtrl->Refresh();
 	patternCtrl->SetBackgroundColour(m_defaultTextCtrlBgColour);
 	patternCtrl->Refresh();
 	findCtrl->SetBackgroundColour(m_defaultTextCtrlBgColour);
@@ -84,7 +86,15 @@ void MainFrame::UpdateUIForMode()
 	lowestNumLabel->Show(isDirScan);
 	highestNumSpin->Show(isDirScan);
 	highestNumLabel->Show(isDirScan);
+	resequenceChoice->Show(isDirScan);
+	resequenceLabel->Show(isDirScan);
 	recursiveCheck->Show(isDirScan);
+	excludePatternsCtrl->Show(isDirScan);
+	excludePatternsLabel->Show(isDirScan);
+	skipHiddenCheck->Show(isDirScan);
+	renameFoldersCheck->Show(isDirScan);
+	maxDepthSpin->Show(isDirScan);
+	maxDepthLabel->Show(isDirScan);
 
 	addFilesButton->Show(!isDirScan);
 	removeFilesButton->Show(!isDirScan);
@@ -125,7 +135,12 @@ void MainFrame::UpdateUIForMode()
 		filterExtensionsCtrl->SetValue("");
 		lowestNumSpin->SetValue(0);
 		highestNumSpin->SetValue(0);
+		resequenceChoice->SetSelection(0);
 		recursiveCheck->SetValue(false);
+		excludePatternsCtrl->SetValue("");
+		skipHiddenCheck->SetValue(false);
+		renameFoldersCheck->SetValue(false);
+		maxDepthSpin->SetValue(0);
 		PopulateManualPreviewList(); // Rebuild list from m_manualFiles (which may be empty)
 	}
 	else
@@ -212,7 +227,12 @@ void MainFrame::SetUIBusy(bool busy)
 	filterExtensionsCtrl->Enable(enable && isDirScan);
 	highestNumSpin->Enable(enable && isDirScan);
 	lowestNumSpin->Enable(enable && isDirScan);
+	resequenceChoice->Enable(enable && isDirScan);
 	recursiveCheck->Enable(enable && isDirScan);
+	excludePatternsCtrl->Enable(enable && isDirScan);
+	skipHiddenCheck->Enable(enable && isDirScan);
+	renameFoldersCheck->Enable(enable && isDirScan);
+	maxDepthSpin->Enable(enable && isDirScan);
 
 	// Manual Selection Controls
 	addFilesButton->Enable(enable && !isDirScan);
@@ -221,12 +241,15 @@ void MainFrame::SetUIBusy(bool busy)
 	clearFilesButton->Enable(enable && !isDirScan && hasManualItems);
 
 	// Common Controls
+	sourcePatternCtrl->Enable(enable);
 	patternCtrl->Enable(enable);
 	findCtrl->Enable(enable);
 	replaceCtrl->Enable(enable);
 	caseSensitiveCheck->Enable(enable);
 	caseChoice->Enable(enable);
 	incrementSpin->Enable(enable);
+	conflictSuffixCtrl->Enable(enable);
+	subfolderCheck->Enable(enable);
 	backupCheck->Enable(enable);
 
 	// Action Buttons
@@ -244,6 +267,9 @@ void MainFrame::SetUIBusy(bool busy)
 		menuBar->Enable(ID_SaveProfile, enable);
 		menuBar->Enable(ID_LoadProfile, enable);
 		menuBar->Enable(ID_DeleteProfile, enable);
+		menuBar->Enable(ID_ChainProfiles, enable);
+		menuBar->Enable(ID_RoutingRules, enable);
+		menuBar->Enable(ID_ReplacementTable, enable);
 		// Undo menu item state depends on undo availability AND not being busy
 		menuBar->Enable(ID_UndoRename, enable && m_undoAvailable);
 	}
@@ -112,7 +112,7 @@ wxThread::ExitCode WorkerThread::Entry()
             }
             if (results->backupResult.success)
             {
-                results->renameResult = RenamerLogic::performRename(m_renamePlan, m_increment);
+                results->renameResult = RenamerLogic::performRename(m_renamePlan, m_increment, DefaultFileSystem(), RenamerLogic::getMoveJournalPath());
             }
             else
             {
@@ -128,7 +128,7 @@ wxThread::ExitCode WorkerThread::Entry()
         else if (m_task == WorkerTask::UNDO_RENAME) // << Handle Undo Task
         {
             UndoResult *results = new UndoResult();
-            *results = RenamerLogic::performUndo(m_undoOperations); // Pass vector by value
+            *results = RenamerLogic::performUndo(m_undoOperations, DefaultFileSystem(), RenamerLogic::getMoveJournalPath()); // Pass vector by value
             if (TestDestroy())
             {
                 delete results;
@@ -147,7 +147,7 @@ wxThread::ExitCode WorkerThread::Entry()
         {
             OutputResults *errRes = new OutputResults();
             errRes->success = false;
-            errRes->errorLog.push_back("FATAL EXCEPTION (Preview): " + std::string(e.what()));
+            errRes->diagnostics.add(DiagCode::PreviewException, e.what());
             PostResultEvent(EVT_PREVIEW_COMPLETE, errRes);
         }
         else if (m_task == WorkerTask::PERFORM_RENAME)
@@ -177,7 +177,7 @@ wxThread::ExitCode WorkerThread::Entry()
         {
             OutputResults *errRes = new OutputResults();
             errRes->success = false;
-            errRes->errorLog.push_back("FATAL UNKNOWN EXCEPTION (Preview)");
+            errRes->diagnostics.add(DiagCode::PreviewUnknownException);
             PostResultEvent(EVT_PREVIEW_COMPLETE, errRes);
         }
         else if (m_task == WorkerTask::PERFORM_RENAME)
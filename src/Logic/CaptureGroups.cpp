@@ -0,0 +1,167 @@
+#include "CaptureGroups.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+// Placeholders ReplacePlaceholders expands; a named group may not hide one
+constexpr std::string_view BuiltInPlaceholders[] = {
+    "num", "orig_num", "orig_name", "ext", "orig_ext", "index", "parent_dir",
+    "file_size", "file_size_kb", "modified_date", "exif_date", "exif_time",
+    "YYYY", "MM", "DD", "hh", "mm", "ss"};
+
+bool IsNameStart(char c) {
+  return std::isalpha(static_cast<unsigned char>(c)) || c == '_';
+}
+
+bool IsNameChar(char c) {
+  return std::isalnum(static_cast<unsigned char>(c)) || c == '_';
+}
+} // namespace
+
+std::optional<CaptureRegex> CaptureRegex::Compile(std::string_view pattern,
+                                                  bool caseSensitive,
+                                                  std::string &error) {
+  error.clear();
+  CaptureRegex compiled;
+  // Copy the pattern, numbering capturing groups and turning (?<name> into (
+  std::string ecmaPattern;
+  ecmaPattern.reserve(pattern.size());
+  bool inClass = false;
+  for (std::size_t i = 0; i < pattern.size(); ++i) {
+    const char c = pattern[i];
+    if (c == '\\' && i + 1 < pattern.size()) {
+      ecmaPattern += c;
+      ecmaPattern += pattern[++i];
+      continue;
+    }
+    if (inClass) {
+      inClass = c != ']';
+      ecmaPattern += c;
+      continue;
+    }
+    if (c == '[') {
+      inClass = true;
+    } else if (c == '(') {
+      if (pattern.substr(i + 1, 2) == "?<" && i + 3 < pattern.size() &&
+          IsNameStart(pattern[i + 3])) {
+        const std::size_t nameStart = i + 3;
+        std::size_t nameEnd = nameStart;
+        while (nameEnd < pattern.size() && IsNameChar(pattern[nameEnd])) {
+          ++nameEnd;
+        }
+        if (nameEnd >= pattern.size() || pattern[nameEnd] != '>') {
+          error = "Invalid group name in source pattern.";
+          return std::nullopt;
+        }
+        const std::string_view name =
+            pattern.substr(nameStart, nameEnd - nameStart);
+        if (std::find(std::begin(BuiltInPlaceholders),
+                      std::end(BuiltInPlaceholders),
+                      name) != std::end(BuiltInPlaceholders)) {
+          error = "Group name '" + std::string(name) +
+                  "' is already a placeholder.";
+          return std::nullopt;
+        }
+        if (compiled.groupIndex(name) >= 0) {
+          error = "Group name '" + std::string(name) + "' is used twice.";
+          return std::nullopt;
+        }
+        compiled.m_names.emplace_back(name, ++compiled.m_groupCount);
+        ecmaPattern += '(';
+        i = nameEnd;
+        continue;
+      }
+      if (pattern.substr(i + 1, 1) != "?") {
+        ++compiled.m_groupCount;
+      }
+    }
+    ecmaPattern += c;
+  }
+
+  try {
+    std::regex::flag_type flags = std::regex::ECMAScript | std::regex::optimize;
+    if (!caseSensitive) {
+      flags |= std::regex::icase;
+    }
+    compiled.m_regex.assign(ecmaPattern, flags);
+  } catch (const std::regex_error &e) {
+    error = e.what();
+    return std::nullopt;
+  }
+  return compiled;
+}
+
+bool CaptureRegex::match(std::string_view subject, std::cmatch &groups) const {
+  return std::regex_search(subject.data(), subject.data() + subject.size(),
+                           groups, m_regex);
+}
+
+int CaptureRegex::groupIndex(std::string_view name) const {
+  for (const auto &entry : m_names) {
+    if (entry.first == name) {
+      return entry.second;
+    }
+  }
+  return -1;
+}
+
+CaptureTemplate::CaptureTemplate(std::string pattern,
+                                 const CaptureRegex &regex)
+    : m_pattern(std::move(pattern)) {
+  std::size_t literalStart = 0;
+  std::size_t pos = 0;
+  while ((pos = m_pattern.find('<', pos)) != std::string::npos) {
+    const std::size_t close = m_pattern.find('>', pos + 1);
+    if (close == std::string::npos) {
+      break;
+    }
+    const std::string_view reference =
+        std::string_view(m_pattern).substr(pos + 1, close - pos - 1);
+    int group = -1;
+    if (!reference.empty() && reference.size() <= 3 &&
+        std::all_of(reference.begin(), reference.end(), [](char c) {
+          return std::isdigit(static_cast<unsigned char>(c));
+        })) {
+      int number = 0;
+      for (char digit : reference) {
+        number = number * 10 + (digit - '0');
+      }
+      if (number >= 1 &&
+          static_cast<std::size_t>(number) <= regex.groupCount()) {
+        group = number;
+      }
+    } else {
+      group = regex.groupIndex(reference);
+    }
+    if (group < 0) {
+      pos = pos + 1; // Not a group reference; leave it for later stages
+      continue;
+    }
+    if (pos > literalStart) {
+      m_segments.push_back({literalStart, pos - literalStart, -1});
+    }
+    m_segments.push_back({0, 0, group});
+    m_referencesGroups = true;
+    pos = literalStart = close + 1;
+  }
+  if (literalStart < m_pattern.size()) {
+    m_segments.push_back({literalStart, m_pattern.size() - literalStart, -1});
+  }
+}
+
+std::string CaptureTemplate::expand(const std::cmatch &groups) const {
+  std::string result;
+  result.reserve(m_pattern.size() + 32);
+  for (const Segment &segment : m_segments) {
+    if (segment.group < 0) {
+      result.append(m_pattern, segment.offset, segment.length);
+    } else if (static_cast<std::size_t>(segment.group) < groups.size() &&
+               groups[segment.group].matched) {
+      const std::csub_match &span = groups[segment.group];
+      result.append(span.first, span.second);
+    }
+  }
+  return result;
+}
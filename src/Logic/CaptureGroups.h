@@ -0,0 +1,61 @@
+#ifndef CAPTUREGROUPS_H
+#define CAPTUREGROUPS_H
+
+#include <cstddef>
+#include <optional>
+#include <regex>
+#include <string>
+#include <string_view>
+#include <utility>
+#include <vector>
+
+// Source-name regex whose capture groups naming patterns can reference as
+// <1>, <2>, ... or, for (?<name>...) groups, as <name>. std::regex has no
+// named groups, so names are recorded and stripped before compiling
+class CaptureRegex {
+public:
+  // Compiles 'pattern' once for a whole plan. Returns nullopt with a message
+  // in 'error' if it is invalid or a group name shadows a built-in
+  // placeholder such as <num>
+  static std::optional<CaptureRegex>
+  Compile(std::string_view pattern, bool caseSensitive, std::string &error);
+
+  // Finds the first match in 'subject'; 'groups' refers into 'subject'
+  bool match(std::string_view subject, std::cmatch &groups) const;
+
+  std::size_t groupCount() const { return m_groupCount; }
+  // Group number of a named group, or -1
+  int groupIndex(std::string_view name) const;
+
+private:
+  CaptureRegex() = default;
+
+  std::regex m_regex;
+  std::vector<std::pair<std::string, int>> m_names;
+  std::size_t m_groupCount = 0;
+};
+
+// A naming pattern split once per plan into literal runs and references to
+// the groups of a CaptureRegex. Expanding it appends each literal and each
+// matched span straight into the result, without copying out the groups.
+// References to groups the regex doesn't have are kept as literal text
+class CaptureTemplate {
+public:
+  CaptureTemplate(std::string pattern, const CaptureRegex &regex);
+
+  bool referencesGroups() const { return m_referencesGroups; }
+  std::string expand(const std::cmatch &groups) const;
+
+private:
+  struct Segment {
+    std::size_t offset = 0; // Literal text in m_pattern
+    std::size_t length = 0;
+    int group = -1; // Group reference instead of literal text if >= 0
+  };
+
+  std::string m_pattern;
+  std::vector<Segment> m_segments;
+  bool m_referencesGroups = false;
+};
+
+#endif // CAPTUREGROUPS_H
@@ -0,0 +1,99 @@
+#include "ConcurrencyLimiter.h"
+
+#include <algorithm>
+#include <map>
+#include <memory>
+#include <tuple>
+#include <typeindex>
+#include <typeinfo>
+
+ConcurrencyLimiter::ConcurrencyLimiter(unsigned initial, unsigned minimum,
+                                       unsigned maximum)
+    : m_minimum(std::max(1u, minimum)),
+      m_maximum(std::max(std::max(1u, minimum), maximum)) {
+  m_limit = std::clamp(initial, m_minimum, m_maximum);
+}
+
+void ConcurrencyLimiter::acquire() {
+  std::unique_lock<std::mutex> lock(m_mutex);
+  m_slotFree.wait(lock, [this] { return m_inFlight < m_limit; });
+  ++m_inFlight;
+}
+
+void ConcurrencyLimiter::release(std::chrono::nanoseconds latency,
+                                 bool failed) {
+  unsigned before, after;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    --m_inFlight;
+    before = m_limit;
+    m_windowNs += static_cast<double>(latency.count());
+    m_windowFailed = m_windowFailed || failed;
+    if (++m_windowCount >= m_limit) {
+      adjust();
+    }
+    after = m_limit;
+  }
+  if (after > before) {
+    m_slotFree.notify_all();
+  } else {
+    m_slotFree.notify_one();
+  }
+}
+
+unsigned ConcurrencyLimiter::limit() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_limit;
+}
+
+void ConcurrencyLimiter::adjust() {
+  const double average = m_windowNs / m_windowCount;
+  if (m_baselineNs == 0 || average < m_baselineNs) {
+    m_baselineNs = average;
+  }
+  if (m_windowFailed || average > m_baselineNs * Tolerance) {
+    m_limit = std::max(m_minimum, std::min(m_limit - 1, m_limit * 3 / 4));
+  } else if (m_limit < m_maximum) {
+    ++m_limit;
+  }
+  m_baselineNs *= BaselineDrift;
+  m_windowNs = 0;
+  m_windowCount = 0;
+  m_windowFailed = false;
+}
+
+ConcurrencyLimiter &DeviceConcurrency(FileSystem &fileSystem,
+                                      const fs::path &path, IoClass ioClass) {
+  // Backend type, device, class. Keyed by type rather than instance, so a
+  // fresh overlay per preview adds no limiters
+  using Key = std::tuple<std::type_index, std::uint64_t, IoClass>;
+  // Never freed: limiters outlive every operation that may still hold one
+  static std::mutex registryMutex;
+  static auto *limiters =
+      new std::map<Key, std::unique_ptr<ConcurrencyLimiter>>();
+
+  // The nearest existing ancestor decides the device; a target may not exist
+  // yet
+  std::uint64_t device = UINT64_MAX;
+  for (fs::path current = path; !current.empty();) {
+    std::error_code ec;
+    FileIdentity id = fileSystem.identity(current, ec);
+    if (!ec) {
+      device = id.device;
+      break;
+    }
+    fs::path parent = current.parent_path();
+    if (parent == current) {
+      break;
+    }
+    current = std::move(parent);
+  }
+
+  std::lock_guard<std::mutex> lock(registryMutex);
+  std::unique_ptr<ConcurrencyLimiter> &limiter =
+      (*limiters)[Key(typeid(fileSystem), device, ioClass)];
+  if (!limiter) {
+    limiter = std::make_unique<ConcurrencyLimiter>();
+  }
+  return *limiter;
+}
@@ -0,0 +1,67 @@
+#ifndef CONCURRENCYLIMITER_H
+#define CONCURRENCYLIMITER_H
+
+#include "FileSystem.h"
+
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+
+// Caps how many operations run at once against one device and tunes the cap
+// while they run (additive increase, multiplicative decrease). Each window of
+// 'limit' completions is compared with the fastest window seen: while latency
+// stays close to it the device has headroom and the limit grows by one; once
+// it climbs, requests are queueing in the device and the limit drops by a
+// quarter. A fast SSD settles high, a disk or network share low
+class ConcurrencyLimiter {
+public:
+  ConcurrencyLimiter(unsigned initial = 4, unsigned minimum = 1,
+                     unsigned maximum = 64);
+
+  // Blocks until fewer than limit() operations are in flight
+  void acquire();
+  // Ends an operation started by acquire(). A failed operation counts as a
+  // sign of overload whatever its latency
+  void release(std::chrono::nanoseconds latency, bool failed = false);
+
+  unsigned limit() const;
+  unsigned maximum() const { return m_maximum; }
+
+private:
+  // Latency within this factor of the baseline still counts as unloaded
+  static constexpr double Tolerance = 2.0;
+  // The baseline drifts up this much per window, so a device that has become
+  // slower for good is relearned rather than throttled forever
+  static constexpr double BaselineDrift = 1.02;
+
+  void adjust(); // At the end of a window, with m_mutex held
+
+  mutable std::mutex m_mutex;
+  std::condition_variable m_slotFree;
+  unsigned m_limit;
+  const unsigned m_minimum;
+  const unsigned m_maximum;
+  unsigned m_inFlight = 0;
+  double m_baselineNs = 0; // Fastest window average, 0 until one ends
+  double m_windowNs = 0;   // Total latency of the current window
+  unsigned m_windowCount = 0;
+  bool m_windowFailed = false;
+};
+
+// Kinds of operation whose latencies are too far apart to share a baseline
+enum class IoClass {
+  Metadata, // Stats, folder creation and renames
+  Read,     // Reading file content: hashes and media headers
+  Copy      // Copying whole files to another device
+};
+
+// The limiter shared by every 'ioClass' operation on the device holding
+// 'path', so what one preview learns about a device carries over to the next
+// and to the renames that follow. Each backend type keeps its own limiters:
+// calls an overlay or an in-memory backend answers from memory must not set
+// the baseline for the disk. Paths whose device can't be told share one
+// limiter per class
+ConcurrencyLimiter &DeviceConcurrency(FileSystem &fileSystem,
+                                      const fs::path &path, IoClass ioClass);
+
+#endif // CONCURRENCYLIMITER_H
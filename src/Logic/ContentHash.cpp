@@ -0,0 +1,179 @@
+#include "ContentHash.h"
+
+#include <algorithm>
+#include <cctype>
+#include <cstring>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+constexpr std::uint64_t Prime1 = 0x9E3779B185EBCA87ull;
+constexpr std::uint64_t Prime2 = 0xC2B2AE3D27D4EB4Full;
+constexpr std::uint64_t Prime3 = 0x165667B19E3779F9ull;
+constexpr std::uint64_t Prime4 = 0x85EBCA77C2B2AE63ull;
+constexpr std::uint64_t Prime5 = 0x27D4EB2F165667C5ull;
+constexpr std::size_t StripeSize = 32;
+constexpr std::string_view HashTag = "<hash:";
+
+inline std::uint64_t Rotl(std::uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+
+// Little-endian loads; memcpy compiles to a single unaligned move
+inline std::uint64_t Read64(const unsigned char *p) {
+  std::uint64_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline std::uint32_t Read32(const unsigned char *p) {
+  std::uint32_t value;
+  std::memcpy(&value, p, sizeof(value));
+  return value;
+}
+
+inline std::uint64_t Round(std::uint64_t acc, std::uint64_t input) {
+  acc += input * Prime2;
+  acc = Rotl(acc, 31);
+  return acc * Prime1;
+}
+
+inline std::uint64_t MergeRound(std::uint64_t acc, std::uint64_t value) {
+  acc ^= Round(0, value);
+  return acc * Prime1 + Prime4;
+}
+
+// Consumes whole 32-byte stripes, one 8-byte word per lane
+inline void ConsumeStripes(std::array<std::uint64_t, 4> &lanes,
+                           const unsigned char *p, std::size_t stripes) {
+  std::uint64_t v1 = lanes[0], v2 = lanes[1], v3 = lanes[2], v4 = lanes[3];
+  for (std::size_t i = 0; i < stripes; ++i, p += StripeSize) {
+    v1 = Round(v1, Read64(p));
+    v2 = Round(v2, Read64(p + 8));
+    v3 = Round(v3, Read64(p + 16));
+    v4 = Round(v4, Read64(p + 24));
+  }
+  lanes = {v1, v2, v3, v4};
+}
+} // namespace
+
+ContentHasher::ContentHasher(std::uint64_t seed)
+    : m_seed(seed),
+      m_lanes{seed + Prime1 + Prime2, seed + Prime2, seed, seed - Prime1} {}
+
+void ContentHasher::update(std::string_view data) {
+  const unsigned char *p = reinterpret_cast<const unsigned char *>(data.data());
+  std::size_t length = data.size();
+  m_totalLength += length;
+
+  if (m_buffered > 0) {
+    const std::size_t take = std::min(length, StripeSize - m_buffered);
+    std::memcpy(m_buffer.data() + m_buffered, p, take);
+    m_buffered += take;
+    p += take;
+    length -= take;
+    if (m_buffered < StripeSize) {
+      return;
+    }
+    ConsumeStripes(m_lanes, m_buffer.data(), 1);
+    m_buffered = 0;
+  }
+
+  const std::size_t stripes = length / StripeSize;
+  ConsumeStripes(m_lanes, p, stripes);
+  p += stripes * StripeSize;
+  length -= stripes * StripeSize;
+
+  std::memcpy(m_buffer.data(), p, length);
+  m_buffered = length;
+}
+
+std::uint64_t ContentHasher::digest() const {
+  std::uint64_t h;
+  if (m_totalLength >= StripeSize) {
+    h = Rotl(m_lanes[0], 1) + Rotl(m_lanes[1], 7) + Rotl(m_lanes[2], 12) +
+        Rotl(m_lanes[3], 18);
+    for (std::uint64_t lane : m_lanes) {
+      h = MergeRound(h, lane);
+    }
+  } else {
+    h = m_seed + Prime5;
+  }
+  h += m_totalLength;
+
+  const unsigned char *p = m_buffer.data();
+  std::size_t remaining = m_buffered;
+  for (; remaining >= 8; remaining -= 8, p += 8) {
+    h ^= Round(0, Read64(p));
+    h = Rotl(h, 27) * Prime1 + Prime4;
+  }
+  if (remaining >= 4) {
+    h ^= static_cast<std::uint64_t>(Read32(p)) * Prime1;
+    h = Rotl(h, 23) * Prime2 + Prime3;
+    remaining -= 4;
+    p += 4;
+  }
+  for (; remaining > 0; --remaining, ++p) {
+    h ^= *p * Prime5;
+    h = Rotl(h, 11) * Prime1;
+  }
+
+  h ^= h >> 33;
+  h *= Prime2;
+  h ^= h >> 29;
+  h *= Prime3;
+  h ^= h >> 32;
+  return h;
+}
+
+std::uint64_t HashFileContent(FileSystem &fileSystem, const fs::path &p,
+                              std::error_code &ec) {
+  ContentHasher hasher;
+  fileSystem.readContent(
+      p, [&](std::string_view chunk) { hasher.update(chunk); }, ec);
+  return ec ? 0 : hasher.digest();
+}
+
+// Same shape as ExpandRandomPlaceholders: one pass, and text that only looks
+// like a placeholder is copied unchanged
+std::string ExpandHashPlaceholders(std::string_view pattern,
+                                   std::uint64_t hash) {
+  static constexpr char HexDigits[] = "0123456789abcdef";
+  char hex[MaxHashChars];
+  for (int i = MaxHashChars - 1; i >= 0; --i, hash >>= 4) {
+    hex[i] = HexDigits[hash & 0xF];
+  }
+
+  std::string result;
+  result.reserve(pattern.size() + MaxHashChars);
+  std::size_t pos = 0;
+  while (pos < pattern.size()) {
+    const std::size_t tag = pattern.find(HashTag, pos);
+    if (tag == std::string_view::npos) {
+      break;
+    }
+    std::size_t cursor = tag + HashTag.size();
+    int numChars = 0;
+    const std::size_t digitsBegin = cursor;
+    while (cursor < pattern.size() &&
+           std::isdigit(static_cast<unsigned char>(pattern[cursor]))) {
+      numChars = std::min(numChars * 10 + (pattern[cursor] - '0'),
+                          MaxHashChars); // A 64-bit hash has 16 digits
+      ++cursor;
+    }
+    if (cursor == digitsBegin || cursor >= pattern.size() ||
+        pattern[cursor] != '>') {
+      result.append(pattern, pos, cursor - pos); // Not a placeholder
+      pos = cursor;
+      continue;
+    }
+    result.append(pattern, pos, tag - pos);
+    result.append(hex, static_cast<std::size_t>(numChars));
+    pos = cursor + 1;
+  }
+  result.append(pattern, std::min(pos, pattern.size()));
+  return result;
+}
+
+bool ReferencesHash(std::string_view pattern) {
+  return pattern.find(HashTag) != std::string_view::npos;
+}
@@ -0,0 +1,44 @@
+#ifndef CONTENTHASH_H
+#define CONTENTHASH_H
+
+#include "FileSystem.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+// Streaming XXH64: a fast non-cryptographic hash whose four independent
+// accumulators keep the CPU's multipliers busy in parallel. Output matches
+// the reference implementation, so names stay stable across versions
+class ContentHasher {
+public:
+  explicit ContentHasher(std::uint64_t seed = 0);
+
+  void update(std::string_view data);
+  std::uint64_t digest() const;
+
+private:
+  std::uint64_t m_seed;
+  std::array<std::uint64_t, 4> m_lanes;
+  std::array<unsigned char, 32> m_buffer{}; // Partial stripe
+  std::size_t m_buffered = 0;
+  std::uint64_t m_totalLength = 0;
+};
+
+// Hashes the whole content of 'p' as read through 'fileSystem'
+std::uint64_t HashFileContent(FileSystem &fileSystem, const fs::path &p,
+                              std::error_code &ec);
+
+// Maximum number of hex digits a single <hash:N> produces
+constexpr int MaxHashChars = 16;
+
+// Replaces every <hash:N> in 'pattern' with the first N lowercase hex digits
+// of 'hash'
+std::string ExpandHashPlaceholders(std::string_view pattern,
+                                   std::uint64_t hash);
+bool ReferencesHash(std::string_view pattern);
+
+#endif // CONTENTHASH_H
@@ -0,0 +1,210 @@
+#include "CrossDeviceMove.h"
+#include "ConcurrencyLimiter.h"
+#include "ContentHash.h"
+#include "Parallel.h"
+
+#include <fstream>
+#include <iterator>
+#include <set>
+#include <string>
+#include <string_view>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+// Journal layout: the header line, then each move as three length-prefixed
+// UTF-8 paths ("<length> <bytes>\n"), so any character may appear in a name:
+// the source, the target and the temporary copy
+constexpr std::string_view JournalHeader = "RUMJ 2\n";
+
+void PutPath(std::string &out, const fs::path &p) {
+  const std::string text = p.u8string();
+  out += std::to_string(text.size());
+  out += ' ';
+  out += text;
+  out += '\n';
+}
+
+bool GetPath(std::string_view &in, fs::path &p) {
+  const std::size_t space = in.find(' ');
+  if (space == std::string_view::npos || space == 0) {
+    return false;
+  }
+  std::size_t length = 0;
+  for (char c : in.substr(0, space)) {
+    if (c < '0' || c > '9') {
+      return false;
+    }
+    length = length * 10 + static_cast<std::size_t>(c - '0');
+  }
+  in.remove_prefix(space + 1);
+  if (in.size() < length + 1 || in[length] != '\n') {
+    return false;
+  }
+  p = fs::u8path(std::string(in.substr(0, length)));
+  in.remove_prefix(length + 1);
+  return true;
+}
+
+// A free name for the copy next to 'target', like ParkingPath: ".partial",
+// then ".partial1", ... skipping names 'taken' by the rest of the batch
+fs::path TemporaryPath(const fs::path &target, FileSystem &fileSystem,
+                       std::set<fs::path> &taken) {
+  for (int attempt = 0;; ++attempt) {
+    fs::path temp = target;
+    temp += attempt == 0 ? ".partial" : ".partial" + std::to_string(attempt);
+    std::error_code ec;
+    if (taken.count(temp) == 0 &&
+        (!fileSystem.exists(temp, ec) || attempt >= 1000)) {
+      taken.insert(temp);
+      return temp;
+    }
+  }
+}
+
+// True if both files can be read and have the same size and content hash
+bool SameContent(FileSystem &fileSystem, const fs::path &a, const fs::path &b,
+                 std::string &error) {
+  std::error_code ec;
+  const std::uintmax_t sizeA = fileSystem.fileSize(a, ec);
+  const std::uintmax_t sizeB = ec ? 0 : fileSystem.fileSize(b, ec);
+  if (ec) {
+    error = "Could not check the copy's size: " + ec.message();
+    return false;
+  }
+  if (sizeA != sizeB) {
+    error = "The copy's size does not match the original.";
+    return false;
+  }
+  const std::uint64_t hashA = HashFileContent(fileSystem, a, ec);
+  const std::uint64_t hashB = ec ? 0 : HashFileContent(fileSystem, b, ec);
+  if (ec) {
+    error = "Could not verify the copy: " + ec.message();
+    return false;
+  }
+  if (hashA != hashB) {
+    error = "The copy's content does not match the original.";
+    return false;
+  }
+  return true;
+}
+
+// Runs one move; leaves the source untouched unless the whole move succeeded
+void MoveOne(CrossDeviceMove &move, const fs::path &temp,
+             FileSystem &fileSystem) {
+  std::error_code ec, cleanupEc;
+  // Created exclusively, so a file that took the name meanwhile is never
+  // replaced; a failed copy removes what it created itself
+  if (!fileSystem.copyFile(move.from, temp, CopyMode::CreateNew, ec)) {
+    move.error = "Could not copy to the target filesystem: " + ec.message();
+    return;
+  }
+  if (!SameContent(fileSystem, move.from, temp, move.error)) {
+    fileSystem.removeAll(temp, cleanupEc);
+    return;
+  }
+  fileSystem.rename(temp, move.to, ec);
+  if (ec) {
+    move.error = "Could not rename the copy into place: " + ec.message();
+    fileSystem.removeAll(temp, cleanupEc);
+    return;
+  }
+  fileSystem.removeAll(move.from, ec);
+  if (ec) {
+    // Keep the original rather than leave two copies behind
+    move.error = "Could not remove the original: " + ec.message();
+    fileSystem.removeAll(move.to, cleanupEc);
+  }
+}
+} // namespace
+
+void MoveAcrossDevices(std::vector<CrossDeviceMove> &moves,
+                       FileSystem &fileSystem, const fs::path &journalFile) {
+  if (moves.empty()) {
+    return;
+  }
+  std::set<fs::path> taken;
+  for (const CrossDeviceMove &move : moves) {
+    taken.insert(move.to);
+  }
+  std::vector<fs::path> temps;
+  temps.reserve(moves.size());
+  for (const CrossDeviceMove &move : moves) {
+    temps.push_back(TemporaryPath(move.to, fileSystem, taken));
+  }
+
+  bool journaled = false;
+  if (!journalFile.empty()) {
+    std::string journal(JournalHeader);
+    for (std::size_t i = 0; i < moves.size(); ++i) {
+      PutPath(journal, moves[i].from);
+      PutPath(journal, moves[i].to);
+      PutPath(journal, temps[i]);
+    }
+    std::error_code dirEc; // Reported by the write below if it matters
+    fs::create_directories(journalFile.parent_path(), dirEc);
+    std::ofstream out(journalFile, std::ios::binary | std::ios::trunc);
+    journaled =
+        out && out.write(journal.data(), journal.size()) && out.flush();
+    if (!journaled) {
+      for (CrossDeviceMove &move : moves) {
+        move.error = "Could not write the move journal (" +
+                     journalFile.string() + ").";
+      }
+      return; // Never move files the journal doesn't know about
+    }
+  }
+
+  // Each move is mostly waiting on the disks, so they overlap well, as far as
+  // the target device keeps up
+  ParallelFor(
+      moves.size(),
+      [&](std::size_t i) { MoveOne(moves[i], temps[i], fileSystem); },
+      DeviceConcurrency(fileSystem, moves.front().to, IoClass::Copy));
+
+  if (journaled) {
+    std::error_code removeEc;
+    fs::remove(journalFile, removeEc); // Every move reached a final state
+  }
+}
+
+std::size_t RecoverInterruptedMoves(const fs::path &journalFile,
+                                    FileSystem &fileSystem,
+                                    std::error_code &ec) {
+  ec.clear();
+  std::string journal;
+  {
+    std::ifstream in(journalFile, std::ios::binary);
+    if (!in) {
+      return 0; // Nothing was interrupted
+    }
+    journal.assign(std::istreambuf_iterator<char>(in),
+                   std::istreambuf_iterator<char>());
+  }
+
+  std::size_t completed = 0;
+  std::string_view rest(journal);
+  if (rest.substr(0, JournalHeader.size()) == JournalHeader) {
+    rest.remove_prefix(JournalHeader.size());
+    fs::path from, to, temp;
+    while (GetPath(rest, from) && GetPath(rest, to) && GetPath(rest, temp)) {
+      std::error_code moveEc;
+      // The journal names the copy's exact path, chosen free when written
+      fileSystem.removeAll(temp, moveEc);
+      // Both present means the copy was renamed into place but the original
+      // not yet removed; anything else is already consistent
+      std::string mismatch;
+      if (fileSystem.isRegularFile(from, moveEc) &&
+          fileSystem.isRegularFile(to, moveEc) &&
+          SameContent(fileSystem, from, to, mismatch)) {
+        fileSystem.removeAll(from, moveEc);
+        if (moveEc) {
+          ec = moveEc;
+          return completed; // Keep the journal for the next attempt
+        }
+        ++completed;
+      }
+    }
+  }
+  fs::remove(journalFile, ec);
+  return completed;
+}
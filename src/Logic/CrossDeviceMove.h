@@ -0,0 +1,39 @@
+#ifndef CROSSDEVICEMOVE_H
+#define CROSSDEVICEMOVE_H
+
+#include "FileSystem.h"
+
+#include <cstddef>
+#include <string>
+#include <vector>
+
+// A rename whose source and target are on different filesystems, which the
+// operating system refuses to rename in place
+struct CrossDeviceMove {
+  fs::path from;
+  fs::path to;
+  std::string error; // Empty once the move succeeded
+};
+
+// Moves each file by copying it next to its target under a temporary name no
+// other file has (".partial", ".partial1", ...), checking the copy's size and
+// content hash against the source, renaming it into place and only then
+// removing the source. A failed move leaves the source untouched and removes
+// the copy it made, never a file it didn't create. Files are copied in
+// parallel. When 'journalFile' is set, the moves and their temporary names
+// are recorded there before any data is copied and the journal is removed
+// once every move finished, so RecoverInterruptedMoves can tidy up after a
+// crash
+void MoveAcrossDevices(std::vector<CrossDeviceMove> &moves,
+                       FileSystem &fileSystem,
+                       const fs::path &journalFile = fs::path());
+
+// Finishes or rolls back the moves left in 'journalFile' by an interrupted
+// MoveAcrossDevices: temporary copies are removed, and a source whose target
+// holds an identical copy is removed. Returns the number of moves completed.
+// A missing journal is not an error
+std::size_t RecoverInterruptedMoves(const fs::path &journalFile,
+                                    FileSystem &fileSystem,
+                                    std::error_code &ec);
+
+#endif // CROSSDEVICEMOVE_H
@@ -0,0 +1,261 @@
+#include "Diagnostics.h"
+#include "RenamerLogic.h"
+
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+Diagnostics::Diagnostics(std::size_t capPerCategory) { setCap(capPerCategory); }
+
+void Diagnostics::setCap(std::size_t capPerCategory) {
+  m_caps.fill(capPerCategory);
+}
+
+void Diagnostics::setCap(DiagCategory category, std::size_t cap) {
+  m_caps[static_cast<std::size_t>(category)] = cap;
+}
+
+DiagnosticRecord *Diagnostics::push(DiagCode code) {
+  const std::size_t category = static_cast<std::size_t>(CategoryOf(code));
+  ++m_counts[category];
+  if (m_records[category].size() >= m_caps[category]) {
+    return nullptr; // Counted only
+  }
+  DiagnosticRecord &record = m_records[category].emplace_back();
+  record.code = code;
+  return &record;
+}
+
+void Diagnostics::add(DiagCode code, std::error_code error) {
+  if (DiagnosticRecord *record = push(code)) {
+    record->error = error;
+  }
+}
+
+void Diagnostics::add(DiagCode code, std::string_view subject,
+                      std::error_code error) {
+  if (DiagnosticRecord *record = push(code)) {
+    record->subject = static_cast<std::int32_t>(m_subjects.size());
+    m_subjects.emplace_back(subject);
+    record->error = error;
+  }
+}
+
+void Diagnostics::addPath(DiagCode code, const fs::path &subject,
+                          std::error_code error) {
+  if (DiagnosticRecord *record = push(code)) {
+    record->subject = static_cast<std::int32_t>(m_subjects.size());
+    m_subjects.push_back(subject.string());
+    record->error = error;
+  }
+}
+
+void Diagnostics::addValue(DiagCode code, std::int64_t value) {
+  if (DiagnosticRecord *record = push(code)) {
+    record->value = value;
+  }
+}
+
+void Diagnostics::addForOp(DiagCode code, std::size_t opIndex,
+                           std::error_code error) {
+  if (DiagnosticRecord *record = push(code)) {
+    record->opIndex = static_cast<std::int32_t>(opIndex);
+    record->error = error;
+  }
+}
+
+bool Diagnostics::keeps(DiagCode code) const {
+  const std::size_t category = static_cast<std::size_t>(CategoryOf(code));
+  return m_records[category].size() < m_caps[category];
+}
+
+std::size_t Diagnostics::count(DiagCategory category) const {
+  return m_counts[static_cast<std::size_t>(category)];
+}
+
+std::size_t Diagnostics::dropped(DiagCategory category) const {
+  const std::size_t index = static_cast<std::size_t>(category);
+  return m_counts[index] - m_records[index].size();
+}
+
+bool Diagnostics::hasIssues() const {
+  return count(DiagCategory::Warning) > 0 || count(DiagCategory::Skipped) > 0 ||
+         count(DiagCategory::Overwrite) > 0 || count(DiagCategory::Error) > 0;
+}
+
+const std::vector<DiagnosticRecord> &
+Diagnostics::records(DiagCategory category) const {
+  return m_records[static_cast<std::size_t>(category)];
+}
+
+DiagCategory Diagnostics::CategoryOf(DiagCode code) {
+  switch (code) {
+  case DiagCode::FilteringByExtensions:
+  case DiagCode::ScanStarted:
+  case DiagCode::IdenticalName:
+  case DiagCode::NoFilesFound:
+  case DiagCode::NoFilesAdded:
+  case DiagCode::NoEligibleFiles:
+  case DiagCode::PlanCalculated:
+  case DiagCode::DirectoriesPruned:
+  case DiagCode::FoldersToCreate:
+  case DiagCode::SequenceGaps:
+  case DiagCode::SequenceDuplicates:
+  case DiagCode::SequencePadding:
+  case DiagCode::ConflictResolved:
+    return DiagCategory::Info;
+  case DiagCode::EntryTypeError:
+  case DiagCode::ScanEntryException:
+  case DiagCode::SubdirectoryScanError:
+  case DiagCode::DuplicateInput:
+  case DiagCode::BatchConflict:
+  case DiagCode::TargetCheckError:
+  case DiagCode::TargetExists:
+  case DiagCode::DryRunFailure:
+    return DiagCategory::Warning;
+  case DiagCode::NumberOutOfRange:
+  case DiagCode::EmptyNameSkipped:
+  case DiagCode::SourceInvalid:
+  case DiagCode::HashFailed:
+  case DiagCode::SourcePatternNoMatch:
+    return DiagCategory::Skipped;
+  case DiagCode::PotentialOverwrite:
+    return DiagCategory::Overwrite;
+  default:
+    return DiagCategory::Error;
+  }
+}
+
+std::string Diagnostics::subjectText(const DiagnosticRecord &record) const {
+  return (record.subject >= 0 &&
+          static_cast<std::size_t>(record.subject) < m_subjects.size())
+             ? m_subjects[record.subject]
+             : std::string();
+}
+
+// Builds the user-facing message for a record; wording matches the messages
+// the planner used to store eagerly
+std::string Diagnostics::format(const DiagnosticRecord &record,
+                                const std::vector<RenameOperation> &plan) const {
+  const std::string subject = subjectText(record);
+  const std::string errorText = record.error ? record.error.message() : "";
+  const RenameOperation *op =
+      (record.opIndex >= 0 &&
+       static_cast<std::size_t>(record.opIndex) < plan.size())
+          ? &plan[record.opIndex]
+          : nullptr;
+  const std::string opTarget =
+      op ? op->NewFullPath.string()
+         : "<operation #" + std::to_string(record.opIndex) + ">";
+
+  switch (record.code) {
+  case DiagCode::FilteringByExtensions:
+    return "Filtering by extensions: " + subject;
+  case DiagCode::ScanStarted:
+    return record.value ? "Starting recursive directory scan..."
+                        : "Starting non-recursive directory scan...";
+  case DiagCode::IdenticalName:
+    return "Skipping '" + subject +
+           "' (New name is identical to old name, case-insensitively)";
+  case DiagCode::NoFilesFound:
+    return "No files found in the target directory matching the specified "
+           "pattern/filters.";
+  case DiagCode::NoFilesAdded:
+    return "No files were added to the list to be renamed.";
+  case DiagCode::NoEligibleFiles:
+    return "No files eligible for renaming after applying all filters and "
+           "checks.";
+  case DiagCode::PlanCalculated:
+    return "Calculated " + std::to_string(record.value) +
+           " file(s) to be renamed.";
+  case DiagCode::DirectoriesPruned:
+    return "Skipped " + std::to_string(record.value) +
+           " excluded subdirectory(ies) without scanning them.";
+  case DiagCode::FoldersToCreate:
+    return "Renaming will create " + std::to_string(record.value) +
+           " new folder(s).";
+  case DiagCode::SequenceGaps:
+    return "Sequence gaps in " + subject;
+  case DiagCode::SequenceDuplicates:
+    return "Numbers used more than once in " + subject;
+  case DiagCode::SequencePadding:
+    return "Mixed zero padding in " + subject;
+  case DiagCode::ConflictResolved:
+    return "Target was taken; renaming to '" + opTarget + "' instead.";
+  case DiagCode::EntryTypeError:
+    return "Warning: Filesystem error checking type of '" + subject +
+           "': " + errorText;
+  case DiagCode::ScanEntryException:
+    return "Warning: Exception during scan: " + subject;
+  case DiagCode::SubdirectoryScanError:
+    return "Warning: Filesystem error during recursive scan near '" + subject +
+           "': " + errorText;
+  case DiagCode::DuplicateInput:
+    return "Warning: Skipping duplicate input file: " + subject;
+  case DiagCode::BatchConflict:
+    return "Conflict: Generated path '" + opTarget +
+           "' conflicts with another file in this batch.";
+  case DiagCode::TargetCheckError:
+    return "Conflict: Filesystem error checking target path '" + opTarget +
+           "': " + errorText;
+  case DiagCode::TargetExists:
+    return "Conflict: Target '" + opTarget + "' already exists.";
+  case DiagCode::DryRunFailure:
+    return "Dry run: renaming " + subject;
+  case DiagCode::NumberOutOfRange: {
+    const fs::path p(subject);
+    return p.filename().string() + " (in " + p.parent_path().string() +
+           ") (Skipped: Incremented number out of int range)";
+  }
+  case DiagCode::EmptyNameSkipped:
+    return subject + " (Skipped: Generated name was empty)";
+  case DiagCode::SourceInvalid:
+    return subject + " (Skipped: Not a valid file or inaccessible" +
+           (record.error ? ". Error: " + errorText : "") + ")";
+  case DiagCode::HashFailed:
+    return subject + " (Skipped: Could not read content for <hash:N>" +
+           (record.error ? ". Error: " + errorText : "") + ")";
+  case DiagCode::SourcePatternNoMatch:
+    return subject + " (Skipped: Name does not match the Source Pattern)";
+  case DiagCode::PotentialOverwrite:
+    return op ? "Skipped renaming '" + op->OldName + "' to '" + op->NewName +
+                    "' because target path exists and is not part of this "
+                    "rename batch."
+              : "Skipped renaming " + opTarget +
+                    " because target path exists and is not part of this "
+                    "rename batch.";
+  case DiagCode::PatternEmpty:
+    return "FATAL: New name pattern cannot be empty.";
+  case DiagCode::TargetDirInvalid:
+    return "FATAL: Target directory is invalid or inaccessible: " + subject +
+           (record.error ? " (" + errorText + ")" : "");
+  case DiagCode::FilenamePatternEmpty:
+    return "FATAL: Filename Pattern cannot be empty in Directory Scan mode.";
+  case DiagCode::NumberRangeInvalid:
+    return "FATAL: Lowest Number filter cannot be greater than Highest Number "
+           "filter.";
+  case DiagCode::FilenamePatternInvalid:
+    return "FATAL: Invalid Filename Pattern (regex error): " + subject;
+  case DiagCode::SourcePatternInvalid:
+    return "FATAL: Invalid Source Pattern: " + subject;
+  case DiagCode::ConflictSuffixInvalid:
+    return "FATAL: Conflict suffix '" + subject +
+           "' contains characters not allowed in file names.";
+  case DiagCode::ScanStartFailed:
+    return "FATAL: Filesystem error starting directory scan at '" + subject +
+           "': " + errorText;
+  case DiagCode::ScanFailed:
+    return "FATAL: Unexpected error during directory scan: " + subject;
+  case DiagCode::EmptyNameError:
+    return "Error: Generated new filename is empty for '" + subject +
+           "'. Skipped.";
+  case DiagCode::ManualListEmpty:
+    return "FATAL: No files were added to the list in Manual Selection mode.";
+  case DiagCode::PreviewException:
+    return "FATAL EXCEPTION (Preview): " + subject;
+  case DiagCode::PreviewUnknownException:
+    return "FATAL UNKNOWN EXCEPTION (Preview)";
+  }
+  return "Unknown diagnostic";
+}
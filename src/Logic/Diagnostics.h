@@ -0,0 +1,141 @@
+#ifndef DIAGNOSTICS_H
+#define DIAGNOSTICS_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <string>
+#include <string_view>
+#include <system_error>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+struct RenameOperation;
+
+// How a diagnostic is presented to the user
+enum class DiagCategory {
+  Info,
+  Warning,
+  Skipped,   // Source files left out of the plan
+  Overwrite, // Planned targets that would overwrite unrelated files
+  Error,
+  Count // Number of categories, not a category itself
+};
+
+// Every message the planner can produce. Text is only built by
+// Diagnostics::format when a record is actually displayed
+enum class DiagCode {
+  // Info
+  FilteringByExtensions, // subject: extension list
+  ScanStarted,           // value: 1 if recursive
+  IdenticalName,         // subject: file name
+  NoFilesFound,
+  NoFilesAdded,
+  NoEligibleFiles,
+  PlanCalculated,    // value: number of operations
+  DirectoriesPruned, // value: number of subdirectories not scanned
+  FoldersToCreate,   // value: number of target folders that don't exist yet
+  SequenceGaps,       // subject: family and its missing numbers
+  SequenceDuplicates, // subject: family and its repeated numbers
+  SequencePadding,    // subject: family and its number widths
+  ConflictResolved,   // op
+  // Warning
+  EntryTypeError,        // subject: path, error
+  ScanEntryException,    // subject: exception text
+  SubdirectoryScanError, // subject: path, error
+  DuplicateInput,        // subject: path
+  BatchConflict,         // op
+  TargetCheckError,      // op, error
+  TargetExists,          // op
+  DryRunFailure,         // subject: file name and reason
+  // Skipped
+  NumberOutOfRange,     // subject: path
+  EmptyNameSkipped,     // subject: file name
+  SourceInvalid,        // subject: path, error
+  HashFailed,           // subject: path, error
+  SourcePatternNoMatch, // subject: path
+  // Overwrite
+  PotentialOverwrite, // op
+  // Error
+  PatternEmpty,
+  TargetDirInvalid, // subject: path, error
+  FilenamePatternEmpty,
+  NumberRangeInvalid,
+  FilenamePatternInvalid, // subject: regex error text
+  SourcePatternInvalid,   // subject: regex error text
+  ConflictSuffixInvalid,  // subject: suffix
+  ScanStartFailed,        // subject: path, error
+  ScanFailed,             // subject: exception text
+  EmptyNameError,         // subject: file name
+  ManualListEmpty,
+  PreviewException, // subject: exception text
+  PreviewUnknownException
+};
+
+// Compact record of one diagnostic. Paths and names are copied into the
+// owning Diagnostics object's subject table, only for records it keeps; plan
+// operations are referenced by index
+struct DiagnosticRecord {
+  DiagCode code;
+  std::int32_t opIndex = -1; // Index into the rename plan, or -1
+  std::int32_t subject = -1; // Index into Diagnostics' subject table, or -1
+  std::int64_t value = 0;    // Numeric argument (counts, flags)
+  std::error_code error;     // errno-style cause, if any
+};
+
+// Bounded, structured diagnostics buffer. Each category keeps at most 'cap'
+// records; anything beyond that is only counted, so a conflict storm over a
+// million files costs a counter increment per file instead of a formatted
+// string
+class Diagnostics {
+public:
+  static constexpr std::size_t DefaultCapPerCategory = 1000;
+
+  explicit Diagnostics(std::size_t capPerCategory = DefaultCapPerCategory);
+
+  void setCap(std::size_t capPerCategory);
+  void setCap(DiagCategory category, std::size_t cap);
+
+  void add(DiagCode code, std::error_code error = {});
+  void add(DiagCode code, std::string_view subject, std::error_code error = {});
+  // Converts 'subject' to a string only if the record is kept
+  void addPath(DiagCode code, const fs::path &subject,
+               std::error_code error = {});
+  void addValue(DiagCode code, std::int64_t value);
+  void addForOp(DiagCode code, std::size_t opIndex,
+                std::error_code error = {});
+
+  // True if a record for 'code' would still be stored rather than only
+  // counted, so callers can skip building a subject that would be dropped
+  bool keeps(DiagCode code) const;
+  // Total number of diagnostics reported, including ones beyond the cap
+  std::size_t count(DiagCategory category) const;
+  // Number of diagnostics that were counted but not stored
+  std::size_t dropped(DiagCategory category) const;
+  // True if anything other than Info was reported
+  bool hasIssues() const;
+  const std::vector<DiagnosticRecord> &records(DiagCategory category) const;
+
+  // Builds the display text for 'record'. 'plan' must be the rename plan the
+  // record's op index refers to
+  std::string format(const DiagnosticRecord &record,
+                     const std::vector<RenameOperation> &plan) const;
+
+  static DiagCategory CategoryOf(DiagCode code);
+
+private:
+  // Returns the record slot to fill, or nullptr if the category is full
+  DiagnosticRecord *push(DiagCode code);
+  std::string subjectText(const DiagnosticRecord &record) const;
+
+  static constexpr std::size_t CategoryCount =
+      static_cast<std::size_t>(DiagCategory::Count);
+  std::array<std::vector<DiagnosticRecord>, CategoryCount> m_records;
+  std::array<std::size_t, CategoryCount> m_counts{};
+  std::array<std::size_t, CategoryCount> m_caps{};
+  std::vector<std::string> m_subjects;
+};
+
+#endif // DIAGNOSTICS_H
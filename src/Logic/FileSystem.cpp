@@ -0,0 +1,1056 @@
+#include "FileSystem.h"
+
+#include <algorithm>
+#include <cstring>
+#include <filesystem>
+#include <memory>
+#include <string>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+#ifdef _WIN32
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+#else
+#include <cerrno>
+#include <fcntl.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#ifdef __linux__
+#include <dirent.h>
+#include <sys/syscall.h>
+#endif
+#endif
+
+namespace fs = std::filesystem;
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+// Maps a std::filesystem type onto the smaller FileKind set
+FileKind ToFileKind(fs::file_type type) {
+  switch (type) {
+  case fs::file_type::not_found:
+  case fs::file_type::none:
+    return FileKind::NotFound;
+  case fs::file_type::regular:
+    return FileKind::Regular;
+  case fs::file_type::directory:
+    return FileKind::Directory;
+  default:
+    return FileKind::Other;
+  }
+}
+
+#ifdef _WIN32
+// Closes a Win32 handle when it goes out of scope
+struct HandleCloser {
+  HANDLE handle;
+  ~HandleCloser() {
+    if (handle != nullptr && handle != INVALID_HANDLE_VALUE) {
+      CloseHandle(handle);
+    }
+  }
+};
+
+std::error_code LastSystemError() {
+  return std::error_code(static_cast<int>(GetLastError()),
+                         std::system_category());
+}
+#else
+// Closes a file descriptor when it goes out of scope
+struct FdCloser {
+  int fd;
+  ~FdCloser() {
+    if (fd >= 0) {
+      ::close(fd);
+    }
+  }
+};
+
+std::error_code LastSystemError() {
+  return std::error_code(errno, std::generic_category());
+}
+#endif
+
+#ifdef __linux__
+FileKind ToFileKind(mode_t mode) {
+  if (S_ISREG(mode)) {
+    return FileKind::Regular;
+  }
+  return S_ISDIR(mode) ? FileKind::Directory : FileKind::Other;
+}
+
+// Fills in what d_type left open: the target of a symlink, or the whole type
+// on filesystems that report DT_UNKNOWN. Like directory_entry::status(), a
+// symlink whose target is missing is an error
+void ResolveKind(int dirFd, const char *name, unsigned char type,
+                 DirEntryView &view) {
+  struct stat st;
+  if (type == DT_UNKNOWN) {
+    if (::fstatat(dirFd, name, &st, AT_SYMLINK_NOFOLLOW) != 0) {
+      view.kind = FileKind::NotFound;
+      view.error = LastSystemError();
+      return;
+    }
+    view.isSymlink = S_ISLNK(st.st_mode);
+    if (!view.isSymlink) {
+      view.kind = ToFileKind(st.st_mode);
+      return;
+    }
+  }
+  if (::fstatat(dirFd, name, &st, 0) != 0) {
+    view.kind = FileKind::NotFound;
+    view.error = LastSystemError();
+    return;
+  }
+  view.kind = ToFileKind(st.st_mode);
+}
+#endif
+} // namespace
+
+bool FileSystem::exists(const fs::path &p, std::error_code &ec) {
+  return status(p, ec) != FileKind::NotFound && !ec;
+}
+
+bool FileSystem::isRegularFile(const fs::path &p, std::error_code &ec) {
+  return status(p, ec) == FileKind::Regular && !ec;
+}
+
+bool FileSystem::isDirectory(const fs::path &p, std::error_code &ec) {
+  return status(p, ec) == FileKind::Directory && !ec;
+}
+
+// ---------------------------------------------------------------------------
+// RealFileSystem
+// ---------------------------------------------------------------------------
+
+FileKind RealFileSystem::status(const fs::path &p, std::error_code &ec) {
+  fs::file_status st = fs::status(p, ec);
+  if (st.type() == fs::file_type::not_found) {
+    ec.clear(); // A missing path is an answer, not an error
+    return FileKind::NotFound;
+  }
+  if (ec) {
+    return FileKind::NotFound;
+  }
+  return ToFileKind(st.type());
+}
+
+std::uintmax_t RealFileSystem::fileSize(const fs::path &p,
+                                        std::error_code &ec) {
+  std::uintmax_t size = fs::file_size(p, ec);
+  return ec ? 0 : size;
+}
+
+fs::file_time_type RealFileSystem::lastWriteTime(const fs::path &p,
+                                                 std::error_code &ec) {
+  return fs::last_write_time(p, ec);
+}
+
+void RealFileSystem::listDirectory(
+    const fs::path &dir, const std::function<void(const DirEntryView &)> &visit,
+    std::error_code &ec) {
+#ifdef __linux__
+  // No path or directory_entry is built per entry: each name is a view into
+  // the buffer, and only symlinks and DT_UNKNOWN entries cost a stat
+  ec.clear();
+  FdCloser folder{::open(dir.c_str(), O_RDONLY | O_DIRECTORY | O_CLOEXEC)};
+  if (folder.fd < 0) {
+    if (errno != EACCES) { // Skipped like skip_permission_denied does
+      ec = LastSystemError();
+    }
+    return;
+  }
+  // Records are 8-byte aligned, which new[] guarantees for the buffer
+  std::unique_ptr<char[]> buffer(new char[ListBufferSize]);
+  for (;;) {
+    const long got =
+        ::syscall(SYS_getdents64, folder.fd, buffer.get(), ListBufferSize);
+    if (got < 0) {
+      ec = LastSystemError();
+      return;
+    }
+    if (got == 0) {
+      return;
+    }
+    // struct linux_dirent64: d_ino, d_off, d_reclen, d_type, d_name
+    for (long offset = 0; offset < got;) {
+      const char *record = buffer.get() + offset;
+      std::uint64_t inode;
+      unsigned short length;
+      std::memcpy(&inode, record, sizeof inode);
+      std::memcpy(&length, record + 16, sizeof length);
+      const unsigned char type = static_cast<unsigned char>(record[18]);
+      const char *name = record + 19;
+      offset += length;
+      if (name[0] == '.' &&
+          (name[1] == '\0' || (name[1] == '.' && name[2] == '\0'))) {
+        continue;
+      }
+      DirEntryView view;
+      view.name = name;
+      view.inode = inode;
+      if (type == DT_REG) {
+        view.kind = FileKind::Regular;
+      } else if (type == DT_DIR) {
+        view.kind = FileKind::Directory;
+      } else if (type == DT_LNK || type == DT_UNKNOWN) {
+        view.isSymlink = type == DT_LNK;
+        ResolveKind(folder.fd, name, type, view);
+      }
+      visit(view);
+    }
+  }
+#else
+  fs::directory_iterator it(dir, fs::directory_options::skip_permission_denied,
+                            ec);
+  if (ec) {
+    return;
+  }
+  std::string name;
+  for (; it != fs::directory_iterator(); it.increment(ec)) {
+    const fs::directory_entry &entry = *it;
+    DirEntryView view;
+    try {
+      name = entry.path().filename().string();
+    } catch (const std::exception &) {
+      // Names not representable in the narrow encoding are reported, not
+      // silently dropped
+      name.clear();
+      view.error = std::make_error_code(std::errc::illegal_byte_sequence);
+    }
+    view.name = name;
+    std::error_code typeEc;
+    view.isSymlink = entry.is_symlink(typeEc);
+    fs::file_status st = entry.status(typeEc);
+    view.kind = ToFileKind(st.type());
+    if (typeEc && !view.error) {
+      view.error = typeEc;
+    }
+    visit(view);
+  }
+#endif
+}
+
+void RealFileSystem::rename(const fs::path &from, const fs::path &to,
+                            std::error_code &ec) {
+  fs::rename(from, to, ec);
+}
+
+bool RealFileSystem::createDirectories(const fs::path &p,
+                                       std::error_code &ec) {
+  return fs::create_directories(p, ec);
+}
+
+// On Linux the data is copied inside the kernel with copy_file_range, which
+// also lets filesystems that support it share extents or offload the copy to
+// the server instead of moving every byte through user space
+bool RealFileSystem::copyFile(const fs::path &from, const fs::path &to,
+                              CopyMode mode, std::error_code &ec) {
+#ifdef __linux__
+  ec.clear();
+  FdCloser in{::open(from.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (in.fd < 0) {
+    ec = LastSystemError();
+    return false;
+  }
+  struct stat st;
+  if (::fstat(in.fd, &st) != 0) {
+    ec = LastSystemError();
+    return false;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return false;
+  }
+  const int createFlags = mode == CopyMode::CreateNew ? O_EXCL : O_TRUNC;
+  FdCloser out{::open(to.c_str(), O_WRONLY | O_CREAT | createFlags | O_CLOEXEC,
+                      st.st_mode & 07777)};
+  if (out.fd < 0) {
+    ec = LastSystemError();
+    return false;
+  }
+  // A file this call created exclusively is removed again if the copy fails
+  auto fail = [&](std::error_code error) {
+    ec = error;
+    if (mode == CopyMode::CreateNew) {
+      ::unlink(to.c_str());
+    }
+    return false;
+  };
+  off_t remaining = st.st_size;
+  while (remaining > 0) {
+    const ssize_t copied =
+        ::copy_file_range(in.fd, nullptr, out.fd, nullptr,
+                          static_cast<std::size_t>(remaining), 0);
+    if (copied > 0) {
+      remaining -= copied;
+    } else if (copied == 0) {
+      break; // The source shrank while it was copied
+    } else if (errno != EINTR) {
+      const int error = errno;
+      if (remaining == st.st_size &&
+          (error == EXDEV || error == ENOSYS || error == EINVAL ||
+           error == EOPNOTSUPP)) {
+        // Older kernels and some filesystem pairs don't support it. 'to' is
+        // ours by now, even when it had to be created
+        std::error_code copyEc;
+        if (!fs::copy_file(from, to, fs::copy_options::overwrite_existing,
+                           copyEc)) {
+          return fail(copyEc);
+        }
+        return true;
+      }
+      return fail(std::error_code(error, std::generic_category()));
+    }
+  }
+  return true;
+#else
+  if (mode == CopyMode::Overwrite) {
+    return fs::copy_file(from, to, fs::copy_options::overwrite_existing, ec);
+  }
+  if (fs::copy_file(from, to, fs::copy_options::none, ec)) {
+    return true;
+  }
+  if (ec != std::errc::file_exists) {
+    std::error_code removeEc;
+    fs::remove(to, removeEc);
+  }
+  return false;
+#endif
+}
+
+std::uintmax_t RealFileSystem::removeAll(const fs::path &p,
+                                         std::error_code &ec) {
+  std::uintmax_t removed = fs::remove_all(p, ec);
+  return removed == static_cast<std::uintmax_t>(-1) ? 0 : removed;
+}
+
+// Maps the file one window at a time so address space use stays bounded and
+// the kernel can read ahead sequentially; no data is copied into user buffers
+void RealFileSystem::readContent(
+    const fs::path &p, const std::function<void(std::string_view)> &visit,
+    std::error_code &ec) {
+  ec.clear();
+#ifdef _WIN32
+  HandleCloser file{CreateFileW(
+      p.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_FLAG_SEQUENTIAL_SCAN, nullptr)};
+  if (file.handle == INVALID_HANDLE_VALUE) {
+    ec = LastSystemError();
+    return;
+  }
+  LARGE_INTEGER size;
+  if (!GetFileSizeEx(file.handle, &size)) {
+    ec = LastSystemError();
+    return;
+  }
+  const std::uintmax_t total = static_cast<std::uintmax_t>(size.QuadPart);
+  if (total == 0) {
+    return; // Empty files can't be mapped
+  }
+  HandleCloser mapping{
+      CreateFileMappingW(file.handle, nullptr, PAGE_READONLY, 0, 0, nullptr)};
+  if (mapping.handle == nullptr) {
+    ec = LastSystemError();
+    return;
+  }
+  for (std::uintmax_t offset = 0; offset < total; offset += MapWindowSize) {
+    const std::size_t length =
+        static_cast<std::size_t>(std::min(MapWindowSize, total - offset));
+    void *view = MapViewOfFile(mapping.handle, FILE_MAP_READ,
+                               static_cast<DWORD>(offset >> 32),
+                               static_cast<DWORD>(offset & 0xFFFFFFFFu),
+                               length);
+    if (view == nullptr) {
+      ec = LastSystemError();
+      return;
+    }
+    struct ViewUnmapper {
+      void *view;
+      ~ViewUnmapper() { UnmapViewOfFile(view); }
+    } unmapper{view};
+    visit(std::string_view(static_cast<const char *>(view), length));
+  }
+#else
+  FdCloser file{::open(p.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (file.fd < 0) {
+    ec = LastSystemError();
+    return;
+  }
+  struct stat st;
+  if (::fstat(file.fd, &st) != 0) {
+    ec = LastSystemError();
+    return;
+  }
+  if (!S_ISREG(st.st_mode)) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return;
+  }
+  const std::uintmax_t total = static_cast<std::uintmax_t>(st.st_size);
+  for (std::uintmax_t offset = 0; offset < total; offset += MapWindowSize) {
+    const std::size_t length =
+        static_cast<std::size_t>(std::min(MapWindowSize, total - offset));
+    void *view = ::mmap(nullptr, length, PROT_READ, MAP_PRIVATE, file.fd,
+                        static_cast<off_t>(offset));
+    if (view == MAP_FAILED) {
+      ec = LastSystemError();
+      return;
+    }
+    ::madvise(view, length, MADV_SEQUENTIAL);
+    struct ViewUnmapper {
+      void *view;
+      std::size_t length;
+      ~ViewUnmapper() { ::munmap(view, length); }
+    } unmapper{view, length};
+    visit(std::string_view(static_cast<const char *>(view), length));
+  }
+#endif
+}
+
+// Positional reads: the file offset is never moved, so concurrent readers of
+// the same path don't interfere
+std::size_t RealFileSystem::readAt(const fs::path &p, std::uintmax_t offset,
+                                   char *buffer, std::size_t size,
+                                   std::error_code &ec) {
+  ec.clear();
+  std::size_t done = 0;
+#ifdef _WIN32
+  HandleCloser file{CreateFileW(
+      p.c_str(), GENERIC_READ,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, nullptr)};
+  if (file.handle == INVALID_HANDLE_VALUE) {
+    ec = LastSystemError();
+    return 0;
+  }
+  while (done < size) {
+    const std::uintmax_t position = offset + done;
+    OVERLAPPED at = {};
+    at.Offset = static_cast<DWORD>(position & 0xFFFFFFFFu);
+    at.OffsetHigh = static_cast<DWORD>(position >> 32);
+    DWORD got = 0;
+    const DWORD want = static_cast<DWORD>(
+        std::min<std::size_t>(size - done, 1u << 30));
+    if (!ReadFile(file.handle, buffer + done, want, &got, &at)) {
+      if (GetLastError() != ERROR_HANDLE_EOF) {
+        ec = LastSystemError();
+      }
+      break;
+    }
+    if (got == 0) {
+      break;
+    }
+    done += got;
+  }
+#else
+  FdCloser file{::open(p.c_str(), O_RDONLY | O_CLOEXEC)};
+  if (file.fd < 0) {
+    ec = LastSystemError();
+    return 0;
+  }
+  while (done < size) {
+    const ssize_t got = ::pread(file.fd, buffer + done, size - done,
+                                static_cast<off_t>(offset + done));
+    if (got < 0) {
+      if (errno == EINTR) {
+        continue;
+      }
+      ec = LastSystemError();
+      break;
+    }
+    if (got == 0) {
+      break;
+    }
+    done += static_cast<std::size_t>(got);
+  }
+#endif
+  return done;
+}
+
+FileIdentity RealFileSystem::identity(const fs::path &p, std::error_code &ec) {
+  ec.clear();
+  FileIdentity id;
+#ifdef _WIN32
+  HandleCloser file{CreateFileW(
+      p.c_str(), FILE_READ_ATTRIBUTES,
+      FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE, nullptr,
+      OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, nullptr)};
+  BY_HANDLE_FILE_INFORMATION info;
+  if (file.handle == INVALID_HANDLE_VALUE ||
+      !GetFileInformationByHandle(file.handle, &info)) {
+    ec = LastSystemError();
+    return id;
+  }
+  id.device = info.dwVolumeSerialNumber;
+  id.inode = (std::uint64_t(info.nFileIndexHigh) << 32) | info.nFileIndexLow;
+  id.size = (std::uint64_t(info.nFileSizeHigh) << 32) | info.nFileSizeLow;
+  const std::uint64_t ticks =
+      (std::uint64_t(info.ftLastWriteTime.dwHighDateTime) << 32) |
+      info.ftLastWriteTime.dwLowDateTime; // 100 ns units since 1601
+  id.modifiedNs = static_cast<std::int64_t>(ticks) * 100;
+#else
+  struct stat st;
+  if (::stat(p.c_str(), &st) != 0) {
+    ec = LastSystemError();
+    return id;
+  }
+  id.device = static_cast<std::uint64_t>(st.st_dev);
+  id.inode = static_cast<std::uint64_t>(st.st_ino);
+  id.size = static_cast<std::uint64_t>(st.st_size);
+#ifdef __APPLE__
+  const struct timespec &mtime = st.st_mtimespec;
+#else
+  const struct timespec &mtime = st.st_mtim;
+#endif
+  id.modifiedNs =
+      static_cast<std::int64_t>(mtime.tv_sec) * 1000000000 + mtime.tv_nsec;
+#endif
+  return id;
+}
+
+FileSystem &DefaultFileSystem() {
+  static RealFileSystem realFileSystem;
+  return realFileSystem;
+}
+
+// ---------------------------------------------------------------------------
+// MemoryFileSystem
+// ---------------------------------------------------------------------------
+
+// Normalizes a path into the map key form ("/a/b", never a trailing slash)
+std::string MemoryFileSystem::Key(const fs::path &p) {
+  std::string key = p.lexically_normal().generic_string();
+  while (key.size() > 1 && key.back() == '/' &&
+         !(key.size() == 3 && key[1] == ':')) // Keep "C:/" intact
+  {
+    key.pop_back();
+  }
+  return key;
+}
+
+std::string MemoryFileSystem::ParentKey(const std::string &key) {
+  return Key(fs::path(key).parent_path());
+}
+
+void MemoryFileSystem::createDirectoriesLocked(const std::string &key) {
+  std::string current = key;
+  std::vector<std::string> missing;
+  while (!current.empty() && m_nodes.find(current) == m_nodes.end()) {
+    missing.push_back(current);
+    std::string parent = ParentKey(current);
+    if (parent == current) {
+      break; // Reached the root
+    }
+    current = parent;
+  }
+  for (auto it = missing.rbegin(); it != missing.rend(); ++it) {
+    Node node;
+    node.kind = FileKind::Directory;
+    node.lastWrite = fs::file_time_type::clock::now();
+    node.inode = m_nextInode++;
+    m_nodes.emplace(*it, node);
+  }
+}
+
+void MemoryFileSystem::addFile(const fs::path &p, const std::string &content,
+                               fs::file_time_type lastWrite) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string key = Key(p);
+  createDirectoriesLocked(ParentKey(key));
+  Node &node = m_nodes[key];
+  if (node.inode == 0) {
+    node.inode = m_nextInode++;
+  }
+  node.kind = FileKind::Regular;
+  node.content = content;
+  node.size = content.size();
+  node.lastWrite = lastWrite;
+}
+
+void MemoryFileSystem::addSizedFile(const fs::path &p, std::uintmax_t size,
+                                    fs::file_time_type lastWrite) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::string key = Key(p);
+  createDirectoriesLocked(ParentKey(key));
+  Node &node = m_nodes[key];
+  if (node.inode == 0) {
+    node.inode = m_nextInode++;
+  }
+  node.kind = FileKind::Regular;
+  node.content.clear();
+  node.size = size;
+  node.lastWrite = lastWrite;
+}
+
+void MemoryFileSystem::addDirectory(const fs::path &p) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  createDirectoriesLocked(Key(p));
+}
+
+std::string MemoryFileSystem::readFile(const fs::path &p) const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto it = m_nodes.find(Key(p));
+  return (it != m_nodes.end() && it->second.kind == FileKind::Regular)
+             ? it->second.content
+             : std::string();
+}
+
+std::size_t MemoryFileSystem::entryCount() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_nodes.size();
+}
+
+FileKind MemoryFileSystem::status(const fs::path &p, std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  auto it = m_nodes.find(Key(p));
+  return it == m_nodes.end() ? FileKind::NotFound : it->second.kind;
+}
+
+std::uintmax_t MemoryFileSystem::fileSize(const fs::path &p,
+                                          std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  auto it = m_nodes.find(Key(p));
+  if (it == m_nodes.end()) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return 0;
+  }
+  if (it->second.kind != FileKind::Regular) {
+    ec = std::make_error_code(std::errc::is_a_directory);
+    return 0;
+  }
+  return it->second.size;
+}
+
+fs::file_time_type MemoryFileSystem::lastWriteTime(const fs::path &p,
+                                                   std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  auto it = m_nodes.find(Key(p));
+  if (it == m_nodes.end()) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return fs::file_time_type::min();
+  }
+  return it->second.lastWrite;
+}
+
+void MemoryFileSystem::listDirectory(
+    const fs::path &dir, const std::function<void(const DirEntryView &)> &visit,
+    std::error_code &ec) {
+  // Snapshot the children first so 'visit' may call back into this object
+  std::vector<std::pair<std::string, FileKind>> children;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ec.clear();
+    std::string key = Key(dir);
+    auto dirIt = m_nodes.find(key);
+    if (dirIt == m_nodes.end()) {
+      ec = std::make_error_code(std::errc::no_such_file_or_directory);
+      return;
+    }
+    if (dirIt->second.kind != FileKind::Directory) {
+      ec = std::make_error_code(std::errc::not_a_directory);
+      return;
+    }
+    const std::string prefix = key.back() == '/' ? key : key + "/";
+    auto it = m_nodes.lower_bound(prefix);
+    while (it != m_nodes.end() &&
+           it->first.compare(0, prefix.size(), prefix) == 0) {
+      std::string_view rest(it->first);
+      rest.remove_prefix(prefix.size());
+      const size_t slash = rest.find('/');
+      if (slash != std::string_view::npos) {
+        // Deeper descendant: jump past the whole subtree of this child
+        it = m_nodes.lower_bound(prefix + std::string(rest.substr(0, slash)) +
+                                 static_cast<char>('/' + 1));
+        continue;
+      }
+      children.emplace_back(std::string(rest), it->second.kind);
+      ++it;
+    }
+  }
+  for (const auto &child : children) {
+    DirEntryView view;
+    view.name = child.first;
+    view.kind = child.second;
+    visit(view);
+  }
+}
+
+void MemoryFileSystem::rename(const fs::path &from, const fs::path &to,
+                              std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  const std::string fromKey = Key(from);
+  const std::string toKey = Key(to);
+  auto fromIt = m_nodes.find(fromKey);
+  if (fromIt == m_nodes.end()) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return;
+  }
+  if (fromKey == toKey) {
+    return;
+  }
+  auto parentIt = m_nodes.find(ParentKey(toKey));
+  if (parentIt == m_nodes.end() ||
+      parentIt->second.kind != FileKind::Directory) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return;
+  }
+  auto toIt = m_nodes.find(toKey);
+  if (fromIt->second.kind != FileKind::Directory) {
+    if (toIt != m_nodes.end() && toIt->second.kind == FileKind::Directory) {
+      ec = std::make_error_code(std::errc::is_a_directory);
+      return;
+    }
+    Node node = std::move(fromIt->second);
+    m_nodes.erase(fromIt);
+    m_nodes[toKey] = std::move(node); // Replaces an existing file like POSIX
+    return;
+  }
+
+  // Directory rename: move the node and its whole subtree
+  if (toKey.compare(0, fromKey.size() + 1, fromKey + "/") == 0) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return;
+  }
+  if (toIt != m_nodes.end()) {
+    ec = std::make_error_code(std::errc::file_exists);
+    return;
+  }
+  const std::string fromPrefix = fromKey + "/";
+  std::vector<std::pair<std::string, Node>> moved;
+  auto it = m_nodes.lower_bound(fromPrefix);
+  while (it != m_nodes.end() &&
+         it->first.compare(0, fromPrefix.size(), fromPrefix) == 0) {
+    moved.emplace_back(toKey + it->first.substr(fromKey.size()),
+                       std::move(it->second));
+    it = m_nodes.erase(it);
+  }
+  Node dirNode = std::move(fromIt->second);
+  m_nodes.erase(fromKey);
+  m_nodes.emplace(toKey, std::move(dirNode));
+  for (auto &entry : moved) {
+    m_nodes.emplace(std::move(entry.first), std::move(entry.second));
+  }
+}
+
+bool MemoryFileSystem::createDirectories(const fs::path &p,
+                                         std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  std::string key = Key(p);
+  // Any existing non-directory along the way blocks creation
+  for (std::string current = key;;) {
+    auto it = m_nodes.find(current);
+    if (it != m_nodes.end()) {
+      if (it->second.kind != FileKind::Directory) {
+        ec = std::make_error_code(std::errc::not_a_directory);
+        return false;
+      }
+      if (current == key) {
+        return false; // Already exists
+      }
+      break;
+    }
+    std::string parent = ParentKey(current);
+    if (parent == current) {
+      break;
+    }
+    current = parent;
+  }
+  createDirectoriesLocked(key);
+  return true;
+}
+
+bool MemoryFileSystem::copyFile(const fs::path &from, const fs::path &to,
+                                CopyMode mode, std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  auto fromIt = m_nodes.find(Key(from));
+  if (fromIt == m_nodes.end()) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return false;
+  }
+  if (fromIt->second.kind != FileKind::Regular) {
+    ec = std::make_error_code(std::errc::invalid_argument);
+    return false;
+  }
+  const std::string toKey = Key(to);
+  auto parentIt = m_nodes.find(ParentKey(toKey));
+  if (parentIt == m_nodes.end() ||
+      parentIt->second.kind != FileKind::Directory) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return false;
+  }
+  auto toIt = m_nodes.find(toKey);
+  if (toIt != m_nodes.end() && mode == CopyMode::CreateNew) {
+    ec = std::make_error_code(std::errc::file_exists);
+    return false;
+  }
+  if (toIt != m_nodes.end() && toIt->second.kind != FileKind::Regular) {
+    ec = std::make_error_code(std::errc::is_a_directory);
+    return false;
+  }
+  Node &target = m_nodes[toKey];
+  const std::uint64_t inode = target.inode != 0 ? target.inode : m_nextInode++;
+  target = fromIt->second;
+  target.inode = inode; // A copy is a different file
+  return true;
+}
+
+std::uintmax_t MemoryFileSystem::removeAll(const fs::path &p,
+                                           std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  const std::string key = Key(p);
+  auto it = m_nodes.find(key);
+  if (it == m_nodes.end()) {
+    return 0;
+  }
+  m_nodes.erase(it);
+  std::uintmax_t removed = 1;
+  const std::string prefix = key + "/";
+  auto child = m_nodes.lower_bound(prefix);
+  while (child != m_nodes.end() &&
+         child->first.compare(0, prefix.size(), prefix) == 0) {
+    child = m_nodes.erase(child);
+    ++removed;
+  }
+  return removed;
+}
+
+// The content is copied out under the lock so 'visit' may call back into the
+// backend
+void MemoryFileSystem::readContent(
+    const fs::path &p, const std::function<void(std::string_view)> &visit,
+    std::error_code &ec) {
+  std::string content;
+  std::uintmax_t size = 0;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    ec.clear();
+    auto it = m_nodes.find(Key(p));
+    if (it == m_nodes.end()) {
+      ec = std::make_error_code(std::errc::no_such_file_or_directory);
+      return;
+    }
+    if (it->second.kind != FileKind::Regular) {
+      ec = std::make_error_code(std::errc::is_a_directory);
+      return;
+    }
+    content = it->second.content;
+    size = it->second.size;
+  }
+  if (!content.empty()) {
+    visit(content);
+  }
+  // Files added with addSizedFile() read as zeros
+  static const std::string zeros(64 * 1024, '\0');
+  for (std::uintmax_t done = content.size(); done < size;) {
+    const std::size_t length = static_cast<std::size_t>(
+        std::min<std::uintmax_t>(zeros.size(), size - done));
+    visit(std::string_view(zeros.data(), length));
+    done += length;
+  }
+}
+
+std::size_t MemoryFileSystem::readAt(const fs::path &p, std::uintmax_t offset,
+                                     char *buffer, std::size_t size,
+                                     std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  auto it = m_nodes.find(Key(p));
+  if (it == m_nodes.end()) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return 0;
+  }
+  if (it->second.kind != FileKind::Regular) {
+    ec = std::make_error_code(std::errc::is_a_directory);
+    return 0;
+  }
+  const Node &node = it->second;
+  if (offset >= node.size) {
+    return 0;
+  }
+  const std::size_t start = static_cast<std::size_t>(offset);
+  const std::size_t length = static_cast<std::size_t>(
+      std::min<std::uintmax_t>(size, node.size - offset));
+  // Bytes past the stored content (sized files) read as zeros
+  const std::size_t stored =
+      start < node.content.size()
+          ? std::min(length, node.content.size() - start)
+          : 0;
+  std::copy_n(node.content.data() + std::min(start, node.content.size()),
+              stored, buffer);
+  std::fill(buffer + stored, buffer + length, '\0');
+  return length;
+}
+
+FileIdentity MemoryFileSystem::identity(const fs::path &p,
+                                        std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  ec.clear();
+  FileIdentity id;
+  auto it = m_nodes.find(Key(p));
+  if (it == m_nodes.end()) {
+    ec = std::make_error_code(std::errc::no_such_file_or_directory);
+    return id;
+  }
+  id.inode = it->second.inode;
+  id.size = it->second.kind == FileKind::Regular ? it->second.size : 0;
+  id.modifiedNs = std::chrono::duration_cast<std::chrono::nanoseconds>(
+                      it->second.lastWrite.time_since_epoch())
+                      .count();
+  return id;
+}
+
+// ---------------------------------------------------------------------------
+// LatencyFileSystem
+// ---------------------------------------------------------------------------
+
+LatencyFileSystem::LatencyFileSystem(FileSystem &inner, LatencyConfig config)
+    : m_inner(inner), m_config(std::move(config)), m_rng(m_config.seed) {}
+
+std::uint64_t LatencyFileSystem::callCount(FileOp op) const {
+  return m_calls[static_cast<size_t>(op)].load(std::memory_order_relaxed);
+}
+
+std::uint64_t LatencyFileSystem::totalCalls() const {
+  std::uint64_t total = 0;
+  for (const auto &count : m_calls) {
+    total += count.load(std::memory_order_relaxed);
+  }
+  return total;
+}
+
+bool LatencyFileSystem::beginCall(FileOp op, const fs::path &p,
+                                  std::error_code &ec) {
+  m_calls[static_cast<size_t>(op)].fetch_add(1, std::memory_order_relaxed);
+
+  auto delay = m_config.latency;
+  bool fail = false;
+  if (m_config.jitter.count() > 0 || m_config.failureRate > 0.0) {
+    std::lock_guard<std::mutex> lock(m_rngMutex);
+    if (m_config.jitter.count() > 0) {
+      std::uniform_int_distribution<long long> jitterDist(
+          0, m_config.jitter.count());
+      delay += std::chrono::microseconds(jitterDist(m_rng));
+    }
+    if (m_config.failureRate > 0.0) {
+      std::uniform_real_distribution<double> failDist(0.0, 1.0);
+      fail = failDist(m_rng) < m_config.failureRate;
+    }
+  }
+  if (delay.count() > 0) {
+    std::this_thread::sleep_for(delay);
+  }
+  if (!fail && m_config.failWhen) {
+    fail = m_config.failWhen(op, p);
+  }
+  if (fail) {
+    ec = std::make_error_code(m_config.failureError);
+    return false;
+  }
+  return true;
+}
+
+FileKind LatencyFileSystem::status(const fs::path &p, std::error_code &ec) {
+  if (!beginCall(FileOp::Status, p, ec)) {
+    return FileKind::NotFound;
+  }
+  return m_inner.status(p, ec);
+}
+
+std::uintmax_t LatencyFileSystem::fileSize(const fs::path &p,
+                                           std::error_code &ec) {
+  if (!beginCall(FileOp::FileSize, p, ec)) {
+    return 0;
+  }
+  return m_inner.fileSize(p, ec);
+}
+
+fs::file_time_type LatencyFileSystem::lastWriteTime(const fs::path &p,
+                                                    std::error_code &ec) {
+  if (!beginCall(FileOp::LastWriteTime, p, ec)) {
+    return fs::file_time_type::min();
+  }
+  return m_inner.lastWriteTime(p, ec);
+}
+
+void LatencyFileSystem::listDirectory(
+    const fs::path &dir, const std::function<void(const DirEntryView &)> &visit,
+    std::error_code &ec) {
+  if (!beginCall(FileOp::List, dir, ec)) {
+    return;
+  }
+  m_inner.listDirectory(dir, visit, ec);
+}
+
+void LatencyFileSystem::rename(const fs::path &from, const fs::path &to,
+                               std::error_code &ec) {
+  if (!beginCall(FileOp::Rename, from, ec)) {
+    return;
+  }
+  m_inner.rename(from, to, ec);
+}
+
+bool LatencyFileSystem::createDirectories(const fs::path &p,
+                                          std::error_code &ec) {
+  if (!beginCall(FileOp::CreateDirectories, p, ec)) {
+    return false;
+  }
+  return m_inner.createDirectories(p, ec);
+}
+
+bool LatencyFileSystem::copyFile(const fs::path &from, const fs::path &to,
+                                 CopyMode mode, std::error_code &ec) {
+  if (!beginCall(FileOp::CopyFile, from, ec)) {
+    return false;
+  }
+  return m_inner.copyFile(from, to, mode, ec);
+}
+
+std::uintmax_t LatencyFileSystem::removeAll(const fs::path &p,
+                                            std::error_code &ec) {
+  if (!beginCall(FileOp::RemoveAll, p, ec)) {
+    return 0;
+  }
+  return m_inner.removeAll(p, ec);
+}
+
+void LatencyFileSystem::readContent(
+    const fs::path &p, const std::function<void(std::string_view)> &visit,
+    std::error_code &ec) {
+  if (!beginCall(FileOp::Read, p, ec)) {
+    return;
+  }
+  m_inner.readContent(p, visit, ec);
+}
+
+std::size_t LatencyFileSystem::readAt(const fs::path &p, std::uintmax_t offset,
+                                      char *buffer, std::size_t size,
+                                      std::error_code &ec) {
+  if (!beginCall(FileOp::ReadAt, p, ec)) {
+    return 0;
+  }
+  return m_inner.readAt(p, offset, buffer, size, ec);
+}
+
+FileIdentity LatencyFileSystem::identity(const fs::path &p,
+                                         std::error_code &ec) {
+  if (!beginCall(FileOp::Identity, p, ec)) {
+    return FileIdentity();
+  }
+  return m_inner.identity(p, ec);
+}
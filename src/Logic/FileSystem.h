@@ -0,0 +1,265 @@
+#ifndef FILESYSTEM_H
+#define FILESYSTEM_H
+
+#include <array>
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <filesystem>
+#include <functional>
+#include <map>
+#include <memory>
+#include <mutex>
+#include <random>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+namespace fs = std::filesystem;
+
+// Type of a filesystem entry; symlinks are followed like fs::status does
+enum class FileKind { NotFound, Regular, Directory, Other };
+
+// A single entry handed to a directory listing callback. 'name' only stays
+// valid for the duration of the callback
+struct DirEntryView {
+  std::string_view name;
+  FileKind kind = FileKind::Other;
+  bool isSymlink = false;
+  std::uint64_t inode = 0; // 0 when the listing doesn't provide it
+  std::error_code error;   // Set if the entry type could not be determined
+};
+
+// Identity and version of a file. A file keeps its device and inode across
+// renames, while writing to it changes its size or modification time
+struct FileIdentity {
+  std::uint64_t device = 0;
+  std::uint64_t inode = 0; // File index on Windows
+  std::uint64_t size = 0;
+  std::int64_t modifiedNs = 0; // Last write time in nanoseconds
+
+  bool operator==(const FileIdentity &other) const {
+    return device == other.device && inode == other.inode &&
+           size == other.size && modifiedNs == other.modifiedNs;
+  }
+  bool operator!=(const FileIdentity &other) const { return !(*this == other); }
+};
+
+// What copyFile does when the destination already exists
+enum class CopyMode {
+  Overwrite, // Replace an existing regular file
+  CreateNew  // Fail with file_exists; a failed copy removes what it created
+};
+
+// Operations that can be observed or fault-injected by decorators
+enum class FileOp {
+  Status,
+  FileSize,
+  LastWriteTime,
+  List,
+  Rename,
+  CreateDirectories,
+  CopyFile,
+  RemoveAll,
+  Read,
+  ReadAt,
+  Identity,
+  Count // Number of operations, not an operation itself
+};
+
+// Injectable filesystem used by the planner, executor, undo and backup code.
+// All calls report errors through 'ec' and never throw for I/O failures
+class FileSystem {
+public:
+  virtual ~FileSystem() = default;
+
+  // Returns FileKind::NotFound with a cleared 'ec' when the path is missing
+  virtual FileKind status(const fs::path &p, std::error_code &ec) = 0;
+  virtual std::uintmax_t fileSize(const fs::path &p, std::error_code &ec) = 0;
+  virtual fs::file_time_type lastWriteTime(const fs::path &p,
+                                           std::error_code &ec) = 0;
+  // Calls 'visit' once per direct child of 'dir' (never "." or "..")
+  virtual void
+  listDirectory(const fs::path &dir,
+                const std::function<void(const DirEntryView &)> &visit,
+                std::error_code &ec) = 0;
+  virtual void rename(const fs::path &from, const fs::path &to,
+                      std::error_code &ec) = 0;
+  virtual bool createDirectories(const fs::path &p, std::error_code &ec) = 0;
+  // Copies a regular file; 'mode' decides whether an existing destination
+  // file is replaced
+  virtual bool copyFile(const fs::path &from, const fs::path &to,
+                        CopyMode mode, std::error_code &ec) = 0;
+  virtual std::uintmax_t removeAll(const fs::path &p, std::error_code &ec) = 0;
+  // Streams the content of a regular file to 'visit' in one or more chunks,
+  // in order. A chunk only stays valid for the duration of the callback
+  virtual void
+  readContent(const fs::path &p,
+              const std::function<void(std::string_view)> &visit,
+              std::error_code &ec) = 0;
+  // Reads up to 'size' bytes starting at 'offset' without touching the rest
+  // of the file. Returns the number of bytes read, which is only short at the
+  // end of the file
+  virtual std::size_t readAt(const fs::path &p, std::uintmax_t offset,
+                             char *buffer, std::size_t size,
+                             std::error_code &ec) = 0;
+  // Device, inode, size and modification time of a file in a single call
+  virtual FileIdentity identity(const fs::path &p, std::error_code &ec) = 0;
+
+  // Convenience queries built on status()
+  bool exists(const fs::path &p, std::error_code &ec);
+  bool isRegularFile(const fs::path &p, std::error_code &ec);
+  bool isDirectory(const fs::path &p, std::error_code &ec);
+};
+
+// Backend that forwards every call to std::filesystem. File content is read
+// through memory-mapped windows so large files are hashed without copying.
+// On Linux folders are listed with raw getdents64 calls, whose names are
+// handed out straight from the kernel's buffer
+class RealFileSystem : public FileSystem {
+public:
+  // Bytes mapped at a time by readContent()
+  static constexpr std::uintmax_t MapWindowSize = 64ull * 1024 * 1024;
+  // Bytes of directory entries fetched per getdents64 call on Linux
+  static constexpr std::size_t ListBufferSize = 128 * 1024;
+
+  FileKind status(const fs::path &p, std::error_code &ec) override;
+  std::uintmax_t fileSize(const fs::path &p, std::error_code &ec) override;
+  fs::file_time_type lastWriteTime(const fs::path &p,
+                                   std::error_code &ec) override;
+  void listDirectory(const fs::path &dir,
+                     const std::function<void(const DirEntryView &)> &visit,
+                     std::error_code &ec) override;
+  void rename(const fs::path &from, const fs::path &to,
+              std::error_code &ec) override;
+  bool createDirectories(const fs::path &p, std::error_code &ec) override;
+  bool copyFile(const fs::path &from, const fs::path &to, CopyMode mode,
+                std::error_code &ec) override;
+  std::uintmax_t removeAll(const fs::path &p, std::error_code &ec) override;
+  void readContent(const fs::path &p,
+                   const std::function<void(std::string_view)> &visit,
+                   std::error_code &ec) override;
+  std::size_t readAt(const fs::path &p, std::uintmax_t offset, char *buffer,
+                     std::size_t size, std::error_code &ec) override;
+  FileIdentity identity(const fs::path &p, std::error_code &ec) override;
+};
+
+// Process-wide real filesystem used when callers don't inject their own
+FileSystem &DefaultFileSystem();
+
+// Fast, thread-safe in-memory backend with POSIX-like semantics (case
+// sensitive, rename replaces an existing file). Useful for tests and for
+// benchmarking planner/executor behaviour on very large trees without a disk
+class MemoryFileSystem : public FileSystem {
+public:
+  MemoryFileSystem() = default;
+
+  // Creates a file (and any missing parent directories)
+  void addFile(const fs::path &p, const std::string &content = "",
+               fs::file_time_type lastWrite = fs::file_time_type::clock::now());
+  // Creates a file of 'size' bytes without storing content; it reads back
+  // as zero bytes
+  void addSizedFile(const fs::path &p, std::uintmax_t size,
+                    fs::file_time_type lastWrite =
+                        fs::file_time_type::clock::now());
+  void addDirectory(const fs::path &p);
+  // Returns the stored content of a regular file, or empty if missing
+  std::string readFile(const fs::path &p) const;
+  std::size_t entryCount() const;
+
+  FileKind status(const fs::path &p, std::error_code &ec) override;
+  std::uintmax_t fileSize(const fs::path &p, std::error_code &ec) override;
+  fs::file_time_type lastWriteTime(const fs::path &p,
+                                   std::error_code &ec) override;
+  void listDirectory(const fs::path &dir,
+                     const std::function<void(const DirEntryView &)> &visit,
+                     std::error_code &ec) override;
+  void rename(const fs::path &from, const fs::path &to,
+              std::error_code &ec) override;
+  bool createDirectories(const fs::path &p, std::error_code &ec) override;
+  bool copyFile(const fs::path &from, const fs::path &to, CopyMode mode,
+                std::error_code &ec) override;
+  std::uintmax_t removeAll(const fs::path &p, std::error_code &ec) override;
+  void readContent(const fs::path &p,
+                   const std::function<void(std::string_view)> &visit,
+                   std::error_code &ec) override;
+  std::size_t readAt(const fs::path &p, std::uintmax_t offset, char *buffer,
+                     std::size_t size, std::error_code &ec) override;
+  FileIdentity identity(const fs::path &p, std::error_code &ec) override;
+
+private:
+  struct Node {
+    FileKind kind = FileKind::Regular;
+    std::string content;
+    std::uintmax_t size = 0;
+    fs::file_time_type lastWrite{};
+    std::uint64_t inode = 0; // Kept across renames, like a real inode
+  };
+
+  static std::string Key(const fs::path &p);
+  static std::string ParentKey(const std::string &key);
+  void createDirectoriesLocked(const std::string &key);
+
+  mutable std::mutex m_mutex;
+  std::map<std::string, Node> m_nodes; // Keyed by normalized generic path
+  std::uint64_t m_nextInode = 1;
+};
+
+// Settings for LatencyFileSystem
+struct LatencyConfig {
+  std::chrono::microseconds latency{0}; // Added to every call
+  std::chrono::microseconds jitter{0};  // Uniform random extra per call
+  double failureRate = 0.0;             // Probability [0,1] a call fails
+  std::uint32_t seed = 0;               // Seed for jitter and failures
+  // Deterministic fault hook; returning true makes the call fail
+  std::function<bool(FileOp, const fs::path &)> failWhen;
+  // Error reported by injected failures, e.g. cross_device_link to make
+  // renames behave as if they crossed a mount point
+  std::errc failureError = std::errc::io_error;
+};
+
+// Decorator that adds per-call latency and fault injection to another backend
+// so slow network mounts and flaky disks can be reproduced locally. Injected
+// failures report LatencyConfig::failureError without reaching the wrapped
+// backend
+class LatencyFileSystem : public FileSystem {
+public:
+  LatencyFileSystem(FileSystem &inner, LatencyConfig config);
+
+  // Number of calls made for 'op' (including injected failures)
+  std::uint64_t callCount(FileOp op) const;
+  std::uint64_t totalCalls() const;
+
+  FileKind status(const fs::path &p, std::error_code &ec) override;
+  std::uintmax_t fileSize(const fs::path &p, std::error_code &ec) override;
+  fs::file_time_type lastWriteTime(const fs::path &p,
+                                   std::error_code &ec) override;
+  void listDirectory(const fs::path &dir,
+                     const std::function<void(const DirEntryView &)> &visit,
+                     std::error_code &ec) override;
+  void rename(const fs::path &from, const fs::path &to,
+              std::error_code &ec) override;
+  bool createDirectories(const fs::path &p, std::error_code &ec) override;
+  bool copyFile(const fs::path &from, const fs::path &to, CopyMode mode,
+                std::error_code &ec) override;
+  std::uintmax_t removeAll(const fs::path &p, std::error_code &ec) override;
+  void readContent(const fs::path &p,
+                   const std::function<void(std::string_view)> &visit,
+                   std::error_code &ec) override;
+  std::size_t readAt(const fs::path &p, std::uintmax_t offset, char *buffer,
+                     std::size_t size, std::error_code &ec) override;
+  FileIdentity identity(const fs::path &p, std::error_code &ec) override;
+
+private:
+  // Sleeps for the configured latency and returns false if the call must fail
+  bool beginCall(FileOp op, const fs::path &p, std::error_code &ec);
+
+  FileSystem &m_inner;
+  LatencyConfig m_config;
+  std::mutex m_rngMutex;
+  std::mt19937 m_rng;
+  std::array<std::atomic<std::uint64_t>, static_cast<size_t>(FileOp::Count)>
+      m_calls{};
+};
+
+#endif // FILESYSTEM_H
@@ -0,0 +1,105 @@
+#include "FreeNameIndex.h"
+#include "RenamerLogic.h"
+
+#include <utility>
+
+FreeNameIndex::FreeNameIndex(std::string suffix, FileSystem &fileSystem,
+                             const std::set<fs::path> &sources)
+    : m_suffix(std::move(suffix)), m_fileSystem(fileSystem),
+      m_sources(sources) {
+  if (m_suffix.find('#') == std::string::npos) {
+    m_suffix += '#';
+  }
+}
+
+bool FreeNameIndex::ValidSuffix(std::string_view suffix) {
+  constexpr std::string_view unsafe = R"(\/:*?"<>|)";
+  for (unsigned char c : suffix) {
+    if (c <= 31 || unsafe.find(c) != std::string_view::npos) {
+      return false;
+    }
+  }
+  return true;
+}
+
+FreeNameIndex::Folder *FreeNameIndex::folder(const fs::path &dir,
+                                             std::error_code &ec) {
+  auto [it, added] = m_folders.try_emplace(ToLower(dir.string()));
+  if (!added) {
+    return &it->second;
+  }
+  std::unordered_set<std::string> &taken = it->second.taken;
+  m_fileSystem.listDirectory(
+      dir,
+      [&](const DirEntryView &entry) {
+        std::string name(entry.name);
+        const fs::path path = dir / fs::path(name);
+        if (m_sources.count(path) == 0 || m_kept.count(path) != 0) {
+          taken.insert(ToLower(std::move(name)));
+        }
+      },
+      ec);
+  if (ec == std::errc::no_such_file_or_directory) {
+    ec.clear(); // A folder the rename creates starts out empty
+  }
+  if (ec) {
+    m_folders.erase(it); // Listed again, and reported again, next time
+    return nullptr;
+  }
+  return &it->second;
+}
+
+void FreeNameIndex::keep(const fs::path &source) {
+  m_kept.insert(source);
+  // A folder listed already treated the name as free
+  auto it = m_folders.find(ToLower(source.parent_path().string()));
+  if (it != m_folders.end()) {
+    it->second.taken.insert(ToLower(source.filename().string()));
+  }
+}
+
+std::string FreeNameIndex::suffixFor(int counter) const {
+  const std::string digits = std::to_string(counter);
+  std::string text;
+  for (std::size_t i = 0; i < m_suffix.size();) {
+    if (m_suffix[i] != '#') {
+      text += m_suffix[i++];
+      continue;
+    }
+    std::size_t width = 0;
+    for (; i < m_suffix.size() && m_suffix[i] == '#'; ++i) {
+      ++width;
+    }
+    if (digits.size() < width) {
+      text.append(width - digits.size(), '0');
+    }
+    text += digits;
+  }
+  return text;
+}
+
+fs::path FreeNameIndex::claim(const fs::path &target, bool isDirectory,
+                              std::error_code &ec) {
+  Folder *index = folder(target.parent_path(), ec);
+  if (!index) {
+    return target;
+  }
+  std::string name = target.filename().string();
+  std::string lower = ToLower(name);
+  if (index->taken.insert(lower).second) {
+    return target;
+  }
+
+  // A folder's whole name is its stem, as in the planner
+  const std::size_t stemLength =
+      isDirectory ? name.size()
+                  : name.size() - target.extension().string().size();
+  int &counter = index->counters.try_emplace(lower, 1).first->second;
+  for (;;) {
+    std::string candidate = name.substr(0, stemLength) + suffixFor(++counter) +
+                            name.substr(stemLength);
+    if (index->taken.insert(ToLower(candidate)).second) {
+      return target.parent_path() / candidate;
+    }
+  }
+}
@@ -0,0 +1,57 @@
+#ifndef FREENAMEINDEX_H
+#define FREENAMEINDEX_H
+
+#include "FileSystem.h"
+
+#include <set>
+#include <string>
+#include <string_view>
+#include <unordered_map>
+#include <unordered_set>
+
+// Hands out conflict-free target names for one plan. Each target folder is
+// listed once; after that names are checked against an in-memory index of
+// taken names, never on disk. Every colliding name remembers the last
+// counter it was given, so resolving many collisions on the same name costs
+// constant time each
+class FreeNameIndex {
+public:
+  // 'suffix' is added after a colliding name's stem with each run of '#'
+  // replaced by the counter, zero-padded to the run's length: " (#)" gives
+  // "photo (2).jpg" and "_###" gives "photo_002.jpg". Without a '#' the
+  // counter follows the suffix. Paths in 'sources' are being renamed away,
+  // so their names count as free
+  FreeNameIndex(std::string suffix, FileSystem &fileSystem,
+                const std::set<fs::path> &sources);
+
+  // 'source' is not renamed after all, so its name stays taken. Must be
+  // called before any claim that might otherwise be given its name
+  void keep(const fs::path &source);
+
+  // Claims 'target' if it is free, otherwise its first free suffixed
+  // variant, counting from 2. A folder's suffix goes after its whole name.
+  // Sets 'ec' and claims nothing if the target folder can't be listed
+  fs::path claim(const fs::path &target, bool isDirectory,
+                 std::error_code &ec);
+
+  // False if 'suffix' contains characters a file name can't hold
+  static bool ValidSuffix(std::string_view suffix);
+
+private:
+  struct Folder {
+    std::unordered_set<std::string> taken; // Lowercase names
+    // Lowercase colliding name -> last counter tried for it
+    std::unordered_map<std::string, int> counters;
+  };
+
+  Folder *folder(const fs::path &dir, std::error_code &ec);
+  std::string suffixFor(int counter) const;
+
+  std::string m_suffix;
+  FileSystem &m_fileSystem;
+  const std::set<fs::path> &m_sources;
+  std::set<fs::path> m_kept; // Sources that keep their names
+  std::unordered_map<std::string, Folder> m_folders; // By lowercase path
+};
+
+#endif // FREENAMEINDEX_H
@@ -0,0 +1,407 @@
+#include "MediaDate.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdint>
+#include <cstdio>
+#include <ctime>
+#include <limits>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+constexpr std::string_view ExifDateTag = "<exif_date>";
+constexpr std::string_view ExifTimeTag = "<exif_time>";
+constexpr int MaxJpegSegments = 64; // Metadata sits in the first few
+constexpr int MaxBoxes = 64;        // Per MP4 container level
+constexpr unsigned MaxIfdEntries = 512;
+// Seconds from 1904-01-01 (the QuickTime epoch) to 1970-01-01
+constexpr std::uint64_t QuickTimeEpochOffset = 2082844800ull;
+constexpr std::uint64_t MaxUnixSeconds = 253402300799ull; // 9999-12-31
+
+inline unsigned Byte(std::string_view s, std::size_t i) {
+  return static_cast<unsigned char>(s[i]);
+}
+
+std::uint32_t ReadBE32(std::string_view s, std::size_t i) {
+  return (std::uint32_t(Byte(s, i)) << 24) | (Byte(s, i + 1) << 16) |
+         (Byte(s, i + 2) << 8) | Byte(s, i + 3);
+}
+
+std::uint64_t ReadBE64(std::string_view s, std::size_t i) {
+  return (std::uint64_t(ReadBE32(s, i)) << 32) | ReadBE32(s, i + 4);
+}
+
+// Integer reader for TIFF's file-declared byte order
+struct TiffOrder {
+  bool little = true;
+  std::uint32_t u16(std::string_view s, std::size_t i) const {
+    return little ? Byte(s, i) | (Byte(s, i + 1) << 8)
+                  : (Byte(s, i) << 8) | Byte(s, i + 1);
+  }
+  std::uint32_t u32(std::string_view s, std::size_t i) const {
+    return little ? u16(s, i) | (u16(s, i + 2) << 16)
+                  : (u16(s, i) << 16) | u16(s, i + 2);
+  }
+};
+
+// Serves byte ranges of one file: the first MediaHeaderReadSize bytes come
+// from a single read made up front, anything further away costs one
+// positional read. A view returned by read() is only valid until the next
+// call
+class HeaderReader {
+public:
+  HeaderReader(FileSystem &fileSystem, const fs::path &p, std::error_code &ec)
+      : m_fileSystem(fileSystem), m_path(p), m_ec(ec) {
+    m_head.resize(MediaHeaderReadSize);
+    m_head.resize(m_fileSystem.readAt(p, 0, m_head.data(), m_head.size(), ec));
+  }
+
+  // Up to 'size' bytes at 'offset'; shorter at the end of the file
+  std::string_view read(std::uint64_t offset, std::size_t size) {
+    if (offset <= m_head.size() && size <= m_head.size() - offset) {
+      return std::string_view(m_head).substr(offset, size);
+    }
+    if (m_ec || offset > std::numeric_limits<std::uint64_t>::max() - size) {
+      return {};
+    }
+    m_scratch.resize(size);
+    m_scratch.resize(
+        m_fileSystem.readAt(m_path, offset, m_scratch.data(), size, m_ec));
+    return m_scratch;
+  }
+
+  std::string_view head() const { return m_head; }
+
+private:
+  FileSystem &m_fileSystem;
+  const fs::path &m_path;
+  std::error_code &m_ec;
+  std::string m_head;
+  std::string m_scratch;
+};
+
+// "YYYY:MM:DD HH:MM:SS" as stored by EXIF. Blank or malformed values (some
+// cameras write spaces or zeros when the clock was never set) are rejected
+std::optional<CaptureDate> ParseExifDateTime(std::string_view s) {
+  if (s.size() < 19) {
+    return std::nullopt;
+  }
+  auto number = [&](std::size_t pos, std::size_t digits) {
+    int value = 0;
+    for (std::size_t i = pos; i < pos + digits; ++i) {
+      if (s[i] < '0' || s[i] > '9') {
+        return -1;
+      }
+      value = value * 10 + (s[i] - '0');
+    }
+    return value;
+  };
+  CaptureDate date;
+  date.year = number(0, 4);
+  date.month = number(5, 2);
+  date.day = number(8, 2);
+  date.hour = number(11, 2);
+  date.minute = number(14, 2);
+  date.second = number(17, 2);
+  if (date.year < 1 || date.month < 1 || date.month > 12 || date.day < 1 ||
+      date.day > 31 || date.hour < 0 || date.hour > 23 || date.minute < 0 ||
+      date.minute > 59 || date.second < 0 || date.second > 60) {
+    return std::nullopt;
+  }
+  return date;
+}
+
+// Civil date from days since 1970-01-01 (Howard Hinnant's algorithm), so UTC
+// timestamps don't depend on the platform's gmtime
+CaptureDate FromUnixSeconds(std::int64_t seconds) {
+  std::int64_t days = seconds / 86400;
+  std::int64_t rest = seconds % 86400;
+  if (rest < 0) {
+    rest += 86400;
+    --days;
+  }
+  days += 719468;
+  const std::int64_t era = (days >= 0 ? days : days - 146096) / 146097;
+  const std::int64_t dayOfEra = days - era * 146097;
+  const std::int64_t yearOfEra =
+      (dayOfEra - dayOfEra / 1460 + dayOfEra / 36524 - dayOfEra / 146096) / 365;
+  const std::int64_t dayOfYear =
+      dayOfEra - (365 * yearOfEra + yearOfEra / 4 - yearOfEra / 100);
+  const std::int64_t mp = (5 * dayOfYear + 2) / 153;
+  CaptureDate date;
+  date.day = static_cast<int>(dayOfYear - (153 * mp + 2) / 5 + 1);
+  date.month = static_cast<int>(mp < 10 ? mp + 3 : mp - 9);
+  date.year = static_cast<int>(yearOfEra + era * 400 + (date.month <= 2));
+  date.hour = static_cast<int>(rest / 3600);
+  date.minute = static_cast<int>(rest % 3600 / 60);
+  date.second = static_cast<int>(rest % 60);
+  return date;
+}
+
+// Tag ids of the dates EXIF can carry, plus the pointer to the Exif sub-IFD
+enum TiffTag : std::uint32_t {
+  TagDateTime = 0x0132,
+  TagExifIfd = 0x8769,
+  TagDateTimeOriginal = 0x9003,
+  TagDateTimeDigitized = 0x9004,
+};
+constexpr std::uint32_t TypeAscii = 2;
+constexpr std::uint32_t TypeLong = 4;
+
+// Walks IFD0 and the Exif sub-IFD of the TIFF structure at 'tiffStart'. All
+// offsets inside it are relative to that position
+std::optional<CaptureDate> ParseTiff(HeaderReader &reader,
+                                     std::uint64_t tiffStart) {
+  std::string_view header = reader.read(tiffStart, 8);
+  if (header.size() < 8 || (header.substr(0, 2) != "II" &&
+                            header.substr(0, 2) != "MM")) {
+    return std::nullopt;
+  }
+  TiffOrder order{header[0] == 'I'};
+  if (order.u16(header, 2) != 42) {
+    return std::nullopt;
+  }
+
+  std::optional<CaptureDate> dates[3]; // Original, digitized, modified
+  std::uint32_t exifIfd = 0;
+  std::uint32_t ifd = order.u32(header, 4);
+  for (int level = 0; level < 2 && ifd != 0; ++level) {
+    std::string_view countBytes = reader.read(tiffStart + ifd, 2);
+    if (countBytes.size() < 2) {
+      break;
+    }
+    const unsigned count =
+        std::min<unsigned>(order.u16(countBytes, 0), MaxIfdEntries);
+    // Copied because reading a value below reuses the reader's buffer
+    const std::string entries(reader.read(tiffStart + ifd + 2, count * 12));
+    for (std::size_t e = 0; e + 12 <= entries.size(); e += 12) {
+      const std::uint32_t tag = order.u16(entries, e);
+      const std::uint32_t type = order.u16(entries, e + 2);
+      const std::uint32_t valueCount = order.u32(entries, e + 4);
+      const std::uint32_t value = order.u32(entries, e + 8);
+      if (tag == TagExifIfd && type == TypeLong && level == 0) {
+        exifIfd = value;
+        continue;
+      }
+      const int slot = tag == TagDateTimeOriginal    ? 0
+                       : tag == TagDateTimeDigitized ? 1
+                       : tag == TagDateTime          ? 2
+                                                     : -1;
+      if (slot >= 0 && type == TypeAscii && valueCount >= 19) {
+        dates[slot] = ParseExifDateTime(reader.read(tiffStart + value, 19));
+      }
+    }
+    if (dates[0]) {
+      break; // Nothing ranks above DateTimeOriginal
+    }
+    ifd = exifIfd;
+  }
+  for (const std::optional<CaptureDate> &date : dates) {
+    if (date) {
+      return date;
+    }
+  }
+  return std::nullopt;
+}
+
+// Follows the JPEG marker segments up to the image data, looking for the
+// APP1 segment that carries EXIF
+std::optional<CaptureDate> ParseJpeg(HeaderReader &reader) {
+  std::uint64_t pos = 2; // After SOI
+  for (int segment = 0; segment < MaxJpegSegments; ++segment) {
+    std::string_view marker = reader.read(pos, 4);
+    if (marker.size() < 4 || Byte(marker, 0) != 0xFF) {
+      return std::nullopt;
+    }
+    const unsigned type = Byte(marker, 1);
+    if (type == 0xFF) {
+      pos += 1; // Fill byte
+      continue;
+    }
+    if (type == 0xDA || type == 0xD9) {
+      return std::nullopt; // Start of scan or end of image: no more metadata
+    }
+    const std::uint32_t length = (Byte(marker, 2) << 8) | Byte(marker, 3);
+    if (type == 0xE1 && length >= 8 &&
+        reader.read(pos + 4, 6) == std::string_view("Exif\0\0", 6)) {
+      return ParseTiff(reader, pos + 10);
+    }
+    pos += 2 + length;
+  }
+  return std::nullopt;
+}
+
+// Finds the first box of 'type' among the boxes in [begin, end). Returns the
+// range of its payload
+std::optional<std::pair<std::uint64_t, std::uint64_t>>
+FindBox(HeaderReader &reader, std::uint64_t begin, std::uint64_t end,
+        std::string_view type) {
+  std::uint64_t pos = begin;
+  for (int box = 0; box < MaxBoxes && pos < end && end - pos >= 8; ++box) {
+    std::string_view header = reader.read(pos, 16);
+    if (header.size() < 8) {
+      return std::nullopt;
+    }
+    std::uint64_t size = ReadBE32(header, 0);
+    std::uint64_t headerSize = 8;
+    if (size == 1) { // 64-bit size follows the type
+      if (header.size() < 16) {
+        return std::nullopt;
+      }
+      size = ReadBE64(header, 8);
+      headerSize = 16;
+    } else if (size == 0) {
+      size = end - pos; // Box runs to the end of its container
+    }
+    if (size < headerSize || size > end - pos) {
+      return std::nullopt;
+    }
+    if (header.substr(4, 4) == type) {
+      return std::make_pair(pos + headerSize, pos + size);
+    }
+    pos += size; // Skipped without reading, however large (e.g. 'mdat')
+  }
+  return std::nullopt;
+}
+
+// Creation time from moov/mvhd of an MP4 or QuickTime file
+std::optional<CaptureDate> ParseMp4(HeaderReader &reader) {
+  const auto moov = FindBox(reader, 0,
+                            std::numeric_limits<std::uint64_t>::max(), "moov");
+  if (!moov) {
+    return std::nullopt;
+  }
+  const auto mvhd = FindBox(reader, moov->first, moov->second, "mvhd");
+  if (!mvhd) {
+    return std::nullopt;
+  }
+  std::string_view payload = reader.read(mvhd->first, 12);
+  if (payload.size() < 8) {
+    return std::nullopt;
+  }
+  std::uint64_t created = 0;
+  if (Byte(payload, 0) == 1) { // Version 1: 64-bit times
+    if (payload.size() < 12) {
+      return std::nullopt;
+    }
+    created = ReadBE64(payload, 4);
+  } else {
+    created = ReadBE32(payload, 4);
+  }
+  if (created <= QuickTimeEpochOffset ||
+      created - QuickTimeEpochOffset > MaxUnixSeconds) {
+    return std::nullopt; // Unset (0), before 1970 or garbage
+  }
+  return FromUnixSeconds(
+      static_cast<std::int64_t>(created - QuickTimeEpochOffset));
+}
+
+bool IsMp4(std::string_view head) {
+  if (head.size() < 8) {
+    return false;
+  }
+  const std::string_view type = head.substr(4, 4);
+  return type == "ftyp" || type == "moov" || type == "mdat" ||
+         type == "wide" || type == "free" || type == "skip";
+}
+
+void ReplaceAll(std::string &text, std::string_view tag,
+                const std::string &value) {
+  std::size_t pos = text.find(tag);
+  while (pos != std::string::npos) {
+    text.replace(pos, tag.size(), value);
+    pos = text.find(tag, pos + value.size());
+  }
+}
+} // namespace
+
+std::string CaptureDate::dateString() const {
+  char text[16];
+  std::snprintf(text, sizeof(text), "%04d%02d%02d", year % 10000, month, day);
+  return text;
+}
+
+std::string CaptureDate::timeString() const {
+  char text[16];
+  std::snprintf(text, sizeof(text), "%02d%02d%02d", hour, minute, second);
+  return text;
+}
+
+std::optional<CaptureDate> ReadCaptureDate(FileSystem &fileSystem,
+                                           const fs::path &p,
+                                           std::error_code &ec) {
+  HeaderReader reader(fileSystem, p, ec);
+  if (ec) {
+    return std::nullopt;
+  }
+  const std::string_view head = reader.head();
+  std::optional<CaptureDate> date;
+  if (head.size() >= 3 && Byte(head, 0) == 0xFF && Byte(head, 1) == 0xD8 &&
+      Byte(head, 2) == 0xFF) {
+    date = ParseJpeg(reader);
+  } else if (head.size() >= 4 &&
+             (head.substr(0, 4) == std::string_view("II*\0", 4) ||
+              head.substr(0, 4) == std::string_view("MM\0*", 4))) {
+    date = ParseTiff(reader, 0);
+  } else if (IsMp4(head)) {
+    date = ParseMp4(reader);
+  }
+  return ec ? std::nullopt : date;
+}
+
+CaptureDate LocalDateOf(fs::file_time_type time) {
+  auto sctp = std::chrono::time_point_cast<std::chrono::system_clock::duration>(
+      time - fs::file_time_type::clock::now() +
+      std::chrono::system_clock::now());
+  auto time_c = std::chrono::system_clock::to_time_t(sctp);
+  std::tm time_tm = {};
+#ifdef _WIN32
+  localtime_s(&time_tm, &time_c);
+#else
+  localtime_r(&time_c, &time_tm);
+#endif
+  CaptureDate date;
+  date.year = time_tm.tm_year + 1900;
+  date.month = time_tm.tm_mon + 1;
+  date.day = time_tm.tm_mday;
+  date.hour = time_tm.tm_hour;
+  date.minute = time_tm.tm_min;
+  date.second = time_tm.tm_sec;
+  return date;
+}
+
+CaptureDate CaptureDateOrModified(FileSystem &fileSystem, const fs::path &p) {
+  std::error_code ec;
+  return CaptureDateOrModified(fileSystem, p, ec);
+}
+
+CaptureDate CaptureDateOrModified(FileSystem &fileSystem, const fs::path &p,
+                                  std::error_code &ec) {
+  if (std::optional<CaptureDate> date = ReadCaptureDate(fileSystem, p, ec)) {
+    return *date;
+  }
+  std::error_code timeEc;
+  const fs::file_time_type lastWrite = fileSystem.lastWriteTime(p, timeEc);
+  if (timeEc) {
+    ec = timeEc;
+    return CaptureDate();
+  }
+  return LocalDateOf(lastWrite); // 'ec' keeps a failed header read
+}
+
+std::string ExpandCaptureDatePlaceholders(std::string_view pattern,
+                                          const CaptureDate &date) {
+  std::string result(pattern);
+  if (result.find(ExifDateTag) != std::string::npos) {
+    ReplaceAll(result, ExifDateTag, date.dateString());
+  }
+  if (result.find(ExifTimeTag) != std::string::npos) {
+    ReplaceAll(result, ExifTimeTag, date.timeString());
+  }
+  return result;
+}
+
+bool ReferencesCaptureDate(std::string_view pattern) {
+  return pattern.find(ExifDateTag) != std::string_view::npos ||
+         pattern.find(ExifTimeTag) != std::string_view::npos;
+}
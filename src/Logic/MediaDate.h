@@ -0,0 +1,54 @@
+#ifndef MEDIADATE_H
+#define MEDIADATE_H
+
+#include "FileSystem.h"
+
+#include <optional>
+#include <string>
+#include <string_view>
+#include <system_error>
+
+// Calendar date and time of day, as recorded by a camera or the filesystem
+struct CaptureDate {
+  int year = 0;
+  int month = 0;
+  int day = 0;
+  int hour = 0;
+  int minute = 0;
+  int second = 0;
+
+  std::string dateString() const; // YYYYMMDD
+  std::string timeString() const; // hhmmss
+};
+
+// Bytes read from the start of a file before any header is parsed; formats
+// that point further into the file fetch just the bytes they need
+constexpr std::size_t MediaHeaderReadSize = 4096;
+
+// Reads the capture date from the header of a JPEG (EXIF APP1), a TIFF-based
+// file (TIFF and most camera raw formats) or an MP4/QuickTime file (mvhd
+// box), preferring DateTimeOriginal over the other EXIF dates. Only a few
+// small positional reads are made, never the whole file. Returns nullopt for
+// other formats or files without a date; 'ec' is only set for I/O errors.
+// MP4 dates are stored in UTC and returned as such
+std::optional<CaptureDate> ReadCaptureDate(FileSystem &fileSystem,
+                                           const fs::path &p,
+                                           std::error_code &ec);
+
+// Local calendar date of a file timestamp
+CaptureDate LocalDateOf(fs::file_time_type time);
+
+// The capture date if the file has one, else its last modification time.
+// All zeros if neither can be read
+CaptureDate CaptureDateOrModified(FileSystem &fileSystem, const fs::path &p);
+// As above; 'ec' is set if the file couldn't be read, the date returned then
+// being only a fallback that mustn't be remembered
+CaptureDate CaptureDateOrModified(FileSystem &fileSystem, const fs::path &p,
+                                  std::error_code &ec);
+
+// Replaces <exif_date> (YYYYMMDD) and <exif_time> (hhmmss) in 'pattern'
+std::string ExpandCaptureDatePlaceholders(std::string_view pattern,
+                                          const CaptureDate &date);
+bool ReferencesCaptureDate(std::string_view pattern);
+
+#endif // MEDIADATE_H
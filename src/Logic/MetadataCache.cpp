@@ -0,0 +1,257 @@
+#include "MetadataCache.h"
+
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <string_view>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+// File layout, all integers little-endian:
+//   header: "RUMC", u32 version, u64 entry count
+//   entry:  u64 device, u64 inode, u64 size, i64 mtime (ns), u64 hash,
+//           u64 packed capture date, u32 flags, u32 reserved
+constexpr std::string_view Magic = "RUMC";
+constexpr std::uint32_t FormatVersion = 1;
+constexpr std::size_t HeaderSize = 16;
+constexpr std::size_t RecordSize = 56;
+
+enum RecordFlag : std::uint32_t {
+  HasContentHash = 1u << 0,
+  HasCaptureDate = 1u << 1,
+};
+
+void PutU32(std::string &out, std::uint32_t v) {
+  for (int i = 0; i < 4; ++i) {
+    out += static_cast<char>((v >> (8 * i)) & 0xFF);
+  }
+}
+
+void PutU64(std::string &out, std::uint64_t v) {
+  PutU32(out, static_cast<std::uint32_t>(v));
+  PutU32(out, static_cast<std::uint32_t>(v >> 32));
+}
+
+std::uint32_t GetU32(std::string_view s, std::size_t i) {
+  std::uint32_t v = 0;
+  for (int b = 3; b >= 0; --b) {
+    v = (v << 8) | static_cast<unsigned char>(s[i + b]);
+  }
+  return v;
+}
+
+std::uint64_t GetU64(std::string_view s, std::size_t i) {
+  return GetU32(s, i) | (std::uint64_t(GetU32(s, i + 4)) << 32);
+}
+
+// YYYYMMDDhhmmss as a single integer
+std::uint64_t PackDate(const CaptureDate &d) {
+  std::uint64_t packed = static_cast<std::uint64_t>(d.year);
+  for (int part : {d.month, d.day, d.hour, d.minute, d.second}) {
+    packed = packed * 100 + static_cast<std::uint64_t>(part);
+  }
+  return packed;
+}
+
+CaptureDate UnpackDate(std::uint64_t packed) {
+  CaptureDate d;
+  d.second = static_cast<int>(packed % 100);
+  d.minute = static_cast<int>(packed / 100 % 100);
+  d.hour = static_cast<int>(packed / 10000 % 100);
+  d.day = static_cast<int>(packed / 1000000 % 100);
+  d.month = static_cast<int>(packed / 100000000 % 100);
+  d.year = static_cast<int>(packed / 10000000000ull % 10000);
+  return d;
+}
+} // namespace
+
+MetadataCache::MetadataCache(fs::path file, std::size_t capacity)
+    : m_file(std::move(file)), m_capacity(capacity) {}
+
+std::size_t MetadataCache::size() const {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  return m_lru.size();
+}
+
+// Adds an entry known not to be present, evicting from the cold end
+void MetadataCache::insertLocked(const Entry &entry, bool front) {
+  if (m_capacity == 0) {
+    return;
+  }
+  auto it = front ? m_lru.insert(m_lru.begin(), entry)
+                  : m_lru.insert(m_lru.end(), entry);
+  m_index[Key{entry.identity.device, entry.identity.inode}] = it;
+  while (m_lru.size() > m_capacity) {
+    const FileIdentity &cold = m_lru.back().identity;
+    m_index.erase(Key{cold.device, cold.inode});
+    m_lru.pop_back();
+  }
+}
+
+bool MetadataCache::lookup(const FileIdentity &id, CachedMetadata &values) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  auto found = m_index.find(Key{id.device, id.inode});
+  if (found == m_index.end()) {
+    return false;
+  }
+  LruList::iterator entry = found->second;
+  if (entry->identity != id) {
+    m_lru.erase(entry); // Modified (or a reused inode): the values are stale
+    m_index.erase(found);
+    m_dirty = true;
+    return false;
+  }
+  m_lru.splice(m_lru.begin(), m_lru, entry);
+  values = entry->values;
+  return true;
+}
+
+void MetadataCache::store(const FileIdentity &id,
+                          const CachedMetadata &values) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_dirty = true;
+  auto found = m_index.find(Key{id.device, id.inode});
+  if (found != m_index.end()) {
+    LruList::iterator entry = found->second;
+    if (entry->identity != id) {
+      entry->identity = id;
+      entry->values = CachedMetadata();
+    }
+    if (values.contentHash) {
+      entry->values.contentHash = values.contentHash;
+    }
+    if (values.captureDate) {
+      entry->values.captureDate = values.captureDate;
+    }
+    m_lru.splice(m_lru.begin(), m_lru, entry);
+    return;
+  }
+  insertLocked(Entry{id, values}, true);
+}
+
+bool MetadataCache::load(std::error_code &ec) {
+  ec.clear();
+  std::lock_guard<std::mutex> lock(m_mutex);
+  m_lru.clear();
+  m_index.clear();
+  m_dirty = false;
+  if (m_file.empty()) {
+    return true;
+  }
+
+  FileSystem &fileSystem = DefaultFileSystem();
+  if (fileSystem.status(m_file, ec) == FileKind::NotFound) {
+    return !ec;
+  }
+  // Records are parsed straight out of the mapped view; 'pending' only holds
+  // a header or record split across two mapped windows
+  std::string pending;
+  std::uint64_t remaining = 0;
+  bool headerRead = false;
+  bool valid = true;
+  auto consume = [&](std::string_view unit) {
+    if (!headerRead) {
+      headerRead = true;
+      valid = unit.substr(0, Magic.size()) == Magic &&
+              GetU32(unit, 4) == FormatVersion;
+      remaining = valid ? GetU64(unit, 8) : 0;
+      return;
+    }
+    --remaining;
+    Entry entry;
+    entry.identity.device = GetU64(unit, 0);
+    entry.identity.inode = GetU64(unit, 8);
+    entry.identity.size = GetU64(unit, 16);
+    entry.identity.modifiedNs = static_cast<std::int64_t>(GetU64(unit, 24));
+    const std::uint32_t flags = GetU32(unit, 48);
+    if (flags & HasContentHash) {
+      entry.values.contentHash = GetU64(unit, 32);
+    }
+    if (flags & HasCaptureDate) {
+      entry.values.captureDate = UnpackDate(GetU64(unit, 40));
+    }
+    if (m_index.count(Key{entry.identity.device, entry.identity.inode}) == 0) {
+      insertLocked(entry, false); // Saved most recently used first
+    }
+  };
+  fileSystem.readContent(
+      m_file,
+      [&](std::string_view chunk) {
+        while (valid && !chunk.empty() && (!headerRead || remaining > 0)) {
+          const std::size_t unit = headerRead ? RecordSize : HeaderSize;
+          if (pending.empty() && chunk.size() >= unit) {
+            consume(chunk.substr(0, unit));
+            chunk.remove_prefix(unit);
+            continue;
+          }
+          const std::size_t take =
+              std::min(unit - pending.size(), chunk.size());
+          pending.append(chunk.data(), take);
+          chunk.remove_prefix(take);
+          if (pending.size() == unit) {
+            consume(pending);
+            pending.clear();
+          }
+        }
+      },
+      ec);
+  if (ec || !valid) {
+    m_lru.clear();
+    m_index.clear();
+    return !ec; // A foreign or outdated file just starts the cache afresh
+  }
+  return true;
+}
+
+bool MetadataCache::save(std::error_code &ec) {
+  ec.clear();
+  std::string data;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    if (m_file.empty() || !m_dirty) {
+      return true;
+    }
+    data.reserve(HeaderSize + m_lru.size() * RecordSize);
+    data.append(Magic);
+    PutU32(data, FormatVersion);
+    PutU64(data, m_lru.size());
+    for (const Entry &entry : m_lru) {
+      const std::uint32_t flags =
+          (entry.values.contentHash ? HasContentHash : 0u) |
+          (entry.values.captureDate ? HasCaptureDate : 0u);
+      PutU64(data, entry.identity.device);
+      PutU64(data, entry.identity.inode);
+      PutU64(data, entry.identity.size);
+      PutU64(data, static_cast<std::uint64_t>(entry.identity.modifiedNs));
+      PutU64(data, entry.values.contentHash.value_or(0));
+      PutU64(data, entry.values.captureDate
+                       ? PackDate(*entry.values.captureDate)
+                       : 0);
+      PutU32(data, flags);
+      PutU32(data, 0);
+    }
+    m_dirty = false;
+  }
+
+  fs::path temp = m_file;
+  temp += ".tmp";
+  std::error_code dirEc; // Reported by the write below if it matters
+  fs::create_directories(m_file.parent_path(), dirEc);
+  {
+    std::ofstream out(temp, std::ios::binary | std::ios::trunc);
+    if (!out || !out.write(data.data(), data.size()) || !out.flush()) {
+      ec = std::make_error_code(std::errc::io_error);
+    }
+  }
+  if (!ec) {
+    DefaultFileSystem().rename(temp, m_file, ec);
+  }
+  if (ec) {
+    std::error_code removeEc;
+    fs::remove(temp, removeEc);
+    std::lock_guard<std::mutex> lock(m_mutex);
+    m_dirty = true; // Try again next time
+    return false;
+  }
+  return true;
+}
@@ -0,0 +1,81 @@
+#ifndef METADATACACHE_H
+#define METADATACACHE_H
+
+#include "FileSystem.h"
+#include "MediaDate.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <list>
+#include <mutex>
+#include <optional>
+#include <system_error>
+#include <unordered_map>
+
+// Values derived from a file's content that are expensive to recompute
+struct CachedMetadata {
+  std::optional<std::uint64_t> contentHash; // <hash:N>
+  std::optional<CaptureDate> captureDate;   // <exif_date>, <exif_time>
+};
+
+// Persistent cache of CachedMetadata keyed by file identity, so repeated
+// previews of the same folder read each file once. An entry is only returned
+// while the file's size and modification time still match what was cached;
+// renaming a file keeps its entry. The least recently used entries are
+// dropped beyond 'capacity'. Thread-safe
+class MetadataCache {
+public:
+  static constexpr std::size_t DefaultCapacity = 200000;
+
+  explicit MetadataCache(fs::path file = fs::path(),
+                         std::size_t capacity = DefaultCapacity);
+
+  // Replaces the contents with the cache file, which is memory-mapped while
+  // it is parsed. A missing file leaves the cache empty without an error; a
+  // file in another format is ignored
+  bool load(std::error_code &ec);
+  // Writes the entries, most recently used first, through a temporary file
+  // so an interrupted save never leaves a truncated cache behind. Does
+  // nothing if no entry changed since the last load or save
+  bool save(std::error_code &ec);
+
+  // Copies the values cached for 'id' into 'values'. Returns false, and
+  // forgets the entry, if the file changed since it was cached
+  bool lookup(const FileIdentity &id, CachedMetadata &values);
+  // Merges 'values' into the entry for 'id'
+  void store(const FileIdentity &id, const CachedMetadata &values);
+
+  std::size_t size() const;
+  const fs::path &file() const { return m_file; }
+
+private:
+  struct Entry {
+    FileIdentity identity;
+    CachedMetadata values;
+  };
+  struct Key {
+    std::uint64_t device;
+    std::uint64_t inode;
+    bool operator==(const Key &other) const {
+      return device == other.device && inode == other.inode;
+    }
+  };
+  struct KeyHash {
+    std::size_t operator()(const Key &key) const {
+      return std::hash<std::uint64_t>()(key.inode * 0x9E3779B97F4A7C15ull ^
+                                        key.device);
+    }
+  };
+  using LruList = std::list<Entry>; // Most recently used first
+
+  void insertLocked(const Entry &entry, bool front);
+
+  fs::path m_file;
+  std::size_t m_capacity;
+  mutable std::mutex m_mutex;
+  LruList m_lru;
+  std::unordered_map<Key, LruList::iterator, KeyHash> m_index;
+  bool m_dirty = false;
+};
+
+#endif // METADATACACHE_H
@@ -0,0 +1,378 @@
+#include "OverlayFileSystem.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+std::string ChildPrefix(const std::string &key) {
+  return key.back() == '/' ? key : key + "/";
+}
+
+std::error_code NotFoundError() {
+  return std::make_error_code(std::errc::no_such_file_or_directory);
+}
+} // namespace
+
+OverlayFileSystem::OverlayFileSystem(FileSystem &base) : m_base(base) {}
+
+std::string OverlayFileSystem::Key(const fs::path &p) {
+  std::string key = p.lexically_normal().generic_string();
+  while (key.size() > 1 && key.back() == '/' &&
+         !(key.size() == 3 && key[1] == ':')) // Keep "C:/" intact
+  {
+    key.pop_back();
+  }
+#ifdef _WIN32
+  // Windows names are case-insensitive
+  for (char &c : key) {
+    if (c >= 'A' && c <= 'Z') {
+      c = static_cast<char>(c - 'A' + 'a');
+    }
+  }
+#endif
+  return key;
+}
+
+OverlayFileSystem::Location
+OverlayFileSystem::locate(const fs::path &p) const {
+  if (m_entries.empty()) {
+    return {FileKind::NotFound, true, p};
+  }
+  // The nearest changed path at or above 'p' decides where it is
+  fs::path current = p.lexically_normal();
+  if (current.filename().empty()) {
+    current = current.parent_path();
+  }
+  fs::path below;
+  for (;;) {
+    auto it = m_entries.find(Key(current));
+    if (it != m_entries.end()) {
+      const Entry &entry = it->second;
+      if (entry.kind == FileKind::NotFound) {
+        return {};
+      }
+      if (entry.origin.empty()) {
+        // An overlay folder holds nothing but other overlay entries
+        return below.empty() ? Location{entry.kind, false, {}} : Location{};
+      }
+      return {FileKind::NotFound, true,
+              below.empty() ? entry.origin : entry.origin / below};
+    }
+    fs::path parent = current.parent_path();
+    if (parent.empty() || parent == current) {
+      return {FileKind::NotFound, true, p};
+    }
+    below = below.empty() ? current.filename() : current.filename() / below;
+    current = std::move(parent);
+  }
+}
+
+std::error_code OverlayFileSystem::UnreadableError(const Location &location) {
+  return location.kind == FileKind::NotFound
+             ? NotFoundError()
+             : std::make_error_code(std::errc::is_a_directory);
+}
+
+FileKind OverlayFileSystem::kindOf(const Location &location,
+                                   std::error_code &ec) {
+  if (location.inBase) {
+    return m_base.status(location.basePath, ec);
+  }
+  ec.clear();
+  return location.kind;
+}
+
+void OverlayFileSystem::eraseBelow(const std::string &key) {
+  // '\xff' never occurs in UTF-8, so it bounds every key below 'key'
+  const std::string prefix = ChildPrefix(key);
+  m_entries.erase(m_entries.lower_bound(prefix),
+                  m_entries.lower_bound(prefix + '\xff'));
+}
+
+void OverlayFileSystem::moveChildren(const std::string &from,
+                                     const std::string &to) {
+  const std::string fromPrefix = ChildPrefix(from);
+  const std::string toPrefix = ChildPrefix(to);
+  eraseBelow(to);
+  auto first = m_entries.lower_bound(fromPrefix);
+  auto last = m_entries.lower_bound(fromPrefix + '\xff');
+  std::vector<std::pair<std::string, Entry>> moved(first, last);
+  m_entries.erase(first, last);
+  // Only the prefix changes; each entry's own name stays the same
+  for (auto &child : moved) {
+    m_entries[toPrefix + child.first.substr(fromPrefix.size())] =
+        std::move(child.second);
+  }
+}
+
+FileKind OverlayFileSystem::status(const fs::path &p, std::error_code &ec) {
+  Location location;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    location = locate(p);
+  }
+  return kindOf(location, ec);
+}
+
+std::uintmax_t OverlayFileSystem::fileSize(const fs::path &p,
+                                           std::error_code &ec) {
+  Location location;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    location = locate(p);
+  }
+  if (!location.inBase) {
+    ec = UnreadableError(location);
+    return 0;
+  }
+  return m_base.fileSize(location.basePath, ec);
+}
+
+fs::file_time_type OverlayFileSystem::lastWriteTime(const fs::path &p,
+                                                    std::error_code &ec) {
+  Location location;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    location = locate(p);
+  }
+  if (!location.inBase) {
+    if (location.kind == FileKind::NotFound) {
+      ec = NotFoundError();
+      return {};
+    }
+    ec.clear();
+    return fs::file_time_type::clock::now(); // Created just now
+  }
+  return m_base.lastWriteTime(location.basePath, ec);
+}
+
+void OverlayFileSystem::listDirectory(
+    const fs::path &dir, const std::function<void(const DirEntryView &)> &visit,
+    std::error_code &ec) {
+  Location location;
+  std::vector<std::string> changed; // Keys of changed direct children
+  std::vector<Entry> added;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    location = locate(dir);
+    const std::string prefix = ChildPrefix(Key(dir));
+    for (auto it = m_entries.lower_bound(prefix);
+         it != m_entries.end() &&
+         it->first.compare(0, prefix.size(), prefix) == 0;
+         ++it) {
+      if (it->first.find('/', prefix.size()) != std::string::npos) {
+        continue; // Further down
+      }
+      changed.push_back(it->first);
+      if (it->second.kind != FileKind::NotFound) {
+        added.push_back(it->second);
+      }
+    }
+  }
+
+  if (location.inBase) {
+    m_base.listDirectory(
+        location.basePath,
+        [&](const DirEntryView &entry) {
+          const std::string key = Key(dir / fs::path(std::string(entry.name)));
+          if (!std::binary_search(changed.begin(), changed.end(), key)) {
+            visit(entry);
+          }
+        },
+        ec);
+    if (ec) {
+      return;
+    }
+  } else if (location.kind != FileKind::Directory) {
+    ec = location.kind == FileKind::NotFound
+             ? NotFoundError()
+             : std::make_error_code(std::errc::not_a_directory);
+    return;
+  }
+  ec.clear();
+  for (const Entry &entry : added) {
+    const std::string name = entry.path.filename().string();
+    DirEntryView view;
+    view.name = name;
+    view.kind = entry.kind;
+    visit(view);
+  }
+}
+
+void OverlayFileSystem::rename(const fs::path &from, const fs::path &to,
+                               std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const Location source = locate(from);
+  const FileKind kind = kindOf(source, ec);
+  if (ec) {
+    return;
+  }
+  if (kind == FileKind::NotFound) {
+    ec = NotFoundError();
+    return;
+  }
+  const FileKind parentKind = kindOf(locate(to.parent_path()), ec);
+  if (ec) {
+    return;
+  }
+  if (parentKind != FileKind::Directory) {
+    ec = NotFoundError();
+    return;
+  }
+  const std::string fromKey = Key(from);
+  const std::string toKey = Key(to);
+  if (toKey.compare(0, ChildPrefix(fromKey).size(), ChildPrefix(fromKey)) ==
+      0) {
+    ec = std::make_error_code(std::errc::invalid_argument); // Into itself
+    return;
+  }
+  const FileKind targetKind = fromKey == toKey ? FileKind::NotFound
+                                               : kindOf(locate(to), ec);
+  if (ec) {
+    return;
+  }
+  // A file may replace a file; folders are never replaced
+  if (targetKind != FileKind::NotFound &&
+      (kind == FileKind::Directory || targetKind == FileKind::Directory)) {
+    ec = std::make_error_code(std::errc::file_exists);
+    return;
+  }
+
+  Entry moved{to, kind, source.inBase ? source.basePath : fs::path()};
+  if (fromKey != toKey) { // Otherwise only the name's case changes
+    moveChildren(fromKey, toKey);
+  }
+  m_entries[fromKey] = Entry{from, FileKind::NotFound, {}};
+  m_entries[toKey] = std::move(moved);
+}
+
+bool OverlayFileSystem::createDirectories(const fs::path &p,
+                                          std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  std::vector<fs::path> missing;
+  fs::path current = p.lexically_normal();
+  if (current.filename().empty()) {
+    current = current.parent_path();
+  }
+  for (;;) {
+    const FileKind kind = kindOf(locate(current), ec);
+    if (ec) {
+      return false;
+    }
+    if (kind == FileKind::Directory) {
+      break;
+    }
+    if (kind != FileKind::NotFound) {
+      ec = std::make_error_code(std::errc::not_a_directory);
+      return false;
+    }
+    missing.push_back(current);
+    fs::path parent = current.parent_path();
+    if (parent.empty() || parent == current) {
+      break;
+    }
+    current = std::move(parent);
+  }
+  for (auto it = missing.rbegin(); it != missing.rend(); ++it) {
+    const std::string key = Key(*it);
+    eraseBelow(key); // Anything left below a removed path
+    m_entries[key] = Entry{*it, FileKind::Directory, {}};
+  }
+  return !missing.empty();
+}
+
+bool OverlayFileSystem::copyFile(const fs::path &from, const fs::path &to,
+                                 CopyMode mode, std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const Location source = locate(from);
+  const FileKind kind = kindOf(source, ec);
+  if (ec) {
+    return false;
+  }
+  if (kind != FileKind::Regular) {
+    ec = kind == FileKind::NotFound
+             ? NotFoundError()
+             : std::make_error_code(std::errc::is_a_directory);
+    return false;
+  }
+  const FileKind parentKind = kindOf(locate(to.parent_path()), ec);
+  if (ec) {
+    return false;
+  }
+  if (parentKind != FileKind::Directory) {
+    ec = NotFoundError();
+    return false;
+  }
+  if (mode == CopyMode::CreateNew) {
+    const FileKind targetKind = kindOf(locate(to), ec);
+    if (ec) {
+      return false;
+    }
+    if (targetKind != FileKind::NotFound) {
+      ec = std::make_error_code(std::errc::file_exists);
+      return false;
+    }
+  }
+  const std::string key = Key(to);
+  eraseBelow(key);
+  m_entries[key] = Entry{to, FileKind::Regular, source.basePath};
+  return true;
+}
+
+std::uintmax_t OverlayFileSystem::removeAll(const fs::path &p,
+                                            std::error_code &ec) {
+  std::lock_guard<std::mutex> lock(m_mutex);
+  const FileKind kind = kindOf(locate(p), ec);
+  if (ec || kind == FileKind::NotFound) {
+    return 0;
+  }
+  const std::string key = Key(p);
+  eraseBelow(key);
+  m_entries[key] = Entry{p, FileKind::NotFound, {}};
+  return 1;
+}
+
+void OverlayFileSystem::readContent(
+    const fs::path &p, const std::function<void(std::string_view)> &visit,
+    std::error_code &ec) {
+  Location location;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    location = locate(p);
+  }
+  if (!location.inBase) {
+    ec = UnreadableError(location);
+    return;
+  }
+  m_base.readContent(location.basePath, visit, ec);
+}
+
+std::size_t OverlayFileSystem::readAt(const fs::path &p,
+                                      std::uintmax_t offset, char *buffer,
+                                      std::size_t size, std::error_code &ec) {
+  Location location;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    location = locate(p);
+  }
+  if (!location.inBase) {
+    ec = UnreadableError(location);
+    return 0;
+  }
+  return m_base.readAt(location.basePath, offset, buffer, size, ec);
+}
+
+FileIdentity OverlayFileSystem::identity(const fs::path &p,
+                                         std::error_code &ec) {
+  Location location;
+  {
+    std::lock_guard<std::mutex> lock(m_mutex);
+    location = locate(p);
+  }
+  if (!location.inBase) {
+    ec = UnreadableError(location);
+    return {};
+  }
+  return m_base.identity(location.basePath, ec);
+}
@@ -0,0 +1,72 @@
+#ifndef OVERLAYFILESYSTEM_H
+#define OVERLAYFILESYSTEM_H
+
+#include "FileSystem.h"
+
+#include <map>
+#include <mutex>
+#include <string>
+
+// Copy-on-write view of another backend: renames, new folders, copies and
+// removals are recorded in memory and never reach the wrapped backend, while
+// everything else is read through to it. Only changed paths are stored, so
+// replaying a plan of n renames costs O(n) memory whatever the folder size.
+// A renamed folder's contents follow it, as they would on disk
+class OverlayFileSystem : public FileSystem {
+public:
+  explicit OverlayFileSystem(FileSystem &base);
+
+  FileKind status(const fs::path &p, std::error_code &ec) override;
+  std::uintmax_t fileSize(const fs::path &p, std::error_code &ec) override;
+  fs::file_time_type lastWriteTime(const fs::path &p,
+                                   std::error_code &ec) override;
+  void listDirectory(const fs::path &dir,
+                     const std::function<void(const DirEntryView &)> &visit,
+                     std::error_code &ec) override;
+  void rename(const fs::path &from, const fs::path &to,
+              std::error_code &ec) override;
+  bool createDirectories(const fs::path &p, std::error_code &ec) override;
+  bool copyFile(const fs::path &from, const fs::path &to, CopyMode mode,
+                std::error_code &ec) override;
+  std::uintmax_t removeAll(const fs::path &p, std::error_code &ec) override;
+  void readContent(const fs::path &p,
+                   const std::function<void(std::string_view)> &visit,
+                   std::error_code &ec) override;
+  std::size_t readAt(const fs::path &p, std::uintmax_t offset, char *buffer,
+                     std::size_t size, std::error_code &ec) override;
+  FileIdentity identity(const fs::path &p, std::error_code &ec) override;
+
+private:
+  // A changed path. 'origin' is where its content lives in the base; empty
+  // for a folder created in the overlay. NotFound marks a removed path
+  struct Entry {
+    fs::path path; // As given, for listings
+    FileKind kind = FileKind::NotFound;
+    fs::path origin;
+  };
+
+  // Where 'p' currently is: removed, an overlay-only folder, or a base path
+  struct Location {
+    FileKind kind = FileKind::NotFound; // Only set when not in the base
+    bool inBase = false;
+    fs::path basePath;
+  };
+
+  static std::string Key(const fs::path &p);
+  // Error for reading a path that has no content in the base
+  static std::error_code UnreadableError(const Location &location);
+  Location locate(const fs::path &p) const;
+  FileKind kindOf(const Location &location, std::error_code &ec);
+  void eraseBelow(const std::string &key);
+  // Moves the entries below 'from' to below 'to', replacing those there
+  void moveChildren(const std::string &from, const std::string &to);
+
+  FileSystem &m_base;
+  // Guards m_entries. Reads release it before calling the base; changes hold
+  // it across their base status checks, so a check and the update it decides
+  // are atomic
+  mutable std::mutex m_mutex;
+  std::map<std::string, Entry> m_entries;
+};
+
+#endif // OVERLAYFILESYSTEM_H
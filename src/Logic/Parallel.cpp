@@ -0,0 +1,85 @@
+#include "Parallel.h"
+#include "ConcurrencyLimiter.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <exception>
+#include <mutex>
+#include <system_error>
+#include <thread>
+#include <vector>
+
+void ParallelFor(std::size_t count,
+                 const std::function<void(std::size_t)> &body,
+                 unsigned maxThreads) {
+  if (count == 0) {
+    return;
+  }
+  if (maxThreads == 0) {
+    maxThreads = std::max(1u, std::thread::hardware_concurrency());
+  }
+  const std::size_t threadCount = std::min<std::size_t>(maxThreads, count);
+
+  std::atomic<std::size_t> next{0};
+  std::atomic<bool> failed{false};
+  std::exception_ptr firstError;
+  std::mutex errorMutex;
+  auto worker = [&]() {
+    for (std::size_t i = next.fetch_add(1, std::memory_order_relaxed);
+         i < count && !failed.load(std::memory_order_relaxed);
+         i = next.fetch_add(1, std::memory_order_relaxed)) {
+      try {
+        body(i);
+      } catch (...) {
+        std::lock_guard<std::mutex> lock(errorMutex);
+        if (!firstError) {
+          firstError = std::current_exception();
+        }
+        failed.store(true, std::memory_order_relaxed);
+      }
+    }
+  };
+
+  std::vector<std::thread> threads;
+  threads.reserve(threadCount - 1);
+  try {
+    for (std::size_t t = 1; t < threadCount; ++t) {
+      threads.emplace_back(worker);
+    }
+  } catch (const std::system_error &) {
+    // Out of threads; the ones already running share the work
+  }
+  worker(); // The calling thread takes a share too
+  for (std::thread &thread : threads) {
+    thread.join();
+  }
+  if (firstError) {
+    std::rethrow_exception(firstError);
+  }
+}
+
+void ParallelFor(std::size_t count,
+                 const std::function<void(std::size_t)> &body,
+                 ConcurrencyLimiter &limiter) {
+  // Enough threads for the limit to double during this run; it keeps
+  // learning across runs
+  const unsigned threads = std::min(
+      limiter.maximum(),
+      std::max(std::max(1u, std::thread::hardware_concurrency()),
+               limiter.limit() * 2));
+  ParallelFor(
+      count,
+      [&](std::size_t i) {
+        limiter.acquire();
+        const auto start = std::chrono::steady_clock::now();
+        try {
+          body(i);
+        } catch (...) {
+          limiter.release(std::chrono::steady_clock::now() - start, true);
+          throw;
+        }
+        limiter.release(std::chrono::steady_clock::now() - start);
+      },
+      threads);
+}
@@ -0,0 +1,25 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+
+class ConcurrencyLimiter;
+
+// Runs body(i) for every i in [0, count) across up to 'maxThreads' threads
+// (0 for one per hardware thread), including the calling one. Items are
+// handed out one at a time, so uneven work such as files of very different
+// sizes balances itself. The first exception thrown by 'body' is rethrown
+// once every thread has stopped
+void ParallelFor(std::size_t count,
+                 const std::function<void(std::size_t)> &body,
+                 unsigned maxThreads = 0);
+
+// As above, but each body(i) runs between limiter.acquire() and
+// limiter.release(), so how many run at once follows the limiter as it adapts
+// to the latency it measures. Meant for bodies that mostly wait on one device
+void ParallelFor(std::size_t count,
+                 const std::function<void(std::size_t)> &body,
+                 ConcurrencyLimiter &limiter);
+
+#endif // PARALLEL_H
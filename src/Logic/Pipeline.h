@@ -0,0 +1,140 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include <atomic>
+#include <condition_variable>
+#include <cstddef>
+#include <exception>
+#include <mutex>
+#include <thread>
+#include <utility>
+#include <vector>
+
+// Bounded queue between two pipeline stages, one pushing and one popping.
+// Items move through a fixed ring of slots with no lock; a stage that finds
+// the ring full (back-pressure) or empty spins briefly and then sleeps until
+// the other side moves
+template <typename T> class SpscRing {
+public:
+  // 'capacity' is rounded up to a power of two
+  explicit SpscRing(std::size_t capacity) {
+    std::size_t size = 2;
+    while (size < capacity) {
+      size *= 2;
+    }
+    m_slots.resize(size);
+    m_mask = size - 1;
+  }
+
+  // Blocks while the ring is full. Returns false, dropping 'value', once the
+  // ring is closed
+  bool push(T value) {
+    const std::size_t tail = m_tail.load(std::memory_order_relaxed);
+    waitUntil(
+        [&] { return tail - m_head.load() <= m_mask || m_closed.load(); });
+    if (m_closed.load()) {
+      return false;
+    }
+    m_slots[tail & m_mask] = std::move(value);
+    m_tail.store(tail + 1, std::memory_order_seq_cst);
+    wake();
+    return true;
+  }
+
+  // Blocks while the ring is empty. Returns false once it is closed and
+  // every item pushed before has been popped
+  bool pop(T &value) {
+    const std::size_t head = m_head.load(std::memory_order_relaxed);
+    waitUntil([&] { return m_tail.load() != head || m_closed.load(); });
+    if (m_tail.load() == head) {
+      return false; // Closed and drained
+    }
+    value = std::move(m_slots[head & m_mask]);
+    m_head.store(head + 1, std::memory_order_seq_cst);
+    wake();
+    return true;
+  }
+
+  // Ends the stream: pops drain what is left, pushes fail. Either side may
+  // close, the consumer to stop a producer it no longer listens to
+  void close() {
+    m_closed.store(true, std::memory_order_seq_cst);
+    wake();
+  }
+
+private:
+  // Spins this many times before going to sleep
+  static constexpr int SpinLimit = 64;
+
+  template <typename Ready> void waitUntil(Ready ready) {
+    for (int spin = 0; spin < SpinLimit; ++spin) {
+      if (ready()) {
+        return;
+      }
+      std::this_thread::yield();
+    }
+    std::unique_lock<std::mutex> lock(m_mutex);
+    // Announced before checking again, so a wake() after this check sees it.
+    // Both sides use sequentially consistent order for the indexes for that
+    m_sleepers.fetch_add(1, std::memory_order_seq_cst);
+    m_changed.wait(lock, ready);
+    m_sleepers.fetch_sub(1, std::memory_order_relaxed);
+  }
+
+  void wake() {
+    if (m_sleepers.load(std::memory_order_seq_cst) > 0) {
+      std::lock_guard<std::mutex> lock(m_mutex);
+      m_changed.notify_all();
+    }
+  }
+
+  std::vector<T> m_slots;
+  std::size_t m_mask = 0;
+  // Each index is only written by one side; kept on separate cache lines
+  alignas(64) std::atomic<std::size_t> m_head{0}; // Next slot to pop
+  alignas(64) std::atomic<std::size_t> m_tail{0}; // Next slot to push
+  std::atomic<bool> m_closed{false};
+  std::atomic<int> m_sleepers{0};
+  std::mutex m_mutex; // Only taken to sleep and to wake a sleeper
+  std::condition_variable m_changed;
+};
+
+// Runs one pipeline stage on its own thread. 'onExit' runs on that thread as
+// the stage ends, returning or throwing, and normally closes the stage's
+// output so the next stage drains it and stops. What the stage throws is
+// rethrown by join()
+class StageThread {
+public:
+  template <typename Body, typename OnExit>
+  StageThread(Body body, OnExit onExit)
+      : m_thread([this, body = std::move(body), onExit = std::move(onExit)] {
+          try {
+            body();
+          } catch (...) {
+            m_error = std::current_exception();
+          }
+          onExit();
+        }) {}
+
+  StageThread(const StageThread &) = delete;
+  StageThread &operator=(const StageThread &) = delete;
+
+  ~StageThread() {
+    if (m_thread.joinable()) {
+      m_thread.join();
+    }
+  }
+
+  void join() {
+    m_thread.join();
+    if (m_error) {
+      std::rethrow_exception(m_error);
+    }
+  }
+
+private:
+  std::exception_ptr m_error;
+  std::thread m_thread; // Last, so it starts once m_error exists
+};
+
+#endif // PIPELINE_H
@@ -0,0 +1,147 @@
+#include "RandomNames.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cctype>
+#include <chrono>
+#include <functional>
+#include <thread>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+constexpr std::string_view AlphanumChars =
+    "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
+constexpr std::string_view RandomTag = "<random:";
+
+std::uint64_t SplitMix64(std::uint64_t &x) {
+  std::uint64_t z = (x += 0x9E3779B97F4A7C15ull);
+  z = (z ^ (z >> 30)) * 0xBF58476D1CE4E5B9ull;
+  z = (z ^ (z >> 27)) * 0x94D049BB133111EBull;
+  return z ^ (z >> 31);
+}
+
+inline std::uint64_t Rotl(std::uint64_t x, int k) {
+  return (x << k) | (x >> (64 - k));
+}
+} // namespace
+
+// The state is filled through SplitMix64 as the xoshiro authors recommend,
+// so nearby seeds still give unrelated streams
+FastRandom::FastRandom(std::uint64_t seed) {
+  for (std::uint64_t &word : m_state) {
+    word = SplitMix64(seed);
+  }
+}
+
+std::uint64_t FastRandom::next() {
+  const std::uint64_t result = Rotl(m_state[1] * 5, 7) * 9;
+  const std::uint64_t t = m_state[1] << 17;
+  m_state[2] ^= m_state[0];
+  m_state[3] ^= m_state[1];
+  m_state[1] ^= m_state[2];
+  m_state[0] ^= m_state[3];
+  m_state[2] ^= t;
+  m_state[3] = Rotl(m_state[3], 45);
+  return result;
+}
+
+// Lemire's multiply-and-reject method
+std::uint32_t FastRandom::below(std::uint32_t bound) {
+  std::uint64_t product = (next() >> 32) * bound;
+  std::uint32_t low = static_cast<std::uint32_t>(product);
+  if (low < bound) {
+    const std::uint32_t threshold = (0u - bound) % bound;
+    while (low < threshold) {
+      product = (next() >> 32) * bound;
+      low = static_cast<std::uint32_t>(product);
+    }
+  }
+  return static_cast<std::uint32_t>(product >> 32);
+}
+
+std::uint64_t MakeRandomSeed() {
+  static std::atomic<std::uint64_t> counter{0};
+  std::uint64_t seed = static_cast<std::uint64_t>(
+      std::chrono::steady_clock::now().time_since_epoch().count());
+  seed ^= std::hash<std::thread::id>()(std::this_thread::get_id()) << 1;
+  seed ^= counter.fetch_add(1, std::memory_order_relaxed) *
+          0x9E3779B97F4A7C15ull;
+  return seed;
+}
+
+FastRandom &ThreadRandom() {
+  thread_local FastRandom rng(MakeRandomSeed());
+  return rng;
+}
+
+// Single left-to-right pass; text that only looks like a placeholder (no
+// digits or no closing '>') is copied unchanged
+std::string ExpandRandomPlaceholders(std::string_view pattern, FastRandom &rng,
+                                     std::string *tokens) {
+  std::string result;
+  result.reserve(pattern.size());
+  std::size_t pos = 0;
+  while (pos < pattern.size()) {
+    const std::size_t tag = pattern.find(RandomTag, pos);
+    if (tag == std::string_view::npos) {
+      break;
+    }
+    std::size_t cursor = tag + RandomTag.size();
+    int numChars = 0;
+    const std::size_t digitsBegin = cursor;
+    while (cursor < pattern.size() &&
+           std::isdigit(static_cast<unsigned char>(pattern[cursor]))) {
+      numChars = std::min(numChars * 10 + (pattern[cursor] - '0'),
+                          MaxRandomChars); // Cap at 64 characters
+      ++cursor;
+    }
+    if (cursor == digitsBegin || cursor >= pattern.size() ||
+        pattern[cursor] != '>') {
+      result.append(pattern, pos, cursor - pos); // Not a placeholder
+      pos = cursor;
+      continue;
+    }
+    result.append(pattern, pos, tag - pos);
+    for (int i = 0; i < numChars; ++i) {
+      const char c = AlphanumChars[rng.below(
+          static_cast<std::uint32_t>(AlphanumChars.size()))];
+      result += c;
+      if (tokens) {
+        *tokens += c;
+      }
+    }
+    pos = cursor + 1;
+  }
+  result.append(pattern, std::min(pos, pattern.size()));
+  return result;
+}
+
+RandomNameGenerator::RandomNameGenerator(std::uint64_t seed)
+    : m_rng(seed != 0 ? seed : MakeRandomSeed()) {}
+
+bool RandomNameGenerator::References(std::string_view pattern) {
+  return pattern.find(RandomTag) != std::string_view::npos;
+}
+
+std::string RandomNameGenerator::expand(std::string_view pattern) {
+  std::string result;
+  std::string tokens;
+  for (int attempt = 0; attempt < MaxAttempts; ++attempt) {
+    tokens.clear();
+    result = ExpandRandomPlaceholders(pattern, m_rng, &tokens);
+    if (tokens.empty()) {
+      break; // Nothing random to keep unique (e.g. <random:0>)
+    }
+    // FNV-1a over the folded random text
+    std::uint64_t hash = 14695981039346656037ull;
+    for (char c : tokens) {
+      hash ^= static_cast<unsigned char>(
+          std::tolower(static_cast<unsigned char>(c)));
+      hash *= 1099511628211ull;
+    }
+    if (m_used.insert(hash).second) {
+      break;
+    }
+  }
+  return result;
+}
@@ -0,0 +1,64 @@
+#ifndef RANDOMNAMES_H
+#define RANDOMNAMES_H
+
+#include <array>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <unordered_set>
+
+// xoshiro256** generator: a few cycles per number and 32 bytes of state, so
+// every thread or plan can own a stream instead of sharing a locked engine
+class FastRandom {
+public:
+  explicit FastRandom(std::uint64_t seed);
+
+  std::uint64_t next();
+  // Uniform value in [0, bound) without modulo bias
+  std::uint32_t below(std::uint32_t bound);
+
+private:
+  std::array<std::uint64_t, 4> m_state;
+};
+
+// The calling thread's own stream, seeded once per thread from the clock and
+// the thread's identity
+FastRandom &ThreadRandom();
+
+// Seed for a fresh, non-reproducible stream
+std::uint64_t MakeRandomSeed();
+
+// Maximum number of characters a single <random:N> produces
+constexpr int MaxRandomChars = 64;
+
+// Replaces every <random:N> in 'pattern' with N random alphanumeric
+// characters from 'rng'. The generated characters are also appended to
+// 'tokens' when it is given
+std::string ExpandRandomPlaceholders(std::string_view pattern, FastRandom &rng,
+                                     std::string *tokens = nullptr);
+
+// Expands <random:N> placeholders for a whole batch. The random text of each
+// expansion is unique (case-insensitively, as targets are compared) across
+// every call on the same generator, so no two planned names can collide on
+// their random part. Seeding with the same value reproduces the sequence
+class RandomNameGenerator {
+public:
+  // Attempts before giving up on a space too small for the batch (e.g.
+  // <random:1> across thousands of files); the planner then reports the
+  // resulting conflict as usual
+  static constexpr int MaxAttempts = 64;
+
+  // 'seed' 0 picks a fresh seed
+  explicit RandomNameGenerator(std::uint64_t seed = 0);
+
+  std::string expand(std::string_view pattern);
+  static bool References(std::string_view pattern);
+
+private:
+  FastRandom m_rng;
+  // 64-bit hashes of the folded random text handed out so far. A hash
+  // collision only costs an extra draw, never a duplicate
+  std::unordered_set<std::uint64_t> m_used;
+};
+
+#endif // RANDOMNAMES_H
@@ -0,0 +1,81 @@
+#include "RenameSchedule.h"
+#include "RenamerLogic.h"
+
+#include <string>
+#include <unordered_map>
+
+std::vector<ScheduledRename>
+ScheduleRenames(const std::vector<RenameOperation> &ops) {
+  // Paths are compared case-insensitively, as case-insensitive filesystems
+  // treat "File2.txt" and "file2.txt" as the same target
+  std::unordered_map<std::string, std::size_t> bySource;
+  bySource.reserve(ops.size());
+  for (std::size_t i = 0; i < ops.size(); ++i) {
+    if (!ops[i].hasConflict) {
+      bySource.emplace(ToLower(ops[i].OldFullPath.string()), i);
+    }
+  }
+
+  enum : char { Pending, OnChain, Done };
+  std::vector<char> state(ops.size(), Pending);
+  std::vector<ScheduledRename> steps;
+  steps.reserve(ops.size());
+  std::vector<std::size_t> chain;
+  for (std::size_t start = 0; start < ops.size(); ++start) {
+    if (state[start] != Pending) {
+      continue;
+    }
+    if (ops[start].hasConflict) {
+      state[start] = Done;
+      steps.push_back({start, ScheduledRename::Kind::Whole});
+      continue;
+    }
+    // Follow the operations whose sources the chain's targets occupy. Every
+    // target is distinct, so a chain either ends at a free target or comes
+    // back round to where it started
+    chain.assign(1, start);
+    state[start] = OnChain;
+    bool cycle = false;
+    for (;;) {
+      auto next =
+          bySource.find(ToLower(ops[chain.back()].NewFullPath.string()));
+      if (next == bySource.end() || next->second == chain.back() ||
+          state[next->second] == Done) {
+        break;
+      }
+      if (state[next->second] == OnChain) {
+        cycle = next->second == start;
+        break;
+      }
+      state[next->second] = OnChain;
+      chain.push_back(next->second);
+    }
+
+    // The chain runs from its free end back to 'start'
+    if (cycle) {
+      steps.push_back({start, ScheduledRename::Kind::Park});
+    }
+    for (std::size_t i = chain.size(); i-- > (cycle ? 1 : 0);) {
+      steps.push_back({chain[i], ScheduledRename::Kind::Whole});
+    }
+    if (cycle) {
+      steps.push_back({start, ScheduledRename::Kind::Unpark});
+    }
+    for (std::size_t op : chain) {
+      state[op] = Done;
+    }
+  }
+  return steps;
+}
+
+fs::path ParkingPath(const fs::path &path, FileSystem &fileSystem) {
+  for (int attempt = 0;; ++attempt) {
+    fs::path parked = path;
+    parked += attempt == 0 ? ".renaming"
+                           : ".renaming" + std::to_string(attempt);
+    std::error_code ec;
+    if (!fileSystem.exists(parked, ec) || attempt >= 1000) {
+      return parked;
+    }
+  }
+}
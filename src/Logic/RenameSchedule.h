@@ -0,0 +1,30 @@
+#ifndef RENAMESCHEDULE_H
+#define RENAMESCHEDULE_H
+
+#include "FileSystem.h"
+
+#include <cstddef>
+#include <vector>
+
+struct RenameOperation;
+
+// One rename to run. A rename cycle (a -> b -> c -> a) can't start anywhere
+// without overwriting a file, so one of its operations is split in two: it
+// is parked under a temporary name first and finished after the rest
+struct ScheduledRename {
+  enum class Kind { Whole, Park, Unpark };
+  std::size_t op; // Index into the scheduled operations
+  Kind kind = Kind::Whole;
+};
+
+// Orders 'ops' so that every operation runs after the one vacating its
+// target, keeping their given order wherever they are independent. Each
+// cycle costs exactly one extra rename. Operations flagged with a conflict
+// are kept in place but never considered to vacate anything
+std::vector<ScheduledRename>
+ScheduleRenames(const std::vector<RenameOperation> &ops);
+
+// An unused name next to 'path' to park it under while a cycle is renamed
+fs::path ParkingPath(const fs::path &path, FileSystem &fileSystem);
+
+#endif // RENAMESCHEDULE_H
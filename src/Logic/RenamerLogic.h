@@ -14,17 +14,27 @@
 #include <sstream>
 #include <stdexcept>
 #include <string>
+#include <string_view>
 #include <vector>
 
 #include <wx/stdpaths.h>
 #include <wx/string.h>
 
+#include "Diagnostics.h"
+#include "FileSystem.h"
+
 namespace fs = std::filesystem;
 
+class MetadataCache;
+class RenderCache;
+
 enum class CaseConversionMode { NoChange, ToUpper, ToLower };
 
 enum class RenamingMode { DirectoryScan, ManualSelection };
 
+// Order in which Directory Scan numbers files 1..N when resequencing
+enum class ResequenceOrder { None, CurrentNumber, NaturalName, ModifiedTime };
+
 struct RenameOperation {
   std::string OldName;
   std::string NewName;
@@ -34,39 +44,103 @@ struct RenameOperation {
   int Index;
   bool hasConflict = false;   // True if this operation has a conflict
   std::string conflictReason; // Description of the conflict if any
+  bool isDirectory = false;   // Renames a folder rather than a file
 };
 
-struct PotentialOverwrite {
-  std::string SourceFile;
-  std::string TargetFile;
-  fs::path TargetPath;
+// One step of a rule chain, applied to the name produced by the previous step
+// rather than to the file on disk
+struct RuleStep {
+  std::string namingPattern; // Empty keeps the name as it is
+  std::string findText;
+  std::string replaceText;
+  bool findCaseSensitive = false;
+  bool findUseRegex = false;
+  CaseConversionMode caseConversionMode = CaseConversionMode::NoChange;
+  int increment = 0; // Added to the name's last number for <num>
+};
+
+// A naming pattern used instead of InputParams::namingPattern for the files
+// its predicates select. Empty predicates match every file
+struct RoutedRule {
+  std::vector<std::string> extensions; // ".jpg" or "jpg", any case
+  std::vector<std::string> filenamePatterns; // Wildcards, any one may match
+  bool useNumberRange = false; // Last number in the name within the range
+  int lowestNumber = 0;
+  int highestNumber = 0;
+  std::string namingPattern;
+};
+
+// One literal substitution of a replacement table
+struct ReplacementPair {
+  std::string find; // Never empty
+  std::string replace;
 };
 
 struct InputParams {
-  RenamingMode mode;
+  RenamingMode mode = RenamingMode::DirectoryScan;
   fs::path targetDirectory;
   std::string namingPattern;
   std::string findText;
   std::string replaceText;
-  bool findCaseSensitive;
-  bool findUseRegex;
-  CaseConversionMode caseConversionMode;
-  int increment;
+  bool findCaseSensitive = true;
+  bool findUseRegex = false;
+  CaseConversionMode caseConversionMode = CaseConversionMode::NoChange;
+  int increment = 0;
   std::string filenamePattern;
   std::string filterExtensions;
-  int highestNumber;
-  int lowestNumber;
-  bool recursiveScan;
+  int highestNumber = 0; // Both numbers 0 for no number filter
+  int lowestNumber = 0;
+  bool recursiveScan = false;
+  // ';'-separated wildcards; entries ending in '/' exclude directories
+  std::string excludePatterns;
+  bool skipHiddenDirectories = false; // Don't descend into ".name" folders
+  int maxScanDepth = 0; // Subdirectory levels to descend, 0 for unlimited
+  // Also rename the folders the filters accept; they are renamed after
+  // everything inside them
+  bool renameDirectories = false;
+  // Directory Scan: <num> becomes each file's position within its folder in
+  // this order, counted from resequenceStart, instead of its number plus
+  // increment. Files already at their position are left alone
+  ResequenceOrder resequence = ResequenceOrder::None;
+  int resequenceStart = 1;
   std::vector<fs::path> manualFiles;
+  std::uint64_t randomSeed = 0; // Seed for <random:N>, 0 for a fresh one
+  // Further steps applied in order after the pattern, find/replace and case
+  // conversion above; only the final name is planned and renamed
+  std::vector<RuleStep> ruleChain;
+  // Per-file pattern selection: the first matching rule's pattern replaces
+  // namingPattern, which still applies to files no rule selects
+  std::vector<RoutedRule> routedRules;
+  // Literal substitutions applied together, in one pass, after findText;
+  // case-sensitive when findCaseSensitive is set
+  std::vector<ReplacementPair> replacementTable;
+  // Regex searched in each file's name without extension; its groups can be
+  // used in namingPattern and routed patterns as <1>, <2>, ... or <name> for
+  // (?<name>...) groups. Files it doesn't match are skipped. Empty for none
+  std::string sourcePattern;
+  bool sourcePatternCaseSensitive = true;
+  // Treat '/' and '\' in the naming pattern as folder separators, moving
+  // files into subfolders (created on rename) below their current folder
+  bool allowSubfolders = false;
+  // Added to a target name that is already taken, each run of '#' being the
+  // lowest free counter from 2 (" (#)", "_###"), instead of flagging the
+  // conflict. Empty to flag conflicts
+  std::string conflictSuffix;
+  // Replay the plan's execution, in execution order, against an in-memory
+  // overlay of the folders and report each rename that would fail
+  bool dryRun = false;
+  // Optional cache of content hashes and capture dates kept across previews
+  MetadataCache *metadataCache = nullptr;
+  // Optional cache of each file's name after each rendering stage, so a
+  // preview reruns only the stages whose fields changed since the last one
+  RenderCache *renderCache = nullptr;
+  std::size_t diagnosticsCap =
+      Diagnostics::DefaultCapPerCategory; // Max stored messages per category
 };
 
 struct OutputResults {
   std::vector<RenameOperation> renamePlan;
-  std::vector<std::string> missingSourceFilesLog;
-  std::vector<PotentialOverwrite> potentialOverwritesLog;
-  std::vector<std::string> generalInfoLog;
-  std::vector<std::string> warningLog;
-  std::vector<std::string> errorLog;
+  Diagnostics diagnostics; // Info, warnings, skipped files, overwrites, errors
   bool success = false;
 };
 
@@ -98,7 +172,8 @@ std::string ToLower(std::string s);
 class RenamerLogic {
 private:
   static void CopyDirectory(const fs::path &source,
-                            const fs::path &destination);
+                            const fs::path &destination,
+                            FileSystem &fileSystem);
   static fs::path GetDefaultBackupParentPathInternal();
 
 public:
@@ -113,7 +188,8 @@ public:
       const std::optional<int> &dirScanOriginalNum,
       const std::optional<int> &dirScanNewNum, int dirScanNumberWidth,
       const std::string &parentDirName = "",
-      const fs::path &fullFilePath = fs::path());
+      const fs::path &fullFilePath = fs::path(),
+      FileSystem &fileSystem = DefaultFileSystem());
   static std::string PerformFindReplace(std::string subject,
                                         const std::string &find,
                                         const std::string &replace,
@@ -121,20 +197,37 @@ public:
                                         bool useRegex = false);
   static std::string ApplyCaseConversion(std::string filename,
                                          CaseConversionMode mode);
-  static std::optional<int> ParseLastNumber(const std::string &filename);
-
-  static OutputResults calculateRenamePlan(const InputParams &params);
+  static std::optional<int> ParseLastNumber(std::string_view filename);
+
+  // All filesystem access goes through 'fileSystem' so callers can inject an
+  // in-memory or latency-injecting backend
+  static OutputResults
+  calculateRenamePlan(const InputParams &params,
+                      FileSystem &fileSystem = DefaultFileSystem());
+  // Renames the operating system refuses across filesystems are done as a
+  // verified copy and delete, journaled in 'moveJournal' if it is set
   static RenameExecutionResult
-  performRename(const std::vector<RenameOperation> &plan, int increment);
-  static UndoResult performUndo(std::vector<RenameOperation> opsToUndo);
-  static BackupResult performBackup(const fs::path &sourcePath,
-                                    const std::string &contextName);
-  static DeleteResult deleteBackup(const fs::path &backupPath);
+  performRename(const std::vector<RenameOperation> &plan, int increment,
+                FileSystem &fileSystem = DefaultFileSystem(),
+                const fs::path &moveJournal = fs::path());
+  static UndoResult performUndo(std::vector<RenameOperation> opsToUndo,
+                                FileSystem &fileSystem = DefaultFileSystem(),
+                                const fs::path &moveJournal = fs::path());
+  static BackupResult
+  performBackup(const fs::path &sourcePath, const std::string &contextName,
+                FileSystem &fileSystem = DefaultFileSystem());
+  static DeleteResult
+  deleteBackup(const fs::path &backupPath,
+               FileSystem &fileSystem = DefaultFileSystem());
 
   // History log
   static bool writeHistoryLog(const std::vector<RenameOperation> &operations,
                               const std::string &operationType);
   static fs::path getHistoryLogPath();
+  // Persistent per-file metadata cache
+  static fs::path getMetadataCachePath();
+  // Journal of cross-filesystem moves in progress
+  static fs::path getMoveJournalPath();
 
   static const fs::path DefaultPath;
 };
@@ -18,67 +18,66 @@ namespace fs = std::filesystem;
 
 // Recursively copies the contents of a source directory to a destination directory
 // Throws std::runtime_error on failure to provide detailed error context
-void RenamerLogic::CopyDirectory(const fs::path &source, const fs::path &destination)
+void RenamerLogic::CopyDirectory(const fs::path &source, const fs::path &destination, FileSystem &fileSystem)
 {
 	try
 	{
 		std::error_code ec;
 
 		// Create destination directory if it doesn't exist
-		if (!fs::exists(destination, ec) || ec)
+		FileKind destinationKind = fileSystem.status(destination, ec);
+		if (ec || destinationKind == FileKind::NotFound)
 		{
-			if (!fs::create_directories(destination, ec) || ec)
+			if (!fileSystem.createDirectories(destination, ec) || ec)
 			{
 				throw std::runtime_error("Failed to create destination directory: " + destination.string() + (ec ? " (" + ec.message() + ")" : ""));
 			}
 		}
-		else if (!fs::is_directory(destination, ec) || ec)
+		else if (destinationKind != FileKind::Directory)
 		{
 			// Destination exists but is not a directory, which is an error for backup
-			throw std::runtime_error("Backup destination path exists but is not a directory: " + destination.string() + (ec ? " (" + ec.message() + ")" : ""));
+			throw std::runtime_error("Backup destination path exists but is not a directory: " + destination.string());
 		}
 
-		// Iterate through source directory contents
-		for (const auto &entry : fs::directory_iterator(source))
+		// Copy files while listing the source; subdirectories are copied after the listing completes
+		std::vector<fs::path> subdirectories;
+		auto copyEntry = [&](const DirEntryView &entry)
 		{
-			const fs::path &srcPath = entry.path();
-			const fs::path dstPath = destination / srcPath.filename(); // Construct corresponding destination path
-			std::error_code copyEc;
+			const fs::path srcPath = source / fs::path(entry.name);
+			const fs::path dstPath = destination / fs::path(entry.name); // Construct corresponding destination path
 
-			if (fs::is_directory(srcPath, copyEc))
+			if (entry.error)
 			{
-				// Recursively copy subdirectories
-				if (!copyEc)
-				{
-					CopyDirectory(srcPath, dstPath);
-				}
-				else
-				{
-					throw std::runtime_error("Error checking if source path is directory '" + srcPath.string() + "': " + copyEc.message());
-				}
+				// Error occurred while checking the type of the source path
+				throw std::runtime_error("Error checking type of source path '" + srcPath.string() + "': " + entry.error.message());
 			}
-			else if (fs::is_regular_file(srcPath, copyEc))
+			if (entry.kind == FileKind::Directory)
+			{
+				subdirectories.push_back(srcPath);
+			}
+			else if (entry.kind == FileKind::Regular)
 			{
 				// Copy regular files, overwriting if they exist in the destination
-				if (!copyEc)
-				{
-					fs::copy_file(srcPath, dstPath, fs::copy_options::overwrite_existing, copyEc);
-					if (copyEc)
-					{
-						throw std::runtime_error("Failed to copy file '" + srcPath.string() + "' to '" + dstPath.string() + "': " + copyEc.message());
-					}
-				}
-				else
+				std::error_code copyEc;
+				fileSystem.copyFile(srcPath, dstPath, CopyMode::Overwrite, copyEc);
+				if (copyEc)
 				{
-					throw std::runtime_error("Error checking if source path is regular file '" + srcPath.string() + "': " + copyEc.message());
+					throw std::runtime_error("Failed to copy file '" + srcPath.string() + "' to '" + dstPath.string() + "': " + copyEc.message());
 				}
 			}
-			// Other file types (symlinks, etc) are skipped; no warning logged to avoid noise for common scenarios
-			else if (copyEc)
-			{
-				// Error occurred while checking the type of the source path
-				throw std::runtime_error("Error checking type of source path '" + srcPath.string() + "': " + copyEc.message());
-			}
+			// Other file types (devices, etc) are skipped; no warning logged to avoid noise for common scenarios
+		};
+		std::error_code listEc;
+		fileSystem.listDirectory(source, copyEntry, listEc);
+		if (listEc)
+		{
+			throw std::runtime_error("Failed to list source directory '" + source.string() + "': " + listEc.message());
+		}
+
+		// Recursively copy subdirectories
+		for (const auto &srcPath : subdirectories)
+		{
+			CopyDirectory(srcPath, destination / srcPath.filename(), fileSystem);
 		}
 	}
 	catch (const fs::filesystem_error &e)
@@ -125,7 +124,7 @@ fs::path RenamerLogic::GetDefaultBackupParentPathInternal()
 }
 
 // Performs a backup of the sourcePath to a timestamped folder within the application's backup directory
-BackupResult RenamerLogic::performBackup(const fs::path &sourcePath, const std::string &contextName)
+BackupResult RenamerLogic::performBackup(const fs::path &sourcePath, const std::string &contextName, FileSystem &fileSystem)
 {
 	BackupResult result;
 	result.success = false; // Assume failure initially
@@ -173,7 +172,8 @@ BackupResult RenamerLogic::performBackup(const fs::path &sourcePath, const std::
 	if (safeContext.empty())
 	{
 		// If context is empty, attempt to use the source directory's name as a fallback
-		if (fs::is_directory(sourcePath) && sourcePath.has_filename())
+		std::error_code contextEc;
+		if (fileSystem.isDirectory(sourcePath, contextEc) && sourcePath.has_filename())
 		{
 			safeContext = sourcePath.filename().string();
 		}
@@ -203,34 +203,35 @@ BackupResult RenamerLogic::performBackup(const fs::path &sourcePath, const std::
 	{
 		std::error_code srcEc;
 		// Validate the source path before attempting to copy
-		if (!fs::exists(sourcePath, srcEc) || srcEc || !fs::is_directory(sourcePath, srcEc) || srcEc)
+		if (!fileSystem.isDirectory(sourcePath, srcEc) || srcEc)
 		{
 			throw std::runtime_error("Backup source path is invalid or not a directory: '" + sourcePath.string() + "'" + (srcEc ? " (" + srcEc.message() + ")" : ""));
 		}
 
 		// Ensure the parent backup directory (e.g., Documents/RenameUtilityBackups) exists
 		std::error_code parentEc;
-		if (!fs::exists(backupParentDir, parentEc) || parentEc)
+		FileKind parentKind = fileSystem.status(backupParentDir, parentEc);
+		if (parentEc || parentKind == FileKind::NotFound)
 		{
-			if (!fs::create_directories(backupParentDir, parentEc) || parentEc)
+			if (!fileSystem.createDirectories(backupParentDir, parentEc) || parentEc)
 			{
 				throw std::runtime_error("Failed to create parent backup directory '" + backupParentDir.string() + "'" + (parentEc ? " (" + parentEc.message() + ")" : ""));
 			}
 		}
-		else if (!fs::is_directory(backupParentDir, parentEc) || parentEc)
+		else if (parentKind != FileKind::Directory)
 		{
-			throw std::runtime_error("Parent backup path exists but is not a directory '" + backupParentDir.string() + "'" + (parentEc ? " (" + parentEc.message() + ")" : ""));
+			throw std::runtime_error("Parent backup path exists but is not a directory '" + backupParentDir.string() + "'");
 		}
 
 		// Check if the specific backup destination already exists (highly unlikely due to timestamp, but good practice)
 		std::error_code destEc;
-		if (fs::exists(result.backupPath, destEc) || destEc)
+		if (fileSystem.exists(result.backupPath, destEc) || destEc)
 		{
 			throw std::runtime_error("Backup destination path already exists (collision?): '" + result.backupPath.string() + "'" + (destEc ? " (" + destEc.message() + ")" : ""));
 		}
 
 		// Perform the recursive copy operation
-		CopyDirectory(sourcePath, result.backupPath);
+		CopyDirectory(sourcePath, result.backupPath, fileSystem);
 
 		// If CopyDirectory didn't throw an exception, the backup is considered successful
 		result.success = true;
@@ -244,11 +245,11 @@ BackupResult RenamerLogic::performBackup(const fs::path &sourcePath, const std::
 		if (!result.backupPath.empty())
 		{
 			std::error_code checkEc, removeEc;
-			if (fs::exists(result.backupPath, checkEc) && !checkEc)
+			if (fileSystem.exists(result.backupPath, checkEc) && !checkEc)
 			{
 				try
 				{
-					fs::remove_all(result.backupPath, removeEc);
+					fileSystem.removeAll(result.backupPath, removeEc);
 					if (removeEc)
 					{
 						// Append cleanup error message if cleanup itself fails
@@ -274,11 +275,11 @@ BackupResult RenamerLogic::performBackup(const fs::path &sourcePath, const std::
 		if (!result.backupPath.empty())
 		{
 			std::error_code checkEc, removeEc;
-			if (fs::exists(result.backupPath, checkEc) && !checkEc)
+			if (fileSystem.exists(result.backupPath, checkEc) && !checkEc)
 			{
 				try
 				{
-					fs::remove_all(result.backupPath, removeEc);
+					fileSystem.removeAll(result.backupPath, removeEc);
 				}
 				catch (...)
 				{
@@ -291,7 +292,7 @@ BackupResult RenamerLogic::performBackup(const fs::path &sourcePath, const std::
 }
 
 // Deletes a specified backup directory
-DeleteResult RenamerLogic::deleteBackup(const fs::path &backupPath)
+DeleteResult RenamerLogic::deleteBackup(const fs::path &backupPath, FileSystem &fileSystem)
 {
 	DeleteResult result;
 	result.success = false;
@@ -304,8 +305,9 @@ DeleteResult RenamerLogic::deleteBackup(const fs::path &backupPath)
 	}
 
 	// Check if the path exists and is a directory before attempting deletion
-	std::error_code existEc, typeEc;
-	bool bExists = fs::exists(backupPath, existEc);
+	std::error_code existEc;
+	FileKind backupKind = fileSystem.status(backupPath, existEc);
+	bool bExists = backupKind != FileKind::NotFound;
 	if (existEc)
 	{
 		result.errorMessage = "Error checking backup existence '" + backupPath.string() + "': " + existEc.message();
@@ -318,11 +320,9 @@ DeleteResult RenamerLogic::deleteBackup(const fs::path &backupPath)
 		result.success = true; // No action needed, so technically a success
 		return result;
 	}
-	if (!fs::is_directory(backupPath, typeEc) || typeEc)
+	if (backupKind != FileKind::Directory)
 	{
 		result.errorMessage = "Path to delete is not a directory: '" + backupPath.string() + "'.";
-		if (typeEc)
-			result.errorMessage += " (Filesystem Error: " + typeEc.message() + ")";
 		return result;
 	}
 
@@ -330,7 +330,7 @@ DeleteResult RenamerLogic::deleteBackup(const fs::path &backupPath)
 	try
 	{
 		std::error_code removeEc;
-		fs::remove_all(backupPath, removeEc);
+		fileSystem.removeAll(backupPath, removeEc);
 
 		if (removeEc)
 		{
@@ -341,7 +341,7 @@ DeleteResult RenamerLogic::deleteBackup(const fs::path &backupPath)
 		{
 			// Verify deletion by checking if the path still exists
 			std::error_code verifyEc;
-			if (fs::exists(backupPath, verifyEc) && !verifyEc)
+			if (fileSystem.exists(backupPath, verifyEc) && !verifyEc)
 			{
 				// Should not exist after a successful remove_all call
 				result.errorMessage = "Verification failed: Directory still exists after reported successful deletion: '" + backupPath.string() + "'.";
@@ -1,9 +1,16 @@
 #include "RenamerLogic.h"
+#include "ConcurrencyLimiter.h"
+#include "CrossDeviceMove.h"
+#include "Parallel.h"
+#include "RenameSchedule.h"
 
 #include <wx/log.h> // For wxLogWarning, if needed for less critical warnings
 
 #include <algorithm> // For std::sort
 #include <filesystem>
+#include <iterator>
+#include <map>
+#include <set>
 #include <stdexcept> // For std::exception safety
 #include <string>
 #include <system_error> // For std::error_code
@@ -12,10 +19,211 @@
 
 namespace fs = std::filesystem;
 
-// Executes the rename operations defined in the provided plan
+namespace // Anonymous namespace for internal linkage helper functions
+{
+// Creates every folder the plan moves files into before anything is renamed.
+// Each missing folder and missing ancestor is checked and created exactly
+// once, shallowest first; folders at the same depth are created in parallel.
+// Returns the folders that could not be created
+std::map<fs::path, std::error_code>
+CreateTargetFolders(const std::vector<RenameOperation> &plan,
+                    FileSystem &fileSystem) {
+  std::set<fs::path> targets;
+  for (const RenameOperation &op : plan) {
+    if (!op.hasConflict &&
+        op.NewFullPath.parent_path() != op.OldFullPath.parent_path()) {
+      targets.insert(op.NewFullPath.parent_path());
+    }
+  }
+
+  std::set<fs::path> visited; // Known to exist or queued for creation
+  std::map<std::size_t, std::vector<fs::path>> missingByDepth;
+  for (const fs::path &target : targets) {
+    for (fs::path folder = target;
+         !folder.empty() && visited.insert(folder).second;
+         folder = folder.parent_path()) {
+      std::error_code ec;
+      if (fileSystem.isDirectory(folder, ec)) {
+        break;
+      }
+      missingByDepth[std::distance(folder.begin(), folder.end())].push_back(
+          folder);
+    }
+  }
+
+  std::map<fs::path, std::error_code> failures;
+  for (const auto &level : missingByDepth) {
+    const std::vector<fs::path> &folders = level.second;
+    std::vector<std::error_code> errors(folders.size());
+    ParallelFor(
+        folders.size(),
+        [&](std::size_t i) {
+          fileSystem.createDirectories(folders[i], errors[i]);
+        },
+        DeviceConcurrency(fileSystem, folders.front(), IoClass::Metadata));
+    for (std::size_t i = 0; i < folders.size(); ++i) {
+      if (errors[i]) {
+        failures[folders[i]] = errors[i];
+      }
+    }
+  }
+  return failures;
+}
+
+enum class RenameOutcome { Renamed, Failed, Skipped, CrossDevice };
+
+// Checks and renames a single operation. 'message' explains a failure or a
+// skip. A file that can only be moved by copying is left for the caller
+RenameOutcome ExecuteOne(const RenameOperation &op, FileSystem &fileSystem,
+                         std::string &message) {
+  try {
+    std::error_code existEc, targetExistEc, renameEc;
+
+    // Verify that the source still exists and is of the planned kind before
+    // attempting to rename (a single status query answers both)
+    FileKind sourceKind = fileSystem.status(op.OldFullPath, existEc);
+    if (existEc) {
+      message = "Skipped: Filesystem error checking source existence: " +
+                existEc.message();
+      return RenameOutcome::Failed;
+    }
+    if (sourceKind == FileKind::NotFound) {
+      message = "Skipped: Source " +
+                std::string(op.isDirectory ? "folder" : "file") +
+                " disappeared (" + op.OldFullPath.string() + ").";
+      return RenameOutcome::Failed;
+    }
+    if (sourceKind !=
+        (op.isDirectory ? FileKind::Directory : FileKind::Regular)) {
+      message = std::string(op.isDirectory
+                                ? "Skipped: Source is not a folder ("
+                                : "Skipped: Source is not a regular file (") +
+                op.OldFullPath.string() + ").";
+      return RenameOutcome::Failed;
+    }
+
+    // Check if the target path already exists
+    // This is a critical check, as fs::rename might overwrite on some
+    // platforms or fail on others Identity renames (OldFullPath ==
+    // NewFullPath) should have been filtered out by the planning stage
+    if (op.OldFullPath != op.NewFullPath) {
+      bool targetExists = fileSystem.exists(op.NewFullPath, targetExistEc);
+      if (targetExistEc) {
+        message = "Skipped: Filesystem error checking target path (" +
+                  op.NewFullPath.string() + "): " + targetExistEc.message();
+        return RenameOutcome::Failed;
+      }
+      if (targetExists) {
+        // The sort order attempts to prevent this for *planned* renames
+        // within the batch This primarily catches conflicts with external
+        // files or unexpected filesystem behavior (e.g. case-insensitivity)
+        message = "Skipped: Target path already exists (" +
+                  op.NewFullPath.string() + ").";
+        return RenameOutcome::Failed;
+      }
+    } else {
+      // This case implies an identity rename made it past planning, which is
+      // unexpected Log a warning and skip, as no actual rename is needed or
+      // possible
+      wxLogWarning("Skipping identity rename operation for '%s' during "
+                   "execution phase",
+                   op.OldName.c_str());
+      return RenameOutcome::Skipped;
+    }
+
+    // Perform the actual rename operation
+    fileSystem.rename(op.OldFullPath, op.NewFullPath, renameEc);
+    if (renameEc == std::errc::cross_device_link && !op.isDirectory) {
+      return RenameOutcome::CrossDevice;
+    }
+
+    // Verify the outcome of the rename operation
+    if (!renameEc) {
+      // The rename reported success; double-check by verifying file
+      // presence/absence
+      std::error_code verifyOldEc, verifyNewEc;
+      bool oldStillExists = fileSystem.exists(op.OldFullPath, verifyOldEc);
+      bool newNowExists = fileSystem.exists(op.NewFullPath, verifyNewEc);
+
+      // Ideal outcome: no verification errors, old file is gone, new file
+      // exists
+      if (!verifyOldEc && !verifyNewEc && !oldStillExists && newNowExists) {
+        return RenameOutcome::Renamed;
+      }
+      // Discrepancy found: rename reported success, but verification failed
+      message = "Verification failed after rename reported success. ";
+      if (oldStillExists)
+        message += "Old file still exists. ";
+      else if (verifyOldEc)
+        message += "Error checking old (" + verifyOldEc.message() + "). ";
+      if (!newNowExists)
+        message += "New file does not exist. ";
+      else if (verifyNewEc)
+        message += "Error checking new (" + verifyNewEc.message() + "). ";
+      return RenameOutcome::Failed;
+    }
+    // The rename itself reported an error
+    message = "Rename failed: " + renameEc.message();
+    return RenameOutcome::Failed;
+  } catch (const fs::filesystem_error &ex) {
+    // Catch specific filesystem exceptions for detailed error reporting
+    message = "Filesystem Exception: " + std::string(ex.what());
+    if (!ex.path1().empty())
+      message += " (Path1: " + ex.path1().string() + ")";
+    if (!ex.path2().empty())
+      message += " (Path2: " + ex.path2().string() + ")";
+    message += " (Code: " + ex.code().message() + ")";
+  } catch (const std::exception &ex) {
+    // Catch other standard library exceptions
+    message = "General Exception: " + std::string(ex.what());
+  } catch (...) {
+    // Catch any other unknown exceptions
+    message = "Unknown exception occurred during rename.";
+  }
+  return RenameOutcome::Failed;
+}
+
+// Runs one scheduled step of 'ops'. Parking a file is not a rename of its
+// own, so it reports Skipped when it worked; a file left parked is named in
+// the failure message
+RenameOutcome ExecuteStep(const std::vector<RenameOperation> &ops,
+                          const ScheduledRename &step,
+                          std::map<std::size_t, fs::path> &parkedPaths,
+                          FileSystem &fileSystem, std::string &message) {
+  RenameOperation op = ops[step.op];
+  switch (step.kind) {
+  case ScheduledRename::Kind::Whole:
+    return ExecuteOne(op, fileSystem, message);
+  case ScheduledRename::Kind::Park:
+    op.NewFullPath = ParkingPath(op.OldFullPath, fileSystem);
+    if (ExecuteOne(op, fileSystem, message) != RenameOutcome::Renamed) {
+      return RenameOutcome::Failed;
+    }
+    parkedPaths[step.op] = op.NewFullPath;
+    return RenameOutcome::Skipped;
+  case ScheduledRename::Kind::Unpark:
+    break;
+  }
+  auto parked = parkedPaths.find(step.op);
+  if (parked == parkedPaths.end()) {
+    return RenameOutcome::Skipped; // Parking failed and was reported
+  }
+  op.OldFullPath = parked->second;
+  const RenameOutcome outcome = ExecuteOne(op, fileSystem, message);
+  if (outcome == RenameOutcome::Failed) {
+    message += " It was left as '" + parked->second.filename().string() + "'.";
+  }
+  return outcome;
+}
+} // namespace
+
+// Executes the rename operations defined in the provided plan. Files are
+// renamed first, then folders from the deepest up, so no pending operation
+// ever refers to a path an earlier one changed
 RenameExecutionResult
 RenamerLogic::performRename(const std::vector<RenameOperation> &plan,
-                            int increment) {
+                            int increment, FileSystem &fileSystem,
+                            const fs::path &moveJournal) {
   RenameExecutionResult results;
   results.overallSuccess =
       false; // Default to false; set to true only if all operations succeed
@@ -26,179 +234,193 @@ RenamerLogic::performRename(const std::vector<RenameOperation> &plan,
     return results;
   }
 
-  std::vector<RenameOperation> executionPlan =
-      plan; // Create a mutable copy of the plan
+  std::vector<RenameOperation> executionPlan;
+  std::map<std::size_t, std::vector<RenameOperation>, std::greater<>>
+      foldersByDepth; // Deepest first
+  executionPlan.reserve(plan.size());
+  for (const RenameOperation &op : plan) {
+    if (op.isDirectory && !op.hasConflict) {
+      foldersByDepth[std::distance(op.OldFullPath.begin(),
+                                   op.OldFullPath.end())]
+          .push_back(op);
+    } else {
+      executionPlan.push_back(op);
+    }
+  }
 
   // Sort the execution plan to minimize potential conflicts during renaming,
   // especially when dealing with numbered sequences
   // The sort order depends on whether numbers are being incremented or
   // decremented
-  std::sort(executionPlan.begin(), executionPlan.end(),
-            [increment](const RenameOperation &a, const RenameOperation &b) {
-              bool aHasNum = a.Number.has_value();
-              bool bHasNum = b.Number.has_value();
-
-              // If both operations involve numbered files, sort based on the
-              // increment direction
-              if (aHasNum && bHasNum) {
-                if (a.Number.value() != b.Number.value()) {
-                  // If incrementing (>0), rename files with higher original
-                  // numbers first (descending sort on original number) This
-                  // avoids conflicts like renaming "file2.txt" to "file3.txt"
-                  // before "file3.txt" is moved out of the way If decrementing
-                  // (<=0), rename files with lower original numbers first
-                  // (ascending sort on original number)
-                  return (increment > 0)
-                             ? (a.Number.value() > b.Number.value())
-                             : (a.Number.value() < b.Number.value());
-                }
-                // If numbers are the same, fall through to other sorting
-                // criteria
-              }
-              // If one has a number and the other doesn't, or if numbers are
-              // identical, use the original index (for Manual mode) or full
-              // path as tie-breakers for stable sorting
-
-              // Use Index from Manual mode as a primary tie-breaker if
-              // available and different (Index is 0 in DirScan mode, so this
-              // mainly affects Manual mode ordering)
-              if (a.Index != b.Index) {
-                return a.Index < b.Index;
-              }
-              // Final tie-breaker: original full path for consistent ordering
-              return a.OldFullPath < b.OldFullPath;
-            });
+  auto byNumberThenPath = [increment](const RenameOperation &a,
+                                      const RenameOperation &b) {
+    bool aHasNum = a.Number.has_value();
+    bool bHasNum = b.Number.has_value();
+
+    // If both operations involve numbered files, sort based on the
+    // increment direction
+    if (aHasNum && bHasNum) {
+      if (a.Number.value() != b.Number.value()) {
+        // If incrementing (>0), rename files with higher original
+        // numbers first (descending sort on original number) This
+        // avoids conflicts like renaming "file2.txt" to "file3.txt"
+        // before "file3.txt" is moved out of the way If decrementing
+        // (<=0), rename files with lower original numbers first
+        // (ascending sort on original number)
+        return (increment > 0) ? (a.Number.value() > b.Number.value())
+                               : (a.Number.value() < b.Number.value());
+      }
+      // If numbers are the same, fall through to other sorting
+      // criteria
+    }
+    // If one has a number and the other doesn't, or if numbers are
+    // identical, use the original index (for Manual mode) or full
+    // path as tie-breakers for stable sorting
+
+    // Use Index from Manual mode as a primary tie-breaker if
+    // available and different (Index is 0 in DirScan mode, so this
+    // mainly affects Manual mode ordering)
+    if (a.Index != b.Index) {
+      return a.Index < b.Index;
+    }
+    // Final tie-breaker: original full path for consistent ordering
+    return a.OldFullPath < b.OldFullPath;
+  };
+  // A shift plan already arrives in execution order
+  if (!std::is_sorted(executionPlan.begin(), executionPlan.end(),
+                      byNumberThenPath)) {
+    std::sort(executionPlan.begin(), executionPlan.end(), byNumberThenPath);
+  }
+
+  // Subfolders named by the pattern are created in one batch up front
+  const std::map<fs::path, std::error_code> folderFailures =
+      CreateTargetFolders(plan, fileSystem);
+  auto folderFailed = [&](const RenameOperation &op) {
+    auto failed = folderFailures.find(op.NewFullPath.parent_path());
+    if (failed == folderFailures.end()) {
+      return false;
+    }
+    results.failedRenames.push_back(
+        {op.OldName, "Skipped: Could not create folder (" +
+                         failed->first.string() +
+                         "): " + failed->second.message()});
+    return true;
+  };
+
+  // Renames refused because the target is on another filesystem; they are
+  // moved together, in parallel, once every other file is renamed
+  std::vector<CrossDeviceMove> crossDeviceMoves;
+  std::vector<const RenameOperation *> crossDeviceOps;
+
+  // Operations renaming into a name another one gives up wait for it; a
+  // cycle of them is broken by parking one file under a temporary name
+  std::map<std::size_t, fs::path> parkedPaths;
 
   bool anyFailure = false;
-  for (const auto &op : executionPlan) {
+  for (const ScheduledRename &step : ScheduleRenames(executionPlan)) {
+    const RenameOperation &op = executionPlan[step.op];
     // Skip operations flagged with conflicts during planning
     if (op.hasConflict) {
       results.failedRenames.push_back(
           {op.OldName, "Skipped: " + op.conflictReason});
       continue; // Don't count as failure - user was warned during preview
     }
+    if (step.kind != ScheduledRename::Kind::Unpark && !folderFailures.empty() &&
+        folderFailed(op)) {
+      anyFailure = true;
+      continue;
+    }
 
-    try {
-      std::error_code existEc, targetExistEc, typeEc, renameEc;
+    std::string message;
+    switch (
+        ExecuteStep(executionPlan, step, parkedPaths, fileSystem, message)) {
+    case RenameOutcome::Renamed:
+      results.successfulRenameOps.push_back(
+          op); // Record the successful operation
+      break;
+    case RenameOutcome::CrossDevice:
+      crossDeviceMoves.push_back({step.kind == ScheduledRename::Kind::Unpark
+                                      ? parkedPaths[step.op]
+                                      : op.OldFullPath,
+                                  op.NewFullPath,
+                                  {}});
+      crossDeviceOps.push_back(&op);
+      break;
+    case RenameOutcome::Failed:
+      results.failedRenames.push_back({op.OldName, std::move(message)});
+      anyFailure = true;
+      break;
+    case RenameOutcome::Skipped:
+      break;
+    }
+  }
 
-      // Verify that the source file still exists and is a regular file before
-      // attempting to rename
-      bool sourceExists = fs::exists(op.OldFullPath, existEc);
-      if (existEc) {
-        results.failedRenames.push_back(
-            {op.OldName,
-             "Skipped: Filesystem error checking source existence: " +
-                 existEc.message()});
-        anyFailure = true;
-        continue;
-      }
-      if (!sourceExists) {
-        results.failedRenames.push_back(
-            {op.OldName, "Skipped: Source file disappeared (" +
-                             op.OldFullPath.string() + ")."});
-        anyFailure = true;
-        continue;
-      }
-      if (!fs::is_regular_file(op.OldFullPath, typeEc) || typeEc) {
-        results.failedRenames.push_back(
-            {op.OldName, "Skipped: Source is not a regular file (" +
-                             op.OldFullPath.string() + ")." +
-                             (typeEc ? " Error: " + typeEc.message() : "")});
-        anyFailure = true;
-        continue;
-      }
+  MoveAcrossDevices(crossDeviceMoves, fileSystem, moveJournal);
+  for (std::size_t i = 0; i < crossDeviceMoves.size(); ++i) {
+    if (crossDeviceMoves[i].error.empty()) {
+      results.successfulRenameOps.push_back(*crossDeviceOps[i]);
+    } else {
+      results.failedRenames.push_back(
+          {crossDeviceOps[i]->OldName,
+           "Move to another drive failed: " + crossDeviceMoves[i].error});
+      anyFailure = true;
+    }
+  }
 
-      // Check if the target path already exists
-      // This is a critical check, as fs::rename might overwrite on some
-      // platforms or fail on others Identity renames (OldFullPath ==
-      // NewFullPath) should have been filtered out by the planning stage
-      if (op.OldFullPath != op.NewFullPath) {
-        bool targetExists = fs::exists(op.NewFullPath, targetExistEc);
-        if (targetExistEc) {
-          results.failedRenames.push_back(
-              {op.OldName, "Skipped: Filesystem error checking target path (" +
-                               op.NewFullPath.string() +
-                               "): " + targetExistEc.message()});
-          anyFailure = true;
-          continue;
-        }
-        if (targetExists) {
-          // The sort order attempts to prevent this for *planned* renames
-          // within the batch This primarily catches conflicts with external
-          // files or unexpected filesystem behavior (e.g. case-insensitivity)
-          results.failedRenames.push_back(
-              {op.OldName, "Skipped: Target path already exists (" +
-                               op.NewFullPath.string() + ")."});
-          anyFailure = true;
-          continue;
+  // Folders at one depth can't contain each other, so they are renamed in
+  // parallel unless one takes a name another gives up, which needs them
+  // scheduled like the files
+  for (auto &level : foldersByDepth) {
+    std::vector<RenameOperation> &folders = level.second;
+    std::sort(folders.begin(), folders.end(), byNumberThenPath);
+    std::set<std::string> sourcesLowercase;
+    for (const RenameOperation &op : folders) {
+      sourcesLowercase.insert(ToLower(op.OldFullPath.string()));
+    }
+    bool chained = false;
+    for (const RenameOperation &op : folders) {
+      chained |= sourcesLowercase.count(ToLower(op.NewFullPath.string())) > 0;
+    }
+
+    std::vector<RenameOutcome> outcomes(folders.size(),
+                                        RenameOutcome::Skipped);
+    std::vector<std::string> messages(folders.size());
+    auto renameFolder = [&](std::size_t i) {
+      if (folderFailures.empty() ||
+          folderFailures.count(folders[i].NewFullPath.parent_path()) == 0) {
+        outcomes[i] = ExecuteOne(folders[i], fileSystem, messages[i]);
+      }
+    };
+    if (chained) {
+      std::map<std::size_t, fs::path> parkedFolders;
+      for (const ScheduledRename &step : ScheduleRenames(folders)) {
+        if (folderFailures.empty() ||
+            folderFailures.count(folders[step.op].NewFullPath.parent_path()) ==
+                0) {
+          RenameOutcome outcome = ExecuteStep(folders, step, parkedFolders,
+                                              fileSystem, messages[step.op]);
+          if (step.kind != ScheduledRename::Kind::Park ||
+              outcome == RenameOutcome::Failed) {
+            outcomes[step.op] = outcome;
+          }
         }
-      } else {
-        // This case implies an identity rename made it past planning, which is
-        // unexpected Log a warning and skip, as no actual rename is needed or
-        // possible
-        wxLogWarning("Skipping identity rename operation for '%s' during "
-                     "execution phase",
-                     op.OldName.c_str());
-        continue;
       }
+    } else {
+      ParallelFor(folders.size(), renameFolder,
+                  DeviceConcurrency(fileSystem, folders.front().OldFullPath,
+                                    IoClass::Metadata));
+    }
 
-      // Perform the actual rename operation
-      fs::rename(op.OldFullPath, op.NewFullPath, renameEc);
-
-      // Verify the outcome of the rename operation
-      if (!renameEc) {
-        // fs::rename reported success; double-check by verifying file
-        // presence/absence
-        std::error_code verifyOldEc, verifyNewEc;
-        bool oldStillExists = fs::exists(op.OldFullPath, verifyOldEc);
-        bool newNowExists = fs::exists(op.NewFullPath, verifyNewEc);
-
-        // Ideal outcome: no verification errors, old file is gone, new file
-        // exists
-        if (!verifyOldEc && !verifyNewEc && !oldStillExists && newNowExists) {
-          results.successfulRenameOps.push_back(
-              op); // Record the successful operation
-        } else {
-          // Discrepancy found: rename reported success, but verification failed
-          std::string verifyMsg =
-              "Verification failed after rename reported success. ";
-          if (oldStillExists)
-            verifyMsg += "Old file still exists. ";
-          else if (verifyOldEc)
-            verifyMsg += "Error checking old (" + verifyOldEc.message() + "). ";
-          if (!newNowExists)
-            verifyMsg += "New file does not exist. ";
-          else if (verifyNewEc)
-            verifyMsg += "Error checking new (" + verifyNewEc.message() + "). ";
-          results.failedRenames.push_back({op.OldName, verifyMsg});
-          anyFailure = true;
-        }
-      } else {
-        // fs::rename itself reported an error
+    for (std::size_t i = 0; i < folders.size(); ++i) {
+      if (outcomes[i] == RenameOutcome::Renamed) {
+        results.successfulRenameOps.push_back(folders[i]);
+      } else if (outcomes[i] == RenameOutcome::Failed) {
         results.failedRenames.push_back(
-            {op.OldName, "Rename failed: " + renameEc.message()});
+            {folders[i].OldName, std::move(messages[i])});
+        anyFailure = true;
+      } else if (!folderFailures.empty() && folderFailed(folders[i])) {
         anyFailure = true;
       }
-    } catch (const fs::filesystem_error &ex) {
-      // Catch specific filesystem exceptions for detailed error reporting
-      std::string errMsg = "Filesystem Exception: " + std::string(ex.what());
-      if (!ex.path1().empty())
-        errMsg += " (Path1: " + ex.path1().string() + ")";
-      if (!ex.path2().empty())
-        errMsg += " (Path2: " + ex.path2().string() + ")";
-      errMsg += " (Code: " + ex.code().message() + ")";
-      results.failedRenames.push_back({op.OldName, errMsg});
-      anyFailure = true;
-    } catch (const std::exception &ex) {
-      // Catch other standard library exceptions
-      results.failedRenames.push_back(
-          {op.OldName, "General Exception: " + std::string(ex.what())});
-      anyFailure = true;
-    } catch (...) {
-      // Catch any other unknown exceptions
-      results.failedRenames.push_back(
-          {op.OldName, "Unknown exception occurred during rename."});
-      anyFailure = true;
     }
   }
 
@@ -206,4 +428,4 @@ RenamerLogic::performRename(const std::vector<RenameOperation> &plan,
   // AND no failures occurred during execution
   results.overallSuccess = !plan.empty() && !anyFailure;
   return results;
-}
\ No newline at end of file
+}
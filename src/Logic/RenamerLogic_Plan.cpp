@@ -1,544 +1,1665 @@
 #include "RenamerLogic.h"
+#include "CaptureGroups.h"
+#include "ConcurrencyLimiter.h"
+#include "ContentHash.h"
+#include "FreeNameIndex.h"
+#include "MediaDate.h"
+#include "MetadataCache.h"
+#include "OverlayFileSystem.h"
+#include "Parallel.h"
+#include "Pipeline.h"
+#include "RandomNames.h"
+#include "RenderCache.h"
+#include "ReplacementTable.h"
+#include "RuleRouter.h"
+#include "ScanFilter.h"
+#include "SequenceReport.h"
 
 #include <wx/log.h>     // For wxLogWarning, if needed
 #include <wx/tokenzr.h> // For splitting comma-separated extension string
 
 #include <algorithm> // For std::sort, std::max, std::abs
+#include <cctype>
 #include <cmath>     // For std::floor, std::log10
 #include <filesystem>
+#include <iterator>
 #include <limits> // For std::numeric_limits
 #include <map>
+#include <mutex>
+#include <numeric> // For std::iota
 #include <optional>
 #include <regex>
 #include <set>
 #include <stdexcept> // For std::exception
 #include <string>
 #include <system_error> // For std::error_code
-#include <type_traits>  // for std::is_same_v (used in a commented-out section)
+#include <unordered_set>
 #include <vector>
 
 namespace fs = std::filesystem;
 
-// Calculates the rename plan based on input parameters, performing file
-// scanning and validation
-OutputResults RenamerLogic::calculateRenamePlan(const InputParams &params) {
-  OutputResults results;
-  results.success =
-      true; // Assume success initially, set to false on fatal errors
-  bool dirScanFilesChecked =
-      false; // Tracks if any files were encountered during directory scan
+namespace // Anonymous namespace for internal linkage helper functions
+{
+// Optional per-file stages of the plan pipeline. Which ones are needed is
+// decided once per plan from the input parameters
+enum PlanFeature : unsigned {
+  FeatureNumbers = 1u << 0,        // <num>/<orig_num> or the number filter
+  FeatureFindReplace = 1u << 1,    // Find text or a replacement table
+  FeatureCaseConversion = 1u << 2, // Case conversion other than NoChange
+  FeatureMetadata = 1u << 3,       // <file_size>, <file_size_kb>, ...
+  FeatureRandom = 1u << 4,         // <random:N>
+  FeatureHash = 1u << 5,           // <hash:N>
+  FeatureCaptureDate = 1u << 6,    // <exif_date>, <exif_time>
+  FeatureRuleChain = 1u << 7,      // Non-empty InputParams::ruleChain
+  FeatureRoutedRules = 1u << 8,    // Non-empty InputParams::routedRules
+  FeatureCaptureGroups = 1u << 9,  // Non-empty InputParams::sourcePattern
+  FeatureSubfolders = 1u << 10,    // Folder separators with allowSubfolders
+  FeatureClock = 1u << 11,         // <YYYY>, <MM>, <DD>, <hh>, <mm>, <ss>
+};
 
-  // Basic validation: a naming pattern is always required
-  if (params.namingPattern.empty()) {
-    results.errorLog.push_back("FATAL: New name pattern cannot be empty.");
-    results.success = false;
-    return results;
+// Feature set fixed at compile time; disabled stages fold away entirely
+template <unsigned Mask> struct StaticFeatures {
+  static constexpr bool has(unsigned feature) { return (Mask & feature) != 0; }
+};
+
+// Generic fallback for combinations that are not instantiated statically
+struct DynamicFeatures {
+  unsigned mask = 0;
+  bool has(unsigned feature) const { return (mask & feature) != 0; }
+};
+
+// Works out which optional stages 'params' actually use
+unsigned DetectFeatures(const InputParams &params) {
+  const std::string &pattern = params.namingPattern;
+  unsigned features = 0;
+  if ((params.lowestNumber != 0 || params.highestNumber != 0) ||
+      pattern.find("<num>") != std::string::npos ||
+      pattern.find("<orig_num>") != std::string::npos) {
+    features |= FeatureNumbers;
+  }
+  if (!params.findText.empty() || !params.replacementTable.empty()) {
+    features |= FeatureFindReplace;
+  }
+  if (params.caseConversionMode != CaseConversionMode::NoChange) {
+    features |= FeatureCaseConversion;
+  }
+  if (!params.ruleChain.empty()) {
+    features |= FeatureRuleChain;
+  }
+  if (!params.sourcePattern.empty()) {
+    features |= FeatureCaptureGroups;
+  }
+  if (!params.routedRules.empty()) {
+    features |= FeatureRoutedRules;
+    for (const RoutedRule &rule : params.routedRules) {
+      if (rule.useNumberRange ||
+          rule.namingPattern.find("<num>") != std::string::npos ||
+          rule.namingPattern.find("<orig_num>") != std::string::npos) {
+        features |= FeatureNumbers;
+      }
+    }
   }
+  // File-derived placeholders may come from any chain step or routed rule
+  auto detectPlaceholders = [&features](const std::string &text) {
+    if (text.find("<file_size") != std::string::npos ||
+        text.find("<modified_date>") != std::string::npos) {
+      features |= FeatureMetadata;
+    }
+    if (RandomNameGenerator::References(text)) {
+      features |= FeatureRandom;
+    }
+    if (ReferencesHash(text)) {
+      features |= FeatureHash;
+    }
+    if (ReferencesCaptureDate(text)) {
+      features |= FeatureCaptureDate;
+    }
+    for (const char *tag : {"<YYYY>", "<MM>", "<DD>", "<hh>", "<mm>", "<ss>"}) {
+      if (text.find(tag) != std::string::npos) {
+        features |= FeatureClock;
+      }
+    }
+  };
+  detectPlaceholders(pattern);
+  auto hasSeparator = [](const std::string &text) {
+    return text.find_first_of("/\\") != std::string::npos;
+  };
+  if (params.allowSubfolders &&
+      (hasSeparator(pattern) ||
+       std::any_of(params.routedRules.begin(), params.routedRules.end(),
+                   [&](const RoutedRule &rule) {
+                     return hasSeparator(rule.namingPattern);
+                   }))) {
+    features |= FeatureSubfolders;
+  }
+  for (const RuleStep &step : params.ruleChain) {
+    detectPlaceholders(step.namingPattern);
+  }
+  for (const RoutedRule &rule : params.routedRules) {
+    detectPlaceholders(rule.namingPattern);
+  }
+  return features;
+}
 
-  if (params.mode == RenamingMode::DirectoryScan) {
-    // Directory Scan specific validations
-    std::error_code ec;
-    if (!fs::exists(params.targetDirectory, ec) || ec ||
-        !fs::is_directory(params.targetDirectory, ec) || ec) {
-      results.errorLog.push_back(
-          "FATAL: Target directory is invalid or inaccessible: " +
-          params.targetDirectory.string() +
-          (ec ? " (" + ec.message() + ")" : ""));
-      results.success = false;
-      return results;
+// Per-file values read from the file's content or header
+struct PrefetchedFile {
+  std::uint64_t contentHash = 0;
+  std::error_code hashError;
+  CaptureDate captureDate;
+};
+
+// Reads the hash and/or capture date 'features' asks for. With a cache, a
+// file whose identity still matches its entry isn't opened at all; the
+// identity is taken before reading, so a file changed meanwhile is simply
+// re-read next time
+template <typename Features>
+PrefetchedFile PrefetchFile(const fs::path &path, const Features &features,
+                            FileSystem &fileSystem, MetadataCache *cache) {
+  PrefetchedFile file;
+  FileIdentity identity;
+  std::error_code identityEc;
+  CachedMetadata cached;
+  if (cache) {
+    identity = fileSystem.identity(path, identityEc);
+    if (!identityEc) {
+      cache->lookup(identity, cached);
     }
-    if (params.filenamePattern.empty()) {
-      results.errorLog.push_back(
-          "FATAL: Filename Pattern cannot be empty in Directory Scan mode.");
-      results.success = false;
-      return results;
+  }
+  bool computed = false;
+  if (features.has(FeatureHash)) {
+    if (cached.contentHash) {
+      file.contentHash = *cached.contentHash;
+    } else {
+      file.contentHash = HashFileContent(fileSystem, path, file.hashError);
+      if (!file.hashError) {
+        cached.contentHash = file.contentHash;
+        computed = true;
+      }
     }
-    // Number filter range must be valid (lowest <= highest, unless both are 0
-    // for no filter)
-    if (params.lowestNumber > params.highestNumber &&
-        (params.lowestNumber != 0 || params.highestNumber != 0)) {
-      results.errorLog.push_back("FATAL: Lowest Number filter cannot be "
-                                 "greater than Highest Number filter.");
-      results.success = false;
-      return results;
+  }
+  if (features.has(FeatureCaptureDate)) {
+    if (cached.captureDate) {
+      file.captureDate = *cached.captureDate;
+    } else {
+      std::error_code dateEc;
+      file.captureDate = CaptureDateOrModified(fileSystem, path, dateEc);
+      if (!dateEc) { // A failed read is retried by the next preview
+        cached.captureDate = file.captureDate;
+        computed = true;
+      }
     }
+  }
+  if (cache && computed && !identityEc) {
+    cache->store(identity, cached);
+  }
+  return file;
+}
 
-    // Prepare filename pattern regex for matching files
-    std::regex findRegex;
+// Find/replace with its regex compiled once per plan rather than on every
+// call, as PerformFindReplace does. An invalid regex leaves names unchanged,
+// like PerformFindReplace. A replacement table is applied after it
+class CompiledFindReplace {
+public:
+  CompiledFindReplace(const std::string &find, const std::string &replace,
+                      bool caseSensitive, bool useRegex,
+                      const std::vector<ReplacementPair> &table = {})
+      : m_find(find), m_replace(replace), m_caseSensitive(caseSensitive),
+        m_useRegex(useRegex), m_table(table, caseSensitive) {
+    if (!useRegex || find.empty()) {
+      return;
+    }
     try {
-      std::string regexString = ConvertWildcardToRegex(
-          params.filenamePattern); // Convert wildcard to regex
-      findRegex.assign(regexString,
-                       std::regex::icase |
-                           std::regex::optimize); // Case-insensitive matching
-    } catch (const std::regex_error &e) {
-      results.errorLog.push_back(
-          "FATAL: Invalid Filename Pattern (regex error): " +
-          std::string(e.what()));
-      results.success = false;
-      return results;
+      std::regex::flag_type flags = std::regex::ECMAScript;
+      if (!caseSensitive) {
+        flags |= std::regex::icase;
+      }
+      m_regex.emplace(find, flags);
+    } catch (const std::regex_error &) {
+      m_regex.reset();
     }
+  }
 
-    // Prepare extension filter set if provided
-    std::set<std::string> extensionFilterSet;
-    bool useExtFilter = !params.filterExtensions.empty();
-    if (useExtFilter) {
-      wxStringTokenizer tokenizer(params.filterExtensions,
-                                  ","); // Split comma-separated extensions
-      while (tokenizer.HasMoreTokens()) {
-        std::string ext = ToLower(tokenizer.GetNextToken()
-                                      .Trim()
-                                      .ToStdString()); // Normalize to lowercase
-        if (!ext.empty()) {
-          if (ext[0] != '.') {
-            ext = "." + ext; // Ensure leading dot for consistent matching
-          }
-          extensionFilterSet.insert(ext);
-        }
+  std::string apply(std::string name) const {
+    if (name.empty()) {
+      return name;
+    }
+    if (!m_find.empty() && m_useRegex) {
+      if (m_regex) {
+        name = std::regex_replace(name, *m_regex, m_replace);
       }
-      if (extensionFilterSet.empty()) {
-        useExtFilter =
-            false; // No valid extensions were parsed from the input string
-      } else {
-        results.generalInfoLog.push_back("Filtering by extensions: " +
-                                         params.filterExtensions);
-      }
-    }
-
-    // Determine number width for formatting <num> and <orig_num> placeholders
-    // This aims to provide consistent zero-padding based on the range of
-    // numbers involved
-    int numberWidth = 1; // Default minimum width
-    bool useNumFilter = (params.lowestNumber != 0 || params.highestNumber != 0);
-    if (useNumFilter) {
-      // Consider the absolute magnitude of filter bounds and potential values
-      // after increment/decrement
-      long long maxAbsVal = std::max(std::abs((long long)params.highestNumber),
-                                     std::abs((long long)params.lowestNumber));
-      long long potentialMaxAfterInc = (long long)params.highestNumber +
-                                       std::abs((long long)params.increment);
-      long long potentialMinAfterInc =
-          (long long)params.lowestNumber -
-          std::abs((long long)params.increment); // consider negative increment
-      maxAbsVal = std::max({maxAbsVal, std::abs(potentialMaxAfterInc),
-                            std::abs(potentialMinAfterInc)});
-
-      if (maxAbsVal > 0) {
-        numberWidth = (int)std::floor(std::log10(maxAbsVal)) + 1;
-      }
-      numberWidth =
-          std::max(2, numberWidth); // Ensure a minimum width of 2 for typical
-                                    // numbering (e.g., 01, 02)
-      numberWidth = std::min(9, numberWidth); // Cap at a sensible maximum width
+    } else if (!m_find.empty()) {
+      name = RenamerLogic::PerformFindReplace(std::move(name), m_find,
+                                              m_replace, m_caseSensitive);
+    }
+    return m_table.empty() ? name : m_table.apply(name);
+  }
+
+private:
+  const std::string &m_find;
+  const std::string &m_replace;
+  bool m_caseSensitive;
+  bool m_useRegex;
+  std::optional<std::regex> m_regex;
+  MultiReplacer m_table;
+};
+
+// A source file accepted into the pipeline
+struct PlanCandidate {
+  fs::path path;
+  std::optional<int> number; // Parsed original number (Directory Scan only)
+  int index = 0;             // 1-based list position (Manual Selection only)
+  bool isDirectory = false;  // A folder (Directory Scan only)
+};
+
+// Directory Scan: candidates come from a filtered scan of the target directory
+struct DirectoryScanPolicy {
+  static constexpr RenamingMode Mode = RenamingMode::DirectoryScan;
+  static constexpr unsigned SupportedFeatures = ~0u;
+
+  std::vector<PlanCandidate> candidates;
+  std::set<fs::path> sources; // Every source path, for overwrite checks
+  int numberWidth = 2;
+  int totalFiles = 0;          // <total> is not available in this mode
+  bool entriesChecked = false; // True if the scan encountered any entry
+  // New number of each candidate when resequencing, otherwise empty
+  std::vector<int> resequenced;
+};
+
+// Manual Selection: candidates are the user's list minus duplicates and
+// files that are no longer valid
+struct ManualSelectionPolicy {
+  static constexpr RenamingMode Mode = RenamingMode::ManualSelection;
+  // No numeric placeholders (<num>, <orig_num>) in manual mode
+  static constexpr unsigned SupportedFeatures = ~unsigned(FeatureNumbers);
+
+  std::vector<PlanCandidate> candidates;
+  std::set<fs::path> sources; // Every unique input path, for overwrite checks
+  int numberWidth = 0;
+  int totalFiles = 0;
+};
+
+// Determines number width for formatting <num> and <orig_num> placeholders
+// This aims to provide consistent zero-padding based on the range of numbers
+// involved
+int CalculateNumberWidth(const InputParams &params) {
+  int numberWidth = 1; // Default minimum width
+  bool useNumFilter = (params.lowestNumber != 0 || params.highestNumber != 0);
+  if (!useNumFilter) {
+    return 2; // Default width if no number filter active but <num>/<orig_num>
+              // might be used
+  }
+  // Consider the absolute magnitude of filter bounds and potential values
+  // after increment/decrement
+  long long maxAbsVal = std::max(std::abs((long long)params.highestNumber),
+                                 std::abs((long long)params.lowestNumber));
+  long long potentialMaxAfterInc =
+      (long long)params.highestNumber + std::abs((long long)params.increment);
+  long long potentialMinAfterInc =
+      (long long)params.lowestNumber -
+      std::abs((long long)params.increment); // consider negative increment
+  maxAbsVal = std::max({maxAbsVal, std::abs(potentialMaxAfterInc),
+                        std::abs(potentialMinAfterInc)});
+
+  if (maxAbsVal > 0) {
+    numberWidth = (int)std::floor(std::log10(maxAbsVal)) + 1;
+  }
+  numberWidth = std::max(2, numberWidth); // Ensure a minimum width of 2 for
+                                          // typical numbering (e.g., 01, 02)
+  return std::min(9, numberWidth); // Cap at a sensible maximum width
+}
+
+// Validates Directory Scan parameters and scans the target directory into
+// 'policy'. Returns false after logging a fatal error
+bool CollectDirectoryScan(const InputParams &params, bool needsNumbers,
+                          FileSystem &fileSystem, DirectoryScanPolicy &policy,
+                          OutputResults &results) {
+  std::error_code ec;
+  if (!fileSystem.isDirectory(params.targetDirectory, ec) || ec) {
+    results.diagnostics.addPath(DiagCode::TargetDirInvalid,
+                                params.targetDirectory, ec);
+    return false;
+  }
+  if (params.filenamePattern.empty()) {
+    results.diagnostics.add(DiagCode::FilenamePatternEmpty);
+    return false;
+  }
+  // Number filter range must be valid (lowest <= highest, unless both are 0
+  // for no filter)
+  bool useNumFilter = (params.lowestNumber != 0 || params.highestNumber != 0);
+  if (params.lowestNumber > params.highestNumber && useNumFilter) {
+    results.diagnostics.add(DiagCode::NumberRangeInvalid);
+    return false;
+  }
+
+  // Compile the filename pattern, extension and number filters into one
+  // short-circuiting pipeline
+  // Both pattern fields take ';'-separated lists; exclude entries ending in a
+  // slash name directories to prune instead of files to skip
+  ScanFilterOptions filterOptions;
+  DirectoryFilterOptions directoryOptions;
+  filterOptions.includePatterns = SplitPatternList(params.filenamePattern);
+  for (std::string &pattern : SplitPatternList(params.excludePatterns)) {
+    if (pattern.back() == '/' || pattern.back() == '\\') {
+      pattern.pop_back();
+      if (pattern.empty()) {
+        continue; // A bare "/" would exclude every folder
+      }
+      directoryOptions.excludePatterns.push_back(std::move(pattern));
     } else {
-      numberWidth = 2; // Default width if no number filter active but
-                       // <num>/<orig_num> might be used
+      filterOptions.excludePatterns.push_back(std::move(pattern));
+    }
+  }
+  directoryOptions.skipHidden = params.skipHiddenDirectories;
+  directoryOptions.maxDepth = params.maxScanDepth;
+  filterOptions.useNumberRange = useNumFilter;
+  filterOptions.lowestNumber = params.lowestNumber;
+  filterOptions.highestNumber = params.highestNumber;
+  filterOptions.needsNumber = needsNumbers;
+  if (!params.filterExtensions.empty()) {
+    wxStringTokenizer tokenizer(params.filterExtensions,
+                                ","); // Split comma-separated extensions
+    while (tokenizer.HasMoreTokens()) {
+      std::string ext = tokenizer.GetNextToken().Trim().ToStdString();
+      if (!ext.empty()) {
+        filterOptions.extensions.push_back(ext);
+      }
+    }
+    // Only report the filter if any valid extensions were parsed from the
+    // input string
+    if (!filterOptions.extensions.empty()) {
+      results.diagnostics.add(DiagCode::FilteringByExtensions,
+                              params.filterExtensions);
     }
+  }
+  ScanFilter scanFilter(filterOptions);
+  DirectoryFilter directoryFilter(directoryOptions);
 
-    // Scan files in the target directory (recursively or not)
-    std::map<fs::path, std::optional<int>>
-        foundFilesMap; // Stores {file path -> original number (if any)}
-    std::set<fs::path> foundFilesSet; // Stores unique full paths of found files
-                                      // for later overwrite checks
-    try {
-      auto scanOptions =
-          fs::directory_options::skip_permission_denied; // Skip inaccessible
-                                                         // directories/files
-      auto processEntry =
-          [&](const fs::directory_entry
-                  &entry) // Lambda to process each directory entry
+  policy.numberWidth = CalculateNumberWidth(params);
+
+  // Scan files in the target directory (recursively or not)
+  std::map<fs::path, std::optional<int>>
+      foundFilesMap; // Stores {file path -> original number (if any)}
+  std::set<fs::path> foundDirectories; // Entries of the map that are folders
+  try {
+    // Lambda to process each entry of 'dir' (at 'depth' below the target);
+    // subdirectories to descend into are collected in 'subdirectories'
+    auto processEntry = [&](const fs::path &dir, int depth,
+                            const DirEntryView &entry,
+                            std::vector<fs::path> &subdirectories) {
+      policy.entriesChecked =
+          true; // Mark that at least one file/directory was encountered
+      if (entry.error) {
+        // Log error checking file type but continue scanning other files
+        results.diagnostics.addPath(DiagCode::EntryTypeError,
+                                    dir / fs::path(entry.name), entry.error);
+        return;
+      }
+      if (entry.kind == FileKind::Directory) {
+        // Folders to rename go through the same filters as files, apart
+        // from the depth limit, which only stops the scan descending
+        std::optional<int> folderNum;
+        if (params.renameDirectories && !directoryFilter.excludes(entry.name) &&
+            scanFilter.accept(entry.name, folderNum)) {
+          const fs::path folder = dir / fs::path(entry.name);
+          foundFilesMap[folder] = folderNum;
+          foundDirectories.insert(folder);
+        }
+        // Like fs::recursive_directory_iterator, symlinked directories are
+        // not followed. Excluded trees are pruned before they are listed
+        if (params.recursiveScan && !entry.isSymlink &&
+            directoryFilter.shouldDescend(entry.name, depth + 1)) {
+          subdirectories.push_back(dir / fs::path(entry.name));
+        }
+        return;
+      }
+      if (entry.kind != FileKind::Regular) // Process only regular files
       {
-        dirScanFilesChecked =
-            true; // Mark that at least one file/directory was encountered
-        const fs::path &currentPath = entry.path();
-        std::error_code fileEc;
-
-        if (fs::is_regular_file(currentPath, fileEc) &&
-            !fileEc) // Process only regular files
-        {
-          std::string filename = currentPath.filename().string();
-          std::string extension =
-              ToLower(currentPath.extension()
-                          .string()); // For case-insensitive extension filter
-
-          // 1. Match filename against the wildcard pattern (converted to regex)
-          if (std::regex_match(filename, findRegex)) {
-            // 2. Match extension filter (if active)
-            if (!useExtFilter || extensionFilterSet.count(extension)) {
-              // 3. Parse number from filename if needed for filtering or
-              // placeholders
-              std::optional<int> originalNum = std::nullopt;
-              bool needsNumParsing =
-                  useNumFilter ||
-                  (params.namingPattern.find("<num>") != std::string::npos) ||
-                  (params.namingPattern.find("<orig_num>") !=
-                   std::string::npos);
-              if (needsNumParsing) {
-                originalNum = RenamerLogic::ParseLastNumber(filename);
-              }
-
-              // 4. Match number filter (if active)
-              bool numberRangeOk = true;
-              if (useNumFilter) {
-                if (!originalNum.has_value() ||
-                    originalNum.value() < params.lowestNumber ||
-                    originalNum.value() > params.highestNumber) {
-                  numberRangeOk =
-                      false; // Number is outside the specified filter range
-                }
-              }
-
-              // If all filters pass, add the file to the map for processing
-              if (numberRangeOk) {
-                foundFilesMap[currentPath] = originalNum;
-                foundFilesSet.insert(currentPath);
-              }
+        return;
+      }
+
+      std::optional<int> originalNum;
+      if (!scanFilter.accept(entry.name, originalNum)) {
+        return;
+      }
+      // All filters passed, add the file to the map for processing
+      foundFilesMap[dir / fs::path(entry.name)] = originalNum;
+    };
+
+    results.diagnostics.addValue(DiagCode::ScanStarted, params.recursiveScan);
+    // Depth-first walk driven by the injected filesystem; only the target
+    // directory itself is listed when the scan is not recursive
+    std::vector<std::pair<fs::path, int>> pendingDirs{
+        {params.targetDirectory, 0}};
+    bool isTargetDir = true;
+    while (!pendingDirs.empty()) {
+      fs::path dir = std::move(pendingDirs.back().first);
+      const int depth = pendingDirs.back().second;
+      pendingDirs.pop_back();
+      std::vector<fs::path> subdirectories;
+      std::error_code listEc;
+      fileSystem.listDirectory(
+          dir,
+          [&](const DirEntryView &entry) {
+            try {
+              processEntry(dir, depth, entry, subdirectories);
+            } catch (const std::exception &e) {
+              // Log error for this entry but attempt to continue
+              results.diagnostics.add(DiagCode::ScanEntryException, e.what());
             }
-          }
-        } else if (fileEc) {
-          // Log error checking file type but continue scanning other files
-          results.warningLog.push_back(
-              "Warning: Filesystem error checking type of '" +
-              currentPath.string() + "': " + fileEc.message());
+          },
+          listEc);
+      if (listEc) {
+        if (isTargetDir) {
+          results.diagnostics.addPath(DiagCode::ScanStartFailed, dir, listEc);
+          return false;
         }
-      };
-
-      if (params.recursiveScan) {
-        results.generalInfoLog.push_back(
-            "Starting recursive directory scan...");
-        for (const auto &entry : fs::recursive_directory_iterator(
-                 params.targetDirectory, scanOptions)) {
-          try {
-            processEntry(entry);
-          } catch (const fs::filesystem_error &fs_err) {
-            // Log error during iteration but attempt to continue
-            results.warningLog.push_back(
-                "Warning: Filesystem error during recursive scan near '" +
-                fs_err.path1().string() + "': " + fs_err.what());
-            // The following was a commented-out attempt to disable recursion on
-            // error, not applicable here as entry is const if constexpr
-            // (std::is_same_v<decltype(entry), const fs::directory_entry&>) { }
-          } catch (const std::exception &e) {
-            results.warningLog.push_back(
-                "Warning: Exception during recursive scan: " +
-                std::string(e.what()));
-          }
+        results.diagnostics.addPath(DiagCode::SubdirectoryScanError, dir,
+                                    listEc);
+      }
+      isTargetDir = false;
+      // Push in reverse so subdirectories are visited in listing order
+      for (auto it = subdirectories.rbegin(); it != subdirectories.rend();
+           ++it) {
+        pendingDirs.emplace_back(std::move(*it), depth + 1);
+      }
+    }
+    if (directoryFilter.prunedCount() > 0) {
+      results.diagnostics.addValue(
+          DiagCode::DirectoriesPruned,
+          static_cast<std::int64_t>(directoryFilter.prunedCount()));
+    }
+  } catch (const fs::filesystem_error &e) {
+    results.diagnostics.addPath(DiagCode::ScanStartFailed, e.path1(),
+                                e.code());
+    return false;
+  } catch (const std::exception &e) {
+    results.diagnostics.add(DiagCode::ScanFailed, e.what());
+    return false;
+  }
+
+  // Candidates are handed to the pipeline in path order
+  policy.candidates.reserve(foundFilesMap.size());
+  for (auto &pair : foundFilesMap) {
+    policy.sources.insert(pair.first);
+    policy.candidates.push_back(
+        {pair.first, pair.second, 0, foundDirectories.count(pair.first) > 0});
+  }
+  return true;
+}
+
+// Reports each numbered family's gaps, repeated numbers and mixed zero
+// padding up front, rather than leaving them to show up as conflicts
+void ReportSequences(const DirectoryScanPolicy &policy,
+                     OutputResults &results) {
+  SequenceAnalyzer analyzer;
+  for (const PlanCandidate &candidate : policy.candidates) {
+    if (!candidate.isDirectory && candidate.number.has_value()) {
+      analyzer.add(candidate.path);
+    }
+  }
+  for (const SequenceFamily &family : analyzer.report()) {
+    if (family.members < 2) {
+      continue;
+    }
+    const std::string name = "'" + (family.folder / family.pattern).string() +
+                             "' (" + std::to_string(family.lowest) + "-" +
+                             std::to_string(family.highest) + "): ";
+    if (family.missing > 0) {
+      std::string text = name;
+      for (const auto &gap : family.gaps) {
+        text += std::to_string(gap.first);
+        if (gap.second != gap.first) {
+          text += "-" + std::to_string(gap.second);
         }
-      } else {
-        results.generalInfoLog.push_back(
-            "Starting non-recursive directory scan...");
-        for (const auto &entry :
-             fs::directory_iterator(params.targetDirectory, scanOptions)) {
-          try {
-            processEntry(entry);
-          } catch (const fs::filesystem_error &fs_err) {
-            results.warningLog.push_back(
-                "Warning: Filesystem error during scan near '" +
-                fs_err.path1().string() + "': " + fs_err.what());
-          } catch (const std::exception &e) {
-            results.warningLog.push_back("Warning: Exception during scan: " +
-                                         std::string(e.what()));
+        text += ", ";
+      }
+      text += std::to_string(family.missing) + " missing";
+      results.diagnostics.add(DiagCode::SequenceGaps, text);
+    }
+    if (family.duplicated > 0) {
+      std::string text = name;
+      for (std::uint32_t number : family.duplicates) {
+        text += std::to_string(number) + ", ";
+      }
+      text += std::to_string(family.duplicated) + " repeated";
+      results.diagnostics.add(DiagCode::SequenceDuplicates, text);
+    }
+    if (family.mixedPadding) {
+      std::string text = name;
+      for (const auto &width : family.widths) {
+        text += std::to_string(width.second) + " with " +
+                std::to_string(width.first) + " digit(s), ";
+      }
+      text.resize(text.size() - 2);
+      results.diagnostics.add(DiagCode::SequencePadding, text);
+    }
+  }
+}
+
+// Runs the plan through performRename against an in-memory overlay of the
+// filesystem, so renames are tried in their real execution order, and
+// reports the ones that would fail. Conflicting operations are left out, as
+// they are skipped on execution anyway
+void DryRunPlan(const InputParams &params, FileSystem &fileSystem,
+                OutputResults &results) {
+  std::vector<RenameOperation> runnable;
+  runnable.reserve(results.renamePlan.size());
+  std::copy_if(results.renamePlan.begin(), results.renamePlan.end(),
+               std::back_inserter(runnable),
+               [](const RenameOperation &op) { return !op.hasConflict; });
+  if (runnable.empty()) {
+    return;
+  }
+  OverlayFileSystem overlay(fileSystem);
+  const RenameExecutionResult simulated =
+      RenamerLogic::performRename(runnable, params.increment, overlay);
+  for (const auto &failed : simulated.failedRenames) {
+    if (!results.diagnostics.keeps(DiagCode::DryRunFailure)) {
+      results.diagnostics.add(DiagCode::DryRunFailure); // Counted only
+      continue;
+    }
+    results.diagnostics.add(DiagCode::DryRunFailure,
+                            "'" + failed.first + "' would fail: " +
+                                failed.second);
+  }
+}
+
+// Orders names as people read them: runs of digits by value ("2" before
+// "10"), everything else case-insensitively
+bool NaturalLess(const std::string &a, const std::string &b) {
+  auto isDigit = [](char c) { return c >= '0' && c <= '9'; };
+  std::size_t i = 0, j = 0;
+  while (i < a.size() && j < b.size()) {
+    if (isDigit(a[i]) && isDigit(b[j])) {
+      while (i < a.size() && a[i] == '0') {
+        ++i;
+      }
+      while (j < b.size() && b[j] == '0') {
+        ++j;
+      }
+      std::size_t endA = i, endB = j;
+      while (endA < a.size() && isDigit(a[endA])) {
+        ++endA;
+      }
+      while (endB < b.size() && isDigit(b[endB])) {
+        ++endB;
+      }
+      if (endA - i != endB - j) {
+        return endA - i < endB - j;
+      }
+      const int cmp = a.compare(i, endA - i, b, j, endB - j);
+      if (cmp != 0) {
+        return cmp < 0;
+      }
+      i = endA;
+      j = endB;
+      continue;
+    }
+    const char ca = static_cast<char>(
+        std::tolower(static_cast<unsigned char>(a[i])));
+    const char cb = static_cast<char>(
+        std::tolower(static_cast<unsigned char>(b[j])));
+    if (ca != cb) {
+      return ca < cb;
+    }
+    ++i;
+    ++j;
+  }
+  if ((i < a.size()) != (j < b.size())) {
+    return j < b.size();
+  }
+  return a < b; // Equal apart from case or leading zeros
+}
+
+// Numbers each folder's candidates from params.resequenceStart in the chosen
+// order. Ties, and files without a number when ordering by number (which go
+// last), fall back to the natural name order
+void ResequenceCandidates(const InputParams &params, FileSystem &fileSystem,
+                          DirectoryScanPolicy &policy) {
+  const std::vector<PlanCandidate> &candidates = policy.candidates;
+  std::vector<fs::file_time_type> modified;
+  if (params.resequence == ResequenceOrder::ModifiedTime) {
+    modified.resize(candidates.size());
+    ParallelFor(
+        candidates.size(),
+        [&](std::size_t i) {
+          std::error_code ec;
+          modified[i] = fileSystem.lastWriteTime(candidates[i].path, ec);
+          if (ec) {
+            modified[i] = fs::file_time_type::max(); // Unknown dates go last
           }
-        }
+        },
+        DeviceConcurrency(fileSystem, params.targetDirectory,
+                          IoClass::Metadata));
+  }
+  std::vector<std::string> names(candidates.size());
+  std::map<fs::path, std::vector<std::size_t>> byFolder;
+  for (std::size_t i = 0; i < candidates.size(); ++i) {
+    names[i] = candidates[i].path.filename().string();
+    byFolder[candidates[i].path.parent_path()].push_back(i);
+  }
+
+  auto before = [&](std::size_t a, std::size_t b) {
+    if (params.resequence == ResequenceOrder::CurrentNumber &&
+        candidates[a].number != candidates[b].number) {
+      if (!candidates[a].number || !candidates[b].number) {
+        return candidates[a].number.has_value();
       }
-    } catch (const fs::filesystem_error &e) {
-      results.errorLog.push_back(
-          "FATAL: Filesystem error starting directory scan at '" +
-          e.path1().string() + "': " + e.what());
-      results.success = false;
-      return results;
-    } catch (const std::exception &e) {
-      results.errorLog.push_back(
-          "FATAL: Unexpected error during directory scan: " +
-          std::string(e.what()));
+      return *candidates[a].number < *candidates[b].number;
+    }
+    if (params.resequence == ResequenceOrder::ModifiedTime &&
+        modified[a] != modified[b]) {
+      return modified[a] < modified[b];
+    }
+    return NaturalLess(names[a], names[b]);
+  };
+
+  policy.resequenced.assign(candidates.size(), 0);
+  std::size_t largestFolder = 0;
+  for (auto &folder : byFolder) {
+    std::vector<std::size_t> &order = folder.second;
+    std::sort(order.begin(), order.end(), before);
+    for (std::size_t rank = 0; rank < order.size(); ++rank) {
+      policy.resequenced[order[rank]] =
+          params.resequenceStart + static_cast<int>(rank);
+    }
+    largestFolder = std::max(largestFolder, order.size());
+  }
+  // Wide enough for the last position, so the names sort as numbered
+  const long long last = std::abs((long long)params.resequenceStart +
+                                  (long long)largestFolder - 1);
+  policy.numberWidth = std::max(
+      policy.numberWidth, static_cast<int>(std::to_string(last).size()));
+}
+
+// Validates the manual file list into 'policy', skipping duplicates and
+// files that were moved or deleted since being added. Returns false after
+// logging a fatal error
+bool CollectManualSelection(const InputParams &params, FileSystem &fileSystem,
+                            ManualSelectionPolicy &policy,
+                            OutputResults &results) {
+  if (params.manualFiles.empty()) {
+    results.diagnostics.add(DiagCode::ManualListEmpty);
+    return false;
+  }
+
+  policy.totalFiles = static_cast<int>(params.manualFiles.size());
+  policy.candidates.reserve(params.manualFiles.size());
+  // 1-based index for manual list display and <index> placeholder; skipped
+  // entries still advance it as it represents position in the user's list
+  int currentIndex = 1;
+  for (const auto &filePath : params.manualFiles) {
+    const int index = currentIndex++;
+
+    // Check for duplicate input files in the manual list itself
+    if (!policy.sources.insert(filePath).second) {
+      results.diagnostics.addPath(DiagCode::DuplicateInput, filePath);
+      continue;
+    }
+
+    // Verify the file exists and is a regular file right before processing
+    std::error_code ec;
+    if (!fileSystem.isRegularFile(filePath, ec) || ec) {
+      results.diagnostics.addPath(DiagCode::SourceInvalid, filePath, ec);
+      continue; // Skip this file
+    }
+    policy.candidates.push_back({filePath, std::nullopt, index});
+  }
+  return true;
+}
+
+// Candidate indexes per batch handed from BuildPlan's fetch stage, and
+// batches the render stage may be behind
+constexpr std::size_t FirstFetchBatch = 64;
+constexpr std::size_t MaxFetchBatch = 4096;
+constexpr std::size_t FetchRingSize = 16;
+// Names rendered ahead of the target checks
+constexpr std::size_t RenderRingSize = 1024;
+
+// A candidate as it leaves BuildPlan's render stage
+struct RenderedName {
+  std::size_t index = 0; // Into the policy's candidates
+  // Why the candidate left the plan, if it did. The check stage reports it,
+  // so diagnostics keep the candidates' order
+  std::optional<DiagCode> skipped;
+  std::error_code error; // Cause reported with 'skipped'
+  bool failed = false;   // Also marks the whole plan as failed
+  std::string oldName;
+  std::string newName; // As rendered, possibly with subfolders
+  fs::path newFullPath;
+};
+
+void ReportSkipped(const RenderedName &item, const fs::path &path,
+                   Diagnostics &diagnostics) {
+  switch (*item.skipped) {
+  case DiagCode::EmptyNameError:
+    diagnostics.add(DiagCode::EmptyNameError, item.oldName);
+    diagnostics.add(DiagCode::EmptyNameSkipped, item.oldName);
+    break;
+  case DiagCode::IdenticalName:
+    diagnostics.add(DiagCode::IdenticalName, item.oldName);
+    break;
+  default:
+    diagnostics.addPath(*item.skipped, path, item.error);
+    break;
+  }
+}
+
+// A target that is one of the sources is taken to be vacated; it isn't if
+// that source stays put. 'keptSources' holds the sources that aren't
+// renamed; flagging an op keeps its source too, so repeat until stable
+void FlagKeptTargets(std::vector<RenameOperation> &plan,
+                     std::set<fs::path> keptSources, Diagnostics &diagnostics) {
+  for (const RenameOperation &op : plan) {
+    if (op.hasConflict) {
+      keptSources.insert(op.OldFullPath);
+    }
+  }
+  for (bool flagged = !keptSources.empty(); flagged;) {
+    flagged = false;
+    for (std::size_t i = 0; i < plan.size(); ++i) {
+      RenameOperation &op = plan[i];
+      if (!op.hasConflict && keptSources.count(op.NewFullPath) != 0) {
+        op.hasConflict = true;
+        op.conflictReason = "Target file already exists";
+        diagnostics.addForOp(DiagCode::PotentialOverwrite, i);
+        diagnostics.addForOp(DiagCode::TargetExists, i);
+        keptSources.insert(op.OldFullPath);
+        flagged = true;
+      }
+    }
+  }
+}
+
+// The per-file pipeline shared by both modes: new number, placeholders,
+// find/replace, case conversion, then redundancy and conflict checks. Stages
+// not present in 'Features' are compiled out of the loop
+template <typename Policy, typename Features>
+void BuildPlan(const Policy &policy, const Features &features,
+               const InputParams &params, FileSystem &fileSystem,
+               OutputResults &results) {
+  std::vector<RenameOperation> tempPlan;
+  tempPlan.reserve(policy.candidates.size());
+  RandomNameGenerator randomNames(params.randomSeed);
+  // Compiled once; each file then costs one extension lookup
+  const RuleRouter router(features.has(FeatureRoutedRules)
+                              ? params.routedRules
+                              : std::vector<RoutedRule>());
+  const CompiledFindReplace findReplace(
+      params.findText, params.replaceText, params.findCaseSensitive,
+      params.findUseRegex, params.replacementTable);
+  std::vector<CompiledFindReplace> stepFindReplace;
+  stepFindReplace.reserve(params.ruleChain.size());
+  for (const RuleStep &step : params.ruleChain) {
+    stepFindReplace.emplace_back(step.findText, step.replaceText,
+                                 step.findCaseSensitive, step.findUseRegex);
+  }
+
+  // The source pattern and the templates referencing its groups (the naming
+  // pattern, then each routed rule's) are compiled once for the whole plan
+  std::optional<CaptureRegex> sourceRegex;
+  std::vector<CaptureTemplate> captureTemplates;
+  if (features.has(FeatureCaptureGroups)) {
+    std::string regexError;
+    sourceRegex = CaptureRegex::Compile(
+        params.sourcePattern, params.sourcePatternCaseSensitive, regexError);
+    if (!sourceRegex) {
+      results.diagnostics.add(DiagCode::SourcePatternInvalid, regexError);
       results.success = false;
-      return results;
+      return;
+    }
+    captureTemplates.emplace_back(params.namingPattern, *sourceRegex);
+    for (const RoutedRule &rule : params.routedRules) {
+      captureTemplates.emplace_back(rule.namingPattern, *sourceRegex);
+    }
+  }
+  std::set<std::string>
+      targetPathsLowercase; // For case-insensitive detection of target
+                            // conflicts within this batch
+  std::set<fs::path> newFolders; // Target folders other than the source's
+  // With a conflict suffix, taken targets get a free suffixed name instead
+  // of being flagged
+  std::optional<FreeNameIndex> freeNames;
+  if (!params.conflictSuffix.empty()) {
+    freeNames.emplace(params.conflictSuffix, fileSystem, policy.sources);
+  }
+
+  // The plan is built by three stages, each on its own thread and linked to
+  // the next by a bounded ring: reading content hashes and capture dates
+  // (waiting on the files, so itself parallel across files), rendering new
+  // names (CPU-bound) and checking targets (waiting on the disk again), so
+  // after the scan these stages overlap rather than run one after another.
+  // The scan itself completes first: <index>, the number width and the sort
+  // order all depend on every candidate. Every stage keeps the candidates'
+  // order, so the plan and its diagnostics are the same as from a single loop
+  const std::size_t count = policy.candidates.size();
+  const bool prefetch =
+      features.has(FeatureHash) || features.has(FeatureCaptureDate);
+  std::vector<PrefetchedFile> prefetched(prefetch ? count : 0);
+  SpscRing<std::size_t> fetched(FetchRingSize); // End of each batch read
+  SpscRing<RenderedName> rendered(RenderRingSize);
+
+  auto fetchStage = [&] {
+    ConcurrencyLimiter &limiter =
+        DeviceConcurrency(fileSystem, params.targetDirectory, IoClass::Read);
+    auto fetchOne = [&](std::size_t i) {
+      if (policy.candidates[i].isDirectory) {
+        // A folder has no content to hash; its date is its modification
+        // time
+        prefetched[i].hashError =
+            std::make_error_code(std::errc::is_a_directory);
+        prefetched[i].captureDate =
+            CaptureDateOrModified(fileSystem, policy.candidates[i].path);
+        return;
+      }
+      prefetched[i] = PrefetchFile(policy.candidates[i].path, features,
+                                   fileSystem, params.metadataCache);
+    };
+    // Small batches first so rendering starts early, then larger ones so
+    // threads are rarely started
+    for (std::size_t first = 0, batch = FirstFetchBatch; first < count;
+         first += batch, batch = std::min(batch * 2, MaxFetchBatch)) {
+      const std::size_t last = std::min(count, first + batch);
+      ParallelFor(
+          last - first, [&](std::size_t k) { fetchOne(first + k); }, limiter);
+      if (!fetched.push(last)) {
+        return;
+      }
+    }
+  };
+
+  // Stage outputs of earlier previews are reused unless a name may differ
+  // between previews for the same inputs
+  RenderCache *renderCache = features.has(FeatureRandom) ||
+                                     features.has(FeatureMetadata) ||
+                                     features.has(FeatureClock)
+                                 ? nullptr
+                                 : params.renderCache;
+  std::unique_lock<std::mutex> renderCacheLock;
+  std::uint64_t findKey = 0, caseKey = 0, chainKey = 0;
+  if (renderCache) {
+    renderCacheLock = std::unique_lock<std::mutex>(renderCache->planMutex());
+    renderCache->beginPlan();
+    StageKey find;
+    find.add(params.findText)
+        .add(params.replaceText)
+        .add(params.findCaseSensitive)
+        .add(params.findUseRegex);
+    for (const ReplacementPair &pair : params.replacementTable) {
+      find.add(pair.find).add(pair.replace);
+    }
+    findKey = find.digest();
+    caseKey = StageKey().add(params.caseConversionMode).digest();
+    StageKey chain;
+    for (const RuleStep &step : params.ruleChain) {
+      chain.add(step.namingPattern)
+          .add(step.findText)
+          .add(step.replaceText)
+          .add(step.findCaseSensitive)
+          .add(step.findUseRegex)
+          .add(step.caseConversionMode)
+          .add(step.increment);
+    }
+    chainKey = chain.digest();
+  }
+
+  auto render = [&](std::size_t i) {
+    RenderedName item;
+    item.index = i;
+    const PlanCandidate &candidate = policy.candidates[i];
+    const fs::path &currentPath = candidate.path;
+    if (features.has(FeatureHash) && prefetched[i].hashError) {
+      item.skipped = DiagCode::HashFailed;
+      item.error = prefetched[i].hashError;
+      return item;
+    }
+    std::string originalFilename = currentPath.filename().string();
+    // A folder's whole name is its stem: "set.v2" has no extension
+    std::string originalStem = candidate.isDirectory
+                                   ? originalFilename
+                                   : currentPath.stem().string();
+    std::string originalExtension =
+        candidate.isDirectory
+            ? std::string()
+            : currentPath.extension()
+                  .string(); // Preserve original case for placeholders
+
+    // The first routed rule selecting this file supplies its pattern
+    const std::string *namingPattern = &params.namingPattern;
+    int rule = -1;
+    if (features.has(FeatureRoutedRules)) {
+      rule = router.route(originalFilename, candidate.number);
+      if (rule >= 0) {
+        namingPattern = &params.routedRules[rule].namingPattern;
+      }
+    }
+    // Capture groups are substituted first; the groups refer into
+    // 'originalStem'
+    std::string capturedPattern;
+    if (features.has(FeatureCaptureGroups)) {
+      std::cmatch groups;
+      if (!sourceRegex->match(originalStem, groups)) {
+        item.skipped = DiagCode::SourcePatternNoMatch;
+        return item;
+      }
+      capturedPattern = captureTemplates[rule + 1].expand(groups);
+      namingPattern = &capturedPattern;
     }
 
-    // Generate the rename plan from the files found and filtered
-    std::vector<RenameOperation> tempPlan;
-    std::set<std::string>
-        targetPathsLowercase; // For case-insensitive detection of target
-                              // conflicts within this batch
-
-    for (const auto &pair :
-         foundFilesMap) { // Iterate over {path, original_number}
-      const fs::path &currentPath = pair.first;
-      const std::optional<int> &originalNumOpt = pair.second;
-      std::string originalFilename = currentPath.filename().string();
-      std::string originalStem = currentPath.stem().string();
-      std::string originalExtension =
-          currentPath.extension()
-              .string(); // Preserve original case for placeholders
-
-      // Calculate new number if applicable (original number + increment)
-      std::optional<int> newNumOpt = std::nullopt;
-      if (originalNumOpt.has_value()) {
-        long long newNumLL =
-            (long long)originalNumOpt.value() +
-            params.increment; // Use long long to detect overflow
-        if (newNumLL >= std::numeric_limits<int>::min() &&
-            newNumLL <= std::numeric_limits<int>::max()) {
-          newNumOpt = static_cast<int>(newNumLL);
-        } else {
-          results.missingSourceFilesLog.push_back(
-              originalFilename + " (in " + currentPath.parent_path().string() +
-              ") (Skipped: Incremented number out of int range)");
-          results.success = false; // Mark as error if number overflows, as it's
-                                   // an invalid operation
-          continue;                // Skip this file
+    // Calculate new number if applicable (original number + increment, or
+    // the file's position when resequencing)
+    std::optional<int> newNumOpt = std::nullopt;
+    bool resequenced = false;
+    if constexpr (Policy::Mode == RenamingMode::DirectoryScan) {
+      if (!policy.resequenced.empty()) {
+        newNumOpt = policy.resequenced[i];
+        resequenced = true;
+      }
+    }
+    if (features.has(FeatureNumbers) && candidate.number.has_value() &&
+        !resequenced) {
+      long long newNumLL = (long long)candidate.number.value() +
+                           params.increment; // Use long long to detect overflow
+      if (newNumLL >= std::numeric_limits<int>::min() &&
+          newNumLL <= std::numeric_limits<int>::max()) {
+        newNumOpt = static_cast<int>(newNumLL);
+      } else {
+        item.skipped = DiagCode::NumberOutOfRange;
+        item.failed = true; // Mark as error if number overflows, as it's an
+                            // invalid operation
+        return item;        // Skip this file
+      }
+    }
+
+    // Generate new filename using placeholders, find/replace, and case
+    // conversion. File metadata is only read when the pattern asks for it
+    std::string parentDirName = currentPath.parent_path().filename().string();
+    auto expandFilePlaceholders = [&](std::string pattern) {
+      if (features.has(FeatureHash)) {
+        pattern = ExpandHashPlaceholders(pattern, prefetched[i].contentHash);
+      }
+      if (features.has(FeatureCaptureDate)) {
+        pattern = ExpandCaptureDatePlaceholders(pattern,
+                                                prefetched[i].captureDate);
+      }
+      return pattern;
+    };
+    auto applyRuleStep = [&](const RuleStep &step,
+                             const CompiledFindReplace &stepReplace,
+                             std::string name) {
+      if (!step.namingPattern.empty()) {
+        const fs::path intermediate(name);
+        const std::string stem = intermediate.stem().string();
+        std::optional<int> stepNumber;
+        std::optional<int> stepNewNumber;
+        if (Policy::Mode == RenamingMode::DirectoryScan) {
+          stepNumber = RenamerLogic::ParseLastNumber(stem);
+          if (stepNumber.has_value()) {
+            const long long shifted =
+                (long long)stepNumber.value() + step.increment;
+            if (shifted >= std::numeric_limits<int>::min() &&
+                shifted <= std::numeric_limits<int>::max()) {
+              stepNewNumber = static_cast<int>(shifted);
+            }
+          }
+        }
+        std::string pattern = step.namingPattern;
+        if (features.has(FeatureRandom)) {
+          pattern = randomNames.expand(pattern);
+        }
+        name = RenamerLogic::ReplacePlaceholders(
+            expandFilePlaceholders(std::move(pattern)), Policy::Mode,
+            candidate.index, policy.totalFiles, name, stem,
+            intermediate.extension().string(), stepNumber, stepNewNumber,
+            policy.numberWidth, parentDirName,
+            features.has(FeatureMetadata) ? currentPath : fs::path(),
+            fileSystem);
+      }
+      name = stepReplace.apply(std::move(name));
+      if (step.caseConversionMode != CaseConversionMode::NoChange) {
+        name = RenamerLogic::ApplyCaseConversion(std::move(name),
+                                                 step.caseConversionMode);
+      }
+      return name;
+    };
+    auto expandPlaceholders = [&](std::string pattern) {
+      return RenamerLogic::ReplacePlaceholders(
+          expandFilePlaceholders(std::move(pattern)), Policy::Mode,
+          candidate.index, policy.totalFiles, originalFilename, originalStem,
+          originalExtension, candidate.number, newNumOpt, policy.numberWidth,
+          parentDirName,
+          features.has(FeatureMetadata) ? currentPath : fs::path(),
+          fileSystem);
+    };
+    // Placeholder output depends on the pattern and on everything known
+    // about the file; each later stage only on its own fields and the
+    // previous stage's output
+    auto placeholderKey = [&](const std::string &pattern) {
+      StageKey key;
+      key.add(pattern)
+          .add(currentPath.string())
+          .add(candidate.isDirectory)
+          .add(candidate.index)
+          .add(policy.totalFiles)
+          .add(policy.numberWidth)
+          .add(features.has(FeatureSubfolders))
+          .add(candidate.number.has_value())
+          .add(candidate.number.value_or(0))
+          .add(newNumOpt.has_value())
+          .add(newNumOpt.value_or(0));
+      if (features.has(FeatureHash)) {
+        key.add(prefetched[i].contentHash);
+      }
+      if (features.has(FeatureCaptureDate)) {
+        const CaptureDate &date = prefetched[i].captureDate;
+        key.add(date.year).add(date.month).add(date.day);
+        key.add(date.hour).add(date.minute).add(date.second);
+      }
+      return key.digest();
+    };
+    // Runs one stage after the placeholders, reusing its cached output for
+    // the same input
+    auto cachedStage = [&](RenderCache::Entry *cached,
+                           RenderCache::Stage stage, std::uint64_t key,
+                           std::string &name, auto compute) {
+      if (!cached) {
+        name = compute(std::move(name));
+        return;
+      }
+      const std::uint64_t inputKey = StageKey().add(key).add(name).digest();
+      if (!renderCache->reuse(*cached, stage, inputKey, name)) {
+        name = compute(std::move(name));
+        renderCache->store(*cached, stage, inputKey, name);
+      }
+    };
+    auto generateName = [&](std::string pattern) {
+      RenderCache::Entry *cached =
+          renderCache ? &renderCache->entry(currentPath.string()) : nullptr;
+      std::uint64_t expandedKey = 0;
+      std::string folders;
+      std::string name;
+      bool expanded = false;
+      if (cached) {
+        expandedKey = placeholderKey(pattern);
+        expanded = renderCache->reuse(*cached, RenderCache::Placeholders,
+                                      expandedKey, name);
+        if (expanded) {
+          folders = cached->slots[RenderCache::Placeholders].folders;
         }
       }
+      // Folder components get placeholders only, each sanitised on its own
+      // so none can be empty, "." or ".."; the rest of the pipeline applies
+      // to the file name
+      if (!expanded && features.has(FeatureSubfolders)) {
+        const std::size_t lastSeparator = pattern.find_last_of("/\\");
+        std::size_t start = 0;
+        while (lastSeparator != std::string::npos && start <= lastSeparator) {
+          const std::size_t end = pattern.find_first_of("/\\", start);
+          if (end > start) {
+            folders += expandPlaceholders(pattern.substr(start, end - start));
+            folders += '/';
+          }
+          start = end + 1;
+        }
+        if (lastSeparator != std::string::npos) {
+          pattern.erase(0, lastSeparator + 1);
+        }
+      }
+      if (!expanded) {
+        name = expandPlaceholders(std::move(pattern));
+        if (cached) {
+          renderCache->store(*cached, RenderCache::Placeholders, expandedKey,
+                             name);
+          cached->slots[RenderCache::Placeholders].folders = folders;
+        }
+      }
+      if (features.has(FeatureFindReplace)) {
+        cachedStage(cached, RenderCache::FindReplace, findKey, name,
+                    [&](std::string text) {
+                      return findReplace.apply(std::move(text));
+                    });
+      }
+      if (features.has(FeatureCaseConversion)) {
+        cachedStage(cached, RenderCache::CaseConversion, caseKey, name,
+                    [&](std::string text) {
+                      return RenamerLogic::ApplyCaseConversion(
+                          std::move(text), params.caseConversionMode);
+                    });
+      }
+      if (features.has(FeatureRuleChain)) {
+        // Each step sees the previous step's name as <orig_name>; nothing
+        // touches the disk until the final name is renamed to. The steps
+        // may use anything known about the file, so the placeholder key is
+        // part of theirs
+        cachedStage(cached, RenderCache::RuleChain,
+                    StageKey().add(chainKey).add(expandedKey).digest(), name,
+                    [&](std::string text) {
+                      for (std::size_t s = 0; s < params.ruleChain.size();
+                           ++s) {
+                        text = applyRuleStep(params.ruleChain[s],
+                                             stepFindReplace[s],
+                                             std::move(text));
+                      }
+                      return text;
+                    });
+      }
+      return name.empty() ? name : folders + name;
+    };
+    std::string finalNewFilename;
+    if (features.has(FeatureRandom)) {
+      // Random text is already unique within the batch; only a name that
+      // lands on an existing file is drawn again
+      for (int attempt = 0; attempt < RandomNameGenerator::MaxAttempts;
+           ++attempt) {
+        finalNewFilename =
+            generateName(randomNames.expand(*namingPattern));
+        std::error_code existsEc;
+        if (finalNewFilename.empty() ||
+            !fileSystem.exists(currentPath.parent_path() / finalNewFilename,
+                               existsEc)) {
+          break;
+        }
+      }
+    } else {
+      finalNewFilename = generateName(*namingPattern);
+    }
+
+    item.oldName = std::move(originalFilename);
+    if (finalNewFilename.empty()) {
+      item.skipped = DiagCode::EmptyNameError;
+      item.failed = true; // An empty filename is an error
+      return item;
+    }
+
+    item.newFullPath =
+        currentPath.parent_path() / fs::path(finalNewFilename).make_preferred();
+    // Check if the rename is redundant (new name is same as old,
+    // case-insensitively)
+    if (RenamerLogic::iequals(currentPath.string(),
+                              item.newFullPath.string())) {
+      item.skipped = DiagCode::IdenticalName;
+      return item;
+    }
+    item.newName = std::move(finalNewFilename);
+    return item;
+  };
 
-      // Generate new filename using placeholders, find/replace, and case
-      // conversion
-      std::string parentDirName = currentPath.parent_path().filename().string();
-      std::string nameAfterPlaceholders = RenamerLogic::ReplacePlaceholders(
-          params.namingPattern, params.mode, 0, 0, originalFilename,
-          originalStem, originalExtension, originalNumOpt, newNumOpt,
-          numberWidth, parentDirName);
-      std::string nameAfterFindReplace = RenamerLogic::PerformFindReplace(
-          nameAfterPlaceholders, params.findText, params.replaceText,
-          params.findCaseSensitive, params.findUseRegex);
-      std::string finalNewFilename = RenamerLogic::ApplyCaseConversion(
-          nameAfterFindReplace, params.caseConversionMode);
-
-      if (finalNewFilename.empty()) {
-        results.errorLog.push_back(
-            "Error: Generated new filename is empty for '" + originalFilename +
-            "'. Skipped.");
-        results.missingSourceFilesLog.push_back(
-            originalFilename + " (Skipped: Generated name was empty)");
-        results.success = false; // An empty filename is an error
-        continue;
-      }
-
-      fs::path newFullPath = currentPath.parent_path() / finalNewFilename;
-
-      // Check if the rename is redundant (new name is same as old,
-      // case-insensitively)
-      if (RenamerLogic::iequals(currentPath.string(), newFullPath.string())) {
-        results.generalInfoLog.push_back(
-            "Skipping '" + originalFilename +
-            "' (New name is identical to old name, case-insensitively)");
-        continue;
+  auto renderStage = [&] {
+    // Without prefetching every candidate is ready from the start
+    std::size_t readyEnd = prefetch ? 0 : count;
+    for (std::size_t i = 0; i < count; ++i) {
+      while (i == readyEnd) {
+        if (!fetched.pop(readyEnd)) {
+          return; // The fetch stage failed
+        }
+      }
+      if (!rendered.push(render(i))) {
+        return;
       }
+    }
+  };
 
+  std::optional<StageThread> fetchThread;
+  if (prefetch) {
+    fetchThread.emplace(fetchStage, [&] { fetched.close(); });
+  }
+  StageThread renderThread(renderStage, [&] { rendered.close(); });
+  // If checking throws, closing both rings first lets the other stages stop
+  // before their threads are joined
+  struct RingCloser {
+    SpscRing<std::size_t> &fetched;
+    SpscRing<RenderedName> &rendered;
+    ~RingCloser() {
+      fetched.close();
+      rendered.close();
+    }
+  } closer{fetched, rendered};
+
+  // Adds the op for a rendered, unskipped item, checking its target
+  auto addOperation = [&](RenderedName &item) {
+    const PlanCandidate &candidate = policy.candidates[item.index];
+    const fs::path &currentPath = candidate.path;
+    fs::path &newFullPath = item.newFullPath;
+    std::string &finalNewFilename = item.newName;
+    bool hasBatchConflict = false;
+    bool resolved = false;
+    std::string conflictReason;
+    if (freeNames) {
+      // The index covers both the batch and the files already on disk
+      std::error_code claimEc;
+      fs::path claimed =
+          freeNames->claim(newFullPath, candidate.isDirectory, claimEc);
+      if (claimEc) {
+        hasBatchConflict = true;
+        conflictReason =
+            "Error checking if target exists: " + claimEc.message();
+        results.diagnostics.addForOp(DiagCode::TargetCheckError,
+                                     tempPlan.size(), claimEc);
+      } else if (claimed != newFullPath) {
+        // Only the last component changes; keep any subfolders in the name
+        const std::size_t nameStart =
+            finalNewFilename.size() - newFullPath.filename().string().size();
+        finalNewFilename = finalNewFilename.substr(0, nameStart) +
+                           claimed.filename().string();
+        newFullPath = std::move(claimed);
+        resolved = true;
+      }
+    } else {
       // Check for target path conflicts within this batch (case-insensitive)
       // This prevents renaming two different source files to the same target
       // name in this operation
       std::string newPathLower = ToLower(newFullPath.string());
-      bool hasBatchConflict = false;
-      std::string conflictReason;
       if (!targetPathsLowercase.insert(newPathLower)
                .second) { // .second is false if element already existed
         hasBatchConflict = true;
         conflictReason = "Target conflicts with another file in this batch";
-        results.warningLog.push_back(
-            "Conflict: Generated path '" + newFullPath.string() +
-            "' conflicts with another file in this batch.");
+        results.diagnostics.addForOp(DiagCode::BatchConflict,
+                                     tempPlan.size());
       }
 
       // Check if target path already exists on disk AND is not one of the
       // source files being renamed in this batch
       std::error_code targetEc;
-      bool targetExists = fs::exists(newFullPath, targetEc);
+      bool targetExists = fileSystem.exists(newFullPath, targetEc);
       if (targetEc) {
         hasBatchConflict = true;
         conflictReason =
             "Error checking if target exists: " + targetEc.message();
-        results.warningLog.push_back(
-            "Conflict: Filesystem error checking target path '" +
-            newFullPath.string() + "': " + targetEc.message());
-      } else if (targetExists && foundFilesSet.count(newFullPath) == 0) {
-        // Target exists and is NOT an original file in our scan
+        results.diagnostics.addForOp(DiagCode::TargetCheckError,
+                                     tempPlan.size(), targetEc);
+      } else if (targetExists && policy.sources.count(newFullPath) == 0) {
+        // Target exists and is NOT one of the source files. A source that
+        // turns out to stay put is caught once every skip is known
         hasBatchConflict = true;
         conflictReason = "Target file already exists";
-        results.potentialOverwritesLog.push_back(
-            {originalFilename, finalNewFilename, newFullPath});
-        results.warningLog.push_back(
-            "Conflict: Target '" + newFullPath.string() + "' already exists.");
-      }
-
-      // Add to the plan (with conflict flag if applicable)
-      RenameOperation op;
-      op.OldName = originalFilename;
-      op.NewName = finalNewFilename;
-      op.OldFullPath = currentPath;
-      op.NewFullPath = newFullPath;
-      op.Number = originalNumOpt;
-      op.Index = 0;
-      op.hasConflict = hasBatchConflict;
-      op.conflictReason = conflictReason;
-      tempPlan.push_back(op);
-    }
-    results.renamePlan = std::move(tempPlan);
-  } else { // ManualSelection Mode
-    if (params.manualFiles.empty()) {
-      results.errorLog.push_back(
-          "FATAL: No files were added to the list in Manual Selection mode.");
-      results.success = false;
-      return results;
+        results.diagnostics.addForOp(DiagCode::PotentialOverwrite,
+                                     tempPlan.size());
+        results.diagnostics.addForOp(DiagCode::TargetExists,
+                                     tempPlan.size());
+      }
+    }
+
+    // Add to the plan (with conflict flag if applicable)
+    RenameOperation op;
+    op.OldName = std::move(item.oldName);
+    op.NewName = std::move(finalNewFilename);
+    op.OldFullPath = currentPath;
+    op.NewFullPath = std::move(newFullPath);
+    op.Number = candidate.number;
+    op.Index = candidate.index;
+    op.hasConflict = hasBatchConflict;
+    op.conflictReason = std::move(conflictReason);
+    op.isDirectory = candidate.isDirectory;
+    if (resolved) {
+      results.diagnostics.addForOp(DiagCode::ConflictResolved,
+                                   tempPlan.size());
     }
+    tempPlan.push_back(std::move(op));
+  };
 
-    int currentIndex =
-        1; // 1-based index for manual list display and <index> placeholder
-    int totalFiles = params.manualFiles.size();
-    std::set<std::string> targetPathsLowercase; // For case-insensitive conflict
-                                                // detection within this batch
-    std::set<fs::path> uniqueInputPaths; // To detect duplicate input files and
-                                         // for overwrite checks
-    std::vector<RenameOperation> tempPlan;
-
-    for (const auto &filePath : params.manualFiles) {
-      fs::path currentPath = filePath; // Work with a copy
-
-      // Check for duplicate input files in the manual list itself
-      if (!uniqueInputPaths.insert(currentPath).second) {
-        results.warningLog.push_back(
-            "Warning: Skipping duplicate input file: " + currentPath.string());
-        currentIndex++; // Still increment index as it represents position in
-                        // the original user list
-        continue;
-      }
-
-      // Verify the file exists and is a regular file right before processing
-      // This is important as file might have been moved/deleted since being
-      // added to list
-      std::error_code ec;
-      if (!fs::exists(currentPath, ec) || ec ||
-          !fs::is_regular_file(currentPath, ec) || ec) {
-        results.missingSourceFilesLog.push_back(
-            currentPath.string() +
-            " (Skipped: Not a valid file or inaccessible" +
-            (ec ? ". Error: " + ec.message() : "") + ")");
-        currentIndex++;
-        continue; // Skip this file
-      }
-
-      std::string originalFilename = currentPath.filename().string();
-      std::string originalStem = currentPath.stem().string();
-      std::string originalExtension = currentPath.extension().string();
-
-      // Generate new name using placeholders, find/replace, and case conversion
-      std::string parentDirName = currentPath.parent_path().filename().string();
-      std::string nameAfterPlaceholders = RenamerLogic::ReplacePlaceholders(
-          params.namingPattern, params.mode, currentIndex, totalFiles,
-          originalFilename, originalStem, originalExtension, std::nullopt,
-          std::nullopt, 0, parentDirName); // No numeric placeholders (<num>,
-                                           // <orig_num>) in manual mode
-      std::string nameAfterFindReplace = RenamerLogic::PerformFindReplace(
-          nameAfterPlaceholders, params.findText, params.replaceText,
-          params.findCaseSensitive, params.findUseRegex);
-      std::string finalNewFilename = RenamerLogic::ApplyCaseConversion(
-          nameAfterFindReplace, params.caseConversionMode);
-
-      if (finalNewFilename.empty()) {
-        results.errorLog.push_back(
-            "Error: Generated new filename is empty for '" + originalFilename +
-            "'. Skipped.");
-        results.missingSourceFilesLog.push_back(
-            originalFilename + " (Skipped: Generated name was empty)");
-        results.success = false;
-        currentIndex++;
-        continue;
-      }
-
-      fs::path newFullPath = currentPath.parent_path() / finalNewFilename;
-
-      // Check for redundant rename (case-insensitive)
-      if (RenamerLogic::iequals(currentPath.string(), newFullPath.string())) {
-        results.generalInfoLog.push_back(
-            "Skipping '" + originalFilename +
-            "' (New name is identical to old name, case-insensitively)");
-        currentIndex++;
-        continue;
+  std::set<fs::path> keptSources; // Skipped sources
+  // With a conflict suffix, names are only claimed once every skip is known:
+  // a later source may turn out to keep the name an earlier file wants.
+  // Claims are checked in memory, so little is lost by not overlapping them
+  std::vector<RenderedName> unclaimed;
+  RenderedName item;
+  while (rendered.pop(item)) {
+    const PlanCandidate &candidate = policy.candidates[item.index];
+    const fs::path &currentPath = candidate.path;
+    if (features.has(FeatureSubfolders) && !item.newFullPath.empty() &&
+        item.newFullPath.parent_path() != currentPath.parent_path()) {
+      newFolders.insert(item.newFullPath.parent_path());
+    }
+    if (item.failed) {
+      results.success = false;
+    }
+    if (item.skipped) {
+      ReportSkipped(item, currentPath, results.diagnostics);
+      keptSources.insert(currentPath);
+      if (freeNames) {
+        freeNames->keep(currentPath);
       }
+      continue;
+    }
+    if (freeNames) {
+      unclaimed.push_back(std::move(item));
+    } else {
+      addOperation(item);
+    }
+  }
+  for (RenderedName &pending : unclaimed) {
+    addOperation(pending);
+  }
+  FlagKeptTargets(tempPlan, std::move(keptSources), results.diagnostics);
+  renderThread.join();
+  if (fetchThread) {
+    fetchThread->join();
+  }
+  if (renderCache) {
+    renderCache->endPlan();
+  }
+  results.renamePlan = std::move(tempPlan);
+  if (!newFolders.empty()) {
+    // Missing intermediate folders are created too; each is counted once
+    std::set<fs::path> visited;
+    std::int64_t missing = 0;
+    for (const fs::path &target : newFolders) {
+      for (fs::path folder = target;
+           !folder.empty() && visited.insert(folder).second;
+           folder = folder.parent_path()) {
+        std::error_code folderEc;
+        if (fileSystem.isDirectory(folder, folderEc)) {
+          break;
+        }
+        ++missing;
+      }
+    }
+    results.diagnostics.addValue(DiagCode::FoldersToCreate, missing);
+  }
+}
 
-      // Check for target path conflicts within this batch (case-insensitive)
-      std::string newPathLower = ToLower(newFullPath.string());
-      bool hasBatchConflict = false;
-      std::string conflictReason;
-      if (!targetPathsLowercase.insert(newPathLower).second) {
-        hasBatchConflict = true;
-        conflictReason = "Target conflicts with another file in this batch";
-        results.warningLog.push_back(
-            "Conflict: Generated path '" + newFullPath.string() +
-            "' conflicts with another file in this batch.");
+// A naming pattern that only renumbers: literal text around a single <num>,
+// optionally followed by the original extension
+struct ShiftPattern {
+  std::string prefix;
+  std::string suffix;
+  bool appendExtension = false;
+};
+
+// Recognises the app's core case, shifting one folder's numbered sequence by
+// a non-zero increment with a pattern such as "File<num><ext>". Literal text
+// must need no sanitising, so names can be assembled directly
+std::optional<ShiftPattern> DetectShift(const InputParams &params,
+                                        unsigned features,
+                                        const DirectoryScanPolicy &policy) {
+  if (features != FeatureNumbers || params.increment == 0 ||
+      params.recursiveScan || params.renameDirectories ||
+      params.resequence != ResequenceOrder::None ||
+      !params.conflictSuffix.empty()) {
+    return std::nullopt;
+  }
+  std::string_view pattern = params.namingPattern;
+  ShiftPattern shift;
+  for (std::string_view ext : {"<ext>", "<orig_ext>"}) {
+    if (pattern.size() >= ext.size() &&
+        pattern.substr(pattern.size() - ext.size()) == ext) {
+      shift.appendExtension = true;
+      pattern.remove_suffix(ext.size());
+      break;
+    }
+  }
+  const std::size_t num = pattern.find("<num>");
+  if (num == std::string_view::npos) {
+    return std::nullopt;
+  }
+  shift.prefix = std::string(pattern.substr(0, num));
+  shift.suffix = std::string(pattern.substr(num + 5));
+  constexpr std::string_view unsafe = R"(\/:*?"<>|)";
+  for (const std::string *literal : {&shift.prefix, &shift.suffix}) {
+    for (unsigned char c : *literal) {
+      if (c <= 31 || unsafe.find(c) != std::string_view::npos) {
+        return std::nullopt;
       }
+    }
+  }
+  // A file without a number would need the general pipeline's handling
+  for (const PlanCandidate &candidate : policy.candidates) {
+    if (!candidate.number.has_value()) {
+      return std::nullopt;
+    }
+  }
+  return shift;
+}
 
-      // Check if target path already exists on disk AND is not one of the other
-      // *input* files in this manual list
+// Plans a shift without the general pipeline. Targets within the batch can
+// only collide when their new number and extension match, and a target that
+// is itself one of the sources is being vacated, so only targets past the
+// edge of the sequence are looked up on disk. Operations are emitted in
+// execution order (highest number first when shifting up), which
+// performRename then uses as is
+void BuildShiftPlan(const DirectoryScanPolicy &policy,
+                    const ShiftPattern &shift, const InputParams &params,
+                    FileSystem &fileSystem, OutputResults &results) {
+  const std::vector<PlanCandidate> &candidates = policy.candidates;
+  const bool descending = params.increment > 0;
+  std::vector<std::size_t> order(candidates.size());
+  std::iota(order.begin(), order.end(), std::size_t(0));
+  std::stable_sort(order.begin(), order.end(),
+                   [&](std::size_t a, std::size_t b) {
+                     const int numA = *candidates[a].number;
+                     const int numB = *candidates[b].number;
+                     return descending ? numA > numB : numA < numB;
+                   });
+
+  std::unordered_set<std::string> sourceNames;
+  sourceNames.reserve(candidates.size());
+  for (const PlanCandidate &candidate : candidates) {
+    sourceNames.insert(candidate.path.filename().string());
+  }
+  std::unordered_set<std::string> targetKeys; // New number + lowercase ext
+  targetKeys.reserve(candidates.size());
+
+  std::vector<RenameOperation> tempPlan;
+  tempPlan.reserve(candidates.size());
+  std::set<fs::path> keptSources; // Skipped sources
+  for (std::size_t i : order) {
+    const PlanCandidate &candidate = candidates[i];
+    const fs::path &currentPath = candidate.path;
+    const long long shifted =
+        (long long)candidate.number.value() + params.increment;
+    if (shifted < std::numeric_limits<int>::min() ||
+        shifted > std::numeric_limits<int>::max()) {
+      results.diagnostics.addPath(DiagCode::NumberOutOfRange, currentPath);
+      results.success = false;
+      keptSources.insert(currentPath);
+      continue;
+    }
+    const int newNumber = static_cast<int>(shifted);
+    std::string originalFilename = currentPath.filename().string();
+    const std::string extension =
+        shift.appendExtension ? currentPath.extension().string()
+                              : std::string();
+    std::string newName;
+    if (extension.find('<') == std::string::npos) {
+      newName = shift.prefix +
+                RenamerLogic::FormatNumber(newNumber, policy.numberWidth) +
+                shift.suffix + extension;
+    } else {
+      // An extension that looks like a placeholder is expanded again by
+      // ReplacePlaceholders; keep its result
+      newName = RenamerLogic::ReplacePlaceholders(
+          params.namingPattern, RenamingMode::DirectoryScan, 0, 0,
+          originalFilename, currentPath.stem().string(),
+          currentPath.extension().string(), candidate.number, newNumber,
+          policy.numberWidth);
+    }
+    if (RenamerLogic::iequals(originalFilename, newName)) {
+      results.diagnostics.add(DiagCode::IdenticalName, originalFilename);
+      keptSources.insert(currentPath);
+      continue;
+    }
+    fs::path newFullPath = currentPath.parent_path() / newName;
+
+    bool hasConflict = false;
+    std::string conflictReason;
+    if (!targetKeys.insert(std::to_string(newNumber) + '/' + ToLower(extension))
+             .second) {
+      hasConflict = true;
+      conflictReason = "Target conflicts with another file in this batch";
+      results.diagnostics.addForOp(DiagCode::BatchConflict, tempPlan.size());
+    }
+    if (sourceNames.count(newName) == 0) {
       std::error_code targetEc;
-      bool targetExists = fs::exists(newFullPath, targetEc);
+      const bool targetExists = fileSystem.exists(newFullPath, targetEc);
       if (targetEc) {
-        hasBatchConflict = true;
+        hasConflict = true;
         conflictReason =
             "Error checking if target exists: " + targetEc.message();
-        results.warningLog.push_back(
-            "Conflict: Filesystem error checking target path '" +
-            newFullPath.string() + "': " + targetEc.message());
-      } else if (targetExists && uniqueInputPaths.count(newFullPath) == 0) {
-        // Target exists and is NOT one of the other files in our manual list
-        hasBatchConflict = true;
+        results.diagnostics.addForOp(DiagCode::TargetCheckError,
+                                     tempPlan.size(), targetEc);
+      } else if (targetExists) {
+        hasConflict = true;
         conflictReason = "Target file already exists";
-        results.potentialOverwritesLog.push_back(
-            {originalFilename, finalNewFilename, newFullPath});
-        results.warningLog.push_back(
-            "Conflict: Target '" + newFullPath.string() + "' already exists.");
+        results.diagnostics.addForOp(DiagCode::PotentialOverwrite,
+                                     tempPlan.size());
+        results.diagnostics.addForOp(DiagCode::TargetExists, tempPlan.size());
       }
+    }
+
+    RenameOperation op;
+    op.OldName = std::move(originalFilename);
+    op.NewName = std::move(newName);
+    op.OldFullPath = currentPath;
+    op.NewFullPath = std::move(newFullPath);
+    op.Number = candidate.number;
+    op.Index = candidate.index;
+    op.hasConflict = hasConflict;
+    op.conflictReason = std::move(conflictReason);
+    tempPlan.push_back(std::move(op));
+  }
+  FlagKeptTargets(tempPlan, std::move(keptSources), results.diagnostics);
+  results.renamePlan = std::move(tempPlan);
+}
+
+// Picks the BuildPlan instantiation for 'features'. The common combinations
+// of numbering, find/replace and case conversion get a dedicated loop;
+// anything else (e.g. metadata placeholders, whose cost is dominated by I/O)
+// uses the runtime-checked fallback
+template <typename Policy>
+void DispatchPlan(const Policy &policy, unsigned features,
+                  const InputParams &params, FileSystem &fileSystem,
+                  OutputResults &results) {
+  features &= Policy::SupportedFeatures;
+  switch (features) {
+  case 0:
+    return BuildPlan(policy, StaticFeatures<0>{}, params, fileSystem, results);
+  case FeatureNumbers:
+    return BuildPlan(policy, StaticFeatures<FeatureNumbers>{}, params,
+                     fileSystem, results);
+  case FeatureFindReplace:
+    return BuildPlan(policy, StaticFeatures<FeatureFindReplace>{}, params,
+                     fileSystem, results);
+  case FeatureCaseConversion:
+    return BuildPlan(policy, StaticFeatures<FeatureCaseConversion>{}, params,
+                     fileSystem, results);
+  case FeatureNumbers | FeatureFindReplace:
+    return BuildPlan(policy,
+                     StaticFeatures<FeatureNumbers | FeatureFindReplace>{},
+                     params, fileSystem, results);
+  case FeatureNumbers | FeatureCaseConversion:
+    return BuildPlan(policy,
+                     StaticFeatures<FeatureNumbers | FeatureCaseConversion>{},
+                     params, fileSystem, results);
+  case FeatureFindReplace | FeatureCaseConversion:
+    return BuildPlan(
+        policy, StaticFeatures<FeatureFindReplace | FeatureCaseConversion>{},
+        params, fileSystem, results);
+  case FeatureNumbers | FeatureFindReplace | FeatureCaseConversion:
+    return BuildPlan(policy,
+                     StaticFeatures<FeatureNumbers | FeatureFindReplace |
+                                    FeatureCaseConversion>{},
+                     params, fileSystem, results);
+  default:
+    return BuildPlan(policy, DynamicFeatures{features}, params, fileSystem,
+                     results);
+  }
+}
+} // namespace
+
+// Calculates the rename plan based on input parameters, performing file
+// scanning and validation
+OutputResults RenamerLogic::calculateRenamePlan(const InputParams &params,
+                                                FileSystem &fileSystem) {
+  OutputResults results;
+  results.diagnostics.setCap(params.diagnosticsCap);
+  results.success =
+      true; // Assume success initially, set to false on fatal errors
+  bool dirScanFilesChecked =
+      false; // Tracks if any files were encountered during directory scan
+
+  // Basic validation: a naming pattern is always required
+  if (params.namingPattern.empty()) {
+    results.diagnostics.add(DiagCode::PatternEmpty);
+    results.success = false;
+    return results;
+  }
+
+  if (!FreeNameIndex::ValidSuffix(params.conflictSuffix)) {
+    results.diagnostics.add(DiagCode::ConflictSuffixInvalid,
+                            params.conflictSuffix);
+    results.success = false;
+    return results;
+  }
 
-      // Add to the plan (with conflict flag if applicable)
-      RenameOperation op;
-      op.OldName = originalFilename;
-      op.NewName = finalNewFilename;
-      op.OldFullPath = currentPath;
-      op.NewFullPath = newFullPath;
-      op.Number = std::nullopt;
-      op.Index = currentIndex;
-      op.hasConflict = hasBatchConflict;
-      op.conflictReason = conflictReason;
-      tempPlan.push_back(op);
-      currentIndex++;
+  // Decided once per plan instead of once per file
+  const unsigned features = DetectFeatures(params);
+
+  if (params.mode == RenamingMode::DirectoryScan) {
+    DirectoryScanPolicy policy;
+    // Ordering by number needs every file's number, whatever the pattern
+    bool collected = CollectDirectoryScan(
+        params,
+        (features & FeatureNumbers) != 0 ||
+            params.resequence == ResequenceOrder::CurrentNumber,
+        fileSystem, policy, results);
+    dirScanFilesChecked = policy.entriesChecked;
+    if (!collected) {
+      results.success = false;
+      return results;
+    }
+    if (features & FeatureNumbers) {
+      ReportSequences(policy, results);
     }
-    results.renamePlan = std::move(tempPlan);
+    if (params.resequence != ResequenceOrder::None) {
+      ResequenceCandidates(params, fileSystem, policy);
+    }
+    if (std::optional<ShiftPattern> shift =
+            DetectShift(params, features, policy)) {
+      BuildShiftPlan(policy, *shift, params, fileSystem, results);
+    } else {
+      DispatchPlan(policy, features, params, fileSystem, results);
+    }
+  } else { // ManualSelection Mode
+    ManualSelectionPolicy policy;
+    if (!CollectManualSelection(params, fileSystem, policy, results)) {
+      results.success = false;
+      return results;
+    }
+    DispatchPlan(policy, features, params, fileSystem, results);
+  }
+  if (params.dryRun) {
+    DryRunPlan(params, fileSystem, results);
   }
 
   // Final success state depends on no new errors being logged during this plan
   // generation It preserves any 'false' state from initial fatal errors
-  results.success = results.success && results.errorLog.empty();
+  results.success =
+      results.success && results.diagnostics.count(DiagCategory::Error) == 0;
 
   // Add a summary log message about the outcome of the planning phase
   if (results.renamePlan.empty()) {
-    bool issuesLogged = !results.missingSourceFilesLog.empty() ||
-                        !results.potentialOverwritesLog.empty() ||
-                        !results.warningLog.empty() ||
-                        !results.errorLog.empty();
+    bool issuesLogged = results.diagnostics.hasIssues();
     // If no files found in DirScan and no other issues, it's likely just an
     // empty matching set
     if (params.mode == RenamingMode::DirectoryScan && !issuesLogged &&
         !dirScanFilesChecked) // MODIFIED: Removed && foundFilesMap.empty()
     {
-      results.generalInfoLog.push_back(
-          "No files found in the target directory matching the specified "
-          "pattern/filters.");
+      results.diagnostics.add(DiagCode::NoFilesFound);
     }
     // If manual list was empty (should be caught earlier, but for completeness)
     else if (params.mode == RenamingMode::ManualSelection &&
              params.manualFiles.empty()) {
-      results.generalInfoLog.push_back(
-          "No files were added to the list to be renamed.");
+      results.diagnostics.add(DiagCode::NoFilesAdded);
     }
     // Otherwise, some files were found/added but none made it into the final
     // plan
     else {
-      results.generalInfoLog.push_back("No files eligible for renaming after "
-                                       "applying all filters and checks.");
+      results.diagnostics.add(DiagCode::NoEligibleFiles);
     }
   } else {
-    results.generalInfoLog.push_back("Calculated " +
-                                     std::to_string(results.renamePlan.size()) +
-                                     " file(s) to be renamed.");
+    results.diagnostics.addValue(
+        DiagCode::PlanCalculated,
+        static_cast<std::int64_t>(results.renamePlan.size()));
   }
   return results;
-}
\ No newline at end of file
+}
@@ -1,4 +1,6 @@
 #include "RenamerLogic.h"
+#include "CrossDeviceMove.h"
+#include "RenameSchedule.h"
 
 #include <wx/log.h> // For wxLogWarning, if needed for less critical warnings
 
@@ -6,13 +8,14 @@
 #include <string>
 #include <filesystem>
 #include <algorithm>	// For std::reverse
+#include <map>
 #include <system_error> // For std::error_code
 #include <stdexcept>	// For std::exception safety
 
 namespace fs = std::filesystem;
 
 // Attempts to undo a previous rename operation by reverting files to their original names
-UndoResult RenamerLogic::performUndo(std::vector<RenameOperation> opsToUndo) // Pass by value to allow modification (reversing)
+UndoResult RenamerLogic::performUndo(std::vector<RenameOperation> opsToUndo, FileSystem &fileSystem, const fs::path &moveJournal) // Pass by value to allow modification (reversing)
 {
 	UndoResult results;
 	results.overallSuccess = false; // Default to false; set to true only if all undo operations succeed
@@ -28,36 +31,63 @@ UndoResult RenamerLogic::performUndo(std::vector<RenameOperation> opsToUndo) //
 	// This helps to avoid conflicts if the original renames involved sequential numbering or dependencies
 	std::reverse(opsToUndo.begin(), opsToUndo.end());
 
+	// Files moved to another filesystem have to be copied back; this is done
+	// for all of them together once the plain renames are reverted
+	std::vector<CrossDeviceMove> crossDeviceMoves;
+	std::vector<const RenameOperation *> crossDeviceOps;
+
+	// A renamed cycle (a -> b -> c -> a) is a cycle again when reverted, so the
+	// undo is scheduled like the rename: by the inverted operations
+	std::vector<RenameOperation> invertedOps(opsToUndo);
+	for (auto &op : invertedOps)
+	{
+		std::swap(op.OldFullPath, op.NewFullPath);
+	}
+	std::map<std::size_t, fs::path> parkedPaths;
+
 	bool anyFailure = false;
-	for (const auto &op : opsToUndo)
+	for (const ScheduledRename &step : ScheduleRenames(invertedOps))
 	{
+		const RenameOperation &op = opsToUndo[step.op];
 		// For an undo operation:
 		// - The "current path" is the file's path *after* the rename (op.NewFullPath)
 		// - The "target path" for undo is the file's path *before* the rename (op.OldFullPath)
-		const fs::path &currentPath = op.NewFullPath;
-		const fs::path &originalPath = op.OldFullPath;
+		// A parked file goes to a temporary name first and on from there later
+		fs::path currentPath = op.NewFullPath;
+		fs::path originalPath = op.OldFullPath;
+		if (step.kind == ScheduledRename::Kind::Park)
+		{
+			originalPath = ParkingPath(currentPath, fileSystem);
+		}
+		else if (step.kind == ScheduledRename::Kind::Unpark)
+		{
+			auto parked = parkedPaths.find(step.op);
+			if (parked == parkedPaths.end())
+				continue; // Parking failed and was reported
+			currentPath = parked->second;
+		}
 
 		try
 		{
-			std::error_code existEc, targetExistEc, typeEc, renameEc;
+			std::error_code existEc, targetExistEc, renameEc;
 
-			// Verify that the current file (the one to be reverted) still exists and is a regular file
-			bool sourceExists = fs::exists(currentPath, existEc);
+			// Verify that the current file (the one to be reverted) still exists and is a regular file, or a folder for folder renames
+			FileKind currentKind = fileSystem.status(currentPath, existEc);
 			if (existEc)
 			{
 				results.failedUndos.push_back({op.NewName, "Skipped Undo: Filesystem error checking current file existence: " + existEc.message()});
 				anyFailure = true;
 				continue;
 			}
-			if (!sourceExists)
+			if (currentKind == FileKind::NotFound)
 			{
 				results.failedUndos.push_back({op.NewName, "Skipped Undo: Current file not found (" + currentPath.string() + "). Cannot revert."});
 				anyFailure = true;
 				continue;
 			}
-			if (!fs::is_regular_file(currentPath, typeEc) || typeEc)
+			if (currentKind != (op.isDirectory ? FileKind::Directory : FileKind::Regular))
 			{
-				results.failedUndos.push_back({op.NewName, "Skipped Undo: Current path is not a regular file (" + currentPath.string() + ")." + (typeEc ? " Error: " + typeEc.message() : "")});
+				results.failedUndos.push_back({op.NewName, (op.isDirectory ? "Skipped Undo: Current path is not a folder (" : "Skipped Undo: Current path is not a regular file (") + currentPath.string() + ")."});
 				anyFailure = true;
 				continue;
 			}
@@ -67,7 +97,7 @@ UndoResult RenamerLogic::performUndo(std::vector<RenameOperation> opsToUndo) //
 			// Identity renames (originalPath == currentPath) should not occur if the original rename plan was valid
 			if (originalPath != currentPath)
 			{
-				bool targetExists = fs::exists(originalPath, targetExistEc);
+				bool targetExists = fileSystem.exists(originalPath, targetExistEc);
 				if (targetExistEc)
 				{
 					results.failedUndos.push_back({op.NewName, "Skipped Undo: Filesystem error checking original path (" + originalPath.string() + "): " + targetExistEc.message()});
@@ -89,18 +119,28 @@ UndoResult RenamerLogic::performUndo(std::vector<RenameOperation> opsToUndo) //
 			}
 
 			// Perform the rename operation to revert the file (from NewFullPath back to OldFullPath)
-			fs::rename(currentPath, originalPath, renameEc);
+			fileSystem.rename(currentPath, originalPath, renameEc);
+			if (renameEc == std::errc::cross_device_link && !op.isDirectory)
+			{
+				crossDeviceMoves.push_back({currentPath, originalPath, {}});
+				crossDeviceOps.push_back(&op);
+				continue;
+			}
 
 			// Verify the outcome of the undo rename operation
 			if (!renameEc)
 			{
-				// fs::rename reported success; double-check by verifying file presence/absence
+				// The rename reported success; double-check by verifying file presence/absence
 				std::error_code verifyCurrentEc, verifyOriginalEc;
-				bool currentStillExists = fs::exists(currentPath, verifyCurrentEc);	 // Should be gone
-				bool originalNowExists = fs::exists(originalPath, verifyOriginalEc); // Should exist
+				bool currentStillExists = fileSystem.exists(currentPath, verifyCurrentEc);	 // Should be gone
+				bool originalNowExists = fileSystem.exists(originalPath, verifyOriginalEc); // Should exist
 
 				// Ideal outcome: no verification errors, current file is gone, original file exists
-				if (!verifyCurrentEc && !verifyOriginalEc && !currentStillExists && originalNowExists)
+				if (!verifyCurrentEc && !verifyOriginalEc && !currentStillExists && originalNowExists && step.kind == ScheduledRename::Kind::Park)
+				{
+					parkedPaths[step.op] = originalPath;
+				}
+				else if (!verifyCurrentEc && !verifyOriginalEc && !currentStillExists && originalNowExists)
 				{
 					results.successfulUndos.push_back({op.NewName, op.OldName}); // Record successful undo (NewName -> OldName)
 				}
@@ -122,7 +162,7 @@ UndoResult RenamerLogic::performUndo(std::vector<RenameOperation> opsToUndo) //
 			}
 			else
 			{
-				// fs::rename itself reported an error
+				// The rename itself reported an error
 				results.failedUndos.push_back({op.NewName, "Undo rename failed: " + renameEc.message()});
 				anyFailure = true;
 			}
@@ -153,6 +193,20 @@ UndoResult RenamerLogic::performUndo(std::vector<RenameOperation> opsToUndo) //
 		}
 	}
 
+	MoveAcrossDevices(crossDeviceMoves, fileSystem, moveJournal);
+	for (std::size_t i = 0; i < crossDeviceMoves.size(); ++i)
+	{
+		if (crossDeviceMoves[i].error.empty())
+		{
+			results.successfulUndos.push_back({crossDeviceOps[i]->NewName, crossDeviceOps[i]->OldName});
+		}
+		else
+		{
+			results.failedUndos.push_back({crossDeviceOps[i]->NewName, "Undo move from another drive failed: " + crossDeviceMoves[i].error});
+			anyFailure = true;
+		}
+	}
+
 	// The overall success of the undo operation is true only if the list of operations was not empty
 	// AND no failures occurred during any of the individual undo attempts
 	results.overallSuccess = !opsToUndo.empty() && !anyFailure;
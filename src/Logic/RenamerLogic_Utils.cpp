@@ -1,4 +1,7 @@
 #include "RenamerLogic.h"
+#include "ContentHash.h"
+#include "MediaDate.h"
+#include "RandomNames.h"
 
 #include <algorithm>
 #include <cctype>
@@ -11,7 +14,6 @@
 #include <iterator>
 #include <limits>
 #include <optional>
-#include <random>
 #include <regex>
 #include <sstream>
 #include <string>
@@ -71,27 +73,31 @@ std::string RenamerLogic::ConvertWildcardToRegex(const std::string &pattern) {
 
 // Extracts the last integer found in 'filename', useful for filtering or
 // sequence manipulation
-std::optional<int> RenamerLogic::ParseLastNumber(const std::string &filename) {
-  // Regex to capture the final numeric sequence
-  static const std::regex last_number_regex(R"(.*?(\d+)[^\d]*$)");
-  std::smatch match;
-  if (std::regex_match(filename, match, last_number_regex)) {
-    if (match.size() == 2) // Ensures the number group was captured
-    {
-      try {
-        // Use long long for intermediate conversion to detect overflow against
-        // int limits
-        long long num_ll = std::stoll(match[1].str());
-        if (num_ll >= std::numeric_limits<int>::min() &&
-            num_ll <= std::numeric_limits<int>::max()) {
-          return static_cast<int>(num_ll);
-        }
-      } catch (const std::exception &) {
-        // Handles stoll conversion errors (e.g., out_of_range)
-      }
+std::optional<int> RenamerLogic::ParseLastNumber(std::string_view filename) {
+  // Scan backwards for the final numeric sequence; no regex or allocation as
+  // this runs for every scanned file when number filtering is active
+  size_t end = filename.size();
+  while (end > 0 &&
+         !std::isdigit(static_cast<unsigned char>(filename[end - 1]))) {
+    --end;
+  }
+  if (end == 0) {
+    return std::nullopt; // No digits at all
+  }
+  size_t begin = end;
+  while (begin > 0 &&
+         std::isdigit(static_cast<unsigned char>(filename[begin - 1]))) {
+    --begin;
+  }
+  // Accumulate in long long and bail out as soon as the value leaves int range
+  long long num_ll = 0;
+  for (size_t i = begin; i < end; ++i) {
+    num_ll = num_ll * 10 + (filename[i] - '0');
+    if (num_ll > std::numeric_limits<int>::max()) {
+      return std::nullopt;
     }
   }
-  return std::nullopt;
+  return static_cast<int>(num_ll);
 }
 
 // Formats 'number' with leading zeros to match a specified 'width'
@@ -216,7 +222,8 @@ std::string RenamerLogic::ReplacePlaceholders(
     const std::string &originalNameStem, const std::string &originalExtension,
     const std::optional<int> &dirScanOriginalNum,
     const std::optional<int> &dirScanNewNum, int dirScanNumberWidth,
-    const std::string &parentDirName, const fs::path &fullFilePath) {
+    const std::string &parentDirName, const fs::path &fullFilePath,
+    FileSystem &fileSystem) {
   std::string result = pattern;
   size_t pos;
 
@@ -228,14 +235,24 @@ std::string RenamerLogic::ReplacePlaceholders(
   }
 
   // File-based placeholders (require valid file path)
-  if (!fullFilePath.empty() && fs::exists(fullFilePath)) {
-    std::error_code ec;
+  std::error_code ec;
+  if (!fullFilePath.empty() &&
+      fileSystem.status(fullFilePath, ec) != FileKind::NotFound && !ec) {
+    // Size is read at most once even if both size placeholders are used
+    std::optional<std::uintmax_t> fileSize;
+    auto getFileSize = [&]() {
+      if (!fileSize.has_value()) {
+        std::error_code sizeEc;
+        std::uintmax_t size = fileSystem.fileSize(fullFilePath, sizeEc);
+        fileSize = sizeEc ? 0 : size;
+      }
+      return fileSize.value();
+    };
 
     // <file_size> - file size in bytes
     pos = result.find("<file_size>");
     if (pos != std::string::npos) {
-      auto fileSize = fs::file_size(fullFilePath, ec);
-      std::string sizeStr = ec ? "0" : std::to_string(fileSize);
+      std::string sizeStr = std::to_string(getFileSize());
       while (pos != std::string::npos) {
         result.replace(pos, 11, sizeStr);
         pos = result.find("<file_size>", pos + sizeStr.length());
@@ -245,8 +262,7 @@ std::string RenamerLogic::ReplacePlaceholders(
     // <file_size_kb> - file size in KB
     pos = result.find("<file_size_kb>");
     if (pos != std::string::npos) {
-      auto fileSize = fs::file_size(fullFilePath, ec);
-      std::string sizeStr = ec ? "0" : std::to_string(fileSize / 1024);
+      std::string sizeStr = std::to_string(getFileSize() / 1024);
       while (pos != std::string::npos) {
         result.replace(pos, 14, sizeStr);
         pos = result.find("<file_size_kb>", pos + sizeStr.length());
@@ -256,48 +272,36 @@ std::string RenamerLogic::ReplacePlaceholders(
     // <modified_date> - file modification date (YYYYMMDD format)
     pos = result.find("<modified_date>");
     if (pos != std::string::npos) {
-      auto lastWrite = fs::last_write_time(fullFilePath, ec);
-      std::string dateStr = "00000000";
-      if (!ec) {
-        auto sctp =
-            std::chrono::time_point_cast<std::chrono::system_clock::duration>(
-                lastWrite - fs::file_time_type::clock::now() +
-                std::chrono::system_clock::now());
-        auto time_c = std::chrono::system_clock::to_time_t(sctp);
-        std::tm time_tm = {};
-#ifdef _WIN32
-        localtime_s(&time_tm, &time_c);
-#else
-        localtime_r(&time_c, &time_tm);
-#endif
-        std::ostringstream oss;
-        oss << std::put_time(&time_tm, "%Y%m%d");
-        dateStr = oss.str();
-      }
+      auto lastWrite = fileSystem.lastWriteTime(fullFilePath, ec);
+      std::string dateStr =
+          ec ? "00000000" : LocalDateOf(lastWrite).dateString();
       while (pos != std::string::npos) {
         result.replace(pos, 15, dateStr);
         pos = result.find("<modified_date>", pos + dateStr.length());
       }
     }
+
+    // <hash:N> - first N hex digits of the content hash. The planner expands
+    // it itself (hashing files in parallel), so this only runs for callers
+    // that use ReplacePlaceholders directly
+    if (ReferencesHash(result)) {
+      std::error_code hashEc;
+      std::uint64_t hash = HashFileContent(fileSystem, fullFilePath, hashEc);
+      result = ExpandHashPlaceholders(result, hashEc ? 0 : hash);
+    }
+
+    // <exif_date>/<exif_time> - capture date from the file's EXIF or MP4
+    // header, falling back to the modification time
+    if (ReferencesCaptureDate(result)) {
+      result = ExpandCaptureDatePlaceholders(
+          result, CaptureDateOrModified(fileSystem, fullFilePath));
+    }
   }
 
   // Replace <random:N> placeholder - generates N random alphanumeric characters
-  static const std::string alphanumChars =
-      "0123456789ABCDEFGHIJKLMNOPQRSTUVWXYZabcdefghijklmnopqrstuvwxyz";
-  static std::mt19937 rng(static_cast<unsigned int>(
-      std::chrono::system_clock::now().time_since_epoch().count()));
-  std::regex randomRegex(R"(<random:(\d+)>)");
-  std::smatch match;
-  while (std::regex_search(result, match, randomRegex)) {
-    int numChars = std::stoi(match[1].str());
-    numChars = std::min(numChars, 64); // Cap at 64 characters
-    std::string randomStr;
-    randomStr.reserve(numChars);
-    std::uniform_int_distribution<size_t> dist(0, alphanumChars.size() - 1);
-    for (int i = 0; i < numChars; ++i) {
-      randomStr += alphanumChars[dist(rng)];
-    }
-    result = match.prefix().str() + randomStr + match.suffix().str();
+  // from the calling thread's own generator
+  if (result.find("<random:") != std::string::npos) {
+    result = ExpandRandomPlaceholders(result, ThreadRandom());
   }
 
   // Efficiently check for and replace date/time placeholders if any are present
@@ -484,6 +488,15 @@ fs::path RenamerLogic::getHistoryLogPath() {
   return logDir / "rename_history.log";
 }
 
+// Gets the path to the metadata cache file next to the history log
+fs::path RenamerLogic::getMetadataCachePath() {
+  return getHistoryLogPath().parent_path() / "metadata.cache";
+}
+
+fs::path RenamerLogic::getMoveJournalPath() {
+  return getHistoryLogPath().parent_path() / "moves.journal";
+}
+
 // Writes rename operations to history log file with timestamp
 bool RenamerLogic::writeHistoryLog(
     const std::vector<RenameOperation> &operations,
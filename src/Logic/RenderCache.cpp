@@ -0,0 +1,41 @@
+#include "RenderCache.h"
+
+void RenderCache::beginPlan() {
+  ++m_generation;
+  m_hits.fill(0);
+}
+
+RenderCache::Entry &RenderCache::entry(const std::string &file) {
+  Entry &found = m_entries[file];
+  found.generation = m_generation;
+  return found;
+}
+
+void RenderCache::endPlan() {
+  for (auto it = m_entries.begin(); it != m_entries.end();) {
+    if (it->second.generation != m_generation) {
+      it = m_entries.erase(it);
+    } else {
+      ++it;
+    }
+  }
+}
+
+bool RenderCache::reuse(Entry &entry, Stage stage, std::uint64_t inputKey,
+                        std::string &output) {
+  const Slot &slot = entry.slots[stage];
+  if (!slot.matches(inputKey)) {
+    return false;
+  }
+  output = slot.output;
+  ++m_hits[stage];
+  return true;
+}
+
+void RenderCache::store(Entry &entry, Stage stage, std::uint64_t inputKey,
+                        const std::string &output) {
+  Slot &slot = entry.slots[stage];
+  slot.valid = true;
+  slot.key = inputKey;
+  slot.output = output;
+}
@@ -0,0 +1,88 @@
+#ifndef RENDERCACHE_H
+#define RENDERCACHE_H
+
+#include "ContentHash.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <string>
+#include <string_view>
+#include <type_traits>
+#include <unordered_map>
+
+// Hash of everything one render stage's output depends on
+class StageKey {
+public:
+  StageKey &add(std::string_view text) {
+    add(text.size()); // Keeps ("ab", "c") apart from ("a", "bc")
+    m_hasher.update(text);
+    return *this;
+  }
+  template <typename T,
+            typename = std::enable_if_t<std::is_arithmetic<T>::value ||
+                                        std::is_enum<T>::value>>
+  StageKey &add(T value) {
+    m_hasher.update(std::string_view(reinterpret_cast<const char *>(&value),
+                                     sizeof value));
+    return *this;
+  }
+  std::uint64_t digest() const { return m_hasher.digest(); }
+
+private:
+  ContentHasher m_hasher;
+};
+
+// Names rendered by earlier previews, kept stage by stage for each file, so
+// a preview that only edits a later stage's inputs (find/replace, case
+// conversion, rule chain) reruns just the stages from there on. Each stage's
+// output is stored with the StageKey of its inputs and reused only while the
+// key matches. Files the latest plan didn't render are dropped as it ends
+class RenderCache {
+public:
+  enum Stage { Placeholders, FindReplace, CaseConversion, RuleChain, Count };
+
+  struct Slot {
+    bool valid = false;
+    std::uint64_t key = 0;
+    std::string output;
+    std::string folders; // Placeholders only: the expanded subfolders
+
+    bool matches(std::uint64_t inputKey) const {
+      return valid && key == inputKey;
+    }
+  };
+  struct Entry {
+    std::array<Slot, Stage::Count> slots;
+    std::uint64_t generation = 0;
+  };
+
+  // A plan holds this for its whole run; entry() and the counters are only
+  // used under it
+  std::mutex &planMutex() { return m_planMutex; }
+
+  void beginPlan();
+  // The stages cached for 'file', which this plan keeps
+  Entry &entry(const std::string &file);
+  // Drops the files this plan didn't ask for
+  void endPlan();
+
+  // Reuses the output of 'stage' for 'inputKey', if cached; counts the hit
+  bool reuse(Entry &entry, Stage stage, std::uint64_t inputKey,
+             std::string &output);
+  void store(Entry &entry, Stage stage, std::uint64_t inputKey,
+             const std::string &output);
+
+  std::size_t size() const { return m_entries.size(); }
+  // Outputs reused from 'stage' since the last beginPlan()
+  std::size_t hits(Stage stage) const { return m_hits[stage]; }
+
+private:
+  std::mutex m_planMutex;
+  std::unordered_map<std::string, Entry> m_entries; // By full path
+  std::uint64_t m_generation = 0;
+  std::array<std::size_t, Stage::Count> m_hits{};
+};
+
+#endif // RENDERCACHE_H
@@ -0,0 +1,197 @@
+#include "ReplacementTable.h"
+
+#include <deque>
+#include <set>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+unsigned char FoldAscii(unsigned char c) {
+  return c >= 'A' && c <= 'Z' ? static_cast<unsigned char>(c - 'A' + 'a')
+                              : c;
+}
+
+std::string_view Trim(std::string_view s) {
+  const std::size_t begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  const std::size_t end = s.find_last_not_of(" \t\r");
+  return s.substr(begin, end - begin + 1);
+}
+
+// Trims 's' and removes one pair of surrounding double quotes
+std::string Unquote(std::string_view s) {
+  s = Trim(s);
+  if (s.size() >= 2 && s.front() == '"' && s.back() == '"') {
+    s = s.substr(1, s.size() - 2);
+  }
+  return std::string(s);
+}
+} // namespace
+
+MultiReplacer::MultiReplacer(const std::vector<ReplacementPair> &pairs,
+                             bool caseSensitive) {
+  auto fold = [caseSensitive](unsigned char c) {
+    return caseSensitive ? c : FoldAscii(c);
+  };
+  // Columns for the bytes the find texts use; a folded letter's other case
+  // shares its column
+  for (const ReplacementPair &pair : pairs) {
+    for (unsigned char c : pair.find) {
+      const unsigned char folded = fold(c);
+      if (m_columnOf[folded] == 0) {
+        m_columnOf[folded] = static_cast<std::uint16_t>(m_columns++);
+      }
+    }
+  }
+  if (!caseSensitive) {
+    for (int c = 'A'; c <= 'Z'; ++c) {
+      m_columnOf[c] = m_columnOf[FoldAscii(static_cast<unsigned char>(c))];
+    }
+  }
+
+  // Trie of the find texts; None marks a missing edge until the automaton
+  // is completed below
+  auto addState = [&](std::uint32_t depth) {
+    m_next.resize(m_next.size() + m_columns, None);
+    m_depth.push_back(depth);
+    m_match.push_back(None);
+    return static_cast<std::uint32_t>(m_depth.size() - 1);
+  };
+  addState(0);
+  for (const ReplacementPair &pair : pairs) {
+    if (pair.find.empty()) {
+      continue;
+    }
+    std::uint32_t state = 0;
+    for (unsigned char c : pair.find) {
+      const std::size_t edge = state * m_columns + m_columnOf[fold(c)];
+      if (m_next[edge] == None) {
+        const std::uint32_t child = addState(m_depth[state] + 1);
+        m_next[edge] = child;
+      }
+      state = m_next[edge];
+    }
+    if (m_match[state] == None) { // The first pair for a text wins
+      m_match[state] = static_cast<std::uint32_t>(m_lengths.size());
+      m_lengths.push_back(static_cast<std::uint32_t>(pair.find.size()));
+      m_replacements.push_back(pair.replace);
+    }
+  }
+
+  // Breadth-first, each state's missing edges take those of its longest
+  // proper suffix that is also in the trie, making every step one lookup.
+  // A state without a pair of its own ends the suffix's longest pair
+  std::vector<std::uint32_t> suffix(m_depth.size(), 0);
+  std::deque<std::uint32_t> pending;
+  for (std::size_t column = 0; column < m_columns; ++column) {
+    std::uint32_t &edge = m_next[column];
+    if (edge == None) {
+      edge = 0;
+    } else {
+      pending.push_back(edge);
+    }
+  }
+  while (!pending.empty()) {
+    const std::uint32_t state = pending.front();
+    pending.pop_front();
+    if (m_match[state] == None) {
+      m_match[state] = m_match[suffix[state]];
+    }
+    for (std::size_t column = 0; column < m_columns; ++column) {
+      std::uint32_t &edge = m_next[state * m_columns + column];
+      const std::uint32_t fallback = m_next[suffix[state] * m_columns + column];
+      if (edge == None) {
+        edge = fallback;
+      } else {
+        suffix[edge] = fallback;
+        pending.push_back(edge);
+      }
+    }
+  }
+}
+
+std::string MultiReplacer::apply(std::string_view name) const {
+  if (empty()) {
+    return std::string(name);
+  }
+  std::string result;
+  std::size_t copied = 0; // Text before this is already in 'result'
+  std::size_t position = 0;
+  while (position < name.size()) {
+    // Find the leftmost-longest match starting at or after 'position'
+    std::uint32_t state = 0;
+    std::size_t bestStart = std::string_view::npos;
+    std::uint32_t bestPair = None;
+    for (std::size_t i = position; i < name.size(); ++i) {
+      state = m_next[state * m_columns +
+                     m_columnOf[static_cast<unsigned char>(name[i])]];
+      const std::uint32_t pair = m_match[state];
+      if (pair != None) {
+        const std::size_t start = i + 1 - m_lengths[pair];
+        if (bestPair == None || start < bestStart ||
+            (start == bestStart && m_lengths[pair] > m_lengths[bestPair])) {
+          bestStart = start;
+          bestPair = pair;
+        }
+      }
+      // Once the text being matched starts after the best match, nothing
+      // longer or further left can still turn up
+      if (bestPair != None && i + 1 - m_depth[state] > bestStart) {
+        break;
+      }
+    }
+    if (bestPair == None) {
+      break;
+    }
+    result.append(name, copied, bestStart - copied);
+    result += m_replacements[bestPair];
+    copied = position = bestStart + m_lengths[bestPair];
+  }
+  if (copied == 0) {
+    return std::string(name);
+  }
+  result.append(name, copied, std::string_view::npos);
+  return result;
+}
+
+bool ParseReplacementTable(std::string_view text,
+                           std::vector<ReplacementPair> &pairs,
+                           std::string &error) {
+  pairs.clear();
+  error.clear();
+  std::set<std::string> seen;
+  int lineNumber = 0;
+  std::size_t start = 0;
+  while (start <= text.size()) {
+    std::size_t end = text.find('\n', start);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    const std::string_view line = Trim(text.substr(start, end - start));
+    start = end + 1;
+    ++lineNumber;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    const std::string where = "Line " + std::to_string(lineNumber) + ": ";
+
+    const std::size_t arrow = line.find("=>");
+    if (arrow == std::string_view::npos) {
+      error = where + "expected 'find => replace'.";
+      return false;
+    }
+    ReplacementPair pair{Unquote(line.substr(0, arrow)),
+                         Unquote(line.substr(arrow + 2))};
+    if (pair.find.empty()) {
+      error = where + "the text to find is empty.";
+      return false;
+    }
+    if (!seen.insert(pair.find).second) {
+      error = where + "'" + pair.find + "' is already in the table.";
+      return false;
+    }
+    pairs.push_back(std::move(pair));
+  }
+  return true;
+}
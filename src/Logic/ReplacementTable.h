@@ -0,0 +1,52 @@
+#ifndef REPLACEMENTTABLE_H
+#define REPLACEMENTTABLE_H
+
+#include "RenamerLogic.h"
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Replaces every pair's find text at once. The pairs are compiled into one
+// Aho-Corasick automaton, so a name is rewritten in a single left-to-right
+// pass however many pairs there are. Of overlapping matches the leftmost
+// wins, and of those starting at the same place the longest; replaced text
+// is not searched again. Without case sensitivity ASCII letters match
+// either case, like PerformFindReplace
+class MultiReplacer {
+public:
+  // Pairs with an empty find text are ignored; of pairs with the same find
+  // text, the first is used
+  MultiReplacer(const std::vector<ReplacementPair> &pairs, bool caseSensitive);
+
+  bool empty() const { return m_lengths.empty(); }
+  std::string apply(std::string_view name) const;
+
+private:
+  static constexpr std::uint32_t None = UINT32_MAX;
+
+  // Byte -> column of the transition table. Bytes no find text contains
+  // share column 0, which always leads back to the root
+  std::array<std::uint16_t, 256> m_columnOf{};
+  std::size_t m_columns = 1;
+  std::vector<std::uint32_t> m_next;  // state * m_columns + column -> state
+  std::vector<std::uint32_t> m_depth; // Length of the text a state spells
+  std::vector<std::uint32_t> m_match; // Longest pair ending here, or None
+  std::vector<std::uint32_t> m_lengths; // Find text length per pair
+  std::vector<std::string> m_replacements;
+};
+
+// Parses a replacement table written one pair per line as
+//   find => replace
+// Both sides are trimmed; put a side in double quotes to keep its spaces.
+// An empty replacement deletes the text. Blank lines and lines starting with
+// '#' are ignored. On failure, returns false with a message naming the
+// offending line in 'error'
+bool ParseReplacementTable(std::string_view text,
+                           std::vector<ReplacementPair> &pairs,
+                           std::string &error);
+
+#endif // REPLACEMENTTABLE_H
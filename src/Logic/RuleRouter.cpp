@@ -0,0 +1,211 @@
+#include "RuleRouter.h"
+
+#include <algorithm>
+#include <charconv>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+std::string_view Trim(std::string_view s) {
+  const std::size_t begin = s.find_first_not_of(" \t\r");
+  if (begin == std::string_view::npos) {
+    return {};
+  }
+  const std::size_t end = s.find_last_not_of(" \t\r");
+  return s.substr(begin, end - begin + 1);
+}
+
+// Parses a whole (optionally negative) integer
+bool ParseInt(std::string_view s, int &value) {
+  const char *end = s.data() + s.size();
+  auto [ptr, ec] = std::from_chars(s.data(), end, value);
+  return ec == std::errc() && ptr == end && !s.empty();
+}
+
+// "lo-hi"; the separator is the first '-' after the first character so a
+// negative lower bound still parses
+bool ParseRange(std::string_view s, int &lowest, int &highest) {
+  const std::size_t dash = s.find('-', 1);
+  return dash != std::string_view::npos &&
+         ParseInt(s.substr(0, dash), lowest) &&
+         ParseInt(s.substr(dash + 1), highest) && lowest <= highest;
+}
+
+std::vector<std::string> SplitExtensions(std::string_view list) {
+  std::vector<std::string> extensions;
+  std::size_t start = 0;
+  while (start <= list.size()) {
+    std::size_t end = list.find_first_of(",;", start);
+    if (end == std::string_view::npos) {
+      end = list.size();
+    }
+    std::string_view ext = Trim(list.substr(start, end - start));
+    if (!ext.empty()) {
+      extensions.emplace_back(ext);
+    }
+    start = end + 1;
+  }
+  return extensions;
+}
+} // namespace
+
+RuleRouter::RuleRouter(const std::vector<RoutedRule> &rules) {
+  const std::size_t count = std::min(rules.size(), MaxRules);
+  std::vector<std::string> allExtensions;
+  for (std::size_t i = 0; i < count; ++i) {
+    allExtensions.insert(allExtensions.end(), rules[i].extensions.begin(),
+                         rules[i].extensions.end());
+  }
+  m_extensions = ExtensionSet(allExtensions);
+  m_extensionMasks.assign(m_extensions.size(), 0);
+
+  m_rules.reserve(count);
+  for (std::size_t i = 0; i < count; ++i) {
+    const RoutedRule &rule = rules[i];
+    const std::uint64_t bit = std::uint64_t(1) << i;
+    bool listsExtension = false;
+    for (const std::string &ext : rule.extensions) {
+      if (ext.empty()) {
+        continue;
+      }
+      // Look the entry up the way ExtensionSet stored it
+      const std::string key = ext[0] == '.' ? ext : "." + ext;
+      const int id = m_extensions.indexOf(key);
+      if (id >= 0) {
+        m_extensionMasks[id] |= bit;
+        listsExtension = true;
+      }
+    }
+    if (!listsExtension) {
+      m_anyExtensionMask |= bit;
+    }
+
+    CompiledRule compiled;
+    for (const std::string &pattern : rule.filenamePatterns) {
+      compiled.patterns.emplace_back(pattern);
+    }
+    compiled.useNumberRange = rule.useNumberRange;
+    compiled.lowestNumber = rule.lowestNumber;
+    compiled.highestNumber = rule.highestNumber;
+    m_usesNumbers = m_usesNumbers || rule.useNumberRange;
+    m_rules.push_back(std::move(compiled));
+  }
+}
+
+int RuleRouter::route(std::string_view filename,
+                      const std::optional<int> &number) const {
+  if (m_rules.empty()) {
+    return -1;
+  }
+  std::uint64_t candidates = m_anyExtensionMask;
+  const int ext = m_extensions.indexOf(ExtensionOf(filename));
+  if (ext >= 0) {
+    candidates |= m_extensionMasks[ext];
+  }
+
+  std::optional<int> parsedNumber = number;
+  bool numberParsed = number.has_value();
+  // Lowest bit first keeps the rules' order of precedence
+  for (std::size_t i = 0; candidates != 0; ++i, candidates >>= 1) {
+    if ((candidates & 1) == 0) {
+      continue;
+    }
+    const CompiledRule &rule = m_rules[i];
+    if (!rule.patterns.empty() &&
+        std::none_of(rule.patterns.begin(), rule.patterns.end(),
+                     [filename](const WildcardPattern &pattern) {
+                       return pattern.matches(filename);
+                     })) {
+      continue;
+    }
+    if (rule.useNumberRange) {
+      if (!numberParsed) {
+        parsedNumber = RenamerLogic::ParseLastNumber(filename);
+        numberParsed = true;
+      }
+      if (!parsedNumber.has_value() ||
+          parsedNumber.value() < rule.lowestNumber ||
+          parsedNumber.value() > rule.highestNumber) {
+        continue;
+      }
+    }
+    return static_cast<int>(i);
+  }
+  return -1;
+}
+
+bool ParseRoutedRules(std::string_view text, std::vector<RoutedRule> &rules,
+                      std::string &error) {
+  rules.clear();
+  error.clear();
+  int lineNumber = 0;
+  std::size_t start = 0;
+  while (start <= text.size()) {
+    std::size_t end = text.find('\n', start);
+    if (end == std::string_view::npos) {
+      end = text.size();
+    }
+    const std::string_view line = Trim(text.substr(start, end - start));
+    start = end + 1;
+    ++lineNumber;
+    if (line.empty() || line[0] == '#') {
+      continue;
+    }
+    const std::string where = "Line " + std::to_string(lineNumber) + ": ";
+
+    const std::size_t arrow = line.find("=>");
+    if (arrow == std::string_view::npos) {
+      error = where + "expected '=> pattern'.";
+      return false;
+    }
+    RoutedRule rule;
+    rule.namingPattern = std::string(Trim(line.substr(arrow + 2)));
+    if (rule.namingPattern.empty()) {
+      error = where + "the naming pattern is empty.";
+      return false;
+    }
+
+    std::string_view predicates = line.substr(0, arrow);
+    while (!(predicates = Trim(predicates)).empty()) {
+      const std::size_t space = predicates.find_first_of(" \t");
+      const std::string_view token = predicates.substr(0, space);
+      predicates = space == std::string_view::npos
+                       ? std::string_view()
+                       : predicates.substr(space);
+      const std::size_t colon = token.find(':');
+      const std::string_view key = token.substr(0, colon);
+      const std::string_view value =
+          colon == std::string_view::npos ? std::string_view()
+                                          : token.substr(colon + 1);
+      if (value.empty()) {
+        error = where + "'" + std::string(token) +
+                "' is not of the form ext:, glob: or num:.";
+        return false;
+      }
+      if (key == "ext") {
+        for (std::string &ext : SplitExtensions(value)) {
+          rule.extensions.push_back(std::move(ext));
+        }
+      } else if (key == "glob") {
+        for (std::string &pattern : SplitPatternList(value)) {
+          rule.filenamePatterns.push_back(std::move(pattern));
+        }
+      } else if (key == "num") {
+        if (!ParseRange(value, rule.lowestNumber, rule.highestNumber)) {
+          error = where + "num: expects a range such as 1-100.";
+          return false;
+        }
+        rule.useNumberRange = true;
+      } else {
+        error = where + "unknown predicate '" + std::string(key) + "'.";
+        return false;
+      }
+    }
+    if (rules.size() == RuleRouter::MaxRules) {
+      error = where + "at most " + std::to_string(RuleRouter::MaxRules) +
+              " rules are supported.";
+      return false;
+    }
+    rules.push_back(std::move(rule));
+  }
+  return true;
+}
@@ -0,0 +1,57 @@
+#ifndef RULEROUTER_H
+#define RULEROUTER_H
+
+#include "RenamerLogic.h"
+#include "ScanFilter.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Selects, for each file name, the first RoutedRule whose predicates all
+// match. Every extension named by any rule sits in one perfect hash that
+// yields the bitmask of rules listing it, so a name is only tested against
+// the rules that can apply to its extension
+class RuleRouter {
+public:
+  // One bit per rule in the dispatch masks
+  static constexpr std::size_t MaxRules = 64;
+
+  // Rules past MaxRules are ignored
+  explicit RuleRouter(const std::vector<RoutedRule> &rules);
+
+  bool empty() const { return m_rules.empty(); }
+  // True if some rule filters on the file's number
+  bool usesNumbers() const { return m_usesNumbers; }
+
+  // Index of the rule for 'filename', or -1 if none applies. 'number' is the
+  // name's last number when the caller already parsed it
+  int route(std::string_view filename,
+            const std::optional<int> &number = std::nullopt) const;
+
+private:
+  struct CompiledRule {
+    std::vector<WildcardPattern> patterns; // Empty matches every name
+    bool useNumberRange = false;
+    int lowestNumber = 0;
+    int highestNumber = 0;
+  };
+
+  ExtensionSet m_extensions;
+  std::vector<std::uint64_t> m_extensionMasks; // Per extension id
+  std::uint64_t m_anyExtensionMask = 0; // Rules without an extension filter
+  std::vector<CompiledRule> m_rules;
+  bool m_usesNumbers = false;
+};
+
+// Parses routing rules written one per line as
+//   [ext:jpg,jpeg] [glob:IMG_*;DSC*] [num:1-100] => pattern
+// Blank lines and lines starting with '#' are ignored. On failure, returns
+// false with a message naming the offending line in 'error'
+bool ParseRoutedRules(std::string_view text, std::vector<RoutedRule> &rules,
+                      std::string &error);
+
+#endif // RULEROUTER_H
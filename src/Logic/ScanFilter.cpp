@@ -0,0 +1,448 @@
+#include "ScanFilter.h"
+#include "RenamerLogic.h"
+
+#include <algorithm>
+#include <cctype>
+
+namespace // Anonymous namespace for internal linkage helper functions
+{
+// Same folding ToLower and std::regex::icase apply to filenames
+inline char Fold(char c) {
+  return static_cast<char>(std::tolower(static_cast<unsigned char>(c)));
+}
+
+// Case-insensitive comparison of 'text' with an already lowercased 'lower'
+bool FoldedEquals(std::string_view text, std::string_view lower) {
+  if (text.size() != lower.size()) {
+    return false;
+  }
+  for (std::size_t i = 0; i < text.size(); ++i) {
+    if (Fold(text[i]) != lower[i]) {
+      return false;
+    }
+  }
+  return true;
+}
+
+// Relative per-evaluation cost of each stage, used until measurements exist
+double BaseCost(ScanFilterStage kind) {
+  switch (kind) {
+  case ScanFilterStage::Extension:
+    return 1.0;
+  case ScanFilterStage::Affix:
+    return 1.0;
+  case ScanFilterStage::NumberRange:
+    return 3.0;
+  case ScanFilterStage::Glob:
+  default:
+    return 4.0;
+  }
+}
+} // namespace
+
+std::string_view ExtensionOf(std::string_view filename) {
+  if (filename == "." || filename == "..") {
+    return {};
+  }
+  std::size_t dot = filename.rfind('.');
+  // A leading dot starts a hidden file's name, not an extension
+  if (dot == std::string_view::npos || dot == 0) {
+    return {};
+  }
+  return filename.substr(dot);
+}
+
+// FNV-1a over the folded bytes, seeded and finalised so a different seed
+// gives an unrelated slot layout
+std::uint32_t ExtensionSet::Hash(std::string_view s, std::uint32_t seed) {
+  std::uint32_t h = 2166136261u ^ (seed * 0x9E3779B9u);
+  for (char c : s) {
+    h ^= static_cast<unsigned char>(Fold(c));
+    h *= 16777619u;
+  }
+  h ^= h >> 15;
+  h *= 0x2C1B3C6Du;
+  h ^= h >> 12;
+  return h;
+}
+
+// Searches for a seed that places every entry in its own slot, doubling the
+// table whenever a size runs out of seeds. Extension lists are short, so
+// this settles within a few attempts
+ExtensionSet::ExtensionSet(const std::vector<std::string> &extensions) {
+  std::vector<std::string> keys;
+  keys.reserve(extensions.size());
+  for (const std::string &ext : extensions) {
+    if (ext.empty()) {
+      continue;
+    }
+    std::string key = ToLower(ext);
+    if (key[0] != '.') {
+      key.insert(key.begin(), '.');
+    }
+    keys.push_back(std::move(key));
+  }
+  std::sort(keys.begin(), keys.end());
+  keys.erase(std::unique(keys.begin(), keys.end()), keys.end());
+  if (keys.empty()) {
+    return;
+  }
+
+  m_count = keys.size();
+  for (const std::string &key : keys) {
+    m_maxLength = std::max(m_maxLength, key.size());
+  }
+
+  std::uint32_t tableSize = 4;
+  while (tableSize < keys.size() * 2) {
+    tableSize <<= 1;
+  }
+  for (;; tableSize <<= 1) {
+    for (std::uint32_t seed = 1; seed <= 64; ++seed) {
+      std::vector<std::string> slots(tableSize);
+      std::vector<int> slotIds(tableSize, -1);
+      bool collisionFree = true;
+      for (std::size_t id = 0; id < keys.size(); ++id) {
+        const std::uint32_t index = Hash(keys[id], seed) & (tableSize - 1);
+        if (!slots[index].empty()) {
+          collisionFree = false;
+          break;
+        }
+        slots[index] = keys[id];
+        slotIds[index] = static_cast<int>(id);
+      }
+      if (collisionFree) {
+        m_slots = std::move(slots);
+        m_slotIds = std::move(slotIds);
+        m_seed = seed;
+        m_mask = tableSize - 1;
+        return;
+      }
+    }
+  }
+}
+
+bool ExtensionSet::contains(std::string_view extension) const {
+  if (m_count == 0 || extension.empty() || extension.size() > m_maxLength) {
+    return false;
+  }
+  return FoldedEquals(extension, m_slots[Hash(extension, m_seed) & m_mask]);
+}
+
+int ExtensionSet::indexOf(std::string_view extension) const {
+  if (m_count == 0 || extension.empty() || extension.size() > m_maxLength) {
+    return -1;
+  }
+  const std::uint32_t index = Hash(extension, m_seed) & m_mask;
+  return FoldedEquals(extension, m_slots[index]) ? m_slotIds[index] : -1;
+}
+
+WildcardPattern::WildcardPattern(std::string_view pattern)
+    : m_pattern(ToLower(std::string(pattern))) {
+  if (m_pattern.empty()) {
+    m_pattern = "*"; // An empty pattern implies matching any string
+  }
+  const std::size_t firstWild = m_pattern.find_first_of("*?");
+  if (firstWild == std::string::npos) {
+    // Plain literal: the affix check is an exact comparison
+    m_prefix = m_pattern;
+    m_minLength = m_pattern.size();
+    m_affixesExact = true;
+    return;
+  }
+  const std::size_t lastWild = m_pattern.find_last_of("*?");
+  m_prefix = m_pattern.substr(0, firstWild);
+  m_suffix = m_pattern.substr(lastWild + 1);
+  m_minLength = m_pattern.size() -
+                std::count(m_pattern.begin(), m_pattern.end(), '*');
+
+  // With only '*' (or only '?') between the literal ends, prefix, suffix and
+  // length fully decide the match
+  const std::string_view middle = std::string_view(m_pattern).substr(
+      firstWild, lastWild + 1 - firstWild);
+  const bool onlyStars = middle.find_first_not_of('*') == std::string::npos;
+  const bool onlyQuestionMarks =
+      middle.find_first_not_of('?') == std::string::npos;
+  m_affixesExact = onlyStars || onlyQuestionMarks;
+  m_matchesEverything = onlyStars && m_prefix.empty() && m_suffix.empty();
+}
+
+bool WildcardPattern::matchesAffixes(std::string_view name) const {
+  const bool hasStar = m_pattern.find('*') != std::string::npos;
+  if (hasStar ? name.size() < m_minLength : name.size() != m_minLength) {
+    return false;
+  }
+  return FoldedEquals(name.substr(0, m_prefix.size()), m_prefix) &&
+         FoldedEquals(name.substr(name.size() - m_suffix.size()), m_suffix);
+}
+
+// Iterative glob match that backtracks only to the most recent '*', so it
+// runs in O(name * pattern) worst case without recursion
+bool WildcardPattern::matches(std::string_view name) const {
+  std::size_t p = 0;
+  std::size_t n = 0;
+  std::size_t starP = std::string::npos;
+  std::size_t starN = 0;
+  while (n < name.size()) {
+    if (p < m_pattern.size() &&
+        (m_pattern[p] == '?' ||
+         (m_pattern[p] != '*' && m_pattern[p] == Fold(name[n])))) {
+      ++p;
+      ++n;
+    } else if (p < m_pattern.size() && m_pattern[p] == '*') {
+      starP = p++;
+      starN = n;
+    } else if (starP != std::string::npos) {
+      p = starP + 1; // Let the last '*' absorb one more character
+      n = ++starN;
+    } else {
+      return false;
+    }
+  }
+  while (p < m_pattern.size() && m_pattern[p] == '*') {
+    ++p;
+  }
+  return p == m_pattern.size();
+}
+
+// Lays the pattern out as consecutive state bits: bit 0 is "nothing matched
+// yet" and bit k is "k literal/'?' positions matched". A '*' becomes a
+// self-loop on the state before it, so runs of stars collapse to one loop
+void GlobSet::add(std::string_view pattern, unsigned group) {
+  if (group >= MaxGroups) {
+    return;
+  }
+  ++m_count;
+  const std::string lowered =
+      pattern.empty() ? std::string("*") : ToLower(std::string(pattern));
+  const unsigned positions = static_cast<unsigned>(
+      lowered.size() - std::count(lowered.begin(), lowered.end(), '*'));
+  const unsigned bitsNeeded = positions + 1;
+  if (bitsNeeded > 64) {
+    m_oversized.emplace_back(WildcardPattern(lowered), group);
+    return;
+  }
+  if (m_words.empty() || m_words.back().used + bitsNeeded > 64) {
+    m_words.emplace_back();
+  }
+  Word &word = m_words.back();
+  const unsigned offset = word.used;
+  word.used += bitsNeeded;
+  auto bit = [offset](unsigned k) { return std::uint64_t(1) << (offset + k); };
+
+  word.start |= bit(0);
+  unsigned k = 0;
+  for (char ch : lowered) {
+    if (ch == '*') {
+      word.loop |= bit(k);
+      continue;
+    }
+    ++k;
+    for (unsigned b = 0; b < 256; ++b) {
+      if (ch == '?' || Fold(static_cast<char>(b)) == ch) {
+        word.accept[b] |= bit(k);
+      }
+    }
+  }
+  word.final[group] |= bit(k);
+}
+
+unsigned GlobSet::matchGroups(std::string_view name) const {
+  unsigned groups = 0;
+  for (const Word &word : m_words) {
+    std::uint64_t state = word.start;
+    for (char c : name) {
+      // Advance every pattern by one position, keep states under a '*'.
+      // Bits shifted into the next pattern's start state are never in
+      // 'accept', so patterns sharing a word can't leak into each other
+      state = ((state << 1) & word.accept[static_cast<unsigned char>(c)]) |
+              (state & word.loop);
+      if (state == 0) {
+        break;
+      }
+    }
+    for (unsigned g = 0; g < MaxGroups && state != 0; ++g) {
+      if (state & word.final[g]) {
+        groups |= 1u << g;
+      }
+    }
+  }
+  for (const auto &entry : m_oversized) {
+    if (!(groups & (1u << entry.second)) && entry.first.matches(name)) {
+      groups |= 1u << entry.second;
+    }
+  }
+  return groups;
+}
+
+std::vector<std::string> SplitPatternList(std::string_view list) {
+  std::vector<std::string> patterns;
+  std::size_t begin = 0;
+  while (begin <= list.size()) {
+    std::size_t end = list.find(';', begin);
+    if (end == std::string_view::npos) {
+      end = list.size();
+    }
+    std::string_view item = list.substr(begin, end - begin);
+    while (!item.empty() && std::isspace(static_cast<unsigned char>(item[0]))) {
+      item.remove_prefix(1);
+    }
+    while (!item.empty() &&
+           std::isspace(static_cast<unsigned char>(item.back()))) {
+      item.remove_suffix(1);
+    }
+    if (!item.empty()) {
+      patterns.emplace_back(item);
+    }
+    begin = end + 1;
+  }
+  return patterns;
+}
+
+ScanFilter::ScanFilter(const ScanFilterOptions &options)
+    : m_extensions(options.extensions),
+      m_pattern(options.includePatterns.size() == 1
+                    ? std::string_view(options.includePatterns[0])
+                    : std::string_view("*")),
+      m_options(options) {
+  // A single include pattern keeps the cheap affix pre-check; several
+  // patterns, or any exclude, are matched together by the glob set
+  m_useGlobSet = options.includePatterns.size() > 1 ||
+                 !options.excludePatterns.empty();
+  if (m_useGlobSet) {
+    if (options.includePatterns.empty()) {
+      m_globs.add("*", IncludeGroup);
+    }
+    for (const std::string &pattern : options.includePatterns) {
+      m_globs.add(pattern, IncludeGroup);
+    }
+    for (const std::string &pattern : options.excludePatterns) {
+      m_globs.add(pattern, ExcludeGroup);
+    }
+  }
+
+  // Only stages that can reject something are part of the pipeline, starting
+  // in order of base cost
+  if (!m_extensions.empty()) {
+    m_stages.push_back({ScanFilterStage::Extension,
+                        BaseCost(ScanFilterStage::Extension)});
+  }
+  if (m_useGlobSet) {
+    m_stages.push_back(
+        {ScanFilterStage::Glob, BaseCost(ScanFilterStage::Glob)});
+  } else if (!m_pattern.matchesEverything()) {
+    m_stages.push_back(
+        {ScanFilterStage::Affix, BaseCost(ScanFilterStage::Affix)});
+    if (!m_pattern.affixesAreExact()) {
+      m_stages.push_back(
+          {ScanFilterStage::Glob, BaseCost(ScanFilterStage::Glob)});
+    }
+  }
+  if (options.useNumberRange) {
+    m_stages.push_back({ScanFilterStage::NumberRange,
+                        BaseCost(ScanFilterStage::NumberRange)});
+  }
+  std::stable_sort(
+      m_stages.begin(), m_stages.end(),
+      [](const Stage &a, const Stage &b) { return a.cost < b.cost; });
+}
+
+bool ScanFilter::passes(ScanFilterStage kind, std::string_view name,
+                        std::optional<int> &number, bool &numberParsed) const {
+  switch (kind) {
+  case ScanFilterStage::Extension:
+    return m_extensions.contains(ExtensionOf(name));
+  case ScanFilterStage::Affix:
+    return m_pattern.matchesAffixes(name);
+  case ScanFilterStage::Glob:
+    if (m_useGlobSet) {
+      const unsigned groups = m_globs.matchGroups(name);
+      return (groups & (1u << IncludeGroup)) &&
+             !(groups & (1u << ExcludeGroup));
+    }
+    return m_pattern.matches(name);
+  case ScanFilterStage::NumberRange:
+    number = RenamerLogic::ParseLastNumber(name);
+    numberParsed = true;
+    return number.has_value() && number.value() >= m_options.lowestNumber &&
+           number.value() <= m_options.highestNumber;
+  default:
+    return true;
+  }
+}
+
+bool ScanFilter::accept(std::string_view name, std::optional<int> &number) {
+  number.reset();
+  bool numberParsed = false;
+  bool accepted = true;
+  for (Stage &stage : m_stages) {
+    ++stage.evaluated;
+    if (!passes(stage.kind, name, number, numberParsed)) {
+      ++stage.rejected;
+      ++m_rejectedTotals[static_cast<std::size_t>(stage.kind)];
+      accepted = false;
+      break;
+    }
+  }
+  if (++m_sinceReorder >= ReorderInterval) {
+    reorder();
+  }
+  if (accepted && m_options.needsNumber && !numberParsed) {
+    number = RenamerLogic::ParseLastNumber(name);
+  }
+  return accepted;
+}
+
+// Orders stages by expected cost per rejection (cost / rejection rate), so a
+// cheap check that rarely rejects doesn't sit in front of one that filters
+// out most of the tree. Counts are halved afterwards so the order keeps
+// tracking the directories currently being scanned
+void ScanFilter::reorder() {
+  m_sinceReorder = 0;
+  auto rank = [](const Stage &stage) {
+    // Smoothed so unmeasured stages keep a finite rank
+    const double rejectRate = (stage.rejected + 1.0) / (stage.evaluated + 2.0);
+    return stage.cost / rejectRate;
+  };
+  std::stable_sort(
+      m_stages.begin(), m_stages.end(),
+      [&](const Stage &a, const Stage &b) { return rank(a) < rank(b); });
+  for (Stage &stage : m_stages) {
+    stage.evaluated /= 2;
+    stage.rejected /= 2;
+  }
+}
+
+std::vector<ScanFilterStage> ScanFilter::stageOrder() const {
+  std::vector<ScanFilterStage> order;
+  order.reserve(m_stages.size());
+  for (const Stage &stage : m_stages) {
+    order.push_back(stage.kind);
+  }
+  return order;
+}
+
+std::uint64_t ScanFilter::rejectedBy(ScanFilterStage stage) const {
+  return m_rejectedTotals[static_cast<std::size_t>(stage)];
+}
+
+DirectoryFilter::DirectoryFilter(const DirectoryFilterOptions &options)
+    : m_options(options) {
+  for (const std::string &pattern : options.excludePatterns) {
+    m_excludes.add(pattern);
+  }
+}
+
+bool DirectoryFilter::excludes(std::string_view name) const {
+  return (m_options.skipHidden && !name.empty() && name[0] == '.') ||
+         (!m_excludes.empty() && m_excludes.matchGroups(name) != 0);
+}
+
+bool DirectoryFilter::shouldDescend(std::string_view name, int depth) {
+  const bool pruned =
+      (m_options.maxDepth > 0 && depth > m_options.maxDepth) || excludes(name);
+  if (pruned) {
+    ++m_pruned;
+  }
+  return !pruned;
+}
@@ -0,0 +1,183 @@
+#ifndef SCANFILTER_H
+#define SCANFILTER_H
+
+#include <array>
+#include <cstddef>
+#include <cstdint>
+#include <optional>
+#include <string>
+#include <string_view>
+#include <vector>
+
+// Case-insensitive set of file extensions (".jpg") stored in a small perfect
+// hash table: a lookup is one hash, one probe and no allocation
+class ExtensionSet {
+public:
+  ExtensionSet() = default;
+  // Entries are lowercased; a missing leading dot is added
+  explicit ExtensionSet(const std::vector<std::string> &extensions);
+
+  bool empty() const { return m_count == 0; }
+  std::size_t size() const { return m_count; }
+  bool contains(std::string_view extension) const;
+  // Dense id (0 to size() - 1) of 'extension', or -1 if it isn't in the set.
+  // Ids follow the sorted order of the lowercased entries
+  int indexOf(std::string_view extension) const;
+
+private:
+  static std::uint32_t Hash(std::string_view s, std::uint32_t seed);
+
+  std::vector<std::string> m_slots; // Lowercased entries, empty if unused
+  std::vector<int> m_slotIds;       // Dense id of each used slot
+  std::uint32_t m_seed = 0;
+  std::uint32_t m_mask = 0;
+  std::size_t m_count = 0;
+  std::size_t m_maxLength = 0;
+};
+
+// Case-insensitive filename wildcard ('*' matches any run, '?' any single
+// character). Equivalent to ConvertWildcardToRegex + std::regex::icase but
+// without the regex engine
+class WildcardPattern {
+public:
+  explicit WildcardPattern(std::string_view pattern = "*");
+
+  // Full match of 'name' against the pattern
+  bool matches(std::string_view name) const;
+  // Cheap pre-check: the literal text before the first and after the last
+  // wildcard, plus the minimum length the pattern requires
+  bool matchesAffixes(std::string_view name) const;
+  // True if matchesAffixes() alone decides matches()
+  bool affixesAreExact() const { return m_affixesExact; }
+  bool matchesEverything() const { return m_matchesEverything; }
+
+private:
+  std::string m_pattern; // Lowercased
+  std::string m_prefix;
+  std::string m_suffix;
+  std::size_t m_minLength = 0;
+  bool m_affixesExact = false;
+  bool m_matchesEverything = false;
+};
+
+// Any number of case-insensitive wildcard patterns, each tagged with a group,
+// run together as one bit-parallel (shift-and) automaton: every pattern is a
+// run of state bits in a 64-bit word, so a name is matched against all of
+// them in a single pass of a shift, an AND and an OR per character. Patterns
+// too long for a word fall back to WildcardPattern
+class GlobSet {
+public:
+  static constexpr unsigned MaxGroups = 8;
+
+  void add(std::string_view pattern, unsigned group = 0);
+  bool empty() const { return m_count == 0; }
+  std::size_t size() const { return m_count; }
+  // Bit 'g' is set if any pattern of group 'g' matches the whole name
+  unsigned matchGroups(std::string_view name) const;
+
+private:
+  struct Word {
+    std::array<std::uint64_t, 256> accept{};      // States entered per byte
+    std::uint64_t start = 0;                      // First state of patterns
+    std::uint64_t loop = 0;                       // States followed by '*'
+    std::array<std::uint64_t, MaxGroups> final{}; // Accepting states
+    unsigned used = 0;                            // Bits taken
+  };
+
+  std::vector<Word> m_words;
+  std::vector<std::pair<WildcardPattern, unsigned>> m_oversized;
+  std::size_t m_count = 0;
+};
+
+// Splits a ';'-separated pattern list, trimming spaces and dropping empties
+std::vector<std::string> SplitPatternList(std::string_view list);
+
+// Filters a directory scan applies to each regular file name
+struct ScanFilterOptions {
+  std::vector<std::string> includePatterns; // Empty matches every name
+  std::vector<std::string> excludePatterns;
+  std::vector<std::string> extensions; // Empty for no extension filter
+  bool useNumberRange = false;
+  int lowestNumber = 0;
+  int highestNumber = 0;
+  bool needsNumber = false; // Parse the number for placeholders
+};
+
+enum class ScanFilterStage { Extension, Affix, Glob, NumberRange, Count };
+
+// Short-circuiting filter pipeline for directory scans. Stages that can't
+// reject anything are dropped up front; the rest start in order of cost and
+// are periodically reordered by measured cost per rejection so the most
+// selective cheap check runs first. Not thread-safe
+class ScanFilter {
+public:
+  // Entries between two reorderings
+  static constexpr std::uint64_t ReorderInterval = 1024;
+
+  explicit ScanFilter(const ScanFilterOptions &options);
+
+  // Returns true if 'name' passes every stage. 'number' receives the parsed
+  // last number when the number range or placeholders need it
+  bool accept(std::string_view name, std::optional<int> &number);
+
+  // Current evaluation order of the active stages
+  std::vector<ScanFilterStage> stageOrder() const;
+  std::uint64_t rejectedBy(ScanFilterStage stage) const;
+
+private:
+  struct Stage {
+    ScanFilterStage kind;
+    double cost; // Relative cost of one evaluation
+    std::uint64_t evaluated = 0;
+    std::uint64_t rejected = 0;
+  };
+
+  bool passes(ScanFilterStage kind, std::string_view name,
+              std::optional<int> &number, bool &numberParsed) const;
+  void reorder();
+
+  enum GlobGroup : unsigned { IncludeGroup = 0, ExcludeGroup = 1 };
+
+  ExtensionSet m_extensions;
+  WildcardPattern m_pattern; // The include pattern, when it is the only glob
+  GlobSet m_globs;           // Every include and exclude pattern otherwise
+  bool m_useGlobSet = false;
+  ScanFilterOptions m_options;
+  std::vector<Stage> m_stages;
+  std::array<std::uint64_t, static_cast<std::size_t>(ScanFilterStage::Count)>
+      m_rejectedTotals{};
+  std::uint64_t m_sinceReorder = 0;
+};
+
+// Decides which subdirectories a recursive scan descends into, so excluded
+// trees (.git, node_modules, thumbnail caches) are never listed at all
+struct DirectoryFilterOptions {
+  std::vector<std::string> excludePatterns; // Matched against the folder name
+  bool skipHidden = false;                  // Names starting with '.'
+  int maxDepth = 0;                         // 0 for unlimited
+};
+
+class DirectoryFilter {
+public:
+  explicit DirectoryFilter(const DirectoryFilterOptions &options);
+
+  // 'depth' is the level the directory sits at below the scan root (1 for
+  // the root's own children)
+  bool shouldDescend(std::string_view name, int depth);
+  // True if 'name' is hidden and hidden folders are skipped, or matches an
+  // exclude pattern. Not counted as pruned
+  bool excludes(std::string_view name) const;
+  // Number of directories rejected so far
+  std::uint64_t prunedCount() const { return m_pruned; }
+
+private:
+  GlobSet m_excludes;
+  DirectoryFilterOptions m_options;
+  std::uint64_t m_pruned = 0;
+};
+
+// Extension of 'filename' as fs::path::extension() would return it, without
+// constructing a path
+std::string_view ExtensionOf(std::string_view filename);
+
+#endif // SCANFILTER_H
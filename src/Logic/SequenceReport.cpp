@@ -0,0 +1,151 @@
+#include "SequenceReport.h"
+
+#include <algorithm>
+#include <limits>
+#include <string_view>
+
+bool NumberSet::insert(std::uint32_t value) {
+  Container &container = m_containers[static_cast<std::uint16_t>(value >> 16)];
+  const std::uint16_t low = static_cast<std::uint16_t>(value);
+  if (!container.bits.empty()) {
+    std::uint64_t &word = container.bits[low >> 6];
+    const std::uint64_t mask = std::uint64_t(1) << (low & 63);
+    if (word & mask) {
+      return false;
+    }
+    word |= mask;
+    ++m_size;
+    return true;
+  }
+
+  // Names are mostly added in order, so check the end before searching
+  std::vector<std::uint16_t> &array = container.array;
+  auto pos = array.end();
+  if (!array.empty() && array.back() >= low) {
+    pos = std::lower_bound(array.begin(), array.end(), low);
+    if (*pos == low) {
+      return false;
+    }
+  }
+  array.insert(pos, low);
+  ++m_size;
+  if (array.size() > ArrayLimit) {
+    container.bits.assign(1024, 0);
+    for (std::uint16_t member : array) {
+      container.bits[member >> 6] |= std::uint64_t(1) << (member & 63);
+    }
+    std::vector<std::uint16_t>().swap(array);
+  }
+  return true;
+}
+
+bool NumberSet::contains(std::uint32_t value) const {
+  auto found = m_containers.find(static_cast<std::uint16_t>(value >> 16));
+  if (found == m_containers.end()) {
+    return false;
+  }
+  const Container &container = found->second;
+  const std::uint16_t low = static_cast<std::uint16_t>(value);
+  if (!container.bits.empty()) {
+    return (container.bits[low >> 6] >> (low & 63)) & 1;
+  }
+  return std::binary_search(container.array.begin(), container.array.end(),
+                            low);
+}
+
+std::uint32_t NumberSet::LowestBit(std::uint64_t bits) {
+  std::uint32_t index = 0;
+  while ((bits & 0xFFFF) == 0) {
+    bits >>= 16;
+    index += 16;
+  }
+  while ((bits & 1) == 0) {
+    bits >>= 1;
+    ++index;
+  }
+  return index;
+}
+
+void SequenceAnalyzer::add(const fs::path &file) {
+  // The same digit run RenamerLogic::ParseLastNumber reads: the last one in
+  // the whole name
+  const std::string name = file.filename().string();
+  std::size_t end = name.size();
+  while (end > 0 && (name[end - 1] < '0' || name[end - 1] > '9')) {
+    --end;
+  }
+  if (end == 0) {
+    return;
+  }
+  std::size_t begin = end;
+  while (begin > 0 && name[begin - 1] >= '0' && name[begin - 1] <= '9') {
+    --begin;
+  }
+  std::uint64_t value = 0;
+  for (std::size_t i = begin; i < end; ++i) {
+    value = value * 10 + static_cast<std::uint64_t>(name[i] - '0');
+    if (value > static_cast<std::uint64_t>(std::numeric_limits<int>::max())) {
+      return; // Not a number ParseLastNumber accepts
+    }
+  }
+
+  std::string pattern = name.substr(0, begin);
+  pattern += "<#>";
+  pattern.append(name, end, std::string::npos);
+  Family &family = m_families[{file.parent_path(), std::move(pattern)}];
+  ++family.members;
+  if (!family.numbers.insert(static_cast<std::uint32_t>(value))) {
+    family.duplicates.insert(static_cast<std::uint32_t>(value));
+  }
+  const std::size_t width = end - begin;
+  ++family.widths[width];
+  if (name[begin] == '0' && width > 1) {
+    family.narrowestPadded = std::min(family.narrowestPadded, width);
+    family.widestPadded = std::max(family.widestPadded, width);
+  } else {
+    family.shortestUnpadded = std::min(family.shortestUnpadded, width);
+  }
+}
+
+std::vector<SequenceFamily> SequenceAnalyzer::report() const {
+  std::vector<SequenceFamily> families;
+  families.reserve(m_families.size());
+  for (const auto &entry : m_families) {
+    const Family &family = entry.second;
+    SequenceFamily &out = families.emplace_back();
+    out.folder = entry.first.first;
+    out.pattern = entry.first.second;
+    out.members = family.members;
+    out.widths = family.widths;
+    // Padded to two widths, or padded while a shorter number is not
+    out.mixedPadding =
+        family.widestPadded > 0 &&
+        (family.narrowestPadded != family.widestPadded ||
+         family.shortestUnpadded < family.widestPadded);
+
+    bool first = true;
+    std::uint32_t previous = 0;
+    family.numbers.forEachRun([&](std::uint32_t low, std::uint32_t high) {
+      if (first) {
+        out.lowest = low;
+        first = false;
+      } else {
+        out.missing += low - previous - 1;
+        if (out.gaps.size() < MaxListed) {
+          out.gaps.emplace_back(previous + 1, low - 1);
+        }
+      }
+      previous = high;
+    });
+    out.highest = previous;
+
+    out.duplicated = family.duplicates.size();
+    family.duplicates.forEachRun([&](std::uint32_t low, std::uint32_t high) {
+      for (std::uint64_t n = low;
+           n <= high && out.duplicates.size() < MaxListed; ++n) {
+        out.duplicates.push_back(static_cast<std::uint32_t>(n));
+      }
+    });
+  }
+  return families;
+}
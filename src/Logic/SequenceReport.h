@@ -0,0 +1,120 @@
+#ifndef SEQUENCEREPORT_H
+#define SEQUENCEREPORT_H
+
+#include <cstddef>
+#include <cstdint>
+#include <filesystem>
+#include <map>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+// Set of 32-bit numbers stored like a roaring bitmap: numbers are grouped by
+// their high 16 bits, and each group holds its low halves either as a sorted
+// array (up to 4096 of them) or as a 65536-bit bitmap. Memory follows the
+// number of members, not the range they span
+class NumberSet {
+public:
+  // Adds 'value'; returns false if it was already present
+  bool insert(std::uint32_t value);
+  bool contains(std::uint32_t value) const;
+  std::uint64_t size() const { return m_size; }
+  bool empty() const { return m_size == 0; }
+
+  // Calls fn(first, last) for each run of consecutive members, in order
+  template <typename Fn> void forEachRun(Fn &&fn) const {
+    bool open = false;
+    std::uint32_t first = 0, last = 0;
+    auto visit = [&](std::uint32_t value) {
+      if (open && value == last + 1) {
+        last = value;
+        return;
+      }
+      if (open) {
+        fn(first, last);
+      }
+      open = true;
+      first = last = value;
+    };
+    for (const auto &entry : m_containers) {
+      const std::uint32_t high = std::uint32_t(entry.first) << 16;
+      const Container &container = entry.second;
+      if (container.bits.empty()) {
+        for (std::uint16_t low : container.array) {
+          visit(high | low);
+        }
+        continue;
+      }
+      for (std::uint32_t word = 0; word < container.bits.size(); ++word) {
+        for (std::uint64_t bits = container.bits[word]; bits != 0;
+             bits &= bits - 1) {
+          visit(high | (word << 6) | LowestBit(bits));
+        }
+      }
+    }
+    if (open) {
+      fn(first, last);
+    }
+  }
+
+private:
+  // Past this many members an array takes more room than a bitmap
+  static constexpr std::size_t ArrayLimit = 4096;
+
+  struct Container {
+    std::vector<std::uint16_t> array; // Sorted, while 'bits' is empty
+    std::vector<std::uint64_t> bits;  // 1024 words once converted
+  };
+
+  static std::uint32_t LowestBit(std::uint64_t bits);
+
+  std::map<std::uint16_t, Container> m_containers;
+  std::uint64_t m_size = 0;
+};
+
+// One numbered family: the files of a folder whose names differ only in
+// their last number, e.g. "IMG_001.jpg" ... "IMG_250.jpg"
+struct SequenceFamily {
+  fs::path folder;
+  std::string pattern; // Name with its last number replaced by "<#>"
+  std::uint64_t members = 0;
+  std::uint32_t lowest = 0;
+  std::uint32_t highest = 0;
+  // Numbers between lowest and highest no member has; the first few gaps
+  std::uint64_t missing = 0;
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> gaps;
+  // Numbers more than one member has ("File5" and "File05"); the first few
+  std::uint64_t duplicated = 0;
+  std::vector<std::uint32_t> duplicates;
+  std::map<std::size_t, std::uint64_t> widths; // Digits written -> members
+  bool mixedPadding = false; // Zero-padded to different widths
+};
+
+// Groups numbered file names into families in a single pass and reports each
+// family's gaps, duplicate numbers and padding widths
+class SequenceAnalyzer {
+public:
+  // Gaps and duplicates listed per family; all of them are counted
+  static constexpr std::size_t MaxListed = 10;
+
+  // Adds a file; names without a number are ignored. The number is the one
+  // RenamerLogic::ParseLastNumber finds
+  void add(const fs::path &file);
+  std::vector<SequenceFamily> report() const;
+
+private:
+  struct Family {
+    NumberSet numbers;
+    NumberSet duplicates;
+    std::uint64_t members = 0;
+    std::map<std::size_t, std::uint64_t> widths;
+    std::size_t shortestUnpadded = SIZE_MAX;
+    std::size_t narrowestPadded = SIZE_MAX;
+    std::size_t widestPadded = 0;
+  };
+  std::map<std::pair<fs::path, std::string>, Family> m_families;
+};
+
+#endif // SEQUENCEREPORT_H
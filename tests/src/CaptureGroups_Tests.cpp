@@ -0,0 +1,79 @@
+#include "pch.h"
+#include "../../src/Logic/CaptureGroups.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+TEST(CaptureGroups, NumbersAndNamesGroups) {
+  std::string error;
+  std::optional<CaptureRegex> regex = CaptureRegex::Compile(
+      R"((?<year>\d{4})-(\d\d)-(?:\d\d) (?<title>[^(]+)\((x)\)?)", true, error);
+  ASSERT_TRUE(regex.has_value()) << error;
+  EXPECT_EQ(regex->groupCount(), 4u);
+  EXPECT_EQ(regex->groupIndex("year"), 1);
+  EXPECT_EQ(regex->groupIndex("title"), 3);
+  EXPECT_EQ(regex->groupIndex("missing"), -1);
+
+  const CaptureTemplate tmpl("<title>_<year><2>_<num><5>", *regex);
+  EXPECT_TRUE(tmpl.referencesGroups());
+  const std::string subject = "2021-07-15 Holiday(x)";
+  std::cmatch groups;
+  ASSERT_TRUE(regex->match(subject, groups));
+  // <num> is left for ReplacePlaceholders; <5> doesn't exist
+  EXPECT_EQ(tmpl.expand(groups), "Holiday_202107_<num><5>");
+}
+
+TEST(CaptureGroups, RejectsInvalidPatterns) {
+  std::string error;
+  EXPECT_FALSE(CaptureRegex::Compile("(?<num>\\d+)", true, error));
+  EXPECT_EQ(error, "Group name 'num' is already a placeholder.");
+  EXPECT_FALSE(CaptureRegex::Compile("(?<a>x)(?<a>y)", true, error));
+  EXPECT_FALSE(CaptureRegex::Compile("(unclosed", true, error));
+  EXPECT_FALSE(error.empty());
+  // Parentheses inside a class or escaped don't count as groups
+  std::optional<CaptureRegex> regex =
+      CaptureRegex::Compile(R"([(]\((a))", false, error);
+  ASSERT_TRUE(regex.has_value()) << error;
+  EXPECT_EQ(regex->groupCount(), 1u);
+}
+
+TEST(CaptureGroups, PlanReorganisesStructuredNames) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/scans/Smith, John - Invoice 042.pdf");
+  memFs.addFile("/scans/Doe, Jane - Receipt 7.pdf");
+  memFs.addFile("/scans/unsorted.pdf");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/scans";
+  params.filenamePattern = "*.pdf";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<2>_<1>_<kind>-<4><ext>"; // Named groups count too
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::ToLower;
+  params.sourcePattern = R"((\w+), (\w+) - (?<kind>\w+) (\d+))";
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+
+  ASSERT_TRUE(results.success);
+  std::vector<std::string> newNames;
+  for (const auto &op : results.renamePlan) {
+    newNames.push_back(op.NewName);
+  }
+  std::sort(newNames.begin(), newNames.end());
+  EXPECT_EQ(newNames, (std::vector<std::string>{"jane_doe_receipt-7.pdf",
+                                                "john_smith_invoice-042.pdf"}));
+  EXPECT_EQ(results.diagnostics.count(DiagCategory::Skipped), 1u);
+
+  params.sourcePattern = "(bad";
+  results = RenamerLogic::calculateRenamePlan(params, memFs);
+  EXPECT_FALSE(results.success);
+  EXPECT_EQ(results.diagnostics.count(DiagCategory::Error), 1u);
+}
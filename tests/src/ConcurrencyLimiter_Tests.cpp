@@ -0,0 +1,105 @@
+#include "pch.h"
+#include "../../src/Logic/ConcurrencyLimiter.h"
+#include "../../src/Logic/OverlayFileSystem.h"
+#include "../../src/Logic/Parallel.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <vector>
+
+using namespace std::chrono_literals;
+
+namespace {
+// Completes one window of operations that each took 'latency'
+void RunWindow(ConcurrencyLimiter &limiter, std::chrono::nanoseconds latency) {
+  const unsigned count = limiter.limit();
+  for (unsigned i = 0; i < count; ++i) {
+    limiter.acquire();
+  }
+  for (unsigned i = 0; i < count; ++i) {
+    limiter.release(latency);
+  }
+}
+
+// A backend type of its own, so no other test has trained its limiters
+class UntrainedFileSystem : public MemoryFileSystem {};
+} // namespace
+
+TEST(ConcurrencyLimiter, GrowsWhileLatencyHoldsAndBacksOffWhenItClimbs) {
+  ConcurrencyLimiter limiter(4, 2, 16);
+  for (int i = 0; i < 5; ++i) {
+    RunWindow(limiter, 1ms);
+  }
+  EXPECT_EQ(limiter.limit(), 9u);
+  for (int i = 0; i < 20; ++i) {
+    RunWindow(limiter, 1ms);
+  }
+  EXPECT_EQ(limiter.limit(), 16u); // Never past the maximum
+
+  RunWindow(limiter, 10ms); // Requests are queueing in the device
+  EXPECT_EQ(limiter.limit(), 12u);
+  for (int i = 0; i < 20; ++i) {
+    RunWindow(limiter, 10ms);
+  }
+  EXPECT_EQ(limiter.limit(), 2u); // Never below the minimum
+
+  limiter.acquire();
+  limiter.release(1ms, true); // A failure backs off like high latency
+  limiter.acquire();
+  limiter.release(1ms);
+  EXPECT_EQ(limiter.limit(), 2u);
+}
+
+TEST(ConcurrencyLimiter, ParallelForKeepsInFlightWithinTheLimit) {
+  ConcurrencyLimiter limiter(3, 1, 3);
+  std::atomic<int> inFlight{0};
+  std::atomic<int> peak{0};
+  std::vector<std::atomic<int>> visits(200);
+  ParallelFor(
+      visits.size(),
+      [&](std::size_t i) {
+        const int now = ++inFlight;
+        int seen = peak.load();
+        while (now > seen && !peak.compare_exchange_weak(seen, now)) {
+        }
+        ++visits[i];
+        --inFlight;
+      },
+      limiter);
+  EXPECT_LE(peak.load(), 3);
+  EXPECT_TRUE(std::all_of(visits.begin(), visits.end(),
+                          [](const std::atomic<int> &v) { return v == 1; }));
+}
+
+TEST(ConcurrencyLimiter, ClassesAndBackendsLearnSeparately) {
+  UntrainedFileSystem memFs;
+  memFs.addDirectory("/d");
+  OverlayFileSystem overlay(memFs);
+  ConcurrencyLimiter &metadata =
+      DeviceConcurrency(memFs, "/d", IoClass::Metadata);
+  ConcurrencyLimiter &copy = DeviceConcurrency(memFs, "/d", IoClass::Copy);
+  EXPECT_EQ(&DeviceConcurrency(memFs, "/d/new/file.txt", IoClass::Metadata),
+            &metadata);
+  EXPECT_NE(&copy, &metadata);
+  // The overlay reports the same device, but answers from memory
+  ConcurrencyLimiter &overlayMetadata =
+      DeviceConcurrency(overlay, "/d", IoClass::Metadata);
+  EXPECT_NE(&overlayMetadata, &metadata);
+
+  // Folder creations take microseconds in the dry run and a millisecond on
+  // the device...
+  for (int i = 0; i < 10; ++i) {
+    RunWindow(overlayMetadata, 1us);
+    RunWindow(metadata, 1ms);
+  }
+  // ...which makes neither the device's folder creations nor its copies,
+  // slower still, look overloaded
+  const unsigned metadataLimit = metadata.limit();
+  RunWindow(metadata, 1500us);
+  EXPECT_EQ(metadata.limit(), metadataLimit + 1);
+  const unsigned copyLimit = copy.limit();
+  for (int i = 0; i < 5; ++i) {
+    RunWindow(copy, 50ms);
+  }
+  EXPECT_EQ(copy.limit(), copyLimit + 5);
+}
@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "../../src/Logic/ContentHash.h"
+#include "../../src/Logic/Parallel.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "TestFixtures.h"
+#include <atomic>
+#include <string>
+
+TEST(ContentHash, MatchesReferenceXxh64) {
+  ContentHasher empty;
+  EXPECT_EQ(empty.digest(), 0xEF46DB3751D8E999ull);
+  ContentHasher abc;
+  abc.update("abc");
+  EXPECT_EQ(abc.digest(), 0x44BC2CF5AD770999ull);
+  ContentHasher longer; // Longer than one 32-byte stripe
+  longer.update("Nobody inspects the spammish repetition");
+  EXPECT_EQ(longer.digest(), 0xFBCEA83C8A378BF1ull);
+}
+
+TEST(ContentHash, ChunkingDoesNotChangeDigest) {
+  std::string data;
+  for (int i = 0; i < 1000; ++i) {
+    data += static_cast<char>(i * 31 + 7);
+  }
+  ContentHasher whole;
+  whole.update(data);
+  for (std::size_t chunk : {1u, 5u, 31u, 32u, 33u, 100u}) {
+    ContentHasher pieces;
+    for (std::size_t pos = 0; pos < data.size(); pos += chunk) {
+      pieces.update(std::string_view(data).substr(pos, chunk));
+    }
+    EXPECT_EQ(pieces.digest(), whole.digest()) << "chunk " << chunk;
+  }
+}
+
+TEST(ContentHash, ExpandsPlaceholders) {
+  const std::uint64_t hash = 0x0123456789ABCDEFull;
+  EXPECT_EQ(ExpandHashPlaceholders("img_<hash:8>.jpg", hash),
+            "img_01234567.jpg");
+  EXPECT_EQ(ExpandHashPlaceholders("<hash:99>", hash), "0123456789abcdef");
+  EXPECT_EQ(ExpandHashPlaceholders("<hash:x><hash:2", hash),
+            "<hash:x><hash:2");
+  EXPECT_FALSE(ReferencesHash("img_<random:8>"));
+}
+
+TEST_F(RenamerLogicFilesystemTest, ContentHash_MappedFileMatchesMemory) {
+  std::string content(200000, 'x');
+  content[12345] = 'y';
+  CreateDummyFile(tempTestDir / "big.bin", content);
+  MemoryFileSystem memFs;
+  memFs.addFile("/big.bin", content);
+
+  std::error_code realEc, memEc;
+  const std::uint64_t onDisk =
+      HashFileContent(DefaultFileSystem(), tempTestDir / "big.bin", realEc);
+  const std::uint64_t inMemory = HashFileContent(memFs, "/big.bin", memEc);
+  EXPECT_FALSE(realEc);
+  EXPECT_FALSE(memEc);
+  EXPECT_EQ(onDisk, inMemory);
+
+  CreateDummyFile(tempTestDir / "empty.bin");
+  EXPECT_EQ(HashFileContent(DefaultFileSystem(), tempTestDir / "empty.bin",
+                            realEc),
+            0xEF46DB3751D8E999ull);
+  EXPECT_FALSE(realEc);
+}
+
+TEST(ContentHash, PlanNamesDuplicatesAlikeAndSkipsUnreadable) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/in/a.jpg", "same pixels");
+  memFs.addFile("/in/b.jpg", "same pixels");
+  memFs.addFile("/in/c.jpg", "other pixels");
+  memFs.addFile("/in/d.jpg", "locked");
+  LatencyConfig config;
+  config.failWhen = [](FileOp op, const fs::path &p) {
+    return op == FileOp::Read && p.filename() == "d.jpg";
+  };
+  LatencyFileSystem flakyFs(memFs, config);
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/in";
+  params.filenamePattern = "*";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<hash:10><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, flakyFs);
+
+  ASSERT_EQ(results.renamePlan.size(), 3u);
+  std::error_code ec;
+  const std::string same =
+      ExpandHashPlaceholders("<hash:10>", HashFileContent(memFs, "/in/a.jpg",
+                                                          ec)) +
+      ".jpg";
+  int sameCount = 0;
+  for (const RenameOperation &op : results.renamePlan) {
+    EXPECT_EQ(op.NewName.size(), 14u);
+    sameCount += op.NewName == same;
+  }
+  EXPECT_EQ(sameCount, 2);
+  EXPECT_EQ(results.diagnostics.count(DiagCategory::Skipped), 1u);
+  EXPECT_EQ(flakyFs.callCount(FileOp::Read), 4u);
+}
+
+TEST(Parallel, VisitsEveryIndexOnce) {
+  std::vector<std::atomic<int>> visits(1000);
+  ParallelFor(visits.size(), [&](std::size_t i) { ++visits[i]; }, 4);
+  for (const std::atomic<int> &count : visits) {
+    EXPECT_EQ(count.load(), 1);
+  }
+  EXPECT_THROW(ParallelFor(
+                   10, [](std::size_t i) {
+                     if (i == 3) {
+                       throw std::runtime_error("boom");
+                     }
+                   }),
+               std::runtime_error);
+}
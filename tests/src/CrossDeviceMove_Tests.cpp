@@ -0,0 +1,152 @@
+#include "pch.h"
+#include "../../src/Logic/CrossDeviceMove.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "TestFixtures.h"
+#include <optional>
+#include <string>
+#include <vector>
+
+namespace {
+// ".partial", ".partial1", ...
+bool IsTemporary(const fs::path &p) {
+  return p.extension().string().rfind(".partial", 0) == 0;
+}
+
+// Every rename except the mover's own temporary files fails as if the
+// target were on another mount point
+LatencyConfig CrossDeviceRenames() {
+  LatencyConfig config;
+  config.failureError = std::errc::cross_device_link;
+  config.failWhen = [](FileOp op, const fs::path &p) {
+    return op == FileOp::Rename && !IsTemporary(p);
+  };
+  return config;
+}
+} // namespace
+
+TEST_F(RenamerLogicFilesystemTest, CrossDeviceMove_RenameAndUndoFallBack) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/src/a.txt", "alpha");
+  memFs.addFile("/src/b.txt", std::string(100000, 'b'));
+  memFs.addFile("/dst/keep.txt", "keep");
+  LatencyFileSystem crossFs(memFs, CrossDeviceRenames());
+  const fs::path journal = tempTestDir / "moves.journal";
+
+  std::vector<RenameOperation> plan = {
+      {"a.txt", "a.txt", "/src/a.txt", "/dst/a.txt", std::nullopt, 1, false,
+       ""},
+      {"b.txt", "b2.txt", "/src/b.txt", "/dst/b2.txt", std::nullopt, 2, false,
+       ""}};
+  RenameExecutionResult renameRes =
+      RenamerLogic::performRename(plan, 0, crossFs, journal);
+  ASSERT_TRUE(renameRes.overallSuccess);
+  EXPECT_EQ(renameRes.successfulRenameOps.size(), 2u);
+  std::error_code ec;
+  EXPECT_FALSE(memFs.exists("/src/a.txt", ec));
+  EXPECT_FALSE(memFs.exists("/dst/a.txt.partial", ec));
+  EXPECT_EQ(memFs.readFile("/dst/a.txt"), "alpha");
+  EXPECT_EQ(memFs.readFile("/dst/b2.txt"), std::string(100000, 'b'));
+  EXPECT_FALSE(fs::exists(journal)); // Removed once the batch finished
+
+  UndoResult undoRes = RenamerLogic::performUndo(renameRes.successfulRenameOps,
+                                                 crossFs, journal);
+  ASSERT_TRUE(undoRes.overallSuccess);
+  EXPECT_EQ(memFs.readFile("/src/b.txt"), std::string(100000, 'b'));
+  EXPECT_FALSE(memFs.exists("/dst/b2.txt", ec));
+}
+
+TEST_F(RenamerLogicFilesystemTest, CrossDeviceMove_FailedCopyKeepsSource) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/src/a.txt", "alpha");
+  memFs.addDirectory("/dst");
+  LatencyConfig config = CrossDeviceRenames();
+  config.failWhen = [](FileOp op, const fs::path &p) {
+    return (op == FileOp::Rename && !IsTemporary(p)) ||
+           (op == FileOp::Read && IsTemporary(p));
+  };
+  LatencyFileSystem crossFs(memFs, config);
+
+  std::vector<CrossDeviceMove> moves = {{"/src/a.txt", "/dst/a.txt", {}}};
+  MoveAcrossDevices(moves, crossFs);
+  EXPECT_FALSE(moves[0].error.empty()); // The copy could not be verified
+  std::error_code ec;
+  EXPECT_EQ(memFs.readFile("/src/a.txt"), "alpha");
+  EXPECT_FALSE(memFs.exists("/dst/a.txt", ec));
+  EXPECT_FALSE(memFs.exists("/dst/a.txt.partial", ec));
+}
+
+TEST_F(RenamerLogicFilesystemTest, CrossDeviceMove_KeepsExistingPartialFiles) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/src/a.txt", "alpha");
+  memFs.addFile("/src/b.txt", "beta");
+  memFs.addFile("/dst/a.txt.partial", "mine");
+  memFs.addFile("/dst/b.txt.partial", "mine too");
+  LatencyConfig config = CrossDeviceRenames();
+  // b.txt's copy can't be verified, so that move fails and cleans up
+  config.failWhen = [](FileOp op, const fs::path &p) {
+    return (op == FileOp::Rename && !IsTemporary(p)) ||
+           (op == FileOp::Read && p == "/dst/b.txt.partial1");
+  };
+  LatencyFileSystem crossFs(memFs, config);
+  const fs::path journal = tempTestDir / "moves.journal";
+
+  std::vector<CrossDeviceMove> moves = {{"/src/a.txt", "/dst/a.txt", {}},
+                                        {"/src/b.txt", "/dst/b.txt", {}}};
+  MoveAcrossDevices(moves, crossFs, journal);
+  EXPECT_TRUE(moves[0].error.empty());
+  EXPECT_FALSE(moves[1].error.empty());
+  std::error_code ec;
+  EXPECT_EQ(memFs.readFile("/dst/a.txt"), "alpha");
+  EXPECT_EQ(memFs.readFile("/src/b.txt"), "beta");
+  EXPECT_EQ(memFs.readFile("/dst/a.txt.partial"), "mine");
+  EXPECT_EQ(memFs.readFile("/dst/b.txt.partial"), "mine too");
+  EXPECT_FALSE(memFs.exists("/dst/a.txt.partial1", ec));
+  EXPECT_FALSE(memFs.exists("/dst/b.txt.partial1", ec));
+}
+
+TEST_F(RenamerLogicFilesystemTest, CrossDeviceMove_RecoversInterruptedMoves) {
+  MemoryFileSystem memFs;
+  // a.txt was renamed into place but its original not yet removed; b.txt
+  // was still being copied
+  memFs.addFile("/src/a.txt", "alpha");
+  memFs.addFile("/dst/a.txt", "alpha");
+  memFs.addFile("/src/b.txt", "beta");
+  memFs.addFile("/dst/b.txt.partial", "mine"); // Not the mover's
+  memFs.addFile("/dst/b.txt.partial1", "be");
+  const fs::path journal = tempTestDir / "moves.journal";
+  CreateDummyFile(journal, "RUMJ 2\n10 /src/a.txt\n10 /dst/a.txt\n"
+                           "18 /dst/a.txt.partial\n"
+                           "10 /src/b.txt\n10 /dst/b.txt\n"
+                           "19 /dst/b.txt.partial1\n");
+
+  std::error_code ec;
+  EXPECT_EQ(RecoverInterruptedMoves(journal, memFs, ec), 1u);
+  EXPECT_FALSE(ec);
+  EXPECT_FALSE(memFs.exists("/src/a.txt", ec));
+  EXPECT_EQ(memFs.readFile("/dst/a.txt"), "alpha");
+  EXPECT_EQ(memFs.readFile("/src/b.txt"), "beta");
+  EXPECT_FALSE(memFs.exists("/dst/b.txt.partial1", ec));
+  EXPECT_EQ(memFs.readFile("/dst/b.txt.partial"), "mine");
+  EXPECT_FALSE(fs::exists(journal));
+  EXPECT_EQ(RecoverInterruptedMoves(journal, memFs, ec), 0u);
+}
+
+TEST_F(RenamerLogicFilesystemTest, CrossDeviceMove_RealCopyFileKeepsContent) {
+  const fs::path from = tempTestDir / "source.bin";
+  const fs::path to = tempTestDir / "copy.bin";
+  CreateDummyFile(from, std::string(300000, 'x') + "end");
+  CreateDummyFile(to, "previous content that is replaced");
+
+  std::error_code ec;
+  EXPECT_TRUE(
+      DefaultFileSystem().copyFile(from, to, CopyMode::Overwrite, ec));
+  EXPECT_FALSE(ec);
+  EXPECT_EQ(fs::file_size(to), 300003u);
+
+  // An exclusive copy leaves an existing file alone
+  CreateDummyFile(to, "kept");
+  EXPECT_FALSE(
+      DefaultFileSystem().copyFile(from, to, CopyMode::CreateNew, ec));
+  EXPECT_EQ(ec, std::errc::file_exists);
+  EXPECT_EQ(fs::file_size(to), 4u);
+}
@@ -0,0 +1,40 @@
+#include "pch.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+TEST(Diagnostics, CapKeepsCountsButDropsRecords) {
+  Diagnostics diagnostics(2);
+  EXPECT_TRUE(diagnostics.keeps(DiagCode::DuplicateInput));
+  for (int i = 0; i < 5; ++i) {
+    diagnostics.addPath(DiagCode::DuplicateInput,
+                        fs::path("file" + std::to_string(i) + ".txt"));
+  }
+  EXPECT_EQ(diagnostics.count(DiagCategory::Warning), 5u);
+  EXPECT_EQ(diagnostics.records(DiagCategory::Warning).size(), 2u);
+  EXPECT_EQ(diagnostics.dropped(DiagCategory::Warning), 3u);
+  EXPECT_FALSE(diagnostics.keeps(DiagCode::TargetExists)); // Same category
+  EXPECT_TRUE(diagnostics.keeps(DiagCode::PlanCalculated));
+  EXPECT_TRUE(diagnostics.hasIssues());
+  EXPECT_EQ(diagnostics.count(DiagCategory::Error), 0u);
+}
+
+TEST(Diagnostics, FormatsLazilyFromPlanAndErrorCode) {
+  std::vector<RenameOperation> plan = {
+      {"a.txt", "b.txt", "dir/a.txt", "dir/b.txt", std::nullopt, 0, false, ""}};
+  Diagnostics diagnostics;
+  diagnostics.addForOp(DiagCode::PotentialOverwrite, 0);
+  diagnostics.addPath(DiagCode::SourceInvalid, fs::path("missing.txt"),
+                      std::make_error_code(std::errc::permission_denied));
+
+  const auto &overwrite = diagnostics.records(DiagCategory::Overwrite).at(0);
+  EXPECT_EQ(diagnostics.format(overwrite, plan),
+            "Skipped renaming 'a.txt' to 'b.txt' because target path exists "
+            "and is not part of this rename batch.");
+  const auto &skipped = diagnostics.records(DiagCategory::Skipped).at(0);
+  EXPECT_EQ(skipped.error, std::errc::permission_denied);
+  EXPECT_NE(diagnostics.format(skipped, plan).find("missing.txt (Skipped: "),
+            std::string::npos);
+}
@@ -0,0 +1,163 @@
+#include "pch.h"
+#include "../../src/Logic/FileSystem.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include <algorithm>
+#include <fstream>
+#include <string>
+#include <vector>
+
+namespace fs = std::filesystem;
+
+TEST(MemoryFileSystem, ListsOnlyDirectChildren) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/data/a.txt", "A");
+  memFs.addFile("/data/a-b.txt", "AB");
+  memFs.addFile("/data/sub/deep.txt", "D");
+
+  std::vector<std::string> names;
+  std::error_code ec;
+  memFs.listDirectory(
+      "/data",
+      [&](const DirEntryView &entry) { names.emplace_back(entry.name); }, ec);
+  ASSERT_FALSE(ec);
+  std::sort(names.begin(), names.end());
+  ASSERT_EQ(names.size(), 3u);
+  EXPECT_EQ(names[0], "a-b.txt");
+  EXPECT_EQ(names[1], "a.txt");
+  EXPECT_EQ(names[2], "sub");
+  EXPECT_EQ(memFs.status("/data/sub", ec), FileKind::Directory);
+  EXPECT_EQ(memFs.status("/data/missing", ec), FileKind::NotFound);
+  EXPECT_FALSE(ec);
+}
+
+TEST(MemoryFileSystem, RenameMovesDirectorySubtree) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/root/old/x.txt", "X");
+  std::error_code ec;
+  memFs.rename("/root/old", "/root/new", ec);
+  ASSERT_FALSE(ec);
+  EXPECT_FALSE(memFs.exists("/root/old/x.txt", ec));
+  EXPECT_EQ(memFs.readFile("/root/new/x.txt"), "X");
+}
+
+TEST(MemoryFileSystem, PlanRenameAndUndoWithoutDisk) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/photos/img_1.jpg", "one");
+  memFs.addFile("/photos/img_2.jpg", "two");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/photos";
+  params.filenamePattern = "*.jpg";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "img_<num><ext>";
+  params.increment = 1;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+
+  OutputResults plan = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(plan.success);
+  ASSERT_EQ(plan.renamePlan.size(), 2u);
+
+  RenameExecutionResult renameRes =
+      RenamerLogic::performRename(plan.renamePlan, params.increment, memFs);
+  ASSERT_TRUE(renameRes.overallSuccess);
+  EXPECT_EQ(memFs.readFile("/photos/img_02.jpg"), "one");
+  EXPECT_EQ(memFs.readFile("/photos/img_03.jpg"), "two");
+
+  UndoResult undoRes =
+      RenamerLogic::performUndo(renameRes.successfulRenameOps, memFs);
+  ASSERT_TRUE(undoRes.overallSuccess);
+  EXPECT_EQ(memFs.readFile("/photos/img_1.jpg"), "one");
+  EXPECT_EQ(memFs.readFile("/photos/img_2.jpg"), "two");
+}
+
+TEST(LatencyFileSystem, InjectedRenameFaultIsReported) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/w/a.txt");
+  memFs.addFile("/w/b.txt");
+
+  LatencyConfig config;
+  config.latency = std::chrono::microseconds(50);
+  config.failWhen = [](FileOp op, const fs::path &p) {
+    return op == FileOp::Rename && p.filename() == "b.txt";
+  };
+  LatencyFileSystem slowFs(memFs, config);
+
+  std::vector<RenameOperation> plan = {
+      {"a.txt", "c.txt", "/w/a.txt", "/w/c.txt", std::nullopt, 1, false, ""},
+      {"b.txt", "d.txt", "/w/b.txt", "/w/d.txt", std::nullopt, 2, false, ""}};
+  RenameExecutionResult res = RenamerLogic::performRename(plan, 0, slowFs);
+
+  EXPECT_FALSE(res.overallSuccess);
+  ASSERT_EQ(res.successfulRenameOps.size(), 1u);
+  ASSERT_EQ(res.failedRenames.size(), 1u);
+  EXPECT_EQ(res.failedRenames[0].first, "b.txt");
+  EXPECT_EQ(slowFs.callCount(FileOp::Rename), 2u);
+  std::error_code ec;
+  EXPECT_TRUE(memFs.exists("/w/b.txt", ec));
+}
+
+TEST(MemoryFileSystem, BackupCopiesTree) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/src/file1.txt", "c1");
+  memFs.addFile("/src/sub/file2.txt", "c2");
+
+  BackupResult backupRes =
+      RenamerLogic::performBackup("/src", "MemoryContext", memFs);
+  ASSERT_TRUE(backupRes.success) << backupRes.errorMessage;
+  EXPECT_EQ(memFs.readFile(backupRes.backupPath / "file1.txt"), "c1");
+  EXPECT_EQ(memFs.readFile(backupRes.backupPath / "sub" / "file2.txt"), "c2");
+
+  DeleteResult deleteRes =
+      RenamerLogic::deleteBackup(backupRes.backupPath, memFs);
+  EXPECT_TRUE(deleteRes.success);
+  std::error_code ec;
+  EXPECT_FALSE(memFs.exists(backupRes.backupPath, ec));
+}
+
+TEST(RealFileSystem, ListsLargeFolderAcrossSeveralReads) {
+  const fs::path dir = fs::temp_directory_path() / "RenameUtility_ListTest";
+  fs::remove_all(dir);
+  fs::create_directories(dir / "sub");
+  // Long names, so the entries span several ListBufferSize reads
+  const std::string padding(100, 'x');
+  constexpr int fileCount = 3000;
+  for (int i = 0; i < fileCount; ++i) {
+    std::ofstream(dir / (padding + std::to_string(i) + ".txt")) << i;
+  }
+
+  RealFileSystem realFs;
+  std::vector<std::string> files;
+  std::vector<std::string> folders;
+  bool inodesKnown = true;
+  std::error_code ec;
+  realFs.listDirectory(
+      dir,
+      [&](const DirEntryView &entry) {
+        EXPECT_FALSE(entry.error);
+        EXPECT_FALSE(entry.isSymlink);
+        inodesKnown = inodesKnown && entry.inode != 0;
+        (entry.kind == FileKind::Directory ? folders : files)
+            .emplace_back(entry.name);
+      },
+      ec);
+  fs::remove_all(dir);
+
+  EXPECT_FALSE(ec);
+  EXPECT_EQ(folders, std::vector<std::string>{"sub"}); // No "." or ".."
+  ASSERT_EQ(files.size(), static_cast<std::size_t>(fileCount));
+  std::sort(files.begin(), files.end());
+  EXPECT_TRUE(std::adjacent_find(files.begin(), files.end()) == files.end());
+  EXPECT_TRUE(std::binary_search(files.begin(), files.end(),
+                                 padding + "2999.txt"));
+#ifdef __linux__
+  EXPECT_TRUE(inodesKnown);
+#endif
+}
@@ -0,0 +1,128 @@
+#include "pch.h"
+#include "../../src/Logic/FreeNameIndex.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "TestFixtures.h"
+#include <set>
+#include <string>
+
+TEST(FreeNameIndex, ClaimsNextFreeSuffixWithoutProbingTheDisk) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/d/photo.jpg", "taken");
+  memFs.addFile("/d/Photo (2).JPG", "taken");
+  memFs.addFile("/d/old.jpg", "being renamed away");
+  LatencyFileSystem countingFs(memFs, LatencyConfig());
+  const std::set<fs::path> sources = {"/d/old.jpg"};
+  FreeNameIndex index(" (#)", countingFs, sources);
+
+  std::error_code ec;
+  EXPECT_EQ(index.claim("/d/photo.jpg", false, ec),
+            fs::path("/d/photo (3).jpg"));
+  EXPECT_EQ(index.claim("/d/photo.jpg", false, ec),
+            fs::path("/d/photo (4).jpg"));
+  EXPECT_EQ(index.claim("/d/old.jpg", false, ec), fs::path("/d/old.jpg"));
+  EXPECT_EQ(index.claim("/d/OLD.jpg", false, ec), fs::path("/d/OLD (2).jpg"));
+  EXPECT_EQ(index.claim("/d/set.v2", true, ec), fs::path("/d/set.v2"));
+  EXPECT_EQ(index.claim("/d/set.v2", true, ec), fs::path("/d/set.v2 (2)"));
+  EXPECT_EQ(index.claim("/d/new/a.txt", false, ec), fs::path("/d/new/a.txt"));
+  EXPECT_FALSE(ec); // A folder the rename creates is empty
+
+  FreeNameIndex padded("_###", countingFs, sources);
+  for (int i = 0; i < 100000; ++i) {
+    index.claim("/d/many.txt", false, ec);
+  }
+  EXPECT_EQ(padded.claim("/d/photo.jpg", false, ec),
+            fs::path("/d/photo_002.jpg"));
+  EXPECT_EQ(index.claim("/d/many.txt", false, ec),
+            fs::path("/d/many (100001).txt"));
+  EXPECT_EQ(countingFs.callCount(FileOp::Status), 0u);
+  EXPECT_EQ(countingFs.callCount(FileOp::List), 3u); // "/d" twice, "/d/new"
+  EXPECT_FALSE(FreeNameIndex::ValidSuffix("/#"));
+}
+
+TEST(FreeNameIndex, PlanResolvesConflictsInOnePreview) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/p/a1.txt", "1");
+  memFs.addFile("/p/a2.txt", "2");
+  memFs.addFile("/p/a3.txt", "3");
+  memFs.addFile("/p/photo.txt", "unrelated");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/p";
+  params.filenamePattern = "a*";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "photo<ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.conflictSuffix = "_##";
+
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  ASSERT_EQ(results.renamePlan.size(), 3u);
+  for (const auto &op : results.renamePlan) {
+    EXPECT_FALSE(op.hasConflict);
+  }
+  EXPECT_EQ(results.diagnostics.count(DiagCategory::Overwrite), 0u);
+  RenameExecutionResult renameRes =
+      RenamerLogic::performRename(results.renamePlan, 0, memFs);
+  ASSERT_TRUE(renameRes.overallSuccess);
+  EXPECT_EQ(memFs.readFile("/p/photo.txt"), "unrelated");
+  EXPECT_EQ(memFs.readFile("/p/photo_02.txt"), "1");
+  EXPECT_EQ(memFs.readFile("/p/photo_04.txt"), "3");
+
+  params.conflictSuffix = "<#>";
+  results = RenamerLogic::calculateRenamePlan(params, memFs);
+  EXPECT_FALSE(results.success);
+}
+
+TEST(FreeNameIndex, SourcesThatStayKeepTheirNames) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/d/photo.jpg", "photo");
+  memFs.addFile("/d/img.jpg", "img");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/d";
+  params.filenamePattern = "*";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "photo<ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.conflictSuffix = " (#)";
+
+  // photo.jpg already has its new name, so img.jpg must not take it
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  ASSERT_EQ(results.renamePlan.size(), 1u);
+  EXPECT_EQ(results.renamePlan[0].NewName, "photo (2).jpg");
+  EXPECT_FALSE(results.renamePlan[0].hasConflict);
+  RenameExecutionResult renameRes =
+      RenamerLogic::performRename(results.renamePlan, 0, memFs);
+  ASSERT_TRUE(renameRes.overallSuccess);
+  EXPECT_EQ(memFs.readFile("/d/photo.jpg"), "photo");
+  EXPECT_EQ(memFs.readFile("/d/photo (2).jpg"), "img");
+
+  // Without a suffix the same target is a conflict
+  MemoryFileSystem unsuffixedFs;
+  unsuffixedFs.addFile("/d/photo.jpg", "photo");
+  unsuffixedFs.addFile("/d/img.jpg", "img");
+  params.conflictSuffix = "";
+  results = RenamerLogic::calculateRenamePlan(params, unsuffixedFs);
+  ASSERT_EQ(results.renamePlan.size(), 1u);
+  EXPECT_TRUE(results.renamePlan[0].hasConflict);
+  EXPECT_EQ(results.diagnostics.count(DiagCategory::Overwrite), 1u);
+}
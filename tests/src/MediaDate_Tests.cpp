@@ -0,0 +1,183 @@
+#include "pch.h"
+#include "../../src/Logic/MediaDate.h"
+#include "../../src/Logic/MetadataCache.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include <string>
+
+namespace {
+void PutLE16(std::string &out, unsigned v) {
+  out += static_cast<char>(v & 0xFF);
+  out += static_cast<char>((v >> 8) & 0xFF);
+}
+
+void PutLE32(std::string &out, std::uint32_t v) {
+  PutLE16(out, v & 0xFFFF);
+  PutLE16(out, v >> 16);
+}
+
+void PutBE32(std::string &out, std::uint32_t v) {
+  for (int shift = 24; shift >= 0; shift -= 8) {
+    out += static_cast<char>((v >> shift) & 0xFF);
+  }
+}
+
+void PutIfdEntry(std::string &out, unsigned tag, unsigned type,
+                 std::uint32_t count, std::uint32_t value) {
+  PutLE16(out, tag);
+  PutLE16(out, type);
+  PutLE32(out, count);
+  PutLE32(out, value);
+}
+
+// JFIF APP0, then an EXIF APP1 whose Exif sub-IFD carries both
+// DateTimeDigitized and DateTimeOriginal
+std::string MakeJpeg() {
+  std::string tiff = "II";
+  PutLE16(tiff, 42);
+  PutLE32(tiff, 8);
+  PutLE16(tiff, 1); // IFD0: pointer to the Exif IFD at 26
+  PutIfdEntry(tiff, 0x8769, 4, 1, 26);
+  PutLE32(tiff, 0);
+  PutLE16(tiff, 2); // Exif IFD; strings follow at 56
+  PutIfdEntry(tiff, 0x9004, 2, 20, 56);
+  PutIfdEntry(tiff, 0x9003, 2, 20, 76);
+  PutLE32(tiff, 0);
+  tiff += std::string("2019:01:02 03:04:05", 20);
+  tiff += std::string("2021:07:15 10:20:30", 20);
+
+  std::string jpeg("\xFF\xD8\xFF\xE0\x00\x10JFIF\0\x01\x01\0\0\x01\0\x01\0\0",
+                   20);
+  const std::string exif = std::string("Exif\0\0", 6) + tiff;
+  jpeg += "\xFF\xE1";
+  jpeg += static_cast<char>(((exif.size() + 2) >> 8) & 0xFF);
+  jpeg += static_cast<char>((exif.size() + 2) & 0xFF);
+  jpeg += exif;
+  jpeg += std::string("\xFF\xDA\x00\x02", 4) + std::string(100, '\x55');
+  return jpeg;
+}
+
+// ftyp, a large mdat, then moov/mvhd at the end of the file as cameras
+// write it
+std::string MakeMp4(std::uint32_t creationTime) {
+  std::string mp4;
+  PutBE32(mp4, 16);
+  mp4 += "ftypisom";
+  PutBE32(mp4, 0);
+  const std::uint32_t mdatSize = 1024 * 1024;
+  PutBE32(mp4, mdatSize);
+  mp4 += "mdat";
+  mp4 += std::string(mdatSize - 8, '\0');
+  PutBE32(mp4, 8 + 8 + 100);
+  mp4 += "moov";
+  PutBE32(mp4, 8 + 100);
+  mp4 += "mvhd";
+  PutBE32(mp4, 0); // Version 0, no flags
+  PutBE32(mp4, creationTime);
+  mp4 += std::string(92, '\0');
+  return mp4;
+}
+} // namespace
+
+TEST(MediaDate, JpegPrefersDateTimeOriginal) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/p/img.jpg", MakeJpeg());
+  std::error_code ec;
+  std::optional<CaptureDate> date = ReadCaptureDate(memFs, "/p/img.jpg", ec);
+  EXPECT_FALSE(ec);
+  ASSERT_TRUE(date.has_value());
+  EXPECT_EQ(date->dateString(), "20210715");
+  EXPECT_EQ(date->timeString(), "102030");
+}
+
+TEST(MediaDate, Mp4ReadsOnlyBoxHeaders) {
+  MemoryFileSystem memFs;
+  // 2020-09-13 12:26:40 UTC in seconds since 1904
+  memFs.addFile("/v/clip.mp4", MakeMp4(1600000000u + 2082844800u));
+  LatencyFileSystem countingFs(memFs, LatencyConfig());
+  std::error_code ec;
+  std::optional<CaptureDate> date =
+      ReadCaptureDate(countingFs, "/v/clip.mp4", ec);
+  ASSERT_TRUE(date.has_value());
+  EXPECT_EQ(date->dateString(), "20200913");
+  EXPECT_EQ(date->timeString(), "122640");
+  EXPECT_EQ(countingFs.callCount(FileOp::Read), 0u);
+  EXPECT_LE(countingFs.callCount(FileOp::ReadAt), 4u);
+}
+
+TEST(MediaDate, FallsBackToModifiedTime) {
+  MemoryFileSystem memFs;
+  const fs::file_time_type written = fs::file_time_type::clock::now();
+  memFs.addFile("/p/notes.txt", "plain text", written);
+  std::error_code ec;
+  EXPECT_FALSE(ReadCaptureDate(memFs, "/p/notes.txt", ec).has_value());
+  EXPECT_EQ(CaptureDateOrModified(memFs, "/p/notes.txt").dateString(),
+            LocalDateOf(written).dateString());
+  EXPECT_EQ(CaptureDateOrModified(memFs, "/p/missing.jpg").dateString(),
+            "00000000");
+}
+
+TEST(MediaDate, PlanUsesCaptureDate) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/p/IMG_0001.jpg", MakeJpeg());
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/p";
+  params.filenamePattern = "*.jpg";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<exif_date>_<exif_time><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+
+  ASSERT_EQ(results.renamePlan.size(), 1u);
+  EXPECT_EQ(results.renamePlan[0].NewName, "20210715_102030.jpg");
+}
+
+TEST(MediaDate, FailedReadIsNotCached) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/p/IMG_0001.jpg", MakeJpeg());
+  bool failReads = true;
+  LatencyConfig config;
+  config.failWhen = [&failReads](FileOp op, const fs::path &) {
+    return failReads && (op == FileOp::Read || op == FileOp::ReadAt);
+  };
+  LatencyFileSystem flakyFs(memFs, config);
+  MetadataCache cache;
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/p";
+  params.filenamePattern = "*.jpg";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<exif_date>_<exif_time><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.metadataCache = &cache;
+
+  // The header can't be read: the modified time stands in, uncached
+  OutputResults failed = RenamerLogic::calculateRenamePlan(params, flakyFs);
+  ASSERT_EQ(failed.renamePlan.size(), 1u);
+  EXPECT_NE(failed.renamePlan[0].NewName, "20210715_102030.jpg");
+  EXPECT_EQ(cache.size(), 0u);
+
+  failReads = false;
+  OutputResults retried = RenamerLogic::calculateRenamePlan(params, flakyFs);
+  ASSERT_EQ(retried.renamePlan.size(), 1u);
+  EXPECT_EQ(retried.renamePlan[0].NewName, "20210715_102030.jpg");
+  EXPECT_EQ(cache.size(), 1u);
+}
@@ -0,0 +1,126 @@
+#include "pch.h"
+#include "../../src/Logic/MetadataCache.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "TestFixtures.h"
+#include <string>
+
+namespace {
+FileIdentity MakeIdentity(std::uint64_t inode, std::uint64_t size,
+                          std::int64_t modifiedNs) {
+  FileIdentity id;
+  id.device = 7;
+  id.inode = inode;
+  id.size = size;
+  id.modifiedNs = modifiedNs;
+  return id;
+}
+
+InputParams HashParams() {
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/media";
+  params.filenamePattern = "*";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<hash:8>_<exif_date><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  return params;
+}
+} // namespace
+
+TEST(MetadataCache, StaleEntriesAreDroppedAndLruEvicts) {
+  MetadataCache cache(fs::path(), 2);
+  CachedMetadata values;
+  values.contentHash = 42;
+  cache.store(MakeIdentity(1, 10, 100), values);
+  cache.store(MakeIdentity(2, 10, 100), values);
+
+  CachedMetadata out;
+  EXPECT_TRUE(cache.lookup(MakeIdentity(1, 10, 100), out));
+  EXPECT_EQ(out.contentHash.value_or(0), 42u);
+  // Same inode, newer mtime: the file was modified
+  EXPECT_FALSE(cache.lookup(MakeIdentity(1, 10, 200), out));
+  EXPECT_EQ(cache.size(), 1u);
+
+  cache.store(MakeIdentity(3, 10, 100), values);
+  cache.store(MakeIdentity(4, 10, 100), values); // Evicts inode 2
+  EXPECT_EQ(cache.size(), 2u);
+  EXPECT_FALSE(cache.lookup(MakeIdentity(2, 10, 100), out));
+  EXPECT_TRUE(cache.lookup(MakeIdentity(3, 10, 100), out));
+}
+
+TEST_F(RenamerLogicFilesystemTest, MetadataCache_SavesAndLoadsInLruOrder) {
+  const fs::path file = tempTestDir / "cache" / "metadata.cache";
+  {
+    MetadataCache cache(file);
+    CachedMetadata values;
+    values.contentHash = 0xABCDEF0123456789ull;
+    CaptureDate date;
+    date.year = 2021;
+    date.month = 7;
+    date.day = 15;
+    date.hour = 10;
+    date.minute = 20;
+    date.second = 30;
+    values.captureDate = date;
+    for (std::uint64_t inode = 1; inode <= 3; ++inode) {
+      cache.store(MakeIdentity(inode, 5, 9), values);
+    }
+    std::error_code ec;
+    EXPECT_TRUE(cache.save(ec));
+    EXPECT_FALSE(ec);
+  }
+
+  MetadataCache reloaded(file, 2); // Keeps the two most recent
+  std::error_code ec;
+  EXPECT_TRUE(reloaded.load(ec));
+  EXPECT_EQ(reloaded.size(), 2u);
+  CachedMetadata out;
+  EXPECT_FALSE(reloaded.lookup(MakeIdentity(1, 5, 9), out));
+  ASSERT_TRUE(reloaded.lookup(MakeIdentity(3, 5, 9), out));
+  EXPECT_EQ(out.contentHash.value_or(0), 0xABCDEF0123456789ull);
+  ASSERT_TRUE(out.captureDate.has_value());
+  EXPECT_EQ(out.captureDate->dateString(), "20210715");
+  EXPECT_EQ(out.captureDate->timeString(), "102030");
+
+  CreateDummyFile(file, "not a cache");
+  EXPECT_TRUE(reloaded.load(ec)); // Foreign content starts afresh
+  EXPECT_EQ(reloaded.size(), 0u);
+}
+
+TEST(MetadataCache, RepeatPreviewSkipsFileReads) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/media/a.bin", "first");
+  memFs.addFile("/media/b.bin", "second");
+  LatencyFileSystem countingFs(memFs, LatencyConfig());
+  MetadataCache cache;
+  InputParams params = HashParams();
+  params.metadataCache = &cache;
+
+  OutputResults first = RenamerLogic::calculateRenamePlan(params, countingFs);
+  ASSERT_EQ(first.renamePlan.size(), 2u);
+  const std::uint64_t readsAfterFirst =
+      countingFs.callCount(FileOp::Read) + countingFs.callCount(FileOp::ReadAt);
+  EXPECT_GT(readsAfterFirst, 0u);
+  EXPECT_EQ(cache.size(), 2u);
+
+  OutputResults second = RenamerLogic::calculateRenamePlan(params, countingFs);
+  ASSERT_EQ(second.renamePlan.size(), 2u);
+  EXPECT_EQ(second.renamePlan[0].NewName, first.renamePlan[0].NewName);
+  EXPECT_EQ(countingFs.callCount(FileOp::Read) +
+                countingFs.callCount(FileOp::ReadAt),
+            readsAfterFirst);
+
+  // Rewriting a file invalidates just its entry
+  memFs.addFile("/media/a.bin", "changed",
+                fs::file_time_type::clock::now() + std::chrono::seconds(5));
+  RenamerLogic::calculateRenamePlan(params, countingFs);
+  EXPECT_EQ(countingFs.callCount(FileOp::Read), 3u);
+}
@@ -0,0 +1,102 @@
+#include "pch.h"
+#include "../../src/Logic/OverlayFileSystem.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "TestFixtures.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+std::vector<std::string> List(FileSystem &fileSystem, const fs::path &dir) {
+  std::vector<std::string> names;
+  std::error_code ec;
+  fileSystem.listDirectory(
+      dir, [&](const DirEntryView &entry) { names.emplace_back(entry.name); },
+      ec);
+  std::sort(names.begin(), names.end());
+  return names;
+}
+} // namespace
+
+TEST(OverlayFileSystem, RecordsChangesWithoutTouchingTheBase) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/d/a.txt", "A");
+  memFs.addFile("/d/sub/b.txt", "B");
+  OverlayFileSystem overlay(memFs);
+  std::error_code ec;
+
+  overlay.rename("/d/a.txt", "/d/c.txt", ec);
+  ASSERT_FALSE(ec);
+  overlay.rename("/d/sub", "/d/moved", ec);
+  ASSERT_FALSE(ec);
+  EXPECT_TRUE(overlay.createDirectories("/d/new/deeper", ec));
+  overlay.rename("/d/moved/b.txt", "/d/new/deeper/b.txt", ec);
+  ASSERT_FALSE(ec);
+  overlay.rename("/d/new", "/d/newer", ec);
+  ASSERT_FALSE(ec);
+
+  EXPECT_FALSE(overlay.exists("/d/a.txt", ec));
+  EXPECT_TRUE(overlay.isRegularFile("/d/c.txt", ec));
+  EXPECT_TRUE(overlay.isDirectory("/d/moved", ec));
+  EXPECT_FALSE(overlay.exists("/d/moved/b.txt", ec));
+  EXPECT_TRUE(overlay.isRegularFile("/d/newer/deeper/b.txt", ec));
+  std::string content;
+  overlay.readContent(
+      "/d/c.txt", [&](std::string_view chunk) { content += chunk; }, ec);
+  EXPECT_EQ(content, "A");
+  EXPECT_EQ(List(overlay, "/d"),
+            (std::vector<std::string>{"c.txt", "moved", "newer"}));
+  EXPECT_EQ(List(overlay, "/d/newer/deeper"),
+            std::vector<std::string>{"b.txt"});
+
+  // Renames that would fail on disk fail here too
+  overlay.rename("/d/missing.txt", "/d/x.txt", ec);
+  EXPECT_TRUE(ec);
+  overlay.rename("/d/c.txt", "/d/nowhere/c.txt", ec);
+  EXPECT_TRUE(ec);
+  overlay.removeAll("/d/newer", ec);
+  EXPECT_FALSE(overlay.exists("/d/newer/deeper/b.txt", ec));
+
+  EXPECT_EQ(memFs.readFile("/d/a.txt"), "A");
+  EXPECT_EQ(memFs.readFile("/d/sub/b.txt"), "B");
+  EXPECT_EQ(memFs.entryCount(), 5u); // "/", "/d", "/d/sub" and both files
+}
+
+TEST(OverlayFileSystem, DryRunReportsFailuresThePreviewMisses) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/d/a.txt", "A");
+  memFs.addFile("/d/b.txt", "B");
+  memFs.addFile("/d/sorted", "a file where the new folder would go");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/d";
+  params.filenamePattern = "*.txt";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "sorted/<orig_name><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.allowSubfolders = true;
+
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  EXPECT_EQ(results.diagnostics.count(DiagCategory::Warning), 0u);
+
+  params.dryRun = true;
+  results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  ASSERT_EQ(results.renamePlan.size(), 2u);
+  std::size_t failures = 0;
+  for (const auto &diag : results.diagnostics.records(DiagCategory::Warning)) {
+    failures += diag.code == DiagCode::DryRunFailure ? 1 : 0;
+  }
+  EXPECT_EQ(failures, 2u);
+  EXPECT_EQ(memFs.readFile("/d/a.txt"), "A"); // Nothing was renamed
+}
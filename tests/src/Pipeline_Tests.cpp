@@ -0,0 +1,46 @@
+#include "pch.h"
+#include "../../src/Logic/Pipeline.h"
+#include <cstddef>
+#include <stdexcept>
+
+TEST(SpscRing, PassesItemsInOrderThroughASmallRing) {
+  SpscRing<std::size_t> ring(4); // Full most of the time
+  constexpr std::size_t count = 100000;
+  StageThread producer(
+      [&] {
+        for (std::size_t i = 0; i < count; ++i) {
+          ASSERT_TRUE(ring.push(i));
+        }
+      },
+      [&] { ring.close(); });
+
+  std::size_t expected = 0;
+  std::size_t value = 0;
+  while (ring.pop(value)) {
+    ASSERT_EQ(value, expected);
+    ++expected;
+  }
+  producer.join();
+  EXPECT_EQ(expected, count);
+}
+
+TEST(SpscRing, ClosingStopsTheProducerAndErrorsReachJoin) {
+  SpscRing<int> ring(2);
+  bool pushFailed = false;
+  StageThread producer(
+      [&] {
+        for (int i = 0;; ++i) {
+          if (!ring.push(i)) {
+            pushFailed = true; // The consumer stopped listening
+            throw std::runtime_error("stopped");
+          }
+        }
+      },
+      [] {});
+  int value = 0;
+  ASSERT_TRUE(ring.pop(value));
+  EXPECT_EQ(value, 0);
+  ring.close();
+  EXPECT_THROW(producer.join(), std::runtime_error);
+  EXPECT_TRUE(pushFailed);
+}
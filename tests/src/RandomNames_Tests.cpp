@@ -0,0 +1,71 @@
+#include "pch.h"
+#include "../../src/Logic/RandomNames.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include <cctype>
+#include <set>
+#include <string>
+
+TEST(RandomNames, ExpandsPlaceholdersWithoutRegex) {
+  FastRandom rng(42);
+  std::string tokens;
+  std::string out = ExpandRandomPlaceholders(
+      "a<random:3>b<random:x><random:99>", rng, &tokens);
+  ASSERT_EQ(out.size(), 1 + 3 + 1 + 10 + 64u);
+  EXPECT_EQ(out.substr(0, 1), "a");
+  EXPECT_EQ(out.substr(4, 11), "b<random:x>");
+  EXPECT_EQ(tokens.size(), 3 + 64u);
+  for (char c : tokens) {
+    EXPECT_TRUE(std::isalnum(static_cast<unsigned char>(c)));
+  }
+  EXPECT_EQ(ExpandRandomPlaceholders("<random:5", rng), "<random:5");
+}
+
+TEST(RandomNames, SameSeedReproducesSequence) {
+  RandomNameGenerator first(1234);
+  RandomNameGenerator second(1234);
+  for (int i = 0; i < 100; ++i) {
+    EXPECT_EQ(first.expand("img_<random:8>.jpg"),
+              second.expand("img_<random:8>.jpg"));
+  }
+}
+
+TEST(RandomNames, TokensAreUniqueCaseInsensitively) {
+  // 36 case-folded values exist for one character; all must be handed out
+  // before any repeats
+  RandomNameGenerator generator(7);
+  std::set<std::string> seen;
+  for (int i = 0; i < 36; ++i) {
+    EXPECT_TRUE(seen.insert(ToLower(generator.expand("<random:1>"))).second);
+  }
+}
+
+TEST(RandomNames, PlanAvoidsExistingTargets) {
+  MemoryFileSystem memFs;
+  for (int i = 0; i < 200; ++i) {
+    memFs.addFile("/r/src_" + std::to_string(i) + ".dat");
+  }
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/r";
+  params.filenamePattern = "src_*.dat";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<random:2><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.randomSeed = 99;
+
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  ASSERT_EQ(results.renamePlan.size(), 200u);
+  for (const auto &op : results.renamePlan) {
+    EXPECT_FALSE(op.hasConflict) << op.NewName;
+  }
+}
@@ -55,4 +55,148 @@ TEST_F(RenamerLogicFilesystemTest, PerformRename_SourceMissing)
     ASSERT_EQ(renameRes.successfulRenameOps.size(), 0);
     ASSERT_EQ(renameRes.failedRenames.size(), 1);
     EXPECT_FALSE(fs::exists(newFile));
-}
\ No newline at end of file
+}
+TEST(RenamerLogicSubfolders, PlanAndRenameMoveFilesIntoNewFolders)
+{
+    MemoryFileSystem memFs;
+    memFs.addFile("/photos/trip_1.jpg");
+    memFs.addFile("/photos/trip_2.jpg");
+    memFs.addFile("/photos/notes.txt");
+
+    InputParams params;
+    params.mode = RenamingMode::DirectoryScan;
+    params.targetDirectory = "/photos";
+    params.filenamePattern = "*";
+    params.filterExtensions = "";
+    params.lowestNumber = 0;
+    params.highestNumber = 0;
+    params.recursiveScan = false;
+    params.namingPattern = "sorted/<parent_dir>/<orig_name>_x<ext>";
+    params.increment = 0;
+    params.findText = "";
+    params.replaceText = "";
+    params.findCaseSensitive = false;
+    params.findUseRegex = false;
+    params.caseConversionMode = CaseConversionMode::NoChange;
+    params.allowSubfolders = true;
+
+    OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+    ASSERT_TRUE(results.success);
+    ASSERT_EQ(results.renamePlan.size(), 3);
+    for (const auto &op : results.renamePlan)
+    {
+        EXPECT_EQ(op.NewFullPath.parent_path(),
+                  fs::path("/photos/sorted/photos").make_preferred());
+    }
+    // "sorted" and "sorted/photos"
+    bool reportedFolders = false;
+    for (const auto &diag : results.diagnostics.records(DiagCategory::Info))
+    {
+        reportedFolders |= diag.code == DiagCode::FoldersToCreate && diag.value == 2;
+    }
+    EXPECT_TRUE(reportedFolders);
+
+    RenameExecutionResult renameRes =
+        RenamerLogic::performRename(results.renamePlan, 0, memFs);
+    ASSERT_TRUE(renameRes.overallSuccess);
+    EXPECT_EQ(renameRes.successfulRenameOps.size(), 3);
+    std::error_code ec;
+    EXPECT_EQ(memFs.status("/photos/sorted/photos/trip_1_x.jpg", ec), FileKind::Regular);
+    EXPECT_EQ(memFs.status("/photos/sorted/photos/notes_x.txt", ec), FileKind::Regular);
+    EXPECT_EQ(memFs.status("/photos/trip_2.jpg", ec), FileKind::NotFound);
+
+    // Without the option the separator is sanitised away
+    params.allowSubfolders = false;
+    memFs.addFile("/photos/loose.png");
+    results = RenamerLogic::calculateRenamePlan(params, memFs);
+    ASSERT_TRUE(results.success);
+    ASSERT_EQ(results.renamePlan.size(), 1);
+    EXPECT_EQ(results.renamePlan[0].NewFullPath.parent_path(), fs::path("/photos"));
+}
+
+TEST(RenamerLogicFolders, RenamesNestedFoldersBottomUpAndUndoes)
+{
+    MemoryFileSystem memFs;
+    memFs.addFile("/data/set1/a.txt", "A");
+    memFs.addFile("/data/set2/sub3/b.txt", "B");
+    memFs.addFile("/data/set2/sub4/c.txt", "C");
+    memFs.addFile("/data/settings.txt", "S");
+
+    InputParams params;
+    params.mode = RenamingMode::DirectoryScan;
+    params.targetDirectory = "/data";
+    params.filenamePattern = "set*;sub*";
+    params.filterExtensions = "";
+    params.lowestNumber = 0;
+    params.highestNumber = 0;
+    params.recursiveScan = true;
+    params.namingPattern = "ds_<orig_name><ext>";
+    params.increment = 0;
+    params.findText = "";
+    params.replaceText = "";
+    params.findCaseSensitive = false;
+    params.findUseRegex = false;
+    params.caseConversionMode = CaseConversionMode::NoChange;
+    params.renameDirectories = true;
+
+    OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+    ASSERT_TRUE(results.success);
+    ASSERT_EQ(results.renamePlan.size(), 5); // Four folders and settings.txt
+    int folders = 0;
+    for (const auto &op : results.renamePlan)
+    {
+        folders += op.isDirectory ? 1 : 0;
+    }
+    EXPECT_EQ(folders, 4);
+
+    RenameExecutionResult renameRes =
+        RenamerLogic::performRename(results.renamePlan, 0, memFs);
+    ASSERT_TRUE(renameRes.overallSuccess);
+    EXPECT_EQ(renameRes.successfulRenameOps.size(), 5);
+    EXPECT_EQ(memFs.readFile("/data/ds_set2/ds_sub3/b.txt"), "B");
+    EXPECT_EQ(memFs.readFile("/data/ds_set2/ds_sub4/c.txt"), "C");
+    EXPECT_EQ(memFs.readFile("/data/ds_set1/a.txt"), "A");
+    EXPECT_EQ(memFs.readFile("/data/ds_settings.txt"), "S");
+
+    UndoResult undoRes = RenamerLogic::performUndo(renameRes.successfulRenameOps, memFs);
+    ASSERT_TRUE(undoRes.overallSuccess);
+    EXPECT_EQ(memFs.readFile("/data/set2/sub3/b.txt"), "B");
+    EXPECT_EQ(memFs.readFile("/data/settings.txt"), "S");
+    std::error_code ec;
+    EXPECT_FALSE(memFs.exists("/data/ds_set2", ec));
+}
+
+TEST(RenamerLogicSchedule, RenamesCycleThroughOneTemporaryNameAndUndoes)
+{
+    MemoryFileSystem memFs;
+    memFs.addFile("/c/a.txt", "A");
+    memFs.addFile("/c/b.txt", "B");
+    memFs.addFile("/c/c.txt", "C");
+    memFs.addFile("/c/d.txt", "D");
+
+    // a -> b -> c -> a is a cycle; d -> e just has to wait for nothing
+    std::vector<RenameOperation> plan = {
+        {"a.txt", "b.txt", "/c/a.txt", "/c/b.txt", std::nullopt, 1, false, ""},
+        {"b.txt", "c.txt", "/c/b.txt", "/c/c.txt", std::nullopt, 2, false, ""},
+        {"c.txt", "a.txt", "/c/c.txt", "/c/a.txt", std::nullopt, 3, false, ""},
+        {"d.txt", "e.txt", "/c/d.txt", "/c/e.txt", std::nullopt, 4, false, ""}};
+    LatencyFileSystem countingFs(memFs, LatencyConfig());
+    RenameExecutionResult renameRes = RenamerLogic::performRename(plan, 0, countingFs);
+    ASSERT_TRUE(renameRes.overallSuccess);
+    EXPECT_EQ(renameRes.successfulRenameOps.size(), 4);
+    EXPECT_EQ(countingFs.callCount(FileOp::Rename), 5u); // One extra for the cycle
+    EXPECT_EQ(memFs.readFile("/c/b.txt"), "A");
+    EXPECT_EQ(memFs.readFile("/c/c.txt"), "B");
+    EXPECT_EQ(memFs.readFile("/c/a.txt"), "C");
+    EXPECT_EQ(memFs.readFile("/c/e.txt"), "D");
+    std::error_code ec;
+    EXPECT_FALSE(memFs.exists("/c/a.txt.renaming", ec));
+
+    UndoResult undoRes = RenamerLogic::performUndo(renameRes.successfulRenameOps, memFs);
+    ASSERT_TRUE(undoRes.overallSuccess);
+    EXPECT_EQ(undoRes.successfulUndos.size(), 4);
+    EXPECT_EQ(memFs.readFile("/c/a.txt"), "A");
+    EXPECT_EQ(memFs.readFile("/c/b.txt"), "B");
+    EXPECT_EQ(memFs.readFile("/c/c.txt"), "C");
+    EXPECT_EQ(memFs.readFile("/c/d.txt"), "D");
+}
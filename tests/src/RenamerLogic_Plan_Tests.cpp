@@ -145,7 +145,276 @@ TEST_F(RenamerLogicFilesystemTest, CalculatePlan_TargetExistsSkip)
 
     OutputResults results = RenamerLogic::calculateRenamePlan(params);
     EXPECT_TRUE(results.success);
-    EXPECT_EQ(results.renamePlan.size(), 0);
-    EXPECT_EQ(results.potentialOverwritesLog.size(), 1);
-    EXPECT_EQ(results.missingSourceFilesLog.size(), 1);
-}
\ No newline at end of file
+    // The conflicting operation stays in the plan, flagged, and is skipped at rename time
+    ASSERT_EQ(results.renamePlan.size(), 1);
+    EXPECT_TRUE(results.renamePlan[0].hasConflict);
+    EXPECT_EQ(results.diagnostics.count(DiagCategory::Overwrite), 1);
+    EXPECT_EQ(results.diagnostics.count(DiagCategory::Skipped), 0);
+}
+
+TEST(RenamerLogicPlan, CalculatePlan_MetadataPlaceholdersFromScan)
+{
+    MemoryFileSystem memFs;
+    memFs.addSizedFile("/docs/report_1.txt", 4096);
+
+    InputParams params;
+    params.mode = RenamingMode::DirectoryScan;
+    params.targetDirectory = "/docs";
+    params.filenamePattern = "*.txt";
+    params.recursiveScan = false;
+    params.namingPattern = "<orig_name>_<file_size_kb>kb_<num><ext>";
+    params.filterExtensions = "";
+    params.lowestNumber = 0;
+    params.highestNumber = 0;
+    params.findText = "report";
+    params.replaceText = "Summary";
+    params.findCaseSensitive = true;
+    params.findUseRegex = false;
+    params.caseConversionMode = CaseConversionMode::ToLower;
+    params.increment = 1;
+
+    OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+
+    ASSERT_TRUE(results.success);
+    ASSERT_EQ(results.renamePlan.size(), 1);
+    EXPECT_EQ(results.renamePlan[0].NewName, "summary_1_4kb_02.txt");
+}
+
+TEST(RenamerLogicPlan, CalculatePlan_ManualIgnoresNumberStage)
+{
+    MemoryFileSystem memFs;
+    memFs.addFile("/m/a_7.txt");
+    memFs.addFile("/m/b_8.txt");
+
+    InputParams params;
+    params.mode = RenamingMode::ManualSelection;
+    params.manualFiles = {"/m/a_7.txt", "/m/missing.txt", "/m/b_8.txt"};
+    params.namingPattern = "<index>-<num>_<orig_name><ext>";
+    params.recursiveScan = false;
+    params.lowestNumber = 0;
+    params.highestNumber = 0;
+    params.findText = "";
+    params.replaceText = "";
+    params.findCaseSensitive = false;
+    params.findUseRegex = false;
+    params.caseConversionMode = CaseConversionMode::ToUpper;
+    params.increment = 1;
+
+    OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+
+    ASSERT_EQ(results.renamePlan.size(), 2);
+    EXPECT_EQ(results.renamePlan[0].NewName, "1-_A_7.txt");
+    EXPECT_EQ(results.renamePlan[1].Index, 3);
+    EXPECT_EQ(results.diagnostics.count(DiagCategory::Skipped), 1u);
+}
+
+TEST(RenamerLogicPlan, CalculatePlan_ExcludesAndPrunesDirectories)
+{
+    MemoryFileSystem memFs;
+    memFs.addFile("/lib/a.txt");
+    memFs.addFile("/lib/a.log");
+    memFs.addFile("/lib/skip_me.txt");
+    memFs.addFile("/lib/docs/b.txt");
+    memFs.addFile("/lib/docs/deep/c.txt");
+    memFs.addFile("/lib/.git/d.txt");
+    memFs.addFile("/lib/node_modules/e.txt");
+
+    InputParams params;
+    params.mode = RenamingMode::DirectoryScan;
+    params.targetDirectory = "/lib";
+    params.filenamePattern = "*.txt;*.log";
+    params.excludePatterns = "skip_*; node_modules/; /";
+    params.skipHiddenDirectories = true;
+    params.maxScanDepth = 1;
+    params.recursiveScan = true;
+    params.namingPattern = "x_<orig_name><ext>";
+    params.filterExtensions = "";
+    params.lowestNumber = 0;
+    params.highestNumber = 0;
+    params.findText = "";
+    params.replaceText = "";
+    params.findCaseSensitive = false;
+    params.caseConversionMode = CaseConversionMode::NoChange;
+    params.increment = 0;
+
+    LatencyFileSystem countingFs(memFs, LatencyConfig{});
+    OutputResults results =
+        RenamerLogic::calculateRenamePlan(params, countingFs);
+
+    ASSERT_TRUE(results.success);
+    std::vector<std::string> oldNames;
+    for (const auto &op : results.renamePlan)
+    {
+        oldNames.push_back(op.OldName);
+    }
+    EXPECT_EQ(oldNames, (std::vector<std::string>{"a.log", "a.txt", "b.txt"}));
+    // Only /lib and /lib/docs were listed; the other folders were pruned
+    EXPECT_EQ(countingFs.callCount(FileOp::List), 2u);
+}
+
+TEST(RenamerLogicPlan, CalculatePlan_RuleChainAppliesStepsInOrder)
+{
+    MemoryFileSystem memFs;
+    memFs.addFile("/photos/Trip_Draft_7.JPG");
+    memFs.addFile("/photos/Trip_Draft_12.JPG");
+
+    InputParams params;
+    params.mode = RenamingMode::DirectoryScan;
+    params.targetDirectory = "/photos";
+    params.filenamePattern = "*";
+    params.filterExtensions = "";
+    params.lowestNumber = 0;
+    params.highestNumber = 0;
+    params.recursiveScan = false;
+    params.namingPattern = "<orig_name><ext>";
+    params.increment = 0;
+    params.findText = "";
+    params.replaceText = "";
+    params.findCaseSensitive = false;
+    params.findUseRegex = false;
+    params.caseConversionMode = CaseConversionMode::NoChange;
+
+    // Normalise case, then strip a tag, then renumber
+    RuleStep lower;
+    lower.caseConversionMode = CaseConversionMode::ToLower;
+    RuleStep strip;
+    strip.findText = "_draft";
+    RuleStep renumber;
+    renumber.namingPattern = "<orig_name>_v<num><ext>";
+    renumber.increment = 100;
+    params.ruleChain = {lower, strip, renumber};
+
+    LatencyFileSystem countingFs(memFs, LatencyConfig{});
+    OutputResults results =
+        RenamerLogic::calculateRenamePlan(params, countingFs);
+
+    ASSERT_TRUE(results.success);
+    std::vector<std::string> newNames;
+    for (const auto &op : results.renamePlan)
+    {
+        newNames.push_back(op.NewName);
+    }
+    std::sort(newNames.begin(), newNames.end());
+    EXPECT_EQ(newNames, (std::vector<std::string>{"trip_12_v112.JPG",
+                                                  "trip_7_v107.JPG"}));
+    EXPECT_EQ(countingFs.callCount(FileOp::Rename), 0u);
+}
+
+TEST(RenamerLogicPlan, CalculatePlan_ShiftMatchesGeneralPipeline)
+{
+    MemoryFileSystem memFs;
+    for (int n = 1; n <= 5; ++n)
+    {
+        memFs.addFile("/seq/File0" + std::to_string(n) + ".txt", std::to_string(n));
+    }
+    memFs.addFile("/seq/File07.txt", "outside the range");
+
+    InputParams params;
+    params.mode = RenamingMode::DirectoryScan;
+    params.targetDirectory = "/seq";
+    params.filenamePattern = "File*";
+    params.filterExtensions = "";
+    params.lowestNumber = 1;
+    params.highestNumber = 5;
+    params.recursiveScan = false;
+    params.namingPattern = "File<num><ext>";
+    params.increment = 2;
+    params.findText = "";
+    params.replaceText = "";
+    params.findCaseSensitive = false;
+    params.findUseRegex = false;
+    params.caseConversionMode = CaseConversionMode::NoChange;
+
+    LatencyFileSystem countingFs(memFs, LatencyConfig());
+    OutputResults shift = RenamerLogic::calculateRenamePlan(params, countingFs);
+    ASSERT_TRUE(shift.success);
+    ASSERT_EQ(shift.renamePlan.size(), 5);
+    // Emitted in execution order; only targets past the sequence are looked up
+    for (int i = 0; i < 5; ++i)
+    {
+        EXPECT_EQ(shift.renamePlan[i].Number, 5 - i);
+    }
+    EXPECT_EQ(shift.renamePlan[0].NewName, "File07.txt");
+    EXPECT_TRUE(shift.renamePlan[0].hasConflict); // File07.txt isn't a source
+    // File05 then stays, so File03 can't take its name, nor File01 File03's
+    EXPECT_TRUE(shift.renamePlan[2].hasConflict);
+    EXPECT_TRUE(shift.renamePlan[4].hasConflict);
+    EXPECT_FALSE(shift.renamePlan[1].hasConflict);
+    EXPECT_EQ(shift.diagnostics.count(DiagCategory::Overwrite), 3);
+    EXPECT_LE(countingFs.callCount(FileOp::Status), 3u); // Folder, File06, File07
+
+    // A find/replace that matches nothing forces the general pipeline
+    params.findText = "no match";
+    OutputResults general = RenamerLogic::calculateRenamePlan(params, memFs);
+    ASSERT_EQ(general.renamePlan.size(), shift.renamePlan.size());
+    for (const auto &op : general.renamePlan)
+    {
+        auto same = std::find_if(shift.renamePlan.begin(), shift.renamePlan.end(),
+                                 [&](const RenameOperation &other)
+                                 { return other.OldFullPath == op.OldFullPath; });
+        ASSERT_NE(same, shift.renamePlan.end());
+        EXPECT_EQ(same->NewFullPath, op.NewFullPath);
+        EXPECT_EQ(same->hasConflict, op.hasConflict);
+    }
+
+    std::error_code ec;
+    memFs.removeAll("/seq/File07.txt", ec);
+    params.findText = "";
+    shift = RenamerLogic::calculateRenamePlan(params, memFs);
+    RenameExecutionResult renameRes = RenamerLogic::performRename(shift.renamePlan, params.increment, memFs);
+    ASSERT_TRUE(renameRes.overallSuccess);
+    EXPECT_EQ(memFs.readFile("/seq/File03.txt"), "1");
+    EXPECT_EQ(memFs.readFile("/seq/File07.txt"), "5");
+    EXPECT_FALSE(memFs.exists("/seq/File02.txt", ec));
+}
+
+TEST(RenamerLogicPlan, CalculatePlan_ResequenceRenamesOnlyChangedFiles)
+{
+    MemoryFileSystem memFs;
+    for (int n : {1, 2, 4, 5, 6})
+    {
+        memFs.addFile("/seq/File0" + std::to_string(n) + ".txt", std::to_string(n));
+    }
+
+    InputParams params;
+    params.mode = RenamingMode::DirectoryScan;
+    params.targetDirectory = "/seq";
+    params.filenamePattern = "File*";
+    params.filterExtensions = "";
+    params.lowestNumber = 0;
+    params.highestNumber = 0;
+    params.recursiveScan = false;
+    params.namingPattern = "File<num><ext>";
+    params.increment = 1; // Ignored when resequencing
+    params.findText = "";
+    params.replaceText = "";
+    params.findCaseSensitive = false;
+    params.findUseRegex = false;
+    params.caseConversionMode = CaseConversionMode::NoChange;
+    params.resequence = ResequenceOrder::CurrentNumber;
+
+    OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+    ASSERT_TRUE(results.success);
+    ASSERT_EQ(results.renamePlan.size(), 3); // File01 and File02 stay
+    RenameExecutionResult renameRes = RenamerLogic::performRename(results.renamePlan, 0, memFs);
+    ASSERT_TRUE(renameRes.overallSuccess);
+    EXPECT_EQ(memFs.readFile("/seq/File03.txt"), "4");
+    EXPECT_EQ(memFs.readFile("/seq/File05.txt"), "6");
+    std::error_code ec;
+    EXPECT_FALSE(memFs.exists("/seq/File06.txt", ec));
+
+    // By name reads numbers by value: "x2" comes before "x10"
+    memFs.addFile("/nat/x10.txt", "10");
+    memFs.addFile("/nat/x2.txt", "2");
+    params.targetDirectory = "/nat";
+    params.filenamePattern = "x*";
+    params.namingPattern = "y<num><ext>";
+    params.resequence = ResequenceOrder::NaturalName;
+    results = RenamerLogic::calculateRenamePlan(params, memFs);
+    ASSERT_TRUE(results.success);
+    ASSERT_EQ(results.renamePlan.size(), 2);
+    for (const auto &op : results.renamePlan)
+    {
+        EXPECT_EQ(op.NewName, op.OldName == "x2.txt" ? "y01.txt" : "y02.txt");
+    }
+}
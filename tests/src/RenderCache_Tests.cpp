@@ -0,0 +1,116 @@
+#include "pch.h"
+#include "../../src/Logic/RenderCache.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "TestFixtures.h"
+#include <chrono>
+#include <ctime>
+#include <string>
+#include <thread>
+#include <vector>
+
+namespace {
+std::vector<std::string> NewNames(const OutputResults &results) {
+  std::vector<std::string> names;
+  for (const RenameOperation &op : results.renamePlan) {
+    names.push_back(op.NewName);
+  }
+  return names;
+}
+} // namespace
+
+TEST(RenderCache, PreviewRerunsOnlyTheStagesAfterTheEditedField) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/d/photo_1.jpg");
+  memFs.addFile("/d/photo_2.jpg");
+  memFs.addFile("/d/photo_3.jpg");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/d";
+  params.filenamePattern = "*.jpg";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "holiday_<num><ext>";
+  params.increment = 10;
+  params.findText = "holiday";
+  params.replaceText = "Trip";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  RenderCache cache;
+  params.renderCache = &cache;
+
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  EXPECT_EQ(NewNames(results),
+            (std::vector<std::string>{"Trip_11.jpg", "Trip_12.jpg",
+                                      "Trip_13.jpg"}));
+  EXPECT_EQ(cache.hits(RenderCache::Placeholders), 0u);
+
+  // Only the case changes: placeholders and find/replace are reused
+  params.caseConversionMode = CaseConversionMode::ToUpper;
+  results = RenamerLogic::calculateRenamePlan(params, memFs);
+  EXPECT_EQ(NewNames(results),
+            (std::vector<std::string>{"TRIP_11.jpg", "TRIP_12.jpg",
+                                      "TRIP_13.jpg"}));
+  EXPECT_EQ(cache.hits(RenderCache::Placeholders), 3u);
+  EXPECT_EQ(cache.hits(RenderCache::FindReplace), 3u);
+  EXPECT_EQ(cache.hits(RenderCache::CaseConversion), 0u);
+
+  // The replacement changes: only the placeholders are reused
+  params.replaceText = "Tour";
+  results = RenamerLogic::calculateRenamePlan(params, memFs);
+  EXPECT_EQ(NewNames(results),
+            (std::vector<std::string>{"TOUR_11.jpg", "TOUR_12.jpg",
+                                      "TOUR_13.jpg"}));
+  EXPECT_EQ(cache.hits(RenderCache::Placeholders), 3u);
+  EXPECT_EQ(cache.hits(RenderCache::FindReplace), 0u);
+
+  // The increment changes a file's number, so nothing is reused; files no
+  // longer scanned leave the cache
+  params.increment = 20;
+  params.filenamePattern = "photo_1.jpg";
+  results = RenamerLogic::calculateRenamePlan(params, memFs);
+  EXPECT_EQ(NewNames(results), std::vector<std::string>{"TOUR_21.jpg"});
+  EXPECT_EQ(cache.hits(RenderCache::Placeholders), 0u);
+  EXPECT_EQ(cache.size(), 1u);
+}
+
+TEST(RenderCache, ClockPlaceholdersAreRenderedEveryPreview) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/d/a.txt");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/d";
+  params.filenamePattern = "*.txt";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<hh><mm><ss>_<orig_name><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  RenderCache cache;
+  params.renderCache = &cache;
+
+  OutputResults first = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_EQ(first.renamePlan.size(), 1u);
+  // Let the clock move on to the next second
+  const std::time_t rendered = std::time(nullptr);
+  while (std::time(nullptr) == rendered) {
+    std::this_thread::sleep_for(std::chrono::milliseconds(10));
+  }
+
+  OutputResults second = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_EQ(second.renamePlan.size(), 1u);
+  EXPECT_NE(second.renamePlan[0].NewName, first.renamePlan[0].NewName);
+  EXPECT_EQ(cache.hits(RenderCache::Placeholders), 0u);
+  EXPECT_EQ(cache.size(), 0u);
+}
@@ -0,0 +1,118 @@
+#include "pch.h"
+#include "../../src/Logic/ReplacementTable.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "TestFixtures.h"
+#include <random>
+#include <string>
+#include <vector>
+
+namespace {
+// Leftmost-longest replacement by trying every pair at every position
+std::string ReplaceNaively(const std::string &name,
+                           const std::vector<ReplacementPair> &pairs) {
+  std::string result;
+  std::size_t i = 0;
+  while (i < name.size()) {
+    const ReplacementPair *best = nullptr;
+    for (const ReplacementPair &pair : pairs) {
+      if (name.compare(i, pair.find.size(), pair.find) == 0 &&
+          (!best || pair.find.size() > best->find.size())) {
+        best = &pair;
+      }
+    }
+    if (best) {
+      result += best->replace;
+      i += best->find.size();
+    } else {
+      result += name[i++];
+    }
+  }
+  return result;
+}
+} // namespace
+
+TEST(MultiReplacer, ReplacesLeftmostLongestInOnePass) {
+  const std::vector<ReplacementPair> pairs = {
+      {"he", "1"}, {"she", "2"}, {"hers", "3"}, {"his", "4"}, {"s", "_"}};
+  const MultiReplacer replacer(pairs, true);
+  EXPECT_EQ(replacer.apply("ushers"), "u2r_"); // "she" starts before "hers"
+  EXPECT_EQ(replacer.apply("hishers"), "43"); // "his" ends before "hers"
+  EXPECT_EQ(replacer.apply("SHE"), "SHE");
+  EXPECT_EQ(replacer.apply(""), "");
+
+  const MultiReplacer folded({{"copy", ""}, {" - ", "_"}}, false);
+  EXPECT_EQ(folded.apply("Report - COPY - Copy.pdf"), "Report__.pdf");
+
+  // Random names over a small alphabet, so matches overlap a lot
+  std::mt19937 rng(7);
+  auto randomText = [&](std::size_t maxLength) {
+    std::string text(rng() % maxLength + 1, 'a');
+    for (char &c : text) {
+      c = static_cast<char>('a' + rng() % 3);
+    }
+    return text;
+  };
+  for (int round = 0; round < 200; ++round) {
+    std::vector<ReplacementPair> table;
+    for (int p = 0; p < 6; ++p) {
+      table.push_back({randomText(4), std::to_string(p)});
+    }
+    // Only the first pair for a find text counts, as in the replacer
+    std::vector<ReplacementPair> unique;
+    for (const ReplacementPair &pair : table) {
+      bool seen = false;
+      for (const ReplacementPair &kept : unique) {
+        seen = seen || kept.find == pair.find;
+      }
+      if (!seen) {
+        unique.push_back(pair);
+      }
+    }
+    const MultiReplacer random(table, true);
+    const std::string name = randomText(40);
+    ASSERT_EQ(random.apply(name), ReplaceNaively(name, unique)) << name;
+  }
+}
+
+TEST(MultiReplacer, TableFromTextCleansNamesInThePlan) {
+  std::vector<ReplacementPair> pairs;
+  std::string error;
+  ASSERT_TRUE(ParseReplacementTable("# junk tokens\n"
+                                    "[720p] =>\n"
+                                    "\" - Copy\" => \"\"\n"
+                                    "_ => \" \"\n",
+                                    pairs, error))
+      << error;
+  ASSERT_EQ(pairs.size(), 3u);
+  EXPECT_EQ(pairs[1].find, " - Copy");
+  EXPECT_EQ(pairs[2].replace, " ");
+  EXPECT_FALSE(ParseReplacementTable("a => b\nc\n", pairs, error));
+  EXPECT_EQ(error, "Line 2: expected 'find => replace'.");
+  EXPECT_FALSE(ParseReplacementTable("a => b\na => c\n", pairs, error));
+  ASSERT_TRUE(ParseReplacementTable("[720p] =>\n\" - copy\" =>\n_ => \" \"\n",
+                                    pairs, error));
+
+  MemoryFileSystem memFs;
+  memFs.addFile("/d/Holiday_Film[720p] - Copy.mkv");
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/d";
+  params.filenamePattern = "*.mkv";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<orig_name><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.replacementTable = pairs;
+
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  ASSERT_EQ(results.renamePlan.size(), 1u);
+  EXPECT_EQ(results.renamePlan[0].NewName, "Holiday Film.mkv");
+}
@@ -0,0 +1,135 @@
+#include "pch.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "../../src/Logic/RuleRouter.h"
+#include <algorithm>
+#include <string>
+#include <vector>
+
+namespace {
+RoutedRule MakeRule(std::vector<std::string> extensions,
+                    std::vector<std::string> patterns, std::string naming) {
+  RoutedRule rule;
+  rule.extensions = std::move(extensions);
+  rule.filenamePatterns = std::move(patterns);
+  rule.namingPattern = std::move(naming);
+  return rule;
+}
+} // namespace
+
+TEST(RuleRouter, FirstMatchingRuleWins) {
+  std::vector<RoutedRule> rules;
+  rules.push_back(MakeRule({"jpg", ".JPEG"}, {"IMG_*"}, "camera"));
+  rules.push_back(MakeRule({"jpg"}, {}, "photo"));
+  rules.push_back(MakeRule({}, {"*_draft*"}, "draft"));
+  RoutedRule ranged = MakeRule({".mov"}, {}, "early_clip");
+  ranged.useNumberRange = true;
+  ranged.lowestNumber = 1;
+  ranged.highestNumber = 9;
+  rules.push_back(ranged);
+  const RuleRouter router(rules);
+
+  EXPECT_EQ(router.route("IMG_0001.JPG"), 0);
+  EXPECT_EQ(router.route("img_2.jpeg"), 0);
+  EXPECT_EQ(router.route("holiday.jpg"), 1);
+  EXPECT_EQ(router.route("notes_draft.txt"), 2);
+  EXPECT_EQ(router.route("clip5.mov"), 3);
+  EXPECT_EQ(router.route("clip50.mov"), -1);
+  EXPECT_EQ(router.route("clip50.mov", 7), 3); // Number supplied by the scan
+  EXPECT_EQ(router.route("readme"), -1);
+  EXPECT_TRUE(router.usesNumbers());
+}
+
+TEST(RuleRouter, ParsesRuleText) {
+  std::vector<RoutedRule> rules;
+  std::string error;
+  const char *text = "# Mixed camera folder\n"
+                     "ext:jpg,jpeg glob:IMG_*;DSC* => <num>_p<ext>\r\n"
+                     "\n"
+                     "ext:xmp num:-5-20 => <orig_name>.sidecar<ext>\n"
+                     "=> other_<orig_name><ext>";
+  ASSERT_TRUE(ParseRoutedRules(text, rules, error)) << error;
+  ASSERT_EQ(rules.size(), 3u);
+  EXPECT_EQ(rules[0].extensions, (std::vector<std::string>{"jpg", "jpeg"}));
+  EXPECT_EQ(rules[0].filenamePatterns,
+            (std::vector<std::string>{"IMG_*", "DSC*"}));
+  EXPECT_EQ(rules[0].namingPattern, "<num>_p<ext>");
+  EXPECT_TRUE(rules[1].useNumberRange);
+  EXPECT_EQ(rules[1].lowestNumber, -5);
+  EXPECT_EQ(rules[1].highestNumber, 20);
+  EXPECT_TRUE(rules[2].extensions.empty());
+
+  EXPECT_FALSE(ParseRoutedRules("ext:jpg photo<ext>", rules, error));
+  EXPECT_EQ(error, "Line 1: expected '=> pattern'.");
+  EXPECT_FALSE(ParseRoutedRules("\nsize:10 => x", rules, error));
+  EXPECT_EQ(error, "Line 2: unknown predicate 'size'.");
+  EXPECT_FALSE(ParseRoutedRules("num:9-1 => x", rules, error));
+}
+
+TEST(RuleRouter, PlanRoutesEachFileInOneScan) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/mixed/IMG_0007.jpg");
+  memFs.addFile("/mixed/IMG_0007.xmp");
+  memFs.addFile("/mixed/MVI_0003.mov");
+  memFs.addFile("/mixed/notes.txt");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/mixed";
+  params.filenamePattern = "*";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "misc_<orig_name><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.routedRules.push_back(MakeRule({"jpg", "xmp"}, {}, "photo<ext>"));
+  params.routedRules.push_back(MakeRule({"mov"}, {}, "video_<num><ext>"));
+
+  LatencyFileSystem countingFs(memFs, LatencyConfig());
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, countingFs);
+
+  ASSERT_TRUE(results.success);
+  std::vector<std::string> newNames;
+  for (const auto &op : results.renamePlan) {
+    newNames.push_back(op.NewName);
+  }
+  std::sort(newNames.begin(), newNames.end());
+  EXPECT_EQ(newNames, (std::vector<std::string>{"misc_notes.txt", "photo.jpg",
+                                                "photo.xmp", "video_03.mov"}));
+  EXPECT_EQ(countingFs.callCount(FileOp::List), 1u);
+}
+
+TEST(RuleRouter, PlanDetectsConflictsAcrossRules) {
+  MemoryFileSystem memFs;
+  memFs.addFile("/mixed/a.jpg");
+  memFs.addFile("/mixed/b.png");
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/mixed";
+  params.filenamePattern = "*";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "<orig_name><ext>";
+  params.increment = 0;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+  params.routedRules.push_back(MakeRule({"jpg"}, {}, "cover.img"));
+  params.routedRules.push_back(MakeRule({"png"}, {}, "COVER.img"));
+
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+
+  ASSERT_EQ(results.renamePlan.size(), 2u);
+  EXPECT_FALSE(results.renamePlan[0].hasConflict);
+  EXPECT_TRUE(results.renamePlan[1].hasConflict);
+}
@@ -0,0 +1,115 @@
+#include "pch.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "../../src/Logic/ScanFilter.h"
+#include <regex>
+#include <string>
+#include <vector>
+
+TEST(ScanFilter, ExtensionSetIsCaseInsensitive) {
+  ExtensionSet set({"JPG", ".png", "tar.gz", "jpg"});
+  EXPECT_EQ(set.size(), 3u);
+  EXPECT_TRUE(set.contains(".jpg"));
+  EXPECT_TRUE(set.contains(".JpG"));
+  EXPECT_TRUE(set.contains(".PNG"));
+  EXPECT_FALSE(set.contains(".gif"));
+  EXPECT_FALSE(set.contains(""));
+  EXPECT_EQ(ExtensionOf("photo.JPG"), ".JPG");
+  EXPECT_EQ(ExtensionOf(".bashrc"), "");
+  EXPECT_EQ(ExtensionOf("archive.tar.gz"), ".gz");
+}
+
+TEST(ScanFilter, WildcardMatchesRegexEquivalent) {
+  const std::vector<std::string> patterns = {
+      "*", "*.txt", "img_??.JPG", "a*b*c", "report", "*_*_?.log", "?*", ""};
+  const std::vector<std::string> names = {
+      "file.txt", "FILE.TXT",  "img_01.jpg", "img_1.jpg",
+      "abc",      "aXbYc",     "acb",        "Report",
+      "x_y_1.log", "x_y_12.log", "a",        "notes.txt.bak"};
+  for (const auto &pattern : patterns) {
+    const std::regex reference(RenamerLogic::ConvertWildcardToRegex(pattern),
+                               std::regex::icase);
+    const WildcardPattern compiled(pattern);
+    for (const auto &name : names) {
+      const bool expected = std::regex_match(name, reference);
+      EXPECT_EQ(compiled.matches(name), expected)
+          << "pattern '" << pattern << "' name '" << name << "'";
+      if (expected) {
+        EXPECT_TRUE(compiled.matchesAffixes(name));
+      }
+      if (compiled.affixesAreExact()) {
+        EXPECT_EQ(compiled.matchesAffixes(name), expected);
+      }
+    }
+  }
+}
+
+TEST(ScanFilter, GlobSetMatchesEveryPatternInOnePass) {
+  const std::vector<std::string> patterns = {
+      "*.txt", "img_??.JPG", "a*b*c", "report", "*_*_?.log", "?*",
+      std::string(70, '?') + "*"}; // Too long for a word
+  GlobSet set;
+  for (unsigned i = 0; i < patterns.size(); ++i) {
+    set.add(patterns[i], i);
+  }
+  const std::vector<std::string> names = {
+      "file.txt", "img_01.jpg", "img_1.jpg", "aXbYc", "acb", "Report",
+      "x_y_1.log", std::string(71, 'n'), ""};
+  for (const auto &name : names) {
+    unsigned expected = 0;
+    for (unsigned i = 0; i < patterns.size(); ++i) {
+      const std::regex reference(
+          RenamerLogic::ConvertWildcardToRegex(patterns[i]), std::regex::icase);
+      if (std::regex_match(name, reference)) {
+        expected |= 1u << i;
+      }
+    }
+    EXPECT_EQ(set.matchGroups(name), expected) << "name '" << name << "'";
+  }
+}
+
+TEST(ScanFilter, IncludeAndExcludeLists) {
+  ScanFilterOptions options;
+  options.includePatterns = SplitPatternList(" *.jpg ; *.png;;");
+  options.excludePatterns = {"*_thumb.*"};
+  ScanFilter filter(options);
+  std::optional<int> number;
+  EXPECT_TRUE(filter.accept("holiday.JPG", number));
+  EXPECT_TRUE(filter.accept("logo.png", number));
+  EXPECT_FALSE(filter.accept("holiday_thumb.jpg", number));
+  EXPECT_FALSE(filter.accept("notes.txt", number));
+
+  DirectoryFilterOptions dirOptions;
+  dirOptions.excludePatterns = {"node_modules", "*cache*"};
+  dirOptions.skipHidden = true;
+  dirOptions.maxDepth = 2;
+  DirectoryFilter dirFilter(dirOptions);
+  EXPECT_TRUE(dirFilter.shouldDescend("photos", 1));
+  EXPECT_FALSE(dirFilter.shouldDescend(".git", 1));
+  EXPECT_FALSE(dirFilter.shouldDescend("Node_Modules", 1));
+  EXPECT_FALSE(dirFilter.shouldDescend("ThumbCache", 2));
+  EXPECT_FALSE(dirFilter.shouldDescend("deeper", 3));
+  EXPECT_EQ(dirFilter.prunedCount(), 4u);
+}
+
+TEST(ScanFilter, ReordersTowardsMostSelectiveStage) {
+  ScanFilterOptions options;
+  options.includePatterns = {"*"};
+  options.extensions = {"txt", "jpg"};
+  options.useNumberRange = true;
+  options.lowestNumber = 100;
+  options.highestNumber = 199;
+  ScanFilter filter(options);
+  ASSERT_EQ(filter.stageOrder().front(), ScanFilterStage::Extension);
+
+  // Every name has an accepted extension, but almost none are in range
+  std::optional<int> number;
+  for (int i = 0; i < 4 * static_cast<int>(ScanFilter::ReorderInterval); ++i) {
+    filter.accept("file_" + std::to_string(i % 1000) + ".txt", number);
+  }
+  EXPECT_EQ(filter.stageOrder().front(), ScanFilterStage::NumberRange);
+
+  EXPECT_TRUE(filter.accept("file_150.TXT", number));
+  EXPECT_EQ(number.value_or(-1), 150);
+  EXPECT_FALSE(filter.accept("file_150.gif", number));
+  EXPECT_FALSE(filter.accept("file_250.txt", number));
+}
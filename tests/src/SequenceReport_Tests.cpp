@@ -0,0 +1,108 @@
+#include "pch.h"
+#include "../../src/Logic/RenamerLogic.h"
+#include "../../src/Logic/SequenceReport.h"
+#include "TestFixtures.h"
+#include <cstdint>
+#include <limits>
+#include <string>
+#include <utility>
+#include <vector>
+
+namespace {
+std::vector<std::pair<std::uint32_t, std::uint32_t>>
+Runs(const NumberSet &set) {
+  std::vector<std::pair<std::uint32_t, std::uint32_t>> runs;
+  set.forEachRun([&](std::uint32_t first, std::uint32_t last) {
+    runs.emplace_back(first, last);
+  });
+  return runs;
+}
+} // namespace
+
+TEST(SequenceReport, NumberSetSpansWholeIntRange) {
+  NumberSet set;
+  // Enough members in one block to turn it into a bitmap, inserted out of
+  // order, plus members at both ends of the range
+  for (std::uint32_t n = 10000; n > 0; --n) {
+    if (n != 5000) {
+      EXPECT_TRUE(set.insert(n));
+    }
+  }
+  const std::uint32_t intMax = std::numeric_limits<int>::max();
+  EXPECT_TRUE(set.insert(intMax));
+  EXPECT_TRUE(set.insert(intMax - 1));
+  EXPECT_FALSE(set.insert(intMax));
+  EXPECT_FALSE(set.insert(4000));
+  EXPECT_EQ(set.size(), 10001u);
+  EXPECT_TRUE(set.contains(4999));
+  EXPECT_FALSE(set.contains(5000));
+
+  auto runs = Runs(set);
+  ASSERT_EQ(runs.size(), 3u);
+  EXPECT_EQ(runs[0], std::make_pair(1u, 4999u));
+  EXPECT_EQ(runs[1], std::make_pair(5001u, 10000u));
+  EXPECT_EQ(runs[2], std::make_pair(intMax - 1, intMax));
+}
+
+TEST(SequenceReport, ReportsGapsDuplicatesAndPadding) {
+  SequenceAnalyzer analyzer;
+  for (const char *name : {"File01.txt", "File02.txt", "File05.txt",
+                           "File5.txt", "File09.txt", "File10.txt"}) {
+    analyzer.add(fs::path("/seq") / name);
+  }
+  analyzer.add("/seq/File03.jpg"); // Another family
+  analyzer.add("/other/File04.txt");
+  analyzer.add("/seq/notes.txt"); // No number
+
+  std::vector<SequenceFamily> families = analyzer.report();
+  ASSERT_EQ(families.size(), 3u);
+  const SequenceFamily &txt = families[2];
+  EXPECT_EQ(txt.folder, fs::path("/seq"));
+  EXPECT_EQ(txt.pattern, "File<#>.txt");
+  EXPECT_EQ(txt.members, 6u);
+  EXPECT_EQ(txt.lowest, 1u);
+  EXPECT_EQ(txt.highest, 10u);
+  EXPECT_EQ(txt.missing, 5u); // 3, 4, 6, 7, 8
+  ASSERT_EQ(txt.gaps.size(), 2u);
+  EXPECT_EQ(txt.gaps[0], std::make_pair(3u, 4u));
+  EXPECT_EQ(txt.gaps[1], std::make_pair(6u, 8u));
+  EXPECT_EQ(txt.duplicated, 1u);
+  EXPECT_EQ(txt.duplicates, std::vector<std::uint32_t>{5});
+  EXPECT_TRUE(txt.mixedPadding); // "File5" next to "File05"
+  EXPECT_EQ(txt.widths.at(2), 5u);
+  EXPECT_FALSE(families[1].mixedPadding);
+}
+
+TEST(SequenceReport, PreviewListsSequenceIssues) {
+  MemoryFileSystem memFs;
+  for (int n : {1, 2, 5}) {
+    memFs.addFile("/seq/File0" + std::to_string(n) + ".txt", "x");
+  }
+
+  InputParams params;
+  params.mode = RenamingMode::DirectoryScan;
+  params.targetDirectory = "/seq";
+  params.filenamePattern = "*.txt";
+  params.filterExtensions = "";
+  params.lowestNumber = 0;
+  params.highestNumber = 0;
+  params.recursiveScan = false;
+  params.namingPattern = "File<num><ext>";
+  params.increment = 1;
+  params.findText = "";
+  params.replaceText = "";
+  params.findCaseSensitive = false;
+  params.findUseRegex = false;
+  params.caseConversionMode = CaseConversionMode::NoChange;
+
+  OutputResults results = RenamerLogic::calculateRenamePlan(params, memFs);
+  ASSERT_TRUE(results.success);
+  std::vector<std::string> gaps;
+  for (const auto &diag : results.diagnostics.records(DiagCategory::Info)) {
+    if (diag.code == DiagCode::SequenceGaps) {
+      gaps.push_back(results.diagnostics.format(diag, results.renamePlan));
+    }
+  }
+  ASSERT_EQ(gaps.size(), 1u);
+  EXPECT_NE(gaps[0].find("3-4, 2 missing"), std::string::npos);
+}